@@ -4,6 +4,7 @@ HEADERS += \
     $$PWD/application.h \
     $$PWD/cmdoptions.h \
     $$PWD/filelogger.h \
+    $$PWD/filelogwriter.h \
     $$PWD/qtlocalpeer/qtlocalpeer.h \
     $$PWD/qtlocalpeer/qtlockedfile.h \
     $$PWD/applicationinstancemanager.h \
@@ -13,6 +14,7 @@ SOURCES += \
     $$PWD/application.cpp \
     $$PWD/cmdoptions.cpp \
     $$PWD/filelogger.cpp \
+    $$PWD/filelogwriter.cpp \
     $$PWD/main.cpp \
     $$PWD/qtlocalpeer/qtlocalpeer.cpp \
     $$PWD/qtlocalpeer/qtlockedfile.cpp \
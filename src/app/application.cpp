@@ -41,8 +41,11 @@
 
 #include <QAtomicInt>
 #include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QLibraryInfo>
-#include <QProcess>
+#include <QTimer>
 
 #ifndef DISABLE_GUI
 #include <QMessageBox>
@@ -63,12 +66,17 @@
 
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
+#include "base/bittorrent/torrentcreationmanager.h"
+#include "base/diskspacemonitor.h"
 #include "base/exceptions.h"
+#include "base/global.h"
+#include "base/hookexecutor.h"
 #include "base/iconprovider.h"
 #include "base/logger.h"
 #include "base/net/downloadmanager.h"
 #include "base/net/geoipmanager.h"
 #include "base/net/proxyconfigurationmanager.h"
+#include "base/net/reverseresolution.h"
 #include "base/net/smtp.h"
 #include "base/preferences.h"
 #include "base/profile.h"
@@ -112,6 +120,38 @@ namespace
     const int MIN_FILELOG_SIZE = 1024; // 1KiB
     const int MAX_FILELOG_SIZE = 1000 * 1024 * 1024; // 1000MiB
     const int DEFAULT_FILELOG_SIZE = 65 * 1024; // 65KiB
+
+    // Torrents finishing within this delay share one notification email
+    // (and one external program run in batch mode)
+    const int FINISHED_TORRENTS_BATCH_DELAY = 5000; // 5s
+
+    HookExecutor::Job shellCommandJob(const QString &hookName, const QString &description, const QString &command)
+    {
+        HookExecutor::Job job;
+        job.hookName = hookName;
+        job.description = description;
+#if defined(Q_OS_WIN)
+        std::unique_ptr<wchar_t[]> commandWchar(new wchar_t[command.length() + 1] {});
+        command.toWCharArray(commandWchar.get());
+
+        // Need to split arguments manually because QProcess::start(QString)
+        // will strip off empty parameters.
+        // E.g. `python.exe "1" "" "3"` will become `python.exe "1" "3"`
+        int argCount = 0;
+        LPWSTR *args = ::CommandLineToArgvW(commandWchar.get(), &argCount);
+
+        if (argCount > 0)
+            job.program = QString::fromWCharArray(args[0]);
+        for (int i = 1; i < argCount; ++i)
+            job.arguments += QString::fromWCharArray(args[i]);
+
+        ::LocalFree(args);
+#else
+        job.program = QLatin1String("/bin/sh");
+        job.arguments = QStringList {QLatin1String("-c"), command};
+#endif
+        return job;
+    }
 }
 
 Application::Application(const QString &id, int &argc, char **argv)
@@ -123,9 +163,15 @@ Application::Application(const QString &id, int &argc, char **argv)
 #ifndef DISABLE_WEBUI
     , m_webui(nullptr)
 #endif
+    , m_hookExecutor(new HookExecutor(this))
+    , m_finishedTorrentsTimer(new QTimer(this))
 {
     qRegisterMetaType<Log::Msg>("Log::Msg");
 
+    m_finishedTorrentsTimer->setSingleShot(true);
+    m_finishedTorrentsTimer->setInterval(FINISHED_TORRENTS_BATCH_DELAY);
+    connect(m_finishedTorrentsTimer, &QTimer::timeout, this, &Application::processFinishedTorrents);
+
     setApplicationName("qBittorrent");
     validateCommandLineParameters();
 
@@ -280,7 +326,7 @@ void Application::processMessage(const QString &message)
         m_paramsQueue.append(params);
 }
 
-void Application::runExternalProgram(const BitTorrent::TorrentHandle *torrent) const
+void Application::runExternalProgram(const BitTorrent::TorrentHandle *torrent)
 {
     QString program = Preferences::instance()->getAutoRunProgram().trimmed();
     program.replace("%N", torrent->name());
@@ -313,45 +359,55 @@ void Application::runExternalProgram(const BitTorrent::TorrentHandle *torrent) c
     Logger *logger = Logger::instance();
     logger->addMessage(tr("Torrent: %1, running external program, command: %2").arg(torrent->name(), program));
 
-#if defined(Q_OS_WIN)
-    std::unique_ptr<wchar_t[]> programWchar(new wchar_t[program.length() + 1] {});
-    program.toWCharArray(programWchar.get());
+    m_hookExecutor->setMaxProcesses(Preferences::instance()->getAutoRunMaxProcesses());
+    m_hookExecutor->enqueue(shellCommandJob(tr("torrent finished"), torrent->name(), program));
+}
 
-    // Need to split arguments manually because QProcess::startDetached(QString)
-    // will strip off empty parameters.
-    // E.g. `python.exe "1" "" "3"` will become `python.exe "1" "3"`
-    int argCount = 0;
-    LPWSTR *args = ::CommandLineToArgvW(programWchar.get(), &argCount);
+// In batch mode the program is run as is, without parameter substitution,
+// and it receives a JSON array describing the finished torrents on its standard input
+void Application::runBatchExternalProgram()
+{
+    if (m_finishedTorrentsData.isEmpty()) return;
 
-    QStringList argList;
-    for (int i = 1; i < argCount; ++i)
-        argList += QString::fromWCharArray(args[i]);
+    const QString program = Preferences::instance()->getAutoRunProgram().trimmed();
+    Logger::instance()->addMessage(tr("Running external program for %1 finished torrents, command: %2")
+                                   .arg(m_finishedTorrentsData.size()).arg(program));
 
-    QProcess::startDetached(QString::fromWCharArray(args[0]), argList);
+    HookExecutor::Job job = shellCommandJob(tr("torrents finished (batch mode)")
+        , tr("%1 torrents").arg(m_finishedTorrentsData.size()), program);
+    job.input = QJsonDocument(m_finishedTorrentsData).toJson(QJsonDocument::Compact) + '\n';
+    m_finishedTorrentsData = QJsonArray();
 
-    ::LocalFree(args);
-#else
-    QProcess::startDetached(QLatin1String("/bin/sh"), {QLatin1String("-c"), program});
-#endif
+    m_hookExecutor->setMaxProcesses(Preferences::instance()->getAutoRunMaxProcesses());
+    m_hookExecutor->enqueue(job);
 }
 
-void Application::sendNotificationEmail(const BitTorrent::TorrentHandle *torrent)
+void Application::sendNotificationEmail()
 {
+    if (m_finishedTorrentsReports.isEmpty()) return;
+
     // Prepare mail content
-    const QString content = tr("Torrent name: %1").arg(torrent->name()) + '\n'
-        + tr("Torrent size: %1").arg(Utils::Misc::friendlyUnit(torrent->wantedSize())) + '\n'
-        + tr("Save path: %1").arg(torrent->savePath()) + "\n\n"
-        + tr("The torrent was downloaded in %1.", "The torrent was downloaded in 1 hour and 20 seconds")
-            .arg(Utils::Misc::userFriendlyDuration(torrent->activeTime())) + "\n\n\n"
+    const QString subject = (m_finishedTorrentsReports.size() == 1)
+        ? tr("[qBittorrent] '%1' has finished downloading").arg(m_finishedTorrentsReports[0].first)
+        : tr("[qBittorrent] %1 torrents have finished downloading").arg(m_finishedTorrentsReports.size());
+    QStringList reports;
+    for (const QPair<QString, QString> &report : asConst(m_finishedTorrentsReports))
+        reports << report.second;
+    const QString content = reports.join(QLatin1String("\n\n")) + "\n\n"
         + tr("Thank you for using qBittorrent.") + '\n';
+    m_finishedTorrentsReports.clear();
 
-    // Send the notification email
+    // Send the notification email, the SMTP session is reused while it is open
     const Preferences *pref = Preferences::instance();
-    Net::Smtp *smtp = new Net::Smtp(this);
-    smtp->sendMail(pref->getMailNotificationSender(),
-                     pref->getMailNotificationEmail(),
-                     tr("[qBittorrent] '%1' has finished downloading").arg(torrent->name()),
-                     content);
+    if (!m_smtp || !m_smtp->canSendMail())
+        m_smtp = new Net::Smtp(this);
+    m_smtp->sendMail(pref->getMailNotificationSender(), pref->getMailNotificationEmail(), subject, content);
+}
+
+void Application::processFinishedTorrents()
+{
+    runBatchExternalProgram();
+    sendNotificationEmail();
 }
 
 void Application::torrentFinished(BitTorrent::TorrentHandle *const torrent)
@@ -359,13 +415,41 @@ void Application::torrentFinished(BitTorrent::TorrentHandle *const torrent)
     Preferences *const pref = Preferences::instance();
 
     // AutoRun program
-    if (pref->isAutoRunEnabled())
-        runExternalProgram(torrent);
+    if (pref->isAutoRunEnabled()) {
+        if (pref->isAutoRunBatchModeEnabled()) {
+            QStringList tags = torrent->tags().toList();
+            std::sort(tags.begin(), tags.end(), Utils::String::naturalLessThan<Qt::CaseInsensitive>);
+            m_finishedTorrentsData.append(QJsonObject {
+                {"name", torrent->name()},
+                {"category", torrent->category()},
+                {"tags", QJsonArray::fromStringList(tags)},
+                {"content_path", Utils::Fs::toNativePath(torrent->contentPath())},
+                {"root_path", Utils::Fs::toNativePath(torrent->rootPath())},
+                {"save_path", Utils::Fs::toNativePath(torrent->savePath())},
+                {"num_files", torrent->filesCount()},
+                {"size", torrent->totalSize()},
+                {"tracker", torrent->currentTracker()},
+                {"hash", QString(torrent->hash())}
+            });
+            if (!m_finishedTorrentsTimer->isActive())
+                m_finishedTorrentsTimer->start();
+        }
+        else {
+            runExternalProgram(torrent);
+        }
+    }
 
     // Mail notification
     if (pref->isMailNotificationEnabled()) {
         Logger::instance()->addMessage(tr("Torrent: %1, sending mail notification").arg(torrent->name()));
-        sendNotificationEmail(torrent);
+        const QString report = tr("Torrent name: %1").arg(torrent->name()) + '\n'
+            + tr("Torrent size: %1").arg(Utils::Misc::friendlyUnit(torrent->wantedSize())) + '\n'
+            + tr("Save path: %1").arg(torrent->savePath()) + "\n\n"
+            + tr("The torrent was downloaded in %1.", "The torrent was downloaded in 1 hour and 20 seconds")
+                .arg(Utils::Misc::userFriendlyDuration(torrent->activeTime())) + '\n';
+        m_finishedTorrentsReports.append(qMakePair(torrent->name(), report));
+        if (!m_finishedTorrentsTimer->isActive())
+            m_finishedTorrentsTimer->start();
     }
 }
 
@@ -501,13 +585,16 @@ int Application::exec(const QStringList &params)
 #endif
 
     try {
+        DiskSpaceMonitor::initInstance();
         BitTorrent::Session::initInstance();
         connect(BitTorrent::Session::instance(), &BitTorrent::Session::torrentFinished, this, &Application::torrentFinished);
         connect(BitTorrent::Session::instance(), &BitTorrent::Session::allTorrentsFinished, this, &Application::allTorrentsFinished, Qt::QueuedConnection);
+        BitTorrent::TorrentCreationManager::initInstance();
 
 #ifndef DISABLE_COUNTRIES_RESOLUTION
         Net::GeoIPManager::initInstance();
 #endif
+        Net::ReverseResolution::initInstance();
         ScanFoldersModel::initInstance(this);
 
 #ifndef DISABLE_WEBUI
@@ -691,6 +778,14 @@ void Application::cleanup()
     }
 #endif // DISABLE_GUI
 
+    // The main event loop has already exited, the SMTP session couldn't run anymore
+    m_finishedTorrentsTimer->stop();
+    if (!m_finishedTorrentsReports.isEmpty()) {
+        Logger::instance()->addMessage(tr("The notification email for %1 finished torrents was not sent because qBittorrent is exiting")
+                                       .arg(m_finishedTorrentsReports.size()), Log::WARNING);
+        m_finishedTorrentsReports.clear();
+    }
+
 #ifndef DISABLE_WEBUI
     delete m_webui;
 #endif
@@ -699,7 +794,17 @@ void Application::cleanup()
     delete RSS::Manager::instance();
 
     ScanFoldersModel::freeInstance();
+    BitTorrent::TorrentCreationManager::freeInstance();
     BitTorrent::Session::freeInstance();
+    DiskSpaceMonitor::freeInstance();
+
+    // The batch of the last finished torrents is still handed over to the external program,
+    // the running programs are left running
+    m_finishedTorrentsTimer->stop();
+    runBatchExternalProgram();
+    delete m_hookExecutor;
+    m_hookExecutor = nullptr;
+    Net::ReverseResolution::freeInstance();
 #ifndef DISABLE_COUNTRIES_RESOLUTION
     Net::GeoIPManager::freeInstance();
 #endif
@@ -29,6 +29,9 @@
 
 #pragma once
 
+#include <QJsonArray>
+#include <QList>
+#include <QPair>
 #include <QPointer>
 #include <QStringList>
 #include <QTranslator>
@@ -54,14 +57,22 @@ using BaseApplication = QCoreApplication;
 class WebUI;
 #endif
 
+class QTimer;
+
 class ApplicationInstanceManager;
 class FileLogger;
+class HookExecutor;
 
 namespace BitTorrent
 {
     class TorrentHandle;
 }
 
+namespace Net
+{
+    class Smtp;
+}
+
 namespace RSS
 {
     class Manager;
@@ -113,6 +124,7 @@ protected:
 private slots:
     void processMessage(const QString &message);
     void torrentFinished(BitTorrent::TorrentHandle *const torrent);
+    void processFinishedTorrents();
     void allTorrentsFinished();
     void cleanup();
 #if (!defined(DISABLE_GUI) && defined(Q_OS_WIN))
@@ -140,9 +152,17 @@ private:
     QTranslator m_translator;
     QStringList m_paramsQueue;
 
+    // External programs and notifications of finished torrents
+    HookExecutor *m_hookExecutor;
+    QTimer *m_finishedTorrentsTimer;
+    QJsonArray m_finishedTorrentsData;
+    QList<QPair<QString, QString>> m_finishedTorrentsReports; // torrent name, report
+    QPointer<Net::Smtp> m_smtp;
+
     void initializeTranslation();
     void processParams(const QStringList &params);
-    void runExternalProgram(const BitTorrent::TorrentHandle *torrent) const;
-    void sendNotificationEmail(const BitTorrent::TorrentHandle *torrent);
+    void runExternalProgram(const BitTorrent::TorrentHandle *torrent);
+    void runBatchExternalProgram();
+    void sendNotificationEmail();
     void validateCommandLineParameters();
 };
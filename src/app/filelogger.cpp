@@ -28,23 +28,22 @@
 
 #include "filelogger.h"
 
-#include <QDateTime>
 #include <QDir>
-#include <QFile>
-#include <QTextStream>
+#include <QMetaObject>
+#include <QThread>
 
 #include "base/global.h"
 #include "base/logger.h"
 #include "base/utils/fs.h"
+#include "filelogwriter.h"
 
 FileLogger::FileLogger(const QString &path, const bool backup, const int maxSize, const bool deleteOld, const int age, const FileLogAgeType ageType)
-    : m_backup(backup)
-    , m_maxSize(maxSize)
-    , m_logFile(nullptr)
+    : m_writerThread(new QThread(this))
+    , m_writer(new FileLogWriter(backup, maxSize))
 {
-    m_flusher.setInterval(0);
-    m_flusher.setSingleShot(true);
-    connect(&m_flusher, &QTimer::timeout, this, &FileLogger::flushLog);
+    m_writer->moveToThread(m_writerThread);
+    connect(m_writerThread, &QThread::finished, m_writer, &QObject::deleteLater);
+    m_writerThread->start(QThread::LowPriority);
 
     changePath(path);
     if (deleteOld)
@@ -59,121 +58,43 @@ FileLogger::FileLogger(const QString &path, const bool backup, const int maxSize
 
 FileLogger::~FileLogger()
 {
-    if (!m_logFile) return;
-    closeLogFile();
-    delete m_logFile;
+    // the writer flushes the remaining messages when it gets destroyed
+    m_writerThread->quit();
+    m_writerThread->wait();
 }
 
 void FileLogger::changePath(const QString &newPath)
 {
-    QString tmpPath = Utils::Fs::fromNativePath(newPath);
-    QDir dir(tmpPath);
-    dir.mkpath(tmpPath);
-    tmpPath = dir.absoluteFilePath("qbittorrent.log");
+    const QString tmpPath = QDir(Utils::Fs::fromNativePath(newPath)).absoluteFilePath("qbittorrent.log");
+    if (tmpPath == m_path) return;
 
-    if (tmpPath != m_path) {
-        m_path = tmpPath;
-
-        if (m_logFile) {
-            closeLogFile();
-            delete m_logFile;
-        }
-        m_logFile = new QFile(m_path);
-        openLogFile();
-    }
+    m_path = tmpPath;
+    QMetaObject::invokeMethod(m_writer, "setPath", Qt::QueuedConnection, Q_ARG(QString, m_path));
 }
 
 void FileLogger::deleteOld(const int age, const FileLogAgeType ageType)
 {
-    QDateTime date = QDateTime::currentDateTime();
-    QDir dir(Utils::Fs::branchPath(m_path));
-
-    for (const QFileInfo &file : asConst(dir.entryInfoList(QStringList("qbittorrent.log.bak*"), QDir::Files | QDir::Writable, QDir::Time | QDir::Reversed))) {
-        QDateTime modificationDate = file.lastModified();
-        switch (ageType) {
-        case DAYS:
-            modificationDate = modificationDate.addDays(age);
-            break;
-        case MONTHS:
-            modificationDate = modificationDate.addMonths(age);
-            break;
-        default:
-            modificationDate = modificationDate.addYears(age);
-        }
-        if (modificationDate > date)
-            break;
-        Utils::Fs::forceRemove(file.absoluteFilePath());
-    }
+    QMetaObject::invokeMethod(m_writer, "deleteOld", Qt::QueuedConnection
+                              , Q_ARG(int, age), Q_ARG(int, ageType));
 }
 
 void FileLogger::setBackup(bool value)
 {
-    m_backup = value;
+    QMetaObject::invokeMethod(m_writer, "setBackup", Qt::QueuedConnection, Q_ARG(bool, value));
 }
 
 void FileLogger::setMaxSize(int value)
 {
-    m_maxSize = value;
-}
-
-void FileLogger::addLogMessage(const Log::Msg &msg)
-{
-    if (!m_logFile) return;
-
-    QTextStream str(m_logFile);
-
-    switch (msg.type) {
-    case Log::INFO:
-        str << "(I) ";
-        break;
-    case Log::WARNING:
-        str << "(W) ";
-        break;
-    case Log::CRITICAL:
-        str << "(C) ";
-        break;
-    default:
-        str << "(N) ";
-    }
-
-    str << QDateTime::fromMSecsSinceEpoch(msg.timestamp).toString(Qt::ISODate) << " - " << msg.message << endl;
-
-    if (m_backup && (m_logFile->size() >= m_maxSize)) {
-        closeLogFile();
-        int counter = 0;
-        QString backupLogFilename = m_path + ".bak";
-
-        while (QFile::exists(backupLogFilename)) {
-            ++counter;
-            backupLogFilename = m_path + ".bak" + QString::number(counter);
-        }
-
-        QFile::rename(m_path, backupLogFilename);
-        openLogFile();
-    }
-    else {
-        m_flusher.start();
-    }
-}
-
-void FileLogger::flushLog()
-{
-    if (m_logFile)
-        m_logFile->flush();
+    QMetaObject::invokeMethod(m_writer, "setMaxSize", Qt::QueuedConnection, Q_ARG(int, value));
 }
 
-void FileLogger::openLogFile()
+quint64 FileLogger::droppedMessagesCount() const
 {
-    if (!m_logFile->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)
-        || !m_logFile->setPermissions(QFile::ReadOwner | QFile::WriteOwner)) {
-        delete m_logFile;
-        m_logFile = nullptr;
-        Logger::instance()->addMessage(tr("An error occurred while trying to open the log file. Logging to file is disabled."), Log::CRITICAL);
-    }
+    return m_writer->droppedCount();
 }
 
-void FileLogger::closeLogFile()
+void FileLogger::addLogMessage(const Log::Msg &msg)
 {
-    m_flusher.stop();
-    m_logFile->close();
+    if (!m_writer->enqueue(msg))
+        Logger::instance()->addDroppedMessage();
 }
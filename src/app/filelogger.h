@@ -30,9 +30,9 @@
 #define FILELOGGER_H
 
 #include <QObject>
-#include <QTimer>
 
-class QFile;
+class QThread;
+class FileLogWriter;
 
 namespace Log
 {
@@ -60,19 +60,16 @@ public:
     void setBackup(bool value);
     void setMaxSize(int value);
 
+    // Number of messages discarded because the writer thread couldn't keep up
+    quint64 droppedMessagesCount() const;
+
 private slots:
     void addLogMessage(const Log::Msg &msg);
-    void flushLog();
 
 private:
-    void openLogFile();
-    void closeLogFile();
-
     QString m_path;
-    bool m_backup;
-    int m_maxSize;
-    QFile *m_logFile;
-    QTimer m_flusher;
+    QThread *m_writerThread;
+    FileLogWriter *m_writer;
 };
 
 #endif // FILELOGGER_H
@@ -0,0 +1,254 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "filelogwriter.h"
+
+#include <QtGlobal>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QMetaObject>
+#include <QMutexLocker>
+
+#include "base/global.h"
+#include "base/utils/fs.h"
+#include "filelogger.h"
+
+namespace
+{
+    // the queue can hold the whole in-memory log so the initial dump is never truncated
+    const int MAX_QUEUED_MESSAGES = MAX_LOG_MESSAGES;
+    // upper bound on the amount of log data that can be lost on power failure
+    const qint64 SYNC_INTERVAL = 5000; // msecs
+
+    QByteArray formatMessage(const Log::Msg &msg)
+    {
+        QString prefix;
+        switch (msg.type) {
+        case Log::INFO:
+            prefix = QLatin1String("(I) ");
+            break;
+        case Log::WARNING:
+            prefix = QLatin1String("(W) ");
+            break;
+        case Log::CRITICAL:
+            prefix = QLatin1String("(C) ");
+            break;
+        default:
+            prefix = QLatin1String("(N) ");
+        }
+
+        return (prefix + QDateTime::fromMSecsSinceEpoch(msg.timestamp).toString(Qt::ISODate)
+                + QLatin1String(" - ") + msg.message + QLatin1Char('\n')).toUtf8();
+    }
+}
+
+FileLogWriter::FileLogWriter(const bool backup, const int maxSize)
+    : m_backup(backup)
+    , m_maxSize(maxSize)
+{
+    m_queue.reserve(MAX_QUEUED_MESSAGES);
+    m_lastSyncTimer.start();
+}
+
+FileLogWriter::~FileLogWriter()
+{
+    writePending();
+
+    if (!m_logFile) return;
+    closeLogFile();
+    delete m_logFile;
+}
+
+bool FileLogWriter::enqueue(const Log::Msg &msg)
+{
+    bool wasEmpty = false;
+    {
+        QMutexLocker locker(&m_queueLock);
+        if (m_queue.size() >= MAX_QUEUED_MESSAGES) {
+            ++m_droppedCount;
+            ++m_totalDroppedCount;
+            return false;
+        }
+
+        wasEmpty = m_queue.isEmpty();
+        m_queue.append(msg);
+    }
+
+    // messages that arrive before the writer thread gets to run are written in the same batch
+    if (wasEmpty)
+        QMetaObject::invokeMethod(this, "writePending", Qt::QueuedConnection);
+    return true;
+}
+
+quint64 FileLogWriter::droppedCount() const
+{
+    return m_totalDroppedCount;
+}
+
+void FileLogWriter::setPath(const QString &path)
+{
+    if (path == m_path) return;
+
+    // flush what was queued for the old file first
+    writePending();
+
+    m_path = path;
+    QDir().mkpath(Utils::Fs::branchPath(m_path));
+
+    if (m_logFile) {
+        closeLogFile();
+        delete m_logFile;
+    }
+    m_logFile = new QFile(m_path);
+    openLogFile();
+}
+
+void FileLogWriter::setBackup(const bool value)
+{
+    m_backup = value;
+}
+
+void FileLogWriter::setMaxSize(const int value)
+{
+    m_maxSize = value;
+}
+
+void FileLogWriter::deleteOld(const int age, const int ageType)
+{
+    const QDateTime date = QDateTime::currentDateTime();
+    const QDir dir(Utils::Fs::branchPath(m_path));
+
+    for (const QFileInfo &file : asConst(dir.entryInfoList(QStringList("qbittorrent.log.bak*"), QDir::Files | QDir::Writable, QDir::Time | QDir::Reversed))) {
+        QDateTime modificationDate = file.lastModified();
+        switch (ageType) {
+        case FileLogger::DAYS:
+            modificationDate = modificationDate.addDays(age);
+            break;
+        case FileLogger::MONTHS:
+            modificationDate = modificationDate.addMonths(age);
+            break;
+        default:
+            modificationDate = modificationDate.addYears(age);
+        }
+        if (modificationDate > date)
+            break;
+        Utils::Fs::forceRemove(file.absoluteFilePath());
+    }
+}
+
+void FileLogWriter::writePending()
+{
+    QVector<Log::Msg> batch;
+    {
+        QMutexLocker locker(&m_queueLock);
+        batch.swap(m_queue);
+    }
+
+    if (!m_logFile || batch.isEmpty()) return;
+
+    QByteArray data;
+    bool hasCritical = false;
+    for (const Log::Msg &msg : asConst(batch)) {
+        data += formatMessage(msg);
+        hasCritical = hasCritical || (msg.type == Log::CRITICAL);
+    }
+
+    // the queue was full, so the dropped messages came after this batch
+    const quint64 droppedCount = m_droppedCount.exchange(0);
+    if (droppedCount > 0) {
+        const Log::Msg droppedMsg {-1, QDateTime::currentMSecsSinceEpoch(), Log::WARNING
+            , FileLogger::tr("%1 log messages were not written to the file because it couldn't keep up").arg(droppedCount)};
+        data += formatMessage(droppedMsg);
+    }
+
+    const qint64 written = m_logFile->write(data);
+    if (written > 0)
+        m_fileSize += written;
+    m_logFile->flush();
+
+    if (m_backup && (m_fileSize >= m_maxSize))
+        rotate();
+    else if (hasCritical || m_lastSyncTimer.hasExpired(SYNC_INTERVAL))
+        sync();
+}
+
+void FileLogWriter::openLogFile()
+{
+    if (!m_logFile->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)
+        || !m_logFile->setPermissions(QFile::ReadOwner | QFile::WriteOwner)) {
+        delete m_logFile;
+        m_logFile = nullptr;
+        Logger::instance()->addMessage(FileLogger::tr("An error occurred while trying to open the log file. Logging to file is disabled."), Log::CRITICAL);
+        return;
+    }
+
+    m_fileSize = m_logFile->size();
+}
+
+void FileLogWriter::closeLogFile()
+{
+    sync();
+    m_logFile->close();
+}
+
+void FileLogWriter::rotate()
+{
+    closeLogFile();
+
+    int counter = 0;
+    QString backupLogFilename = m_path + ".bak";
+    while (QFile::exists(backupLogFilename)) {
+        ++counter;
+        backupLogFilename = m_path + ".bak" + QString::number(counter);
+    }
+
+    QFile::rename(m_path, backupLogFilename);
+    openLogFile();
+}
+
+void FileLogWriter::sync()
+{
+    m_lastSyncTimer.restart();
+    if (!m_logFile->isOpen()) return;
+
+    m_logFile->flush();
+#ifdef Q_OS_WIN
+    ::_commit(m_logFile->handle());
+#else
+    ::fsync(m_logFile->handle());
+#endif
+}
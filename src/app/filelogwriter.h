@@ -0,0 +1,86 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <atomic>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+#include "base/logger.h"
+
+class QFile;
+
+// Writes log messages to the log file from a dedicated thread.
+// Messages are enqueued from any thread and written in batches,
+// so slow storage can never block the caller.
+class FileLogWriter : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(FileLogWriter)
+
+public:
+    FileLogWriter(bool backup, int maxSize);
+    ~FileLogWriter() override;
+
+    // Thread-safe. Returns false if the message was dropped because the queue is full,
+    // the number of dropped messages is then written to the file along with the next batch.
+    bool enqueue(const Log::Msg &msg);
+    // Thread-safe. Number of messages dropped since the writer was created
+    quint64 droppedCount() const;
+
+public slots:
+    void setPath(const QString &path);
+    void setBackup(bool value);
+    void setMaxSize(int value);
+    void deleteOld(int age, int ageType);
+    void writePending();
+
+private:
+    void openLogFile();
+    void closeLogFile();
+    void rotate();
+    void sync();
+
+    QString m_path;
+    bool m_backup;
+    int m_maxSize;
+    QFile *m_logFile = nullptr;
+    qint64 m_fileSize = 0;
+    QElapsedTimer m_lastSyncTimer;
+
+    QMutex m_queueLock;
+    QVector<Log::Msg> m_queue;
+    // Dropped since the last batch
+    std::atomic<quint64> m_droppedCount {0};
+    std::atomic<quint64> m_totalDroppedCount {0};
+};
@@ -2,6 +2,7 @@ HEADERS += \
     $$PWD/algorithm.h \
     $$PWD/asyncfilestorage.h \
     $$PWD/bittorrent/addtorrentparams.h  \
+    $$PWD/bittorrent/bandwidthschedule.h \
     $$PWD/bittorrent/cachestatus.h \
     $$PWD/bittorrent/filepriority.h \
     $$PWD/bittorrent/infohash.h \
@@ -14,11 +15,16 @@ HEADERS += \
     $$PWD/bittorrent/private/statistics.h \
     $$PWD/bittorrent/session.h \
     $$PWD/bittorrent/sessionstatus.h \
+    $$PWD/bittorrent/storagejobscheduler.h \
+    $$PWD/bittorrent/torrentcreationmanager.h \
     $$PWD/bittorrent/torrentcreatorthread.h \
     $$PWD/bittorrent/torrenthandle.h \
+    $$PWD/bittorrent/torrentindex.h \
     $$PWD/bittorrent/torrentinfo.h \
     $$PWD/bittorrent/tracker.h \
     $$PWD/bittorrent/trackerentry.h \
+    $$PWD/bittorrent/trackerindex.h \
+    $$PWD/diskspacemonitor.h \
     $$PWD/exceptions.h \
     $$PWD/filesystemwatcher.h \
     $$PWD/global.h \
@@ -30,9 +36,12 @@ HEADERS += \
     $$PWD/http/responsegenerator.h \
     $$PWD/http/server.h \
     $$PWD/http/types.h \
+    $$PWD/hookexecutor.h \
     $$PWD/iconprovider.h \
     $$PWD/indexrange.h \
+    $$PWD/latencyhistogram.h \
     $$PWD/logger.h \
+    $$PWD/net/addressratelimiter.h \
     $$PWD/net/dnsupdater.h \
     $$PWD/net/downloadhandler.h \
     $$PWD/net/downloadmanager.h \
@@ -59,8 +68,11 @@ HEADERS += \
     $$PWD/search/searchhandler.h \
     $$PWD/search/searchdownloadhandler.h \
     $$PWD/search/searchpluginmanager.h \
+    $$PWD/search/searchresultstore.h \
+    $$PWD/search/searchworker.h \
     $$PWD/settingsstorage.h \
     $$PWD/settingvalue.h \
+    $$PWD/timeseries.h \
     $$PWD/torrentfileguard.h \
     $$PWD/torrentfilter.h \
     $$PWD/tristatebool.h \
@@ -80,6 +92,7 @@ HEADERS += \
 
 SOURCES += \
     $$PWD/asyncfilestorage.cpp \
+    $$PWD/bittorrent/bandwidthschedule.cpp \
     $$PWD/bittorrent/filepriority.cpp \
     $$PWD/bittorrent/infohash.cpp \
     $$PWD/bittorrent/magneturi.cpp \
@@ -90,11 +103,16 @@ SOURCES += \
     $$PWD/bittorrent/private/speedmonitor.cpp \
     $$PWD/bittorrent/private/statistics.cpp \
     $$PWD/bittorrent/session.cpp \
+    $$PWD/bittorrent/storagejobscheduler.cpp \
+    $$PWD/bittorrent/torrentcreationmanager.cpp \
     $$PWD/bittorrent/torrentcreatorthread.cpp \
     $$PWD/bittorrent/torrenthandle.cpp \
+    $$PWD/bittorrent/torrentindex.cpp \
     $$PWD/bittorrent/torrentinfo.cpp \
     $$PWD/bittorrent/tracker.cpp \
     $$PWD/bittorrent/trackerentry.cpp \
+    $$PWD/bittorrent/trackerindex.cpp \
+    $$PWD/diskspacemonitor.cpp \
     $$PWD/exceptions.cpp \
     $$PWD/filesystemwatcher.cpp \
     $$PWD/http/connection.cpp \
@@ -103,8 +121,11 @@ SOURCES += \
     $$PWD/http/responsebuilder.cpp \
     $$PWD/http/responsegenerator.cpp \
     $$PWD/http/server.cpp \
+    $$PWD/hookexecutor.cpp \
     $$PWD/iconprovider.cpp \
+    $$PWD/latencyhistogram.cpp \
     $$PWD/logger.cpp \
+    $$PWD/net/addressratelimiter.cpp \
     $$PWD/net/dnsupdater.cpp \
     $$PWD/net/downloadhandler.cpp \
     $$PWD/net/downloadmanager.cpp \
@@ -131,7 +152,10 @@ SOURCES += \
     $$PWD/search/searchdownloadhandler.cpp \
     $$PWD/search/searchhandler.cpp \
     $$PWD/search/searchpluginmanager.cpp \
+    $$PWD/search/searchresultstore.cpp \
+    $$PWD/search/searchworker.cpp \
     $$PWD/settingsstorage.cpp \
+    $$PWD/timeseries.cpp \
     $$PWD/torrentfileguard.cpp \
     $$PWD/torrentfilter.cpp \
     $$PWD/tristatebool.cpp \
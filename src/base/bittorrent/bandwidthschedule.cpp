@@ -0,0 +1,201 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "bandwidthschedule.h"
+
+#include <algorithm>
+
+#include <QDateTime>
+
+using namespace BitTorrent;
+
+namespace
+{
+    const QString TIME_FORMAT = QStringLiteral("HH:mm");
+
+    const char KEY_SCOPE[] = "scope";
+    const char KEY_TARGET[] = "target";
+    const char KEY_DAYS[] = "days";
+    const char KEY_START_TIME[] = "start";
+    const char KEY_END_TIME[] = "end";
+    const char KEY_PRIORITY[] = "priority";
+    const char KEY_DOWNLOAD_LIMIT[] = "dl_limit";
+    const char KEY_UPLOAD_LIMIT[] = "up_limit";
+
+    QString scopeToString(const BandwidthScheduleRule::Scope scope)
+    {
+        switch (scope) {
+        case BandwidthScheduleRule::Scope::Category:
+            return QLatin1String("category");
+        case BandwidthScheduleRule::Scope::Tag:
+            return QLatin1String("tag");
+        default:
+            return QLatin1String("global");
+        }
+    }
+
+    BandwidthScheduleRule::Scope scopeFromString(const QString &str)
+    {
+        if (str == QLatin1String("category"))
+            return BandwidthScheduleRule::Scope::Category;
+        if (str == QLatin1String("tag"))
+            return BandwidthScheduleRule::Scope::Tag;
+        return BandwidthScheduleRule::Scope::Global;
+    }
+
+    bool hasDay(const int days, const QDate &date)
+    {
+        return (days & (1 << (date.dayOfWeek() - 1)));
+    }
+}
+
+bool BandwidthScheduleRule::isActiveAt(const QDateTime &time) const
+{
+    const QDate date = time.date();
+    const QTime timeOfDay = time.time();
+
+    if (startTime == endTime)
+        return hasDay(days, date);
+
+    if (startTime < endTime)
+        return (hasDay(days, date) && (timeOfDay >= startTime) && (timeOfDay < endTime));
+
+    // The window spans midnight
+    return ((hasDay(days, date) && (timeOfDay >= startTime))
+            || (hasDay(days, date.addDays(-1)) && (timeOfDay < endTime)));
+}
+
+bool BandwidthScheduleRule::isSameTarget(const BandwidthScheduleRule &other) const
+{
+    return ((scope == other.scope)
+            && ((scope == Scope::Global) || (target == other.target)));
+}
+
+QVariantMap BandwidthScheduleRule::toMap() const
+{
+    return {
+        {KEY_SCOPE, scopeToString(scope)},
+        {KEY_TARGET, target},
+        {KEY_DAYS, days},
+        {KEY_START_TIME, startTime.toString(TIME_FORMAT)},
+        {KEY_END_TIME, endTime.toString(TIME_FORMAT)},
+        {KEY_PRIORITY, priority},
+        {KEY_DOWNLOAD_LIMIT, downloadLimit},
+        {KEY_UPLOAD_LIMIT, uploadLimit}
+    };
+}
+
+BandwidthScheduleRule BandwidthScheduleRule::fromMap(const QVariantMap &map)
+{
+    BandwidthScheduleRule rule;
+    rule.scope = scopeFromString(map.value(KEY_SCOPE).toString());
+    if (rule.scope != Scope::Global)
+        rule.target = map.value(KEY_TARGET).toString();
+    rule.days = map.value(KEY_DAYS, EVERY_DAY).toInt() & EVERY_DAY;
+
+    const QTime startTime = QTime::fromString(map.value(KEY_START_TIME).toString(), TIME_FORMAT);
+    if (startTime.isValid())
+        rule.startTime = startTime;
+    const QTime endTime = QTime::fromString(map.value(KEY_END_TIME).toString(), TIME_FORMAT);
+    if (endTime.isValid())
+        rule.endTime = endTime;
+
+    rule.priority = map.value(KEY_PRIORITY).toInt();
+    rule.downloadLimit = std::max(0, map.value(KEY_DOWNLOAD_LIMIT).toInt());
+    rule.uploadLimit = std::max(0, map.value(KEY_UPLOAD_LIMIT).toInt());
+    return rule;
+}
+
+BandwidthSchedule::BandwidthSchedule(const QList<BandwidthScheduleRule> &rules)
+    : m_rules(rules)
+{
+}
+
+const QList<BandwidthScheduleRule> &BandwidthSchedule::rules() const
+{
+    return m_rules;
+}
+
+bool BandwidthSchedule::isEmpty() const
+{
+    return m_rules.isEmpty();
+}
+
+QList<BandwidthScheduleRule> BandwidthSchedule::activeRules(const QDateTime &time) const
+{
+    QList<BandwidthScheduleRule> activeRules;
+    for (const BandwidthScheduleRule &rule : m_rules) {
+        if (!rule.isActiveAt(time)) continue;
+
+        const auto sameTargetRule = std::find_if(activeRules.begin(), activeRules.end()
+            , [&rule](const BandwidthScheduleRule &activeRule) { return activeRule.isSameTarget(rule); });
+        if (sameTargetRule == activeRules.end())
+            activeRules << rule;
+        else if (rule.priority > sameTargetRule->priority)
+            *sameTargetRule = rule;
+    }
+
+    return activeRules;
+}
+
+QDateTime BandwidthSchedule::nextTransition(const QDateTime &time) const
+{
+    if (m_rules.isEmpty()) return {};
+
+    // The rules change only at their start and end times of day,
+    // and at midnight since their days are checked there
+    QDateTime nextTime {time.date().addDays(1), QTime(0, 0)};
+    for (const BandwidthScheduleRule &rule : m_rules) {
+        for (const QTime &boundary : {rule.startTime, rule.endTime}) {
+            const QDateTime boundaryTime {time.date(), boundary};
+            if ((boundaryTime > time) && (boundaryTime < nextTime))
+                nextTime = boundaryTime;
+        }
+    }
+
+    return nextTime;
+}
+
+QVariantList BandwidthSchedule::toList() const
+{
+    QVariantList list;
+    list.reserve(m_rules.size());
+    for (const BandwidthScheduleRule &rule : m_rules)
+        list << rule.toMap();
+    return list;
+}
+
+BandwidthSchedule BandwidthSchedule::fromList(const QVariantList &list)
+{
+    QList<BandwidthScheduleRule> rules;
+    rules.reserve(list.size());
+    for (const QVariant &item : list)
+        rules << BandwidthScheduleRule::fromMap(item.toMap());
+    return BandwidthSchedule(rules);
+}
@@ -0,0 +1,99 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QTime>
+#include <QVariantMap>
+
+class QDateTime;
+
+namespace BitTorrent
+{
+    // A weekly time window in which different speed limits apply.
+    // The global rules switch the session to the alternative speed limits,
+    // the category and tag rules cap the rates of each of their torrents.
+    struct BandwidthScheduleRule
+    {
+        enum class Scope
+        {
+            Global,
+            Category,
+            Tag
+        };
+
+        // Flags of the days the window starts on, bit (Qt::DayOfWeek - 1)
+        static const int EVERY_DAY = 0x7F;
+
+        Scope scope = Scope::Global;
+        // Category or tag name
+        QString target;
+        int days = EVERY_DAY;
+        // The window ends on the next day if the end time is before the start time,
+        // it lasts the whole day if they are equal
+        QTime startTime {0, 0};
+        QTime endTime {0, 0};
+        // The rule with the highest priority wins among the active ones of the same target
+        int priority = 0;
+        // In bytes per second, 0 means no limit
+        int downloadLimit = 0;
+        int uploadLimit = 0;
+
+        bool isActiveAt(const QDateTime &time) const;
+        bool isSameTarget(const BandwidthScheduleRule &other) const;
+
+        QVariantMap toMap() const;
+        static BandwidthScheduleRule fromMap(const QVariantMap &map);
+    };
+
+    // Evaluates a list of rules at the given times, it doesn't depend on the clock
+    class BandwidthSchedule
+    {
+    public:
+        BandwidthSchedule() = default;
+        explicit BandwidthSchedule(const QList<BandwidthScheduleRule> &rules);
+
+        const QList<BandwidthScheduleRule> &rules() const;
+        bool isEmpty() const;
+
+        // The active rule of the highest priority for each target
+        QList<BandwidthScheduleRule> activeRules(const QDateTime &time) const;
+        // The first time after the given one the active rules can change at,
+        // invalid if there are no rules
+        QDateTime nextTransition(const QDateTime &time) const;
+
+        QVariantList toList() const;
+        static BandwidthSchedule fromList(const QVariantList &list);
+
+    private:
+        QList<BandwidthScheduleRule> m_rules;
+    };
+}
@@ -29,74 +29,153 @@
 
 #include "bandwidthscheduler.h"
 
-#include <utility>
-
-#include <QDate>
-#include <QTime>
+#include <algorithm>
 
+#include "base/global.h"
 #include "base/preferences.h"
 
-BandwidthScheduler::BandwidthScheduler(QObject *parent)
-    : QObject(parent)
-    , m_lastAlternative(false)
+namespace
 {
-    connect(&m_timer, &QTimer::timeout, this, &BandwidthScheduler::onTimeout);
-}
+    // The system clock can be changed by the user, by a timesync utility or by
+    // a timezone switch, the rules are evaluated again when it drifts further
+    // than this from the monotonic clock
+    const qint64 CLOCK_CHANGE_THRESHOLD = 2000;
 
-void BandwidthScheduler::start()
-{
-    m_lastAlternative = isTimeForAlternative();
-    emit bandwidthLimitRequested(m_lastAlternative);
-
-    // Timeout regularly to accommodate for external system clock changes
-    // eg from the user or from a timesync utility
-    m_timer.start(30000);
-}
-
-bool BandwidthScheduler::isTimeForAlternative() const
-{
-    const Preferences *const pref = Preferences::instance();
+    bool isSameRule(const BitTorrent::BandwidthScheduleRule &left, const BitTorrent::BandwidthScheduleRule &right)
+    {
+        return (left.isSameTarget(right)
+                && (left.downloadLimit == right.downloadLimit)
+                && (left.uploadLimit == right.uploadLimit));
+    }
 
-    QTime start = pref->getSchedulerStartTime();
-    QTime end = pref->getSchedulerEndTime();
-    const QTime now = QTime::currentTime();
-    const int schedulerDays = pref->getSchedulerDays();
-    const int day = QDate::currentDate().dayOfWeek();
-    bool alternative = false;
+    // The single alternative speed window of the preferences,
+    // it's used when no rule is set
+    BitTorrent::BandwidthSchedule legacySchedule()
+    {
+        const Preferences *const pref = Preferences::instance();
 
-    if (start > end) {
-        std::swap(start, end);
-        alternative = true;
-    }
+        BitTorrent::BandwidthScheduleRule rule;
+        rule.startTime = pref->getSchedulerStartTime();
+        rule.endTime = pref->getSchedulerEndTime();
+        // An empty window, not the whole day as for the rules
+        if (rule.startTime == rule.endTime)
+            return {};
 
-    if ((start <= now) && (end >= now)) {
+        const int schedulerDays = pref->getSchedulerDays();
         switch (schedulerDays) {
         case EVERY_DAY:
-            alternative = !alternative;
+            rule.days = BitTorrent::BandwidthScheduleRule::EVERY_DAY;
             break;
         case WEEK_ENDS:
-            if ((day == 6) || (day == 7))
-                alternative = !alternative;
+            rule.days = (1 << (Qt::Saturday - 1)) | (1 << (Qt::Sunday - 1));
             break;
         case WEEK_DAYS:
-            if ((day != 6) && (day != 7))
-                alternative = !alternative;
+            rule.days = BitTorrent::BandwidthScheduleRule::EVERY_DAY
+                    & ~((1 << (Qt::Saturday - 1)) | (1 << (Qt::Sunday - 1)));
             break;
         default:
-            if (day == (schedulerDays - 2))
-                alternative = !alternative;
+            rule.days = 1 << (schedulerDays - MON);
         }
+
+        return BitTorrent::BandwidthSchedule({rule});
     }
+}
 
-    return alternative;
+BandwidthScheduler::BandwidthScheduler(QObject *parent, const Clock &clock)
+    : QObject(parent)
+    , m_clock(clock)
+    , m_isStarted(false)
+    , m_lastAlternative(false)
+    , m_globalDownloadLimit(0)
+    , m_globalUploadLimit(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, [this]() { evaluate(); });
+    connect(Preferences::instance(), &Preferences::changed, this, [this]()
+    {
+        if (m_isStarted && m_schedule.isEmpty())
+            evaluate();
+    });
 }
 
-void BandwidthScheduler::onTimeout()
+void BandwidthScheduler::setSchedule(const BitTorrent::BandwidthSchedule &schedule)
 {
-    bool alternative = isTimeForAlternative();
+    m_schedule = schedule;
+    if (m_isStarted)
+        evaluate();
+}
 
-    if (alternative != m_lastAlternative) {
+void BandwidthScheduler::start()
+{
+    m_isStarted = true;
+    evaluate(true);
+}
+
+QList<BitTorrent::BandwidthScheduleRule> BandwidthScheduler::activeTorrentRules() const
+{
+    return m_activeTorrentRules;
+}
+
+void BandwidthScheduler::checkClockChange()
+{
+    if (!m_isStarted) return;
+
+    const QDateTime now = m_clock();
+    const QDateTime expectedNow = m_lastEvaluationTime.addMSecs(m_sinceLastEvaluation.elapsed());
+    if ((qAbs(expectedNow.msecsTo(now)) > CLOCK_CHANGE_THRESHOLD)
+        || (now.offsetFromUtc() != m_lastEvaluationTime.offsetFromUtc())) {
+        evaluate();
+    }
+}
+
+void BandwidthScheduler::evaluate(const bool force)
+{
+    const QDateTime now = m_clock();
+    m_lastEvaluationTime = now;
+    m_sinceLastEvaluation.start();
+    const BitTorrent::BandwidthSchedule schedule = m_schedule.isEmpty() ? legacySchedule() : m_schedule;
+
+    // activeRules() keeps the global rule of the highest priority only
+    bool alternative = false;
+    int globalDownloadLimit = 0;
+    int globalUploadLimit = 0;
+    QList<BitTorrent::BandwidthScheduleRule> torrentRules;
+    for (const BitTorrent::BandwidthScheduleRule &rule : asConst(schedule.activeRules(now))) {
+        if (rule.scope == BitTorrent::BandwidthScheduleRule::Scope::Global) {
+            alternative = true;
+            globalDownloadLimit = rule.downloadLimit;
+            globalUploadLimit = rule.uploadLimit;
+        }
+        else {
+            torrentRules << rule;
+        }
+    }
+
+    // before switching to the alternative mode, so that it starts with the rule limits
+    if (force || (globalDownloadLimit != m_globalDownloadLimit) || (globalUploadLimit != m_globalUploadLimit)) {
+        m_globalDownloadLimit = globalDownloadLimit;
+        m_globalUploadLimit = globalUploadLimit;
+        emit globalLimitsChanged(globalDownloadLimit, globalUploadLimit);
+    }
+
+    if (force || (alternative != m_lastAlternative)) {
         m_lastAlternative = alternative;
         emit bandwidthLimitRequested(alternative);
     }
+
+    const bool isTorrentRulesChanged = (torrentRules.size() != m_activeTorrentRules.size())
+            || !std::equal(torrentRules.cbegin(), torrentRules.cend(), m_activeTorrentRules.cbegin(), isSameRule);
+    if (isTorrentRulesChanged) {
+        m_activeTorrentRules = torrentRules;
+        emit torrentRulesChanged();
+    }
+
+    // Wake up right at the next boundary instead of polling,
+    // the transitions are at most a week away
+    const QDateTime nextTransition = schedule.nextTransition(now);
+    if (nextTransition.isValid())
+        m_timer.start(static_cast<int>(std::max<qint64>(now.msecsTo(nextTransition), 0)));
+    else
+        m_timer.stop();
 }
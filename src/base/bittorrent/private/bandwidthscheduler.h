@@ -30,27 +30,55 @@
 #ifndef BANDWIDTHSCHEDULER_H
 #define BANDWIDTHSCHEDULER_H
 
+#include <functional>
+
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QTimer>
 
+#include "base/bittorrent/bandwidthschedule.h"
+
 class BandwidthScheduler : public QObject
 {
     Q_OBJECT
     Q_DISABLE_COPY(BandwidthScheduler)
 
 public:
-    explicit BandwidthScheduler(QObject *parent = nullptr);
+    using Clock = std::function<QDateTime ()>;
+
+    explicit BandwidthScheduler(QObject *parent = nullptr, const Clock &clock = &QDateTime::currentDateTime);
+
+    void setSchedule(const BitTorrent::BandwidthSchedule &schedule);
     void start();
 
+    // The category and tag rules active at the last evaluation
+    QList<BitTorrent::BandwidthScheduleRule> activeTorrentRules() const;
+
+    // The timer only wakes up at the transitions, this is meant to be called
+    // from a regular tick so that clock and timezone changes are noticed
+    void checkClockChange();
+
 signals:
     void bandwidthLimitRequested(bool alternative);
+    // The limits of the active global rule, 0 means the alternative limit applies
+    void globalLimitsChanged(int downloadLimit, int uploadLimit);
+    void torrentRulesChanged();
 
 private:
-    bool isTimeForAlternative() const;
-    void onTimeout();
+    void evaluate(bool force = false);
 
+    Clock m_clock;
+    BitTorrent::BandwidthSchedule m_schedule;
     QTimer m_timer;
+    bool m_isStarted;
     bool m_lastAlternative;
+    int m_globalDownloadLimit;
+    int m_globalUploadLimit;
+    // The wall clock is expected to move along with the monotonic one
+    QDateTime m_lastEvaluationTime;
+    QElapsedTimer m_sinceLastEvaluation;
+    QList<BitTorrent::BandwidthScheduleRule> m_activeTorrentRules;
 };
 
 #endif // BANDWIDTHSCHEDULER_H
@@ -29,6 +29,7 @@
 #include "resumedatasavingmanager.h"
 
 #include <QDebug>
+#include <QFile>
 #include <QSaveFile>
 
 #include "base/logger.h"
@@ -39,18 +40,21 @@ ResumeDataSavingManager::ResumeDataSavingManager(const QString &resumeFolderPath
 {
 }
 
-void ResumeDataSavingManager::save(const QString &filename, const QByteArray &data) const
+bool ResumeDataSavingManager::save(const QString &filename, const QByteArray &data) const
 {
     const QString filepath = m_resumeDataDir.absoluteFilePath(filename);
 
     QSaveFile file {filepath};
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(data);
-        if (!file.commit()) {
-            Logger::instance()->addMessage(QString("Couldn't save data in '%1'. Error: %2")
-                                           .arg(filepath, file.errorString()), Log::WARNING);
-        }
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    file.write(data);
+    if (!file.commit()) {
+        Logger::instance()->addMessage(QString("Couldn't save data in '%1'. Error: %2")
+                                       .arg(filepath, file.errorString()), Log::WARNING);
+        return false;
     }
+
+    return true;
 }
 
 void ResumeDataSavingManager::remove(const QString &filename) const
@@ -59,3 +63,39 @@ void ResumeDataSavingManager::remove(const QString &filename) const
 
     Utils::Fs::forceRemove(filepath);
 }
+
+void ResumeDataSavingManager::removeFiles(const QStringList &filenames) const
+{
+    for (const QString &filename : filenames)
+        remove(filename);
+}
+
+void ResumeDataSavingManager::saveTorrentFile(const QString &hash, const QByteArray &data
+    , const QString &exportFolder, const QString &exportName)
+{
+    if (!save(QString("%1.torrent").arg(hash), data)) {
+        emit torrentFileSaveFailed(hash);
+        return;
+    }
+
+    if (!exportFolder.isEmpty())
+        exportTorrentFile(hash, exportFolder, exportName);
+}
+
+void ResumeDataSavingManager::exportTorrentFile(const QString &hash, const QString &exportFolder, const QString &exportName) const
+{
+    const QString torrentPath = m_resumeDataDir.absoluteFilePath(QString("%1.torrent").arg(hash));
+    const QDir exportDir {exportFolder};
+    if (!exportDir.exists() && !exportDir.mkpath(exportDir.absolutePath()))
+        return;
+
+    QString newTorrentPath = exportDir.absoluteFilePath(QString("%1.torrent").arg(exportName));
+    int counter = 0;
+    while (QFile::exists(newTorrentPath) && !Utils::Fs::sameFiles(torrentPath, newTorrentPath)) {
+        // Append number to torrent name to make it unique
+        newTorrentPath = exportDir.absoluteFilePath(QString("%1 %2.torrent").arg(exportName).arg(++counter));
+    }
+
+    if (!QFile::exists(newTorrentPath))
+        QFile::copy(torrentPath, newTorrentPath);
+}
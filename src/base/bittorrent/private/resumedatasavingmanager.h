@@ -31,6 +31,7 @@
 #include <QByteArray>
 #include <QDir>
 #include <QObject>
+#include <QStringList>
 
 class ResumeDataSavingManager : public QObject
 {
@@ -41,8 +42,15 @@ public:
     explicit ResumeDataSavingManager(const QString &resumeFolderPath);
 
 public slots:
-    void save(const QString &filename, const QByteArray &data) const;
+    bool save(const QString &filename, const QByteArray &data) const;
     void remove(const QString &filename) const;
+    void removeFiles(const QStringList &filenames) const;
+    // Saves "<hash>.torrent", then copies it to the export folder unless it is empty
+    void saveTorrentFile(const QString &hash, const QByteArray &data, const QString &exportFolder, const QString &exportName);
+    void exportTorrentFile(const QString &hash, const QString &exportFolder, const QString &exportName) const;
+
+signals:
+    void torrentFileSaveFailed(const QString &hash);
 
 private:
     QDir m_resumeDataDir;
@@ -31,10 +31,11 @@
 
 #include <algorithm>
 #include <cstdlib>
-#include <queue>
+#include <limits>
 #include <string>
 
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QHostAddress>
@@ -58,12 +59,14 @@
 #include <libtorrent/identify_client.hpp>
 #include <libtorrent/ip_filter.hpp>
 #include <libtorrent/magnet_uri.hpp>
+#include <libtorrent/performance_counters.hpp>
 #include <libtorrent/session.hpp>
 #include <libtorrent/session_stats.hpp>
 #include <libtorrent/session_status.hpp>
 #include <libtorrent/torrent_info.hpp>
 
 #include "base/algorithm.h"
+#include "base/diskspacemonitor.h"
 #include "base/exceptions.h"
 #include "base/global.h"
 #include "base/logger.h"
@@ -101,6 +104,11 @@ using NETIO_STATUS = LONG;
 static const char PEER_ID[] = "qB";
 static const char RESUME_FOLDER[] = "BT_backup";
 static const char USER_AGENT[] = "qBittorrent/" QBT_VERSION_2;
+static const int ALERTS_TIME_SLICE = 50; // msecs
+static const int ALERTS_BACKLOG_WARNING_LEVEL = 10000;
+static const char TRANSFER_RATE_HISTORY_FILENAME[] = "transferhistory";
+static const int TRANSFER_RATE_HISTORY_SAVE_INTERVAL = 10 * 60; // secs
+static const int STATUS_UPDATE_TIMEOUT = 5 * 1000; // msecs
 
 namespace libt = libtorrent;
 using namespace BitTorrent;
@@ -259,6 +267,8 @@ Session::Session(QObject *parent)
     , m_announceToAllTiers(BITTORRENT_SESSION_KEY("AnnounceToAllTiers"), true)
     , m_asyncIOThreads(BITTORRENT_SESSION_KEY("AsyncIOThreadsCount"), 4)
     , m_checkingMemUsage(BITTORRENT_SESSION_KEY("CheckingMemUsageSize"), 16)
+    , m_maxActiveStorageJobsPerDevice(BITTORRENT_SESSION_KEY("MaxActiveStorageJobsPerDevice"), 1)
+    , m_diskSpaceReserve(BITTORRENT_SESSION_KEY("DiskSpaceReserve"), 0)
     , m_diskCacheSize(BITTORRENT_SESSION_KEY("DiskCacheSize"), 64)
     , m_diskCacheTTL(BITTORRENT_SESSION_KEY("DiskCacheTTL"), 60)
     , m_useOSCache(BITTORRENT_SESSION_KEY("UseOSCache"), true)
@@ -315,6 +325,7 @@ Session::Session(QObject *parent)
     , m_altGlobalUploadSpeedLimit(BITTORRENT_SESSION_KEY("AlternativeGlobalUPSpeedLimit"), 10, lowerLimited(0))
     , m_isAltGlobalSpeedLimitEnabled(BITTORRENT_SESSION_KEY("UseAlternativeGlobalSpeedLimit"), false)
     , m_isBandwidthSchedulerEnabled(BITTORRENT_SESSION_KEY("BandwidthSchedulerEnabled"), false)
+    , m_bandwidthScheduleRules(BITTORRENT_SESSION_KEY("BandwidthScheduleRules"))
     , m_saveResumeDataInterval(BITTORRENT_SESSION_KEY("SaveResumeDataInterval"), 60)
     , m_port(BITTORRENT_SESSION_KEY("Port"), 8999)
     , m_useRandomPort(BITTORRENT_SESSION_KEY("UseRandomPort"), false)
@@ -331,6 +342,7 @@ Session::Session(QObject *parent)
         , clampValue(SeedChokingAlgorithm::RoundRobin, SeedChokingAlgorithm::AntiLeech))
     , m_storedCategories(BITTORRENT_SESSION_KEY("Categories"))
     , m_storedTags(BITTORRENT_SESSION_KEY("Tags"))
+    , m_storedLowDiskSpacePausedTorrents(BITTORRENT_SESSION_KEY("LowDiskSpacePausedTorrents"))
     , m_maxRatioAction(BITTORRENT_SESSION_KEY("MaxRatioAction"), Pause)
     , m_defaultSavePath(BITTORRENT_SESSION_KEY("DefaultSavePath"), specialFolderLocation(SpecialFolder::Downloads), normalizePath)
     , m_tempPath(BITTORRENT_SESSION_KEY("TempPath"), defaultSavePath() + "temp/", normalizePath)
@@ -353,8 +365,21 @@ Session::Session(QObject *parent)
     , m_wasPexEnabled(m_isPeXEnabled)
     , m_numResumeData(0)
     , m_extraLimit(0)
+    , m_scheduledGlobalDownloadLimit(0)
+    , m_scheduledGlobalUploadLimit(0)
     , m_useProxy(false)
+    , m_torrentsBatchDepth(0)
+    , m_isTorrentsQueueChanged(false)
     , m_recentErroredTorrentsTimer(new QTimer(this))
+    , m_pendingAlertsPosition(0)
+    , m_lastAlertsCount(0)
+    , m_alertsHighWaterMark(0)
+    , m_alertsWarningLevel(ALERTS_BACKLOG_WARNING_LEVEL)
+    , m_alertTypeStatistics(libt::num_alert_types)
+    , m_syncNativeCallsCount(0)
+    // about 45 minutes of samples (at the default refresh interval), a day of minutes and a month of hours
+    , m_transferRateHistory(TransferRateChannelsCount, {{1800, 1440, 720}})
+    , m_transferRateHistorySaveTime(0)
 {
     Logger *const logger = Logger::instance();
 
@@ -364,8 +389,9 @@ Session::Session(QObject *parent)
     m_recentErroredTorrentsTimer->setInterval(1000);
     connect(m_recentErroredTorrentsTimer, &QTimer::timeout, this, [this]() { m_recentErroredTorrents.clear(); });
 
+    m_shareLimitsClock.start();
     m_seedingLimitTimer = new QTimer(this);
-    m_seedingLimitTimer->setInterval(10000);
+    m_seedingLimitTimer->setSingleShot(true);
     connect(m_seedingLimitTimer, &QTimer::timeout, this, &Session::processShareLimits);
 
     // Set severity level of libtorrent session
@@ -455,6 +481,12 @@ Session::Session(QObject *parent)
 
     m_tags = QSet<QString>::fromList(m_storedTags.value());
 
+    // These torrents are saved as paused, they are resumed once there is enough space again
+    if (diskSpaceReserve() > 0) {
+        for (const QString &hash : asConst(m_storedLowDiskSpacePausedTorrents.value()))
+            m_lowDiskSpacePausedTorrents.insert(hash);
+    }
+
     m_refreshTimer = new QTimer(this);
     m_refreshTimer->setInterval(refreshInterval());
     connect(m_refreshTimer, &QTimer::timeout, this, &Session::refresh);
@@ -462,7 +494,6 @@ Session::Session(QObject *parent)
 
     m_statistics = new Statistics(this);
 
-    updateSeedingLimitTimer();
     populateAdditionalTrackers();
 
     enableTracker(isTrackerEnabled());
@@ -476,12 +507,27 @@ Session::Session(QObject *parent)
     connect(&m_networkManager, &QNetworkConfigurationManager::configurationRemoved, this, &Session::networkConfigurationChange);
     connect(&m_networkManager, &QNetworkConfigurationManager::configurationChanged, this, &Session::networkConfigurationChange);
 
+    m_storageJobScheduler = new StorageJobScheduler(this);
+    m_storageJobScheduler->setMaxJobsPerDevice(maxActiveStorageJobsPerDevice());
+    connect(m_storageJobScheduler, &StorageJobScheduler::jobStarted, this, &Session::handleStorageJobStarted);
+
+    connect(DiskSpaceMonitor::instance(), &DiskSpaceMonitor::lowDiskSpace, this, &Session::handleLowDiskSpace);
+    // Unlike diskSpaceRecovered(), it's also emitted for the first value of a path,
+    // which resumes the torrents held back in the previous session
+    connect(DiskSpaceMonitor::instance(), &DiskSpaceMonitor::freeSpaceChanged, this, &Session::handleFreeSpaceChanged);
+    connect(DiskSpaceMonitor::instance(), &DiskSpaceMonitor::deviceResolved, this, &Session::handleDiskSpaceDeviceResolved);
+
     m_ioThread = new QThread(this);
     m_resumeDataSavingManager = new ResumeDataSavingManager {m_resumeFolderPath};
     m_resumeDataSavingManager->moveToThread(m_ioThread);
     connect(m_ioThread, &QThread::finished, m_resumeDataSavingManager, &QObject::deleteLater);
+    connect(m_resumeDataSavingManager, &ResumeDataSavingManager::torrentFileSaveFailed
+            , this, &Session::handleTorrentFileSaveFailed);
     m_ioThread->start();
 
+    m_transferRateHistory.setSampleInterval(refreshInterval());
+    loadTransferRateHistory();
+
     // Regular saving of fastresume data
     m_resumeDataTimer = new QTimer(this);
     connect(m_resumeDataTimer, &QTimer::timeout, this, [this]() { generateResumeData(); });
@@ -583,6 +629,10 @@ void Session::setRefreshInterval(uint value)
     if (value != refreshInterval()) {
         m_refreshTimer->setInterval(value);
         m_refreshInterval = value;
+
+        m_transferRateHistory.setSampleInterval(value);
+        for (TimeSeries &history : m_torrentTransferRateHistory)
+            history.setSampleInterval(value);
     }
 }
 
@@ -905,7 +955,7 @@ void Session::setGlobalMaxRatio(qreal ratio)
 
     if (ratio != globalMaxRatio()) {
         m_globalMaxRatio = ratio;
-        updateSeedingLimitTimer();
+        recheckAllShareLimits();
     }
 }
 
@@ -921,7 +971,7 @@ void Session::setGlobalMaxSeedingMinutes(int minutes)
 
     if (minutes != globalMaxSeedingMinutes()) {
         m_globalMaxSeedingMinutes = minutes;
-        updateSeedingLimitTimer();
+        recheckAllShareLimits();
     }
 }
 
@@ -930,6 +980,7 @@ Session::~Session()
 {
     // Do some BT related saving
     saveResumeData();
+    saveTransferRateHistory();
 
     // We must delete FilterParserThread
     // before we delete libtorrent::session
@@ -1033,12 +1084,23 @@ void Session::adjustLimits(libt::settings_pack &settingsPack)
 void Session::applyBandwidthLimits(libtorrent::settings_pack &settingsPack)
 {
     const bool altSpeedLimitEnabled = isAltGlobalSpeedLimitEnabled();
-    settingsPack.set_int(libt::settings_pack::download_rate_limit, altSpeedLimitEnabled ? altGlobalDownloadSpeedLimit() : globalDownloadSpeedLimit());
-    settingsPack.set_int(libt::settings_pack::upload_rate_limit, altSpeedLimitEnabled ? altGlobalUploadSpeedLimit() : globalUploadSpeedLimit());
+    // A global rule of the scheduler can bring its own limits instead of the alternative ones
+    const int altDownloadLimit = (m_scheduledGlobalDownloadLimit > 0) ? m_scheduledGlobalDownloadLimit : altGlobalDownloadSpeedLimit();
+    const int altUploadLimit = (m_scheduledGlobalUploadLimit > 0) ? m_scheduledGlobalUploadLimit : altGlobalUploadSpeedLimit();
+    settingsPack.set_int(libt::settings_pack::download_rate_limit, altSpeedLimitEnabled ? altDownloadLimit : globalDownloadSpeedLimit());
+    settingsPack.set_int(libt::settings_pack::upload_rate_limit, altSpeedLimitEnabled ? altUploadLimit : globalUploadSpeedLimit());
 }
 
 void Session::initMetrics()
 {
+    const std::vector<libt::stats_metric> nativeMetrics = libt::session_stats_metrics();
+    m_metrics.reserve(static_cast<int>(nativeMetrics.size()));
+    for (const libt::stats_metric &nativeMetric : nativeMetrics) {
+        m_metrics.append({QString::fromLatin1(nativeMetric.name), nativeMetric.value_index
+                          , (nativeMetric.type == libt::stats_metric::type_gauge)});
+    }
+    m_metricValues.fill(0, libt::counters::num_counters);
+
     m_metricIndices.net.hasIncomingConnections = libt::find_metric_idx("net.has_incoming_connections");
     Q_ASSERT(m_metricIndices.net.hasIncomingConnections >= 0);
 
@@ -1468,12 +1530,167 @@ void Session::enableBandwidthScheduler()
 {
     if (!m_bwScheduler) {
         m_bwScheduler = new BandwidthScheduler(this);
+        connect(m_bwScheduler.data(), &BandwidthScheduler::globalLimitsChanged
+                , this, &Session::setScheduledGlobalLimits);
         connect(m_bwScheduler.data(), &BandwidthScheduler::bandwidthLimitRequested
                 , this, &Session::setAltGlobalSpeedLimitEnabled);
+        connect(m_bwScheduler.data(), &BandwidthScheduler::torrentRulesChanged
+                , this, [this]() { updateScheduledTorrentLimits(); });
+        m_bwScheduler->setSchedule(bandwidthSchedule());
     }
     m_bwScheduler->start();
 }
 
+void Session::setScheduledGlobalLimits(const int downloadLimit, const int uploadLimit)
+{
+    if ((downloadLimit == m_scheduledGlobalDownloadLimit) && (uploadLimit == m_scheduledGlobalUploadLimit))
+        return;
+
+    m_scheduledGlobalDownloadLimit = downloadLimit;
+    m_scheduledGlobalUploadLimit = uploadLimit;
+    if (isAltGlobalSpeedLimitEnabled())
+        applyBandwidthLimits();
+}
+
+void Session::updateScheduledTorrentLimits()
+{
+    QSet<InfoHash> torrents;
+    if (m_bwScheduler) {
+        for (const BandwidthScheduleRule &rule : asConst(m_bwScheduler->activeTorrentRules())) {
+            if (rule.scope == BandwidthScheduleRule::Scope::Category)
+                torrents += m_torrentIndex.categoryTorrents(rule.target, isSubcategoriesEnabled());
+            else
+                torrents += m_torrentIndex.tagTorrents(rule.target);
+        }
+    }
+
+    // The torrents which were capped before are updated too to release them
+    const QSet<InfoHash> affectedTorrents = torrents + m_scheduledLimitsTorrents;
+    m_scheduledLimitsTorrents.clear();
+    for (const InfoHash &hash : affectedTorrents)
+        updateScheduledTorrentLimits(m_torrents.value(hash));
+}
+
+void Session::updateScheduledTorrentLimits(TorrentHandle *const torrent)
+{
+    if (!torrent) return;
+
+    // The lowest limit wins when several rules apply to the torrent
+    const auto combineLimits = [](const int left, const int right)
+    {
+        return ((left > 0) && (right > 0)) ? std::min(left, right) : std::max(left, right);
+    };
+
+    int downloadLimit = 0;
+    int uploadLimit = 0;
+    if (m_bwScheduler) {
+        for (const BandwidthScheduleRule &rule : asConst(m_bwScheduler->activeTorrentRules())) {
+            const bool matches = (rule.scope == BandwidthScheduleRule::Scope::Category)
+                    ? torrent->belongsToCategory(rule.target)
+                    : torrent->hasTag(rule.target);
+            if (!matches) continue;
+
+            downloadLimit = combineLimits(downloadLimit, rule.downloadLimit);
+            uploadLimit = combineLimits(uploadLimit, rule.uploadLimit);
+        }
+    }
+
+    if ((downloadLimit > 0) || (uploadLimit > 0))
+        m_scheduledLimitsTorrents.insert(torrent->hash());
+    else
+        m_scheduledLimitsTorrents.remove(torrent->hash());
+    torrent->setScheduledLimits(downloadLimit, uploadLimit);
+}
+
+void Session::watchDiskSpace(TorrentHandle *const torrent)
+{
+    if (diskSpaceReserve() <= 0) return;
+
+    const QString savePath = Utils::Fs::expandPathAbs(torrent->savePath(true));
+    const auto deviceIt = m_diskSpaceSavePathDevices.constFind(savePath);
+    if (deviceIt == m_diskSpaceSavePathDevices.cend()) {
+        // The torrent keeps its current watch until the device is known
+        m_diskSpacePendingTorrents.insert(torrent->hash(), savePath);
+        DiskSpaceMonitor::instance()->resolveDevice(savePath);
+        return;
+    }
+
+    // It's copied since unwatching the previous path may drop the cached devices
+    const QString device = deviceIt.value();
+    m_diskSpacePendingTorrents.remove(torrent->hash());
+    watchDiskSpace(torrent, savePath, device);
+}
+
+void Session::watchDiskSpace(TorrentHandle *const torrent, const QString &savePath, const QString &device)
+{
+    // A single path is watched per device, so the torrents saved in different folders
+    // of a disk are paused and resumed together and the disk is queried once
+    const QString watchedPath = device.isEmpty() ? savePath : m_diskSpaceDevicePaths.value(device, savePath);
+    if (m_diskSpaceWatchedPaths.value(torrent->hash()) == watchedPath) return;
+
+    unwatchDiskSpace(torrent->hash());
+    if (!device.isEmpty())
+        m_diskSpaceDevicePaths.insert(device, watchedPath);
+    m_diskSpaceWatchedPaths.insert(torrent->hash(), watchedPath);
+    DiskSpaceMonitor *const monitor = DiskSpaceMonitor::instance();
+    monitor->watchPath(watchedPath);
+    monitor->setReserve(watchedPath, (static_cast<qint64>(diskSpaceReserve()) * 1024 * 1024));
+
+    // A torrent moved to or added on a disk that is already low on space isn't started
+    if (monitor->isLowOnSpace(watchedPath) && !torrent->isPaused() && !torrent->isSeed()
+            && !m_lowDiskSpacePausedTorrents.contains(torrent->hash())) {
+        torrent->pause();
+        m_lowDiskSpacePausedTorrents.insert(torrent->hash());
+        storeLowDiskSpacePausedTorrents();
+    }
+    // A torrent held back in the previous session, or moved to another disk,
+    // is resumed if the free space of its disk is already known to be enough
+    else if (m_lowDiskSpacePausedTorrents.contains(torrent->hash())
+             && (monitor->freeSpace(watchedPath) >= 0) && !monitor->isLowOnSpace(watchedPath)) {
+        m_lowDiskSpacePausedTorrents.remove(torrent->hash());
+        storeLowDiskSpacePausedTorrents();
+        if (torrent->isPaused())
+            torrent->resume();
+    }
+}
+
+void Session::unwatchDiskSpace(const InfoHash &hash)
+{
+    const QString watchedPath = m_diskSpaceWatchedPaths.take(hash);
+    if (watchedPath.isEmpty()) return;
+
+    DiskSpaceMonitor *const monitor = DiskSpaceMonitor::instance();
+    monitor->unwatchPath(watchedPath);
+    if (monitor->isWatched(watchedPath)) return;
+
+    QString device;
+    for (auto it = m_diskSpaceDevicePaths.begin(); it != m_diskSpaceDevicePaths.end();) {
+        if (it.value() == watchedPath) {
+            device = it.key();
+            it = m_diskSpaceDevicePaths.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // The save paths of an unwatched device are resolved again, e.g. after it was remounted
+    for (auto it = m_diskSpaceSavePathDevices.begin(); it != m_diskSpaceSavePathDevices.end();) {
+        if ((it.key() == watchedPath) || (!device.isEmpty() && (it.value() == device)))
+            it = m_diskSpaceSavePathDevices.erase(it);
+        else
+            ++it;
+    }
+}
+
+void Session::storeLowDiskSpacePausedTorrents()
+{
+    QStringList hashes;
+    for (const InfoHash &hash : asConst(m_lowDiskSpacePausedTorrents))
+        hashes << hash;
+    m_storedLowDiskSpacePausedTorrents = hashes;
+}
+
 void Session::populateAdditionalTrackers()
 {
     m_additionalTrackerList.clear();
@@ -1488,58 +1705,126 @@ void Session::processShareLimits()
 {
     qDebug("Processing share limits...");
 
-    for (TorrentHandle *const torrent : asConst(torrents())) {
-        if (torrent->isSeed() && !torrent->isForced()) {
-            if (torrent->ratioLimit() != TorrentHandle::NO_RATIO_LIMIT) {
-                const qreal ratio = torrent->realRatio();
-                qreal ratioLimit = torrent->ratioLimit();
-                if (ratioLimit == TorrentHandle::USE_GLOBAL_RATIO)
-                    // If Global Max Ratio is really set...
-                    ratioLimit = globalMaxRatio();
-
-                if (ratioLimit >= 0) {
-                    qDebug("Ratio: %f (limit: %f)", ratio, ratioLimit);
-
-                    if ((ratio <= TorrentHandle::MAX_RATIO) && (ratio >= ratioLimit)) {
-                        Logger *const logger = Logger::instance();
-                        if (m_maxRatioAction == Remove) {
-                            logger->addMessage(tr("'%1' reached the maximum ratio you set. Removed.").arg(torrent->name()));
-                            deleteTorrent(torrent->hash());
-                        }
-                        else if (!torrent->isPaused()) {
-                            torrent->pause();
-                            logger->addMessage(tr("'%1' reached the maximum ratio you set. Paused.").arg(torrent->name()));
-                        }
-                        continue;
-                    }
-                }
+    // Collect the due entries first since processing may remove torrents
+    // or reschedule them, both of which modify the queue
+    const qint64 now = m_shareLimitsClock.elapsed();
+    QVector<InfoHash> dueTorrents;
+    while (!m_shareLimitsQueue.empty() && (m_shareLimitsQueue.begin()->first <= now)) {
+        const InfoHash hash = m_shareLimitsQueue.begin()->second;
+        m_shareLimitsQueueIndex.remove(hash);
+        m_shareLimitsQueue.erase(m_shareLimitsQueue.begin());
+        dueTorrents.append(hash);
+    }
+
+    for (const InfoHash &hash : asConst(dueTorrents)) {
+        TorrentHandle *const torrent = m_torrents.value(hash);
+        if (torrent && !checkShareLimits(torrent))
+            updateSeedingTimeDeadline(torrent);
+    }
+
+    updateSeedingLimitTimer();
+}
+
+// Returns true if the torrent has reached one of its limits
+// (it may have been deleted in this case)
+bool Session::checkShareLimits(TorrentHandle *const torrent)
+{
+    if (!torrent->isSeed() || torrent->isForced())
+        return false;
+
+    const qreal ratioLimit = torrent->maxRatio();
+    if (ratioLimit >= 0) {
+        const qreal ratio = torrent->realRatio();
+        qDebug("Ratio: %f (limit: %f)", ratio, ratioLimit);
+
+        if ((ratio <= TorrentHandle::MAX_RATIO) && (ratio >= ratioLimit)) {
+            Logger *const logger = Logger::instance();
+            if (m_maxRatioAction == Remove) {
+                logger->addMessage(tr("'%1' reached the maximum ratio you set. Removed.").arg(torrent->name()));
+                deleteTorrent(torrent->hash());
             }
+            else if (!torrent->isPaused()) {
+                torrent->pause();
+                logger->addMessage(tr("'%1' reached the maximum ratio you set. Paused.").arg(torrent->name()));
+            }
+            return true;
+        }
+    }
 
-            if (torrent->seedingTimeLimit() != TorrentHandle::NO_SEEDING_TIME_LIMIT) {
-                const int seedingTimeInMinutes = torrent->seedingTime() / 60;
-                int seedingTimeLimit = torrent->seedingTimeLimit();
-                if (seedingTimeLimit == TorrentHandle::USE_GLOBAL_SEEDING_TIME)
-                     // If Global Seeding Time Limit is really set...
-                    seedingTimeLimit = globalMaxSeedingMinutes();
-
-                if (seedingTimeLimit >= 0) {
-                    qDebug("Seeding Time: %d (limit: %d)", seedingTimeInMinutes, seedingTimeLimit);
-
-                    if ((seedingTimeInMinutes <= TorrentHandle::MAX_SEEDING_TIME) && (seedingTimeInMinutes >= seedingTimeLimit)) {
-                        Logger *const logger = Logger::instance();
-                        if (m_maxRatioAction == Remove) {
-                            logger->addMessage(tr("'%1' reached the maximum seeding time you set. Removed.").arg(torrent->name()));
-                            deleteTorrent(torrent->hash());
-                        }
-                        else if (!torrent->isPaused()) {
-                            torrent->pause();
-                            logger->addMessage(tr("'%1' reached the maximum seeding time you set. Paused.").arg(torrent->name()));
-                        }
-                    }
-                }
+    const int seedingTimeLimit = torrent->maxSeedingTime();
+    if (seedingTimeLimit >= 0) {
+        const int seedingTimeInMinutes = torrent->seedingTime() / 60;
+        qDebug("Seeding Time: %d (limit: %d)", seedingTimeInMinutes, seedingTimeLimit);
+
+        if ((seedingTimeInMinutes <= TorrentHandle::MAX_SEEDING_TIME) && (seedingTimeInMinutes >= seedingTimeLimit)) {
+            Logger *const logger = Logger::instance();
+            if (m_maxRatioAction == Remove) {
+                logger->addMessage(tr("'%1' reached the maximum seeding time you set. Removed.").arg(torrent->name()));
+                deleteTorrent(torrent->hash());
             }
+            else if (!torrent->isPaused()) {
+                torrent->pause();
+                logger->addMessage(tr("'%1' reached the maximum seeding time you set. Paused.").arg(torrent->name()));
+            }
+            return true;
         }
     }
+
+    return false;
+}
+
+// Seeding time only advances while the torrent is actively seeding,
+// so paused torrents don't need to be tracked until they are resumed
+bool Session::hasSeedingTimeDeadline(const TorrentHandle *torrent) const
+{
+    return (torrent->isSeed() && !torrent->isPaused() && !torrent->isForced()
+            && (torrent->maxSeedingTime() >= 0));
+}
+
+void Session::enqueueShareLimitsCheck(const InfoHash &hash, const qint64 deadline)
+{
+    const auto indexIter = m_shareLimitsQueueIndex.find(hash);
+    if (indexIter != m_shareLimitsQueueIndex.end()) {
+        if (indexIter.value()->first <= deadline)
+            return;
+        m_shareLimitsQueue.erase(indexIter.value());
+    }
+
+    m_shareLimitsQueueIndex[hash] = m_shareLimitsQueue.emplace(deadline, hash);
+}
+
+void Session::dequeueShareLimitsCheck(const InfoHash &hash)
+{
+    const auto indexIter = m_shareLimitsQueueIndex.find(hash);
+    if (indexIter == m_shareLimitsQueueIndex.end())
+        return;
+
+    m_shareLimitsQueue.erase(indexIter.value());
+    m_shareLimitsQueueIndex.erase(indexIter);
+}
+
+void Session::updateSeedingTimeDeadline(TorrentHandle *const torrent)
+{
+    dequeueShareLimitsCheck(torrent->hash());
+    if (!hasSeedingTimeDeadline(torrent))
+        return;
+
+    // The cached seeding time lags behind by up to one refresh interval,
+    // so never schedule the next check sooner than that
+    const qint64 remainingSecs = (static_cast<qint64>(torrent->maxSeedingTime()) * 60) - torrent->seedingTime();
+    const qint64 delay = std::max<qint64>(remainingSecs * 1000, refreshInterval());
+    enqueueShareLimitsCheck(torrent->hash(), (m_shareLimitsClock.elapsed() + delay));
+}
+
+void Session::recheckAllShareLimits()
+{
+    const qint64 now = m_shareLimitsClock.elapsed();
+    for (const TorrentHandle *torrent : asConst(m_torrents)) {
+        if (torrent->isSeed())
+            enqueueShareLimitsCheck(torrent->hash(), now);
+    }
+
+    updateSeedingLimitTimer();
 }
 
 void Session::handleDownloadFailed(const QString &url, const QString &reason)
@@ -1612,52 +1897,80 @@ void Session::banIP(const QString &ip)
 // deleteLocalFiles = true means that the torrent will be removed from the hard-drive too
 bool Session::deleteTorrent(const QString &hash, bool deleteLocalFiles)
 {
-    TorrentHandle *const torrent = m_torrents.take(hash);
-    if (!torrent) return false;
+    return (deleteTorrents({hash}, deleteLocalFiles) > 0);
+}
+
+int Session::deleteTorrents(const QStringList &hashes, bool deleteLocalFiles)
+{
+    QVector<TorrentHandle *> torrents;
+    torrents.reserve(hashes.size());
+    for (const InfoHash hash : hashes) {
+        TorrentHandle *const torrent = m_torrents.take(hash);
+        if (torrent) {
+            m_torrentIndex.removeTorrent(torrent);
+            m_trackerIndex.removeTorrent(torrent->hash());
+            m_storageJobScheduler->removeJobs(torrent->hash());
+            m_scheduledLimitsTorrents.remove(torrent->hash());
+            unwatchDiskSpace(torrent->hash());
+            m_diskSpacePendingTorrents.remove(torrent->hash());
+            if (m_lowDiskSpacePausedTorrents.remove(torrent->hash()))
+                storeLowDiskSpacePausedTorrents();
+            torrents << torrent;
+        }
+    }
+    if (torrents.isEmpty()) return 0;
 
-    qDebug("Deleting torrent with hash: %s", qUtf8Printable(torrent->hash()));
-    emit torrentAboutToBeRemoved(torrent);
+    emit torrentsAboutToBeRemoved(torrents);
 
-    // Remove it from session
-    if (deleteLocalFiles) {
-        QString rootPath = torrent->rootPath(true);
-        if (!rootPath.isEmpty())
-            // torrent with root folder
-            m_removingTorrents[torrent->hash()] = {torrent->name(), rootPath, deleteLocalFiles};
-        else if (torrent->useTempPath())
-            // torrent without root folder still has it in its temporary save path
-            m_removingTorrents[torrent->hash()] = {torrent->name(), torrent->savePath(true), deleteLocalFiles};
-        else
-            m_removingTorrents[torrent->hash()] = {torrent->name(), "", deleteLocalFiles};
-        m_nativeSession->remove_torrent(torrent->nativeHandle(), libt::session::delete_files);
-    }
-    else {
-        m_removingTorrents[torrent->hash()] = {torrent->name(), "", deleteLocalFiles};
-        QStringList unwantedFiles;
-        if (torrent->hasMetadata())
-            unwantedFiles = torrent->absoluteFilePathsUnwanted();
-        m_nativeSession->remove_torrent(torrent->nativeHandle(), libt::session::delete_partfile);
-        // Remove unwanted and incomplete files
-        for (const QString &unwantedFile : asConst(unwantedFiles)) {
-            qDebug("Removing unwanted file: %s", qUtf8Printable(unwantedFile));
-            Utils::Fs::forceRemove(unwantedFile);
-            const QString parentFolder = Utils::Fs::branchPath(unwantedFile);
-            qDebug("Attempt to remove parent folder (if empty): %s", qUtf8Printable(parentFolder));
-            QDir().rmpath(parentFolder);
+    // The resume data files have known names, they are removed
+    // on the I/O thread after any pending write of them
+    QStringList resumeDataFiles;
+    resumeDataFiles.reserve(torrents.size() * 2);
+
+    for (TorrentHandle *const torrent : asConst(torrents)) {
+        const InfoHash hash = torrent->hash();
+        dequeueShareLimitsCheck(hash);
+        m_torrentTransferRateHistory.remove(hash);
+
+        qDebug("Deleting torrent with hash: %s", qUtf8Printable(hash));
+
+        // Remove it from session
+        if (deleteLocalFiles) {
+            QString rootPath = torrent->rootPath(true);
+            if (!rootPath.isEmpty())
+                // torrent with root folder
+                m_removingTorrents[hash] = {torrent->name(), rootPath, deleteLocalFiles};
+            else if (torrent->useTempPath())
+                // torrent without root folder still has it in its temporary save path
+                m_removingTorrents[hash] = {torrent->name(), torrent->savePath(true), deleteLocalFiles};
+            else
+                m_removingTorrents[hash] = {torrent->name(), "", deleteLocalFiles};
+            m_nativeSession->remove_torrent(torrent->nativeHandle(), libt::session::delete_files);
         }
+        else {
+            m_removingTorrents[hash] = {torrent->name(), "", deleteLocalFiles};
+            QStringList unwantedFiles;
+            if (torrent->hasMetadata())
+                unwantedFiles = torrent->absoluteFilePathsUnwanted();
+            m_nativeSession->remove_torrent(torrent->nativeHandle(), libt::session::delete_partfile);
+            // Remove unwanted and incomplete files
+            for (const QString &unwantedFile : asConst(unwantedFiles)) {
+                qDebug("Removing unwanted file: %s", qUtf8Printable(unwantedFile));
+                Utils::Fs::forceRemove(unwantedFile);
+                const QString parentFolder = Utils::Fs::branchPath(unwantedFile);
+                qDebug("Attempt to remove parent folder (if empty): %s", qUtf8Printable(parentFolder));
+                QDir().rmpath(parentFolder);
+            }
+        }
+
+        resumeDataFiles << QString("%1.fastresume").arg(hash) << QString("%1.torrent").arg(hash);
+        delete torrent;
     }
 
-    // Remove it from torrent resume directory
-    QDir resumeDataDir(m_resumeFolderPath);
-    QStringList filters;
-    filters << QString("%1.*").arg(torrent->hash());
-    const QStringList files = resumeDataDir.entryList(filters, QDir::Files, QDir::Unsorted);
-    for (const QString &file : files)
-        Utils::Fs::forceRemove(resumeDataDir.absoluteFilePath(file));
+    QMetaObject::invokeMethod(m_resumeDataSavingManager, "removeFiles", Q_ARG(QStringList, resumeDataFiles));
 
-    delete torrent;
-    qDebug("Torrent deleted.");
-    return true;
+    qDebug("%d torrents deleted.", torrents.size());
+    return torrents.size();
 }
 
 bool Session::cancelLoadMetadata(const InfoHash &hash)
@@ -1682,100 +1995,194 @@ bool Session::cancelLoadMetadata(const InfoHash &hash)
 
 void Session::increaseTorrentsPriority(const QStringList &hashes)
 {
-    std::priority_queue<QPair<int, TorrentHandle *>,
-            std::vector<QPair<int, TorrentHandle *>>,
-            std::greater<QPair<int, TorrentHandle *>>> torrentQueue;
+    moveTorrentsInQueue(hashes, QueueMove::Up);
+}
 
-    // Sort torrents by priority
-    for (const InfoHash infoHash : hashes) {
-        TorrentHandle *const torrent = m_torrents.value(infoHash);
-        if (torrent && !torrent->isSeed())
-            torrentQueue.push(qMakePair(torrent->queuePosition(), torrent));
-    }
+void Session::decreaseTorrentsPriority(const QStringList &hashes)
+{
+    moveTorrentsInQueue(hashes, QueueMove::Down);
+}
 
-    // Increase torrents priority (starting with the ones with highest priority)
-    while (!torrentQueue.empty()) {
-        TorrentHandle *const torrent = torrentQueue.top().second;
-        torrentQueuePositionUp(torrent->nativeHandle());
-        torrentQueue.pop();
-    }
+void Session::topTorrentsPriority(const QStringList &hashes)
+{
+    moveTorrentsInQueue(hashes, QueueMove::Top);
+}
 
-    saveTorrentsQueue();
+void Session::bottomTorrentsPriority(const QStringList &hashes)
+{
+    moveTorrentsInQueue(hashes, QueueMove::Bottom);
 }
 
-void Session::decreaseTorrentsPriority(const QStringList &hashes)
+void Session::moveTorrentsInQueue(const QStringList &hashes, const QueueMove move)
 {
-    std::priority_queue<QPair<int, TorrentHandle *>,
-            std::vector<QPair<int, TorrentHandle *>>,
-            std::less<QPair<int, TorrentHandle *>>> torrentQueue;
+    // Sort torrents by priority once. Moving towards the top starts with the ones
+    // with highest priority, moving towards the bottom with the ones with lowest priority.
+    // libtorrent 1.1 can only move a torrent by one step or to an end of the queue,
+    // so it still takes one call per torrent.
+    const bool towardsTop = ((move == QueueMove::Up) || (move == QueueMove::Top));
 
-    // Sort torrents by priority
+    std::vector<QPair<int, TorrentHandle *>> queuedTorrents;
+    queuedTorrents.reserve(hashes.size());
     for (const InfoHash infoHash : hashes) {
         TorrentHandle *const torrent = m_torrents.value(infoHash);
         if (torrent && !torrent->isSeed())
-            torrentQueue.push(qMakePair(torrent->queuePosition(), torrent));
+            queuedTorrents.push_back(qMakePair(torrent->queuePosition(), torrent));
     }
 
-    // Decrease torrents priority (starting with the ones with lowest priority)
-    while (!torrentQueue.empty()) {
-        TorrentHandle *const torrent = torrentQueue.top().second;
-        torrentQueuePositionDown(torrent->nativeHandle());
-        torrentQueue.pop();
+    std::sort(queuedTorrents.begin(), queuedTorrents.end()
+              , [towardsTop](const QPair<int, TorrentHandle *> &left, const QPair<int, TorrentHandle *> &right)
+    {
+        return towardsTop ? (left.first < right.first) : (left.first > right.first);
+    });
+
+    for (const QPair<int, TorrentHandle *> &queuedTorrent : queuedTorrents) {
+        const libt::torrent_handle nativeHandle = queuedTorrent.second->nativeHandle();
+        switch (move) {
+        case QueueMove::Up:
+            torrentQueuePositionUp(nativeHandle);
+            break;
+        case QueueMove::Down:
+            torrentQueuePositionDown(nativeHandle);
+            break;
+        case QueueMove::Top:
+            torrentQueuePositionTop(nativeHandle);
+            break;
+        case QueueMove::Bottom:
+            torrentQueuePositionBottom(nativeHandle);
+            break;
+        }
     }
 
-    for (auto i = m_loadedMetadata.cbegin(); i != m_loadedMetadata.cend(); ++i)
-        torrentQueuePositionBottom(m_nativeSession->find_torrent(i.key()));
+    // Keep the torrents that are only loading metadata at the bottom of the queue
+    if (!towardsTop) {
+        for (auto i = m_loadedMetadata.cbegin(); i != m_loadedMetadata.cend(); ++i)
+            torrentQueuePositionBottom(m_nativeSession->find_torrent(i.key()));
+    }
 
-    saveTorrentsQueue();
+    // the new positions are reported by the next state update
+    m_isTorrentsQueueChanged = true;
 }
 
-void Session::topTorrentsPriority(const QStringList &hashes)
+void Session::cancelStorageJobs(const QStringList &hashes)
 {
-    std::priority_queue<QPair<int, TorrentHandle *>,
-            std::vector<QPair<int, TorrentHandle *>>,
-            std::greater<QPair<int, TorrentHandle *>>> torrentQueue;
+    beginTorrentsBatch();
+    for (const InfoHash hash : hashes) {
+        TorrentHandle *const torrent = m_torrents.value(hash);
+        if (!torrent) continue;
 
-    // Sort torrents by priority
-    for (const InfoHash infoHash : hashes) {
-        TorrentHandle *const torrent = m_torrents.value(infoHash);
-        if (torrent && !torrent->isSeed())
-            torrentQueue.push(qMakePair(torrent->queuePosition(), torrent));
+        const QList<StorageJob> cancelledJobs = m_storageJobScheduler->cancelJobs(hash);
+        for (const StorageJob &job : cancelledJobs)
+            torrent->handleStorageJobCancelled(job.type);
+        if (!cancelledJobs.isEmpty())
+            markTorrentChanged(torrent);
     }
+    endTorrentsBatch();
+}
 
-    // Top torrents priority (starting with the ones with highest priority)
-    while (!torrentQueue.empty()) {
-        TorrentHandle *const torrent = torrentQueue.top().second;
-        torrentQueuePositionTop(torrent->nativeHandle());
-        torrentQueue.pop();
+bool Session::setStorageJobQueuePosition(const InfoHash &hash, const int position)
+{
+    return m_storageJobScheduler->setQueuePosition(hash, position);
+}
+
+void Session::applyToTorrents(const QStringList &hashes, const std::function<void (TorrentHandle *const)> &operation)
+{
+    beginTorrentsBatch();
+    for (const QString &hash : hashes) {
+        TorrentHandle *const torrent = m_torrents.value(hash);
+        if (torrent)
+            operation(torrent);
     }
+    endTorrentsBatch();
+}
 
-    saveTorrentsQueue();
+void Session::beginTorrentsBatch()
+{
+    ++m_torrentsBatchDepth;
 }
 
-void Session::bottomTorrentsPriority(const QStringList &hashes)
+void Session::endTorrentsBatch()
 {
-    std::priority_queue<QPair<int, TorrentHandle *>,
-            std::vector<QPair<int, TorrentHandle *>>,
-            std::less<QPair<int, TorrentHandle *>>> torrentQueue;
+    Q_ASSERT(m_torrentsBatchDepth > 0);
+    if (--m_torrentsBatchDepth > 0) return;
 
-    // Sort torrents by priority
-    for (const InfoHash infoHash : hashes) {
-        TorrentHandle *const torrent = m_torrents.value(infoHash);
-        if (torrent && !torrent->isSeed())
-            torrentQueue.push(qMakePair(torrent->queuePosition(), torrent));
+    // Torrents might have been removed during the batch so they are looked up again
+    QSet<InfoHash> resumeDataTorrents;
+    resumeDataTorrents.swap(m_batchResumeDataTorrents);
+    for (const InfoHash &hash : asConst(resumeDataTorrents)) {
+        TorrentHandle *const torrent = m_torrents.value(hash);
+        if (torrent)
+            saveTorrentResumeData(torrent);
+    }
+
+    const QVector<TorrentHandle *> changedTorrents = takeBatchTorrents(m_batchChangedTorrents);
+    if (!changedTorrents.isEmpty())
+        emit torrentsChanged(changedTorrents);
+
+    const QVector<TorrentHandle *> pausedTorrents = takeBatchTorrents(m_batchPausedTorrents);
+    if (!pausedTorrents.isEmpty())
+        emit torrentsPaused(pausedTorrents);
+
+    const QVector<TorrentHandle *> resumedTorrents = takeBatchTorrents(m_batchResumedTorrents);
+    if (!resumedTorrents.isEmpty())
+        emit torrentsResumed(resumedTorrents);
+
+    const QVector<TorrentHandle *> savePathChangedTorrents = takeBatchTorrents(m_batchSavePathChangedTorrents);
+    if (!savePathChangedTorrents.isEmpty())
+        emit torrentsSavePathChanged(savePathChangedTorrents);
+
+    const QVector<TorrentHandle *> savingModeChangedTorrents = takeBatchTorrents(m_batchSavingModeChangedTorrents);
+    if (!savingModeChangedTorrents.isEmpty())
+        emit torrentsSavingModeChanged(savingModeChangedTorrents);
+
+    QHash<InfoHash, QString> oldCategories;
+    oldCategories.swap(m_batchOldCategories);
+    QVector<TorrentHandle *> categoryChangedTorrents;
+    QStringList changedOldCategories;
+    for (auto it = oldCategories.cbegin(); it != oldCategories.cend(); ++it) {
+        TorrentHandle *const torrent = m_torrents.value(it.key());
+        // the category could have been changed back in the meantime
+        if (!torrent || (torrent->category() == it.value())) continue;
+
+        categoryChangedTorrents << torrent;
+        changedOldCategories << it.value();
     }
+    if (!categoryChangedTorrents.isEmpty())
+        emit torrentsCategoryChanged(categoryChangedTorrents, changedOldCategories);
 
-    // Bottom torrents priority (starting with the ones with lowest priority)
-    while (!torrentQueue.empty()) {
-        TorrentHandle *const torrent = torrentQueue.top().second;
-        torrentQueuePositionBottom(torrent->nativeHandle());
-        torrentQueue.pop();
+    QHash<InfoHash, QSet<QString>> oldTags;
+    oldTags.swap(m_batchOldTags);
+    QVector<TorrentHandle *> tagsChangedTorrents;
+    QVector<QSet<QString>> changedOldTags;
+    for (auto it = oldTags.cbegin(); it != oldTags.cend(); ++it) {
+        TorrentHandle *const torrent = m_torrents.value(it.key());
+        if (!torrent || (torrent->tags() == it.value())) continue;
+
+        tagsChangedTorrents << torrent;
+        changedOldTags << it.value();
     }
+    if (!tagsChangedTorrents.isEmpty())
+        emit torrentsTagsChanged(tagsChangedTorrents, changedOldTags);
+}
 
-    for (auto i = m_loadedMetadata.cbegin(); i != m_loadedMetadata.cend(); ++i)
-        torrentQueuePositionBottom(m_nativeSession->find_torrent(i.key()));
+QVector<TorrentHandle *> Session::takeBatchTorrents(QSet<InfoHash> &hashes) const
+{
+    QVector<TorrentHandle *> torrents;
+    torrents.reserve(hashes.size());
+    for (const InfoHash &hash : asConst(hashes)) {
+        TorrentHandle *const torrent = m_torrents.value(hash);
+        if (torrent)
+            torrents << torrent;
+    }
+    hashes.clear();
+    return torrents;
+}
 
-    saveTorrentsQueue();
+void Session::markTorrentChanged(TorrentHandle *const torrent)
+{
+    if (m_torrentsBatchDepth > 0)
+        m_batchChangedTorrents.insert(torrent->hash());
+    else
+        emit torrentsChanged({torrent});
 }
 
 QHash<InfoHash, TorrentHandle *> Session::torrents() const
@@ -1783,9 +2190,74 @@ QHash<InfoHash, TorrentHandle *> Session::torrents() const
     return m_torrents;
 }
 
+QVector<TorrentHandle *> Session::torrents(const TorrentFilter &filter) const
+{
+    // Only the torrents of the smallest indexed set the filter
+    // is restricted to need to be matched against it
+    QVector<QSet<InfoHash>> candidateSets;
+    if (filter.type() != TorrentFilter::All)
+        candidateSets << m_torrentIndex.stateTorrents(filter.type());
+    if (!filter.category().isNull())
+        candidateSets << m_torrentIndex.categoryTorrents(filter.category(), isSubcategoriesEnabled());
+    if (!filter.tag().isNull())
+        candidateSets << m_torrentIndex.tagTorrents(filter.tag());
+
+    const QStringSet hashSet = filter.hashSet();
+    if (hashSet != TorrentFilter::AnyHash) {
+        QSet<InfoHash> hashes;
+        hashes.reserve(hashSet.size());
+        for (const QString &hash : hashSet)
+            hashes.insert(hash);
+        candidateSets << hashes;
+    }
+
+    if (candidateSets.isEmpty())
+        return m_torrents.values().toVector();
+
+    const auto candidates = std::min_element(candidateSets.cbegin(), candidateSets.cend()
+        , [](const QSet<InfoHash> &left, const QSet<InfoHash> &right)
+    {
+        return (left.size() < right.size());
+    });
+
+    QVector<TorrentHandle *> result;
+    result.reserve(candidates->size());
+    for (const InfoHash &hash : *candidates) {
+        TorrentHandle *const torrent = m_torrents.value(hash);
+        if (torrent && filter.match(torrent))
+            result << torrent;
+    }
+
+    return result;
+}
+
+const TorrentIndex &Session::torrentIndex() const
+{
+    return m_torrentIndex;
+}
+
+const TrackerIndex &Session::trackerIndex() const
+{
+    return m_trackerIndex;
+}
+
+const StorageJobScheduler *Session::storageJobScheduler() const
+{
+    return m_storageJobScheduler;
+}
+
 TorrentStatusReport Session::torrentStatusReport() const
 {
-    return m_torrentStatusReport;
+    TorrentStatusReport report;
+    report.nbDownloading = m_torrentIndex.stateTorrentsCount(TorrentFilter::Downloading);
+    report.nbSeeding = m_torrentIndex.stateTorrentsCount(TorrentFilter::Seeding);
+    report.nbCompleted = m_torrentIndex.stateTorrentsCount(TorrentFilter::Completed);
+    report.nbActive = m_torrentIndex.stateTorrentsCount(TorrentFilter::Active);
+    report.nbInactive = m_torrentIndex.stateTorrentsCount(TorrentFilter::Inactive);
+    report.nbPaused = m_torrentIndex.stateTorrentsCount(TorrentFilter::Paused);
+    report.nbResumed = m_torrentIndex.stateTorrentsCount(TorrentFilter::Resumed);
+    report.nbErrored = m_torrentIndex.stateTorrentsCount(TorrentFilter::Errored);
+    return report;
 }
 
 bool Session::addTorrent(const QString &source, const AddTorrentParams &params)
@@ -2052,23 +2524,11 @@ void Session::exportTorrentFile(TorrentHandle *const torrent, TorrentExportFolde
     Q_ASSERT(((folder == TorrentExportFolder::Regular) && !torrentExportDirectory().isEmpty()) ||
              ((folder == TorrentExportFolder::Finished) && !finishedTorrentExportDirectory().isEmpty()));
 
-    QString validName = Utils::Fs::toValidFileSystemName(torrent->name());
-    QString torrentFilename = QString("%1.torrent").arg(torrent->hash());
-    QString torrentExportFilename = QString("%1.torrent").arg(validName);
-    QString torrentPath = QDir(m_resumeFolderPath).absoluteFilePath(torrentFilename);
-    QDir exportPath(folder == TorrentExportFolder::Regular ? torrentExportDirectory() : finishedTorrentExportDirectory());
-    if (exportPath.exists() || exportPath.mkpath(exportPath.absolutePath())) {
-        QString newTorrentPath = exportPath.absoluteFilePath(torrentExportFilename);
-        int counter = 0;
-        while (QFile::exists(newTorrentPath) && !Utils::Fs::sameFiles(torrentPath, newTorrentPath)) {
-            // Append number to torrent name to make it unique
-            torrentExportFilename = QString("%1 %2.torrent").arg(validName).arg(++counter);
-            newTorrentPath = exportPath.absoluteFilePath(torrentExportFilename);
-        }
-
-        if (!QFile::exists(newTorrentPath))
-            QFile::copy(torrentPath, newTorrentPath);
-    }
+    const QString exportFolder = (folder == TorrentExportFolder::Regular)
+        ? torrentExportDirectory() : finishedTorrentExportDirectory();
+    QMetaObject::invokeMethod(m_resumeDataSavingManager, "exportTorrentFile"
+                              , Q_ARG(QString, torrent->hash()), Q_ARG(QString, exportFolder)
+                              , Q_ARG(QString, Utils::Fs::toValidFileSystemName(torrent->name())));
 }
 
 void Session::generateResumeData(bool final)
@@ -2091,16 +2551,34 @@ void Session::saveResumeData()
     // Pause session
     m_nativeSession->pause();
 
-    if (isQueueingSystemEnabled())
+    // alerts left over from the last time slice of readAlerts() are only valid until the next pop
+    for (auto i = (m_pendingAlerts.cbegin() + m_pendingAlertsPosition); i != m_pendingAlerts.cend(); ++i) {
+        switch ((*i)->type()) {
+        case libt::save_resume_data_failed_alert::alert_type:
+        case libt::save_resume_data_alert::alert_type:
+            dispatchTorrentAlert(*i);
+            break;
+        }
+    }
+    m_pendingAlerts.clear();
+    m_pendingAlertsPosition = 0;
+
+    if (isQueueingSystemEnabled()) {
+        // The cached positions may not include the latest queue changes yet
+        if (m_isTorrentsQueueChanged)
+            waitForTorrentsStatus();
         saveTorrentsQueue();
+    }
     generateResumeData(true);
 
+    std::vector<libt::alert *> alerts;
     while (m_numResumeData > 0) {
-        std::vector<libt::alert *> alerts;
-        getPendingAlerts(alerts, 30 * 1000);
         if (alerts.empty()) {
-            fprintf(stderr, " aborting with %d outstanding torrents to save resume data for\n", m_numResumeData);
-            break;
+            getPendingAlerts(alerts, 30 * 1000);
+            if (alerts.empty()) {
+                fprintf(stderr, " aborting with %d outstanding torrents to save resume data for\n", m_numResumeData);
+                break;
+            }
         }
 
         for (const auto a : alerts) {
@@ -2111,16 +2589,52 @@ void Session::saveResumeData()
                 break;
             }
         }
+        alerts.clear();
     }
 }
 
+// Gets the status of all the torrents with a single state update
+// rather than a blocking status() call per torrent
+void Session::waitForTorrentsStatus()
+{
+    m_nativeSession->post_torrent_updates();
+
+    QElapsedTimer timer;
+    timer.start();
+    bool isUpdated = false;
+    while (!isUpdated && !timer.hasExpired(STATUS_UPDATE_TIMEOUT)) {
+        std::vector<libt::alert *> alerts;
+        getPendingAlerts(alerts, static_cast<ulong>(STATUS_UPDATE_TIMEOUT - timer.elapsed()));
+        for (const auto a : alerts) {
+            switch (a->type()) {
+            case libt::state_update_alert::alert_type:
+                for (const libt::torrent_status &status : static_cast<libt::state_update_alert *>(a)->status) {
+                    TorrentHandle *const torrent = m_torrents.value(status.info_hash);
+                    if (torrent)
+                        torrent->handleStateUpdate(status);
+                }
+                isUpdated = true;
+                break;
+            case libt::save_resume_data_failed_alert::alert_type:
+            case libt::save_resume_data_alert::alert_type:
+                dispatchTorrentAlert(a);
+                break;
+            }
+        }
+    }
+
+    if (!isUpdated)
+        LogMsg(tr("Timed out waiting for the torrents status, the saved queue may be outdated."), Log::WARNING);
+}
+
 void Session::saveTorrentsQueue()
 {
+    m_isTorrentsQueueChanged = false;
+
     QMap<int, QString> queue; // Use QMap since it should be ordered by key
-    for (const TorrentHandle *torrent : asConst(torrents())) {
-        // We require actual (non-cached) queue position here!
-        const int queuePos = torrent->nativeHandle().queue_position();
-        if (queuePos >= 0)
+    for (const TorrentHandle *torrent : asConst(m_torrents)) {
+        const int queuePos = torrent->queuePosition();
+        if (queuePos > 0)
             queue[queuePos] = torrent->hash();
     }
 
@@ -2133,6 +2647,27 @@ void Session::saveTorrentsQueue()
                               , Q_ARG(QString, filename), Q_ARG(QByteArray, data));
 }
 
+void Session::saveTorrentFile(TorrentHandle *const torrent)
+{
+    const QByteArray data = torrent->torrentFileData();
+    if (data.isEmpty()) {
+        handleTorrentFileSaveFailed(torrent->hash());
+        return;
+    }
+
+    // The file is written on the I/O thread, after the removals queued there
+    // for a torrent with the same hash that was just deleted
+    QMetaObject::invokeMethod(m_resumeDataSavingManager, "saveTorrentFile"
+                              , Q_ARG(QString, torrent->hash()), Q_ARG(QByteArray, data)
+                              , Q_ARG(QString, torrentExportDirectory())
+                              , Q_ARG(QString, Utils::Fs::toValidFileSystemName(torrent->name())));
+}
+
+void Session::handleTorrentFileSaveFailed(const QString &hash)
+{
+    LogMsg(tr("Couldn't save '%1.torrent'").arg(hash), Log::CRITICAL);
+}
+
 void Session::removeTorrentsQueue()
 {
     const QString filename = QLatin1String {"queue"};
@@ -2410,13 +2945,29 @@ void Session::setBandwidthSchedulerEnabled(bool enabled)
 {
     if (enabled != isBandwidthSchedulerEnabled()) {
         m_isBandwidthSchedulerEnabled = enabled;
-        if (enabled)
+        if (enabled) {
             enableBandwidthScheduler();
-        else
+        }
+        else {
             delete m_bwScheduler;
+            setScheduledGlobalLimits(0, 0);
+            updateScheduledTorrentLimits();
+        }
     }
 }
 
+BandwidthSchedule Session::bandwidthSchedule() const
+{
+    return BandwidthSchedule::fromList(m_bandwidthScheduleRules);
+}
+
+void Session::setBandwidthSchedule(const BandwidthSchedule &schedule)
+{
+    m_bandwidthScheduleRules = schedule.toList();
+    if (m_bwScheduler)
+        m_bwScheduler->setSchedule(schedule);
+}
+
 uint Session::saveResumeDataInterval() const
 {
     return m_saveResumeDataInterval;
@@ -2773,6 +3324,61 @@ void Session::setCheckingMemUsage(int size)
     configureDeferred();
 }
 
+int Session::maxActiveStorageJobsPerDevice() const
+{
+    return qMax(1, m_maxActiveStorageJobsPerDevice.value());
+}
+
+void Session::setMaxActiveStorageJobsPerDevice(int max)
+{
+    max = qMax(max, 1);
+
+    if (max == m_maxActiveStorageJobsPerDevice)
+        return;
+
+    m_maxActiveStorageJobsPerDevice = max;
+    m_storageJobScheduler->setMaxJobsPerDevice(max);
+}
+
+int Session::diskSpaceReserve() const
+{
+    return qMax(0, m_diskSpaceReserve.value());
+}
+
+void Session::setDiskSpaceReserve(int size)
+{
+    size = qMax(size, 0);
+
+    if (size == m_diskSpaceReserve)
+        return;
+
+    m_diskSpaceReserve = size;
+    if (size > 0) {
+        for (TorrentHandle *const torrent : asConst(m_torrents))
+            watchDiskSpace(torrent);
+
+        const qint64 reserve = static_cast<qint64>(size) * 1024 * 1024;
+        const QSet<QString> watchedPaths = m_diskSpaceWatchedPaths.values().toSet();
+        for (const QString &path : watchedPaths)
+            DiskSpaceMonitor::instance()->setReserve(path, reserve);
+    }
+    else {
+        const QList<InfoHash> watchedTorrents = m_diskSpaceWatchedPaths.keys();
+        for (const InfoHash &hash : watchedTorrents)
+            unwatchDiskSpace(hash);
+        m_diskSpacePendingTorrents.clear();
+        m_diskSpaceSavePathDevices.clear();
+
+        for (const InfoHash &hash : asConst(m_lowDiskSpacePausedTorrents)) {
+            TorrentHandle *const torrent = m_torrents.value(hash);
+            if (torrent && torrent->isPaused())
+                torrent->resume();
+        }
+        m_lowDiskSpacePausedTorrents.clear();
+        storeLowDiskSpacePausedTorrents();
+    }
+}
+
 int Session::diskCacheSize() const
 {
     int size = m_diskCacheSize;
@@ -3250,24 +3856,31 @@ bool Session::isKnownTorrent(const InfoHash &hash) const
 
 void Session::updateSeedingLimitTimer()
 {
-    if ((globalMaxRatio() == TorrentHandle::NO_RATIO_LIMIT) && !hasPerTorrentRatioLimit()
-        && (globalMaxSeedingMinutes() == TorrentHandle::NO_SEEDING_TIME_LIMIT) && !hasPerTorrentSeedingTimeLimit()) {
-        if (m_seedingLimitTimer->isActive())
-            m_seedingLimitTimer->stop();
-    }
-    else if (!m_seedingLimitTimer->isActive()) {
-        m_seedingLimitTimer->start();
+    if (m_shareLimitsQueue.empty()) {
+        m_seedingLimitTimer->stop();
+        return;
     }
+
+    const qint64 delay = m_shareLimitsQueue.begin()->first - m_shareLimitsClock.elapsed();
+    m_seedingLimitTimer->start(static_cast<int>(qBound<qint64>(0, delay, std::numeric_limits<int>::max())));
 }
 
 void Session::handleTorrentShareLimitChanged(TorrentHandle *const torrent)
 {
     saveTorrentResumeData(torrent);
+    markTorrentChanged(torrent);
+    enqueueShareLimitsCheck(torrent->hash(), m_shareLimitsClock.elapsed());
     updateSeedingLimitTimer();
 }
 
 void Session::saveTorrentResumeData(TorrentHandle *const torrent)
 {
+    if (m_torrentsBatchDepth > 0) {
+        // it will be saved once the batch is finished
+        m_batchResumeDataTorrents.insert(torrent->hash());
+        return;
+    }
+
     qDebug("Saving fastresume data for %s", qUtf8Printable(torrent->name()));
     torrent->saveResumeData();
     ++m_numResumeData;
@@ -3276,40 +3889,84 @@ void Session::saveTorrentResumeData(TorrentHandle *const torrent)
 void Session::handleTorrentNameChanged(TorrentHandle *const torrent)
 {
     saveTorrentResumeData(torrent);
+    markTorrentChanged(torrent);
 }
 
 void Session::handleTorrentSavePathChanged(TorrentHandle *const torrent)
 {
+    watchDiskSpace(torrent);
     saveTorrentResumeData(torrent);
-    emit torrentSavePathChanged(torrent);
+    markTorrentChanged(torrent);
+    if (m_torrentsBatchDepth > 0)
+        m_batchSavePathChangedTorrents.insert(torrent->hash());
+    else
+        emit torrentsSavePathChanged({torrent});
 }
 
 void Session::handleTorrentCategoryChanged(TorrentHandle *const torrent, const QString &oldCategory)
 {
+    m_torrentIndex.updateCategory(torrent, oldCategory);
+    updateScheduledTorrentLimits(torrent);
     saveTorrentResumeData(torrent);
-    emit torrentCategoryChanged(torrent, oldCategory);
+    markTorrentChanged(torrent);
+    if (m_torrentsBatchDepth > 0) {
+        if (!m_batchOldCategories.contains(torrent->hash()))
+            m_batchOldCategories.insert(torrent->hash(), oldCategory);
+    }
+    else {
+        emit torrentsCategoryChanged({torrent}, {oldCategory});
+    }
 }
 
 void Session::handleTorrentTagAdded(TorrentHandle *const torrent, const QString &tag)
 {
+    m_torrentIndex.addTag(torrent, tag);
+    updateScheduledTorrentLimits(torrent);
     saveTorrentResumeData(torrent);
-    emit torrentTagAdded(torrent, tag);
+    markTorrentChanged(torrent);
+
+    QSet<QString> oldTags = torrent->tags();
+    oldTags.remove(tag);
+    if (m_torrentsBatchDepth > 0) {
+        if (!m_batchOldTags.contains(torrent->hash()))
+            m_batchOldTags.insert(torrent->hash(), oldTags);
+    }
+    else {
+        emit torrentsTagsChanged({torrent}, {oldTags});
+    }
 }
 
 void Session::handleTorrentTagRemoved(TorrentHandle *const torrent, const QString &tag)
 {
+    m_torrentIndex.removeTag(torrent, tag);
+    updateScheduledTorrentLimits(torrent);
     saveTorrentResumeData(torrent);
-    emit torrentTagRemoved(torrent, tag);
+    markTorrentChanged(torrent);
+
+    QSet<QString> oldTags = torrent->tags();
+    oldTags.insert(tag);
+    if (m_torrentsBatchDepth > 0) {
+        if (!m_batchOldTags.contains(torrent->hash()))
+            m_batchOldTags.insert(torrent->hash(), oldTags);
+    }
+    else {
+        emit torrentsTagsChanged({torrent}, {oldTags});
+    }
 }
 
 void Session::handleTorrentSavingModeChanged(TorrentHandle *const torrent)
 {
     saveTorrentResumeData(torrent);
-    emit torrentSavingModeChanged(torrent);
+    markTorrentChanged(torrent);
+    if (m_torrentsBatchDepth > 0)
+        m_batchSavingModeChangedTorrents.insert(torrent->hash());
+    else
+        emit torrentsSavingModeChanged({torrent});
 }
 
 void Session::handleTorrentTrackersAdded(TorrentHandle *const torrent, const QList<TrackerEntry> &newTrackers)
 {
+    m_trackerIndex.updateTorrent(torrent);
     saveTorrentResumeData(torrent);
 
     for (const TrackerEntry &newTracker : newTrackers)
@@ -3322,6 +3979,7 @@ void Session::handleTorrentTrackersAdded(TorrentHandle *const torrent, const QLi
 
 void Session::handleTorrentTrackersRemoved(TorrentHandle *const torrent, const QList<TrackerEntry> &deletedTrackers)
 {
+    m_trackerIndex.updateTorrent(torrent);
     saveTorrentResumeData(torrent);
 
     for (const TrackerEntry &deletedTracker : deletedTrackers)
@@ -3334,6 +3992,7 @@ void Session::handleTorrentTrackersRemoved(TorrentHandle *const torrent, const Q
 
 void Session::handleTorrentTrackersChanged(TorrentHandle *const torrent)
 {
+    m_trackerIndex.updateTorrent(torrent);
     saveTorrentResumeData(torrent);
     emit trackersChanged(torrent);
 }
@@ -3357,32 +4016,149 @@ void Session::handleTorrentMetadataReceived(TorrentHandle *const torrent)
     saveTorrentResumeData(torrent);
 
     // Save metadata
-    const QDir resumeDataDir(m_resumeFolderPath);
-    QString torrentFile = resumeDataDir.absoluteFilePath(QString("%1.torrent").arg(torrent->hash()));
-    if (torrent->saveTorrentFile(torrentFile)) {
-        // Copy the torrent file to the export folder
-        if (!torrentExportDirectory().isEmpty())
-            exportTorrentFile(torrent);
-    }
+    saveTorrentFile(torrent);
 
+    markTorrentChanged(torrent);
     emit torrentMetadataLoaded(torrent);
 }
 
 void Session::handleTorrentPaused(TorrentHandle *const torrent)
 {
+    // libtorrent doesn't check the files of a paused torrent
+    m_storageJobScheduler->finishJob(torrent->hash(), StorageJob::Recheck);
     if (!torrent->hasError() && !torrent->hasMissingFiles())
         saveTorrentResumeData(torrent);
-    emit torrentPaused(torrent);
+    markTorrentChanged(torrent);
+    dequeueShareLimitsCheck(torrent->hash());
+    updateSeedingLimitTimer();
+    if (m_torrentsBatchDepth > 0)
+        m_batchPausedTorrents.insert(torrent->hash());
+    else
+        emit torrentsPaused({torrent});
 }
 
 void Session::handleTorrentResumed(TorrentHandle *const torrent)
 {
+    // It's no longer held back once resumed by other means
+    if (m_lowDiskSpacePausedTorrents.remove(torrent->hash()))
+        storeLowDiskSpacePausedTorrents();
     saveTorrentResumeData(torrent);
-    emit torrentResumed(torrent);
+    markTorrentChanged(torrent);
+    updateSeedingTimeDeadline(torrent);
+    updateSeedingLimitTimer();
+    if (m_torrentsBatchDepth > 0)
+        m_batchResumedTorrents.insert(torrent->hash());
+    else
+        emit torrentsResumed({torrent});
+}
+
+void Session::handleTorrentStorageJobRequested(TorrentHandle *const torrent, const StorageJob::Type type, const QStringList &paths)
+{
+    StorageJob job;
+    job.torrentHash = torrent->hash();
+    job.type = type;
+    job.paths = paths;
+    if (m_storageJobScheduler->addJob(job))
+        markTorrentChanged(torrent);
+}
+
+void Session::handleTorrentStorageJobFinished(TorrentHandle *const torrent, const StorageJob::Type type)
+{
+    m_storageJobScheduler->finishJob(torrent->hash(), type);
+}
+
+void Session::handleStorageJobStarted(const StorageJob &job)
+{
+    TorrentHandle *const torrent = m_torrents.value(job.torrentHash);
+    if (!torrent) {
+        m_storageJobScheduler->finishJob(job.torrentHash, job.type);
+        return;
+    }
+
+    torrent->handleStorageJobStarted(job.type);
+    markTorrentChanged(torrent);
+}
+
+void Session::handleLowDiskSpace(const QString &path, const qint64 bytesFree, const qint64 reserve)
+{
+    int pausedCount = 0;
+    for (auto it = m_diskSpaceWatchedPaths.cbegin(); it != m_diskSpaceWatchedPaths.cend(); ++it) {
+        if ((it.value() != path) || m_lowDiskSpacePausedTorrents.contains(it.key()))
+            continue;
+
+        TorrentHandle *const torrent = m_torrents.value(it.key());
+        if (!torrent || torrent->isPaused() || torrent->isSeed())
+            continue;
+
+        torrent->pause();
+        m_lowDiskSpacePausedTorrents.insert(it.key());
+        ++pausedCount;
+    }
+    if (pausedCount > 0)
+        storeLowDiskSpacePausedTorrents();
+
+    LogMsg(tr("Free disk space on '%1' is %2, below the reserve of %3. Paused %4 downloads.")
+           .arg(Utils::Fs::toNativePath(path), Utils::Misc::friendlyUnit(bytesFree)
+                , Utils::Misc::friendlyUnit(reserve), QString::number(pausedCount))
+           , Log::WARNING);
+}
+
+void Session::handleDiskSpaceDeviceResolved(const QString &path, const QString &device)
+{
+    if (diskSpaceReserve() <= 0) return;
+
+    QList<InfoHash> resolvedTorrents;
+    for (auto it = m_diskSpacePendingTorrents.begin(); it != m_diskSpacePendingTorrents.end();) {
+        // A torrent moved in the meantime waits for its new save path
+        if (it.value() == path) {
+            resolvedTorrents << it.key();
+            it = m_diskSpacePendingTorrents.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    if (resolvedTorrents.isEmpty()) return;
+
+    m_diskSpaceSavePathDevices.insert(path, device);
+    for (const InfoHash &hash : asConst(resolvedTorrents)) {
+        TorrentHandle *const torrent = m_torrents.value(hash);
+        if (torrent)
+            watchDiskSpace(torrent, path, device);
+    }
+}
+
+void Session::handleFreeSpaceChanged(const QString &path)
+{
+    if (DiskSpaceMonitor::instance()->isLowOnSpace(path)) return;
+
+    int heldCount = 0;
+    int resumedCount = 0;
+    for (auto it = m_lowDiskSpacePausedTorrents.begin(); it != m_lowDiskSpacePausedTorrents.end();) {
+        if (m_diskSpaceWatchedPaths.value(*it) != path) {
+            ++it;
+            continue;
+        }
+
+        TorrentHandle *const torrent = m_torrents.value(*it);
+        if (torrent && torrent->isPaused()) {
+            torrent->resume();
+            ++resumedCount;
+        }
+        it = m_lowDiskSpacePausedTorrents.erase(it);
+        ++heldCount;
+    }
+
+    if (heldCount == 0) return;
+
+    storeLowDiskSpacePausedTorrents();
+    LogMsg(tr("Free disk space on '%1' is above the reserve again. Resumed %2 downloads.")
+           .arg(Utils::Fs::toNativePath(path), QString::number(resumedCount)));
 }
 
 void Session::handleTorrentChecked(TorrentHandle *const torrent)
 {
+    markTorrentChanged(torrent);
     emit torrentFinishedChecking(torrent);
 }
 
@@ -3390,6 +4166,9 @@ void Session::handleTorrentFinished(TorrentHandle *const torrent)
 {
     if (!torrent->hasError() && !torrent->hasMissingFiles())
         saveTorrentResumeData(torrent);
+    markTorrentChanged(torrent);
+    enqueueShareLimitsCheck(torrent->hash(), m_shareLimitsClock.elapsed());
+    updateSeedingLimitTimer();
     emit torrentFinished(torrent);
 
     qDebug("Checking if the torrent contains torrent files to download");
@@ -3445,33 +4224,36 @@ void Session::handleTorrentResumeDataFailed(TorrentHandle *const torrent)
 
 void Session::handleTorrentTrackerReply(TorrentHandle *const torrent, const QString &trackerUrl)
 {
+    m_trackerIndex.setTrackerWorking(torrent->hash(), trackerUrl);
     emit trackerSuccess(torrent, trackerUrl);
 }
 
 void Session::handleTorrentTrackerError(TorrentHandle *const torrent, const QString &trackerUrl)
 {
+    m_trackerIndex.setTrackerError(torrent->hash(), trackerUrl);
     emit trackerError(torrent, trackerUrl);
 }
 
-void Session::handleTorrentTrackerWarning(TorrentHandle *const torrent, const QString &trackerUrl)
+void Session::handleTorrentSyncNativeCall(const TorrentHandle *torrent, const char *function)
 {
-    emit trackerWarning(torrent, trackerUrl);
+    ++m_syncNativeCallsCount;
+    qDebug("Synchronous torrent_handle::%s() call for torrent %s", function, qUtf8Printable(torrent->hash()));
 }
 
-bool Session::hasPerTorrentRatioLimit() const
+void Session::handleTorrentCachesOutdated(const TorrentHandle *torrent)
 {
-    return std::any_of(m_torrents.cbegin(), m_torrents.cend(), [](const TorrentHandle *torrent)
-    {
-        return (torrent->ratioLimit() >= 0);
-    });
+    m_outdatedCachesTorrents.insert(torrent->hash());
 }
 
-bool Session::hasPerTorrentSeedingTimeLimit() const
+void Session::handleTorrentStateChanged(TorrentHandle *const torrent)
 {
-    return std::any_of(m_torrents.cbegin(), m_torrents.cend(), [](const TorrentHandle *torrent)
-    {
-        return (torrent->seedingTimeLimit() >= 0);
-    });
+    m_torrentIndex.updateState(torrent);
+}
+
+void Session::handleTorrentTrackerWarning(TorrentHandle *const torrent, const QString &trackerUrl)
+{
+    m_trackerIndex.setTrackerWarning(torrent->hash(), trackerUrl);
+    emit trackerWarning(torrent, trackerUrl);
 }
 
 void Session::initResumeFolder()
@@ -3563,6 +4345,80 @@ const CacheStatus &Session::cacheStatus() const
     return m_cacheStatus;
 }
 
+const QVector<SessionMetric> &Session::metrics() const
+{
+    return m_metrics;
+}
+
+const QVector<qint64> &Session::metricValues() const
+{
+    return m_metricValues;
+}
+
+int Session::lastAlertsCount() const
+{
+    return m_lastAlertsCount;
+}
+
+int Session::alertsBacklog() const
+{
+    return static_cast<int>(m_pendingAlerts.size() - m_pendingAlertsPosition);
+}
+
+int Session::alertsHighWaterMark() const
+{
+    return m_alertsHighWaterMark;
+}
+
+quint64 Session::syncNativeCallsCount() const
+{
+    return m_syncNativeCallsCount;
+}
+
+const LatencyHistogram &Session::alertsHandlingLatency() const
+{
+    return m_alertsHandlingLatency;
+}
+
+const QVector<AlertTypeStatistics> &Session::alertTypeStatistics() const
+{
+    return m_alertTypeStatistics;
+}
+
+QVector<AlertTypeStatistics> Session::slowestAlertTypes(const int count) const
+{
+    QVector<AlertTypeStatistics> result;
+    for (const AlertTypeStatistics &typeStats : asConst(m_alertTypeStatistics)) {
+        if (typeStats.latency.count() > 0)
+            result.append(typeStats);
+    }
+
+    const auto middle = result.begin() + std::min(count, result.size());
+    std::partial_sort(result.begin(), middle, result.end()
+        , [](const AlertTypeStatistics &left, const AlertTypeStatistics &right)
+    {
+        return (left.latency.sum() > right.latency.sum());
+    });
+    result.erase(middle, result.end());
+    return result;
+}
+
+const TimeSeries &Session::transferRateHistory() const
+{
+    return m_transferRateHistory;
+}
+
+const TimeSeries *Session::torrentTransferRateHistory(const InfoHash &hash) const
+{
+    const auto iter = m_torrentTransferRateHistory.constFind(hash);
+    return (iter != m_torrentTransferRateHistory.cend()) ? &iter.value() : nullptr;
+}
+
+int Session::pendingResumeDataCount() const
+{
+    return m_numResumeData;
+}
+
 // Will resume torrents in backup directory
 void Session::startUpTorrents()
 {
@@ -3704,6 +4560,9 @@ void Session::refresh()
 {
     m_nativeSession->post_torrent_updates();
     m_nativeSession->post_session_stats();
+
+    if (m_bwScheduler)
+        m_bwScheduler->checkClockChange();
 }
 
 void Session::handleIPFilterParsed(int ruleCount)
@@ -3749,11 +4608,55 @@ void Session::setCreateTorrentSubfolder(bool value)
 // Read alerts sent by the BitTorrent session
 void Session::readAlerts()
 {
-    std::vector<libt::alert *> alerts;
-    getPendingAlerts(alerts);
+    QElapsedTimer sliceTimer;
+    sliceTimer.start();
+
+    // Coalesce the changes caused by the whole bunch of alerts
+    beginTorrentsBatch();
+    forever {
+        if (m_pendingAlertsPosition >= m_pendingAlerts.size()) {
+            m_pendingAlerts.clear();
+            m_pendingAlertsPosition = 0;
+            getPendingAlerts(m_pendingAlerts);
+            if (m_pendingAlerts.empty())
+                break;
+
+            updateAlertsBacklogStats();
+        }
+
+        // Yield to the event loop to keep UI and WebUI responsive,
+        // the rest of the alerts are handled by the next invocation
+        if (sliceTimer.elapsed() >= ALERTS_TIME_SLICE) {
+            QMetaObject::invokeMethod(this, "readAlerts", Qt::QueuedConnection);
+            break;
+        }
 
-    for (const auto a : alerts)
+        libt::alert *a = m_pendingAlerts[m_pendingAlertsPosition++];
+        const qint64 alertStartTime = sliceTimer.nsecsElapsed();
         handleAlert(a);
+
+        AlertTypeStatistics &typeStats = m_alertTypeStatistics[a->type()];
+        if (typeStats.name.isEmpty())
+            typeStats.name = QString::fromLatin1(a->what());
+        typeStats.latency.record((sliceTimer.nsecsElapsed() - alertStartTime) / 1000);
+    }
+    endTorrentsBatch();
+
+    m_alertsHandlingLatency.record(sliceTimer.nsecsElapsed() / 1000);
+}
+
+void Session::updateAlertsBacklogStats()
+{
+    m_lastAlertsCount = static_cast<int>(m_pendingAlerts.size());
+    m_alertsHighWaterMark = std::max(m_alertsHighWaterMark, m_lastAlertsCount);
+
+    if (m_lastAlertsCount >= m_alertsWarningLevel) {
+        LogMsg(tr("Alert processing is falling behind: %1 alerts were queued at once.").arg(m_lastAlertsCount), Log::WARNING);
+        m_alertsWarningLevel = m_lastAlertsCount * 2;
+    }
+    else if (m_lastAlertsCount < (ALERTS_BACKLOG_WARNING_LEVEL / 2)) {
+        m_alertsWarningLevel = ALERTS_BACKLOG_WARNING_LEVEL;
+    }
 }
 
 void Session::handleAlert(libt::alert *a)
@@ -3790,6 +4693,9 @@ void Session::handleAlert(libt::alert *a)
         case libt::file_error_alert::alert_type:
             handleFileErrorAlert(static_cast<libt::file_error_alert*>(a));
             break;
+        case libt::torrent_error_alert::alert_type:
+            handleTorrentErrorAlert(static_cast<libt::torrent_error_alert*>(a));
+            break;
         case libt::add_torrent_alert::alert_type:
             handleAddTorrentAlert(static_cast<libt::add_torrent_alert*>(a));
             break;
@@ -3849,6 +4755,9 @@ void Session::createTorrentHandle(const libt::torrent_handle &nativeHandle)
 
     TorrentHandle *const torrent = new TorrentHandle(this, nativeHandle, params);
     m_torrents.insert(torrent->hash(), torrent);
+    m_torrentIndex.addTorrent(torrent);
+    m_trackerIndex.addTorrent(torrent);
+    updateScheduledTorrentLimits(torrent);
 
     Logger *const logger = Logger::instance();
 
@@ -3861,16 +4770,7 @@ void Session::createTorrentHandle(const libt::torrent_handle &nativeHandle)
         // The following is useless for newly added magnet
         if (!fromMagnetUri) {
             // Backup torrent file
-            const QDir resumeDataDir(m_resumeFolderPath);
-            const QString newFile = resumeDataDir.absoluteFilePath(QString("%1.torrent").arg(torrent->hash()));
-            if (torrent->saveTorrentFile(newFile)) {
-                // Copy the torrent file to the export folder
-                if (!torrentExportDirectory().isEmpty())
-                    exportTorrentFile(torrent);
-            }
-            else {
-                logger->addMessage(tr("Couldn't save '%1.torrent'").arg(torrent->hash()), Log::CRITICAL);
-            }
+            saveTorrentFile(torrent);
         }
 
         if (isAddTrackersEnabled() && !torrent->isPrivate())
@@ -3884,9 +4784,12 @@ void Session::createTorrentHandle(const libt::torrent_handle &nativeHandle)
         saveTorrentResumeData(torrent);
     }
 
-    if (((torrent->ratioLimit() >= 0) || (torrent->seedingTimeLimit() >= 0))
-        && !m_seedingLimitTimer->isActive())
-        m_seedingLimitTimer->start();
+    if (torrent->isSeed()) {
+        enqueueShareLimitsCheck(torrent->hash(), m_shareLimitsClock.elapsed());
+        updateSeedingLimitTimer();
+    }
+
+    watchDiskSpace(torrent);
 
     // Send torrent addition signal
     emit torrentAdded(torrent);
@@ -3971,6 +4874,8 @@ void Session::handleFileErrorAlert(libt::file_error_alert *p)
     TorrentHandle *const torrent = m_torrents.value(p->handle.info_hash());
     if (torrent) {
         const InfoHash hash = torrent->hash();
+        // the torrent is paused, a recheck stops there
+        m_storageJobScheduler->finishJob(hash, StorageJob::Recheck);
         if (!m_recentErroredTorrents.contains(hash)) {
             m_recentErroredTorrents.insert(hash);
             const QString msg = QString::fromStdString(p->message());
@@ -3982,6 +4887,12 @@ void Session::handleFileErrorAlert(libt::file_error_alert *p)
     }
 }
 
+void Session::handleTorrentErrorAlert(libt::torrent_error_alert *p)
+{
+    // the torrent is stopped, a recheck stops there
+    m_storageJobScheduler->finishJob(p->handle.info_hash(), StorageJob::Recheck);
+}
+
 void Session::handlePortmapWarningAlert(libt::portmap_error_alert *p)
 {
     Logger::instance()->addMessage(tr("UPnP/NAT-PMP: Port mapping failure, message: %1").arg(QString::fromStdString(p->message())), Log::CRITICAL);
@@ -4094,6 +5005,9 @@ void Session::handleSessionStatsAlert(libt::session_stats_alert *p)
 {
     qreal interval = m_statsUpdateTimer.restart() / 1000.;
 
+    for (int i = 0; i < m_metricValues.size(); ++i)
+        m_metricValues[i] = p->values[i];
+
     m_status.hasIncomingConnections = static_cast<bool>(p->values[m_metricIndices.net.hasIncomingConnections]);
 
     const auto ipOverheadDownload = p->values[m_metricIndices.net.recvIPOverheadBytes];
@@ -4152,36 +5066,107 @@ void Session::handleSessionStatsAlert(libt::session_stats_alert *p)
     m_cacheStatus.averageJobTime = totalJobs > 0
                                    ? (p->values[m_metricIndices.disk.diskJobTime] / totalJobs) : 0;
 
+    recordTransferRates();
+
     emit statsUpdated();
 }
 
+void Session::recordTransferRates()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    quint64 rates[TransferRateChannelsCount];
+    rates[UploadRate] = m_status.uploadRate;
+    rates[DownloadRate] = m_status.downloadRate;
+    rates[PayloadUploadRate] = m_status.payloadUploadRate;
+    rates[PayloadDownloadRate] = m_status.payloadDownloadRate;
+    rates[OverheadUploadRate] = m_status.ipOverheadUploadRate;
+    rates[OverheadDownloadRate] = m_status.ipOverheadDownloadRate;
+    rates[DHTUploadRate] = m_status.dhtUploadRate;
+    rates[DHTDownloadRate] = m_status.dhtDownloadRate;
+    rates[TrackerUploadRate] = m_status.trackerUploadRate;
+    rates[TrackerDownloadRate] = m_status.trackerDownloadRate;
+    m_transferRateHistory.addSample(now, rates);
+
+    if ((now - m_transferRateHistorySaveTime) >= TRANSFER_RATE_HISTORY_SAVE_INTERVAL)
+        saveTransferRateHistory();
+}
+
+void Session::loadTransferRateHistory()
+{
+    QByteArray data;
+    if (!readFile(QDir(m_resumeFolderPath).absoluteFilePath(TRANSFER_RATE_HISTORY_FILENAME), data))
+        return;
+
+    if (!m_transferRateHistory.deserialize(data))
+        LogMsg(tr("Couldn't load the transfer rate history. Its file is corrupted or has an unsupported format."), Log::WARNING);
+}
+
+void Session::saveTransferRateHistory()
+{
+    m_transferRateHistorySaveTime = QDateTime::currentMSecsSinceEpoch() / 1000;
+    QMetaObject::invokeMethod(m_resumeDataSavingManager, "save"
+                              , Q_ARG(QString, TRANSFER_RATE_HISTORY_FILENAME)
+                              , Q_ARG(QByteArray, m_transferRateHistory.serialize()));
+}
+
 void Session::handleStateUpdateAlert(libt::state_update_alert *p)
 {
+    // Only torrents whose status has changed are reported, so share limits
+    // are rechecked just for those that uploaded something or started seeding.
+    // Stale deadlines (e.g. of torrents switched to forced mode) are dropped
+    // once they are due.
+    const qint64 now = m_shareLimitsClock.elapsed();
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch() / 1000;
+    bool shareLimitsQueueChanged = false;
     for (const libt::torrent_status &status : p->status) {
         TorrentHandle *const torrent = m_torrents.value(status.info_hash);
-        if (torrent)
-            torrent->handleStateUpdate(status);
+        if (!torrent) continue;
+
+        const qlonglong uploadedBefore = torrent->totalUpload();
+        torrent->handleStateUpdate(status);
+
+        // Histories are created on the first transfer so idle torrents cost nothing.
+        // Torrents are only reported while their status changes, hence the gaps
+        // in the history mean that nothing was transferred, the history counts
+        // them as zero samples.
+        const quint64 rates[TorrentTransferRateChannelsCount] = {
+            static_cast<quint64>(std::max(torrent->uploadPayloadRate(), 0)),
+            static_cast<quint64>(std::max(torrent->downloadPayloadRate(), 0))
+        };
+        auto historyIter = m_torrentTransferRateHistory.find(torrent->hash());
+        if ((historyIter == m_torrentTransferRateHistory.end()) && ((rates[0] > 0) || (rates[1] > 0))) {
+            historyIter = m_torrentTransferRateHistory.insert(torrent->hash()
+                , TimeSeries(TorrentTransferRateChannelsCount, {{300, 60, 24}}));
+            historyIter->setSampleInterval(refreshInterval());
+        }
+        if (historyIter != m_torrentTransferRateHistory.end())
+            historyIter->addSample(timestamp, rates);
+
+        if (torrent->isSeed() && (torrent->totalUpload() != uploadedBefore)
+                && (torrent->maxRatio() >= 0)) {
+            enqueueShareLimitsCheck(torrent->hash(), now);
+            shareLimitsQueueChanged = true;
+        }
+        else if (hasSeedingTimeDeadline(torrent) && !m_shareLimitsQueueIndex.contains(torrent->hash())) {
+            updateSeedingTimeDeadline(torrent);
+            shareLimitsQueueChanged = true;
+        }
     }
 
-    m_torrentStatusReport = TorrentStatusReport();
-    for (TorrentHandle *const torrent : asConst(m_torrents)) {
-        if (torrent->isDownloading())
-            ++m_torrentStatusReport.nbDownloading;
-        if (torrent->isUploading())
-            ++m_torrentStatusReport.nbSeeding;
-        if (torrent->isCompleted())
-            ++m_torrentStatusReport.nbCompleted;
-        if (torrent->isPaused())
-            ++m_torrentStatusReport.nbPaused;
-        if (torrent->isResumed())
-            ++m_torrentStatusReport.nbResumed;
-        if (torrent->isActive())
-            ++m_torrentStatusReport.nbActive;
-        if (torrent->isInactive())
-            ++m_torrentStatusReport.nbInactive;
-        if (torrent->isErrored())
-            ++m_torrentStatusReport.nbErrored;
+    if (shareLimitsQueueChanged)
+        updateSeedingLimitTimer();
+
+    if (m_isTorrentsQueueChanged && isQueueingSystemEnabled())
+        saveTorrentsQueue();
+
+    // once per tick rather than on each read
+    for (const InfoHash &hash : asConst(m_outdatedCachesTorrents)) {
+        TorrentHandle *const torrent = m_torrents.value(hash);
+        if (torrent)
+            torrent->refreshCaches();
     }
+    m_outdatedCachesTorrents.clear();
 
     emit torrentsUpdated();
 }
@@ -30,6 +30,8 @@
 #ifndef BITTORRENT_SESSION_H
 #define BITTORRENT_SESSION_H
 
+#include <functional>
+#include <map>
 #include <vector>
 
 #include <QElapsedTimer>
@@ -44,13 +46,19 @@
 #include <QVector>
 #include <QWaitCondition>
 
+#include "base/latencyhistogram.h"
 #include "base/settingvalue.h"
+#include "base/timeseries.h"
 #include "base/tristatebool.h"
 #include "base/types.h"
 #include "addtorrentparams.h"
+#include "bandwidthschedule.h"
 #include "cachestatus.h"
 #include "sessionstatus.h"
+#include "storagejobscheduler.h"
+#include "torrentindex.h"
 #include "torrentinfo.h"
+#include "trackerindex.h"
 
 namespace libtorrent
 {
@@ -79,6 +87,7 @@ namespace libtorrent
     struct storage_moved_failed_alert;
     struct metadata_received_alert;
     struct file_error_alert;
+    struct torrent_error_alert;
     struct file_completed_alert;
     struct tracker_error_alert;
     struct tracker_reply_alert;
@@ -224,12 +233,51 @@ namespace BitTorrent
         } disk;
     };
 
+    struct AlertTypeStatistics
+    {
+        QString name;
+        LatencyHistogram latency;
+    };
+
+    struct SessionMetric
+    {
+        QString name; // e.g. "net.sent_payload_bytes"
+        int valueIndex;
+        bool isGauge;
+    };
+
     class Session : public QObject
     {
         Q_OBJECT
         Q_DISABLE_COPY(Session)
 
     public:
+        // channels of transferRateHistory(), in bytes per second
+        enum TransferRateChannel
+        {
+            UploadRate,
+            DownloadRate,
+            PayloadUploadRate,
+            PayloadDownloadRate,
+            OverheadUploadRate,
+            OverheadDownloadRate,
+            DHTUploadRate,
+            DHTDownloadRate,
+            TrackerUploadRate,
+            TrackerDownloadRate,
+
+            TransferRateChannelsCount
+        };
+
+        // channels of torrentTransferRateHistory(), in bytes per second
+        enum TorrentTransferRateChannel
+        {
+            TorrentPayloadUploadRate,
+            TorrentPayloadDownloadRate,
+
+            TorrentTransferRateChannelsCount
+        };
+
         static void initInstance();
         static void freeInstance();
         static Session *instance();
@@ -323,6 +371,9 @@ namespace BitTorrent
         void setAltGlobalSpeedLimitEnabled(bool enabled);
         bool isBandwidthSchedulerEnabled() const;
         void setBandwidthSchedulerEnabled(bool enabled);
+        // The scheduler uses the single window of the preferences when it has no rule
+        BandwidthSchedule bandwidthSchedule() const;
+        void setBandwidthSchedule(const BandwidthSchedule &schedule);
 
         uint saveResumeDataInterval() const;
         void setSaveResumeDataInterval(uint value);
@@ -364,6 +415,11 @@ namespace BitTorrent
         void setAsyncIOThreads(int num);
         int checkingMemUsage() const;
         void setCheckingMemUsage(int size);
+        int maxActiveStorageJobsPerDevice() const;
+        void setMaxActiveStorageJobsPerDevice(int max);
+        // In MiB, the downloads are paused while there is less free space on their disk, 0 disables it
+        int diskSpaceReserve() const;
+        void setDiskSpaceReserve(int size);
         int diskCacheSize() const;
         void setDiskCacheSize(int size);
         int diskCacheTTL() const;
@@ -438,12 +494,34 @@ namespace BitTorrent
         void startUpTorrents();
         TorrentHandle *findTorrent(const InfoHash &hash) const;
         QHash<InfoHash, TorrentHandle *> torrents() const;
+        // Uses the torrent index to visit only the candidate torrents
+        QVector<TorrentHandle *> torrents(const TorrentFilter &filter) const;
+        const TorrentIndex &torrentIndex() const;
+        const TrackerIndex &trackerIndex() const;
+        const StorageJobScheduler *storageJobScheduler() const;
         TorrentStatusReport torrentStatusReport() const;
         bool hasActiveTorrents() const;
         bool hasUnfinishedTorrents() const;
         bool hasRunningSeed() const;
         const SessionStatus &status() const;
         const CacheStatus &cacheStatus() const;
+        // all the counters and gauges reported by libtorrent
+        const QVector<SessionMetric> &metrics() const;
+        const QVector<qint64> &metricValues() const;
+        int lastAlertsCount() const;
+        int alertsBacklog() const;
+        int alertsHighWaterMark() const;
+        const LatencyHistogram &alertsHandlingLatency() const;
+        // indexed by alert type, unnamed entries are for types not handled yet
+        const QVector<AlertTypeStatistics> &alertTypeStatistics() const;
+        // alert types with the highest total handling time
+        QVector<AlertTypeStatistics> slowestAlertTypes(int count) const;
+        // blocking torrent_handle calls made since startup, they should stay out of the hot paths
+        quint64 syncNativeCallsCount() const;
+        int pendingResumeDataCount() const;
+        const TimeSeries &transferRateHistory() const;
+        // nullptr if the torrent hasn't transferred anything since startup
+        const TimeSeries *torrentTransferRateHistory(const InfoHash &hash) const;
         quint64 getAlltimeDL() const;
         quint64 getAlltimeUL() const;
         bool isListening() const;
@@ -457,6 +535,8 @@ namespace BitTorrent
         bool addTorrent(const QString &source, const AddTorrentParams &params = AddTorrentParams());
         bool addTorrent(const TorrentInfo &torrentInfo, const AddTorrentParams &params = AddTorrentParams());
         bool deleteTorrent(const QString &hash, bool deleteLocalFiles = false);
+        // Removes the torrents in one pass, returns the number of removed torrents
+        int deleteTorrents(const QStringList &hashes, bool deleteLocalFiles = false);
         bool loadMetadata(const MagnetUri &magnetUri);
         bool cancelLoadMetadata(const InfoHash &hash);
 
@@ -465,6 +545,14 @@ namespace BitTorrent
         void decreaseTorrentsPriority(const QStringList &hashes);
         void topTorrentsPriority(const QStringList &hashes);
         void bottomTorrentsPriority(const QStringList &hashes);
+        // Cancels the queued rechecks and storage moves of the torrents
+        void cancelStorageJobs(const QStringList &hashes);
+        bool setStorageJobQueuePosition(const InfoHash &hash, int position);
+
+        // Applies the operation to the given torrents as a single transaction.
+        // Resume data of the affected torrents is saved once when it's finished
+        // and each kind of change is reported with one signal for all the torrents.
+        void applyToTorrents(const QStringList &hashes, const std::function<void (TorrentHandle *const)> &operation);
 
         // TorrentHandle interface
         void handleTorrentShareLimitChanged(TorrentHandle *const torrent);
@@ -489,23 +577,30 @@ namespace BitTorrent
         void handleTorrentTrackerReply(TorrentHandle *const torrent, const QString &trackerUrl);
         void handleTorrentTrackerWarning(TorrentHandle *const torrent, const QString &trackerUrl);
         void handleTorrentTrackerError(TorrentHandle *const torrent, const QString &trackerUrl);
+        void handleTorrentSyncNativeCall(const TorrentHandle *torrent, const char *function);
+        void handleTorrentCachesOutdated(const TorrentHandle *torrent);
+        void handleTorrentStateChanged(TorrentHandle *const torrent);
+        void handleTorrentStorageJobRequested(TorrentHandle *const torrent, StorageJob::Type type, const QStringList &paths);
+        void handleTorrentStorageJobFinished(TorrentHandle *const torrent, StorageJob::Type type);
 
     signals:
         void statsUpdated();
         void torrentsUpdated();
+        void torrentsChanged(const QVector<BitTorrent::TorrentHandle *> &torrents);
         void addTorrentFailed(const QString &error);
         void torrentAdded(BitTorrent::TorrentHandle *const torrent);
         void torrentNew(BitTorrent::TorrentHandle *const torrent);
-        void torrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent);
-        void torrentPaused(BitTorrent::TorrentHandle *const torrent);
-        void torrentResumed(BitTorrent::TorrentHandle *const torrent);
+        void torrentsAboutToBeRemoved(const QVector<BitTorrent::TorrentHandle *> &torrents);
+        // The torrent signals below are emitted once per transaction (see applyToTorrents())
+        void torrentsPaused(const QVector<BitTorrent::TorrentHandle *> &torrents);
+        void torrentsResumed(const QVector<BitTorrent::TorrentHandle *> &torrents);
         void torrentFinished(BitTorrent::TorrentHandle *const torrent);
         void torrentFinishedChecking(BitTorrent::TorrentHandle *const torrent);
-        void torrentSavePathChanged(BitTorrent::TorrentHandle *const torrent);
-        void torrentCategoryChanged(BitTorrent::TorrentHandle *const torrent, const QString &oldCategory);
-        void torrentTagAdded(TorrentHandle *const torrent, const QString &tag);
-        void torrentTagRemoved(TorrentHandle *const torrent, const QString &tag);
-        void torrentSavingModeChanged(BitTorrent::TorrentHandle *const torrent);
+        void torrentsSavePathChanged(const QVector<BitTorrent::TorrentHandle *> &torrents);
+        // The old values are the ones the torrents had when the transaction began
+        void torrentsCategoryChanged(const QVector<BitTorrent::TorrentHandle *> &torrents, const QStringList &oldCategories);
+        void torrentsTagsChanged(const QVector<BitTorrent::TorrentHandle *> &torrents, const QVector<QSet<QString>> &oldTags);
+        void torrentsSavingModeChanged(const QVector<BitTorrent::TorrentHandle *> &torrents);
         void allTorrentsFinished();
         void metadataLoaded(const BitTorrent::TorrentInfo &info);
         void torrentMetadataLoaded(BitTorrent::TorrentHandle *const torrent);
@@ -540,6 +635,10 @@ namespace BitTorrent
         void handleDownloadFinished(const QString &url, const QByteArray &data);
         void handleDownloadFailed(const QString &url, const QString &reason);
         void handleRedirectedToMagnet(const QString &url, const QString &magnetUri);
+        void handleStorageJobStarted(const BitTorrent::StorageJob &job);
+        void handleLowDiskSpace(const QString &path, qint64 bytesFree, qint64 reserve);
+        void handleFreeSpaceChanged(const QString &path);
+        void handleDiskSpaceDeviceResolved(const QString &path, const QString &device);
 
         // Session reconfiguration triggers
         void networkOnlineStateChanged(const bool online);
@@ -553,12 +652,17 @@ namespace BitTorrent
             bool requestedFileDeletion;
         };
 
+        enum class QueueMove
+        {
+            Up,
+            Down,
+            Top,
+            Bottom
+        };
+
         explicit Session(QObject *parent = nullptr);
         ~Session();
 
-        bool hasPerTorrentRatioLimit() const;
-        bool hasPerTorrentSeedingTimeLimit() const;
-
         void initResumeFolder();
 
         // Session configuration
@@ -575,6 +679,13 @@ namespace BitTorrent
         void configureListeningInterface();
         void enableTracker(bool enable);
         void enableBandwidthScheduler();
+        void setScheduledGlobalLimits(int downloadLimit, int uploadLimit);
+        void updateScheduledTorrentLimits();
+        void updateScheduledTorrentLimits(TorrentHandle *const torrent);
+        void watchDiskSpace(TorrentHandle *const torrent);
+        void watchDiskSpace(TorrentHandle *const torrent, const QString &savePath, const QString &device);
+        void unwatchDiskSpace(const InfoHash &hash);
+        void storeLowDiskSpacePausedTorrents();
         void populateAdditionalTrackers();
         void enableIPFilter();
         void disableIPFilter();
@@ -584,9 +695,28 @@ namespace BitTorrent
                              const QByteArray &fastresumeData = QByteArray());
         bool findIncompleteFiles(TorrentInfo &torrentInfo, QString &savePath) const;
 
+        // Share limits are evaluated lazily: a torrent is checked either when
+        // its upload counter moves or when its predicted seeding time deadline passes
+        bool checkShareLimits(TorrentHandle *const torrent);
+        bool hasSeedingTimeDeadline(const TorrentHandle *torrent) const;
+        void enqueueShareLimitsCheck(const InfoHash &hash, qint64 deadline);
+        void dequeueShareLimitsCheck(const InfoHash &hash);
+        void updateSeedingTimeDeadline(TorrentHandle *const torrent);
+        void recheckAllShareLimits();
         void updateSeedingLimitTimer();
         void exportTorrentFile(TorrentHandle *const torrent, TorrentExportFolder folder = TorrentExportFolder::Regular);
         void saveTorrentResumeData(TorrentHandle *const torrent);
+        // The file is copied to the export folder once it is saved
+        void saveTorrentFile(TorrentHandle *const torrent);
+        void handleTorrentFileSaveFailed(const QString &hash);
+        void markTorrentChanged(TorrentHandle *const torrent);
+        void moveTorrentsInQueue(const QStringList &hashes, QueueMove move);
+
+        // Changes made between these calls are coalesced, they can be nested
+        void beginTorrentsBatch();
+        void endTorrentsBatch();
+        // Returns the torrents that still exist and clears the set
+        QVector<TorrentHandle *> takeBatchTorrents(QSet<InfoHash> &hashes) const;
 
         void handleAlert(libtorrent::alert *a);
         void dispatchTorrentAlert(libtorrent::alert *a);
@@ -594,6 +724,7 @@ namespace BitTorrent
         void handleStateUpdateAlert(libtorrent::state_update_alert *p);
         void handleMetadataReceivedAlert(libtorrent::metadata_received_alert *p);
         void handleFileErrorAlert(libtorrent::file_error_alert *p);
+        void handleTorrentErrorAlert(libtorrent::torrent_error_alert *p);
         void handleTorrentRemovedAlert(libtorrent::torrent_removed_alert *p);
         void handleTorrentDeletedAlert(libtorrent::torrent_deleted_alert *p);
         void handleTorrentDeleteFailedAlert(libtorrent::torrent_delete_failed_alert *p);
@@ -611,9 +742,15 @@ namespace BitTorrent
 
         void saveResumeData();
         void saveTorrentsQueue();
+        void waitForTorrentsStatus();
         void removeTorrentsQueue();
 
         void getPendingAlerts(std::vector<libtorrent::alert *> &out, ulong time = 0);
+        void updateAlertsBacklogStats();
+
+        void recordTransferRates();
+        void loadTransferRateHistory();
+        void saveTransferRateHistory();
 
         // BitTorrent
         libtorrent::session *m_nativeSession;
@@ -632,6 +769,8 @@ namespace BitTorrent
         CachedSettingValue<bool> m_announceToAllTiers;
         CachedSettingValue<int> m_asyncIOThreads;
         CachedSettingValue<int> m_checkingMemUsage;
+        CachedSettingValue<int> m_maxActiveStorageJobsPerDevice;
+        CachedSettingValue<int> m_diskSpaceReserve;
         CachedSettingValue<int> m_diskCacheSize;
         CachedSettingValue<int> m_diskCacheTTL;
         CachedSettingValue<bool> m_useOSCache;
@@ -682,6 +821,7 @@ namespace BitTorrent
         CachedSettingValue<int> m_altGlobalUploadSpeedLimit;
         CachedSettingValue<bool> m_isAltGlobalSpeedLimitEnabled;
         CachedSettingValue<bool> m_isBandwidthSchedulerEnabled;
+        CachedSettingValue<QVariantList> m_bandwidthScheduleRules;
         CachedSettingValue<uint> m_saveResumeDataInterval;
         CachedSettingValue<int> m_port;
         CachedSettingValue<bool> m_useRandomPort;
@@ -696,6 +836,7 @@ namespace BitTorrent
         CachedSettingValue<SeedChokingAlgorithm> m_seedChokingAlgorithm;
         CachedSettingValue<QVariantMap> m_storedCategories;
         CachedSettingValue<QStringList> m_storedTags;
+        CachedSettingValue<QStringList> m_storedLowDiskSpacePausedTorrents;
         CachedSettingValue<int> m_maxRatioAction;
         CachedSettingValue<QString> m_defaultSavePath;
         CachedSettingValue<QString> m_tempPath;
@@ -715,6 +856,9 @@ namespace BitTorrent
 
         int m_numResumeData;
         int m_extraLimit;
+        // Limits of the active global rule of the scheduler, they replace the alternative ones
+        int m_scheduledGlobalDownloadLimit;
+        int m_scheduledGlobalUploadLimit;
         QList<BitTorrent::TrackerEntry> m_additionalTrackerList;
         QString m_resumeFolderPath;
         QFile m_resumeFolderLock;
@@ -727,6 +871,17 @@ namespace BitTorrent
         // IP filtering
         QPointer<FilterParserThread> m_filterParser;
         QPointer<BandwidthScheduler> m_bwScheduler;
+        // Torrents capped by the category and tag rules of the scheduler
+        QSet<InfoHash> m_scheduledLimitsTorrents;
+        // Free disk space
+        QHash<InfoHash, QString> m_diskSpaceWatchedPaths;
+        // The path watched for each device, the other folders of a device share its free space
+        QHash<QString, QString> m_diskSpaceDevicePaths;
+        // The device of each save path, it's resolved by the disk space monitor off the main thread
+        QHash<QString, QString> m_diskSpaceSavePathDevices;
+        // The torrents waiting for the device of their save path
+        QHash<InfoHash, QString> m_diskSpacePendingTorrents;
+        QSet<InfoHash> m_lowDiskSpacePausedTorrents;
         // Tracker
         QPointer<Tracker> m_tracker;
         // fastresume data writing thread
@@ -738,17 +893,58 @@ namespace BitTorrent
         QHash<InfoHash, CreateTorrentParams> m_addingTorrents;
         QHash<QString, AddTorrentParams> m_downloadedTorrents;
         QHash<InfoHash, RemovingTorrentData> m_removingTorrents;
-        TorrentStatusReport m_torrentStatusReport;
+        TorrentIndex m_torrentIndex;
+        TrackerIndex m_trackerIndex;
+        StorageJobScheduler *m_storageJobScheduler;
         QStringMap m_categories;
         QSet<QString> m_tags;
 
+        // Bulk operations
+        int m_torrentsBatchDepth;
+        QSet<InfoHash> m_batchResumeDataTorrents;
+        QSet<InfoHash> m_batchChangedTorrents;
+        QSet<InfoHash> m_batchPausedTorrents;
+        QSet<InfoHash> m_batchResumedTorrents;
+        QSet<InfoHash> m_batchSavePathChangedTorrents;
+        QSet<InfoHash> m_batchSavingModeChangedTorrents;
+        QHash<InfoHash, QString> m_batchOldCategories;
+        QHash<InfoHash, QSet<QString>> m_batchOldTags;
+        // The queue is saved from the cached queue positions,
+        // so it waits for the next state update once it has changed
+        bool m_isTorrentsQueueChanged;
+
+        // Share limits
+        using ShareLimitsQueue = std::multimap<qint64, InfoHash>;
+        QElapsedTimer m_shareLimitsClock;
+        ShareLimitsQueue m_shareLimitsQueue;
+        QHash<InfoHash, ShareLimitsQueue::iterator> m_shareLimitsQueueIndex;
+
         // I/O errored torrents
         QSet<InfoHash> m_recentErroredTorrents;
         QTimer *m_recentErroredTorrentsTimer;
 
         SessionMetricIndices m_metricIndices;
+        QVector<SessionMetric> m_metrics;
+        QVector<qint64> m_metricValues;
+        // Alerts are handled in time slices, the ones not handled yet stay
+        // valid until the next pop_alerts() call
+        std::vector<libtorrent::alert *> m_pendingAlerts;
+        std::size_t m_pendingAlertsPosition;
+        int m_lastAlertsCount;
+        int m_alertsHighWaterMark;
+        int m_alertsWarningLevel;
+        LatencyHistogram m_alertsHandlingLatency;
+        QVector<AlertTypeStatistics> m_alertTypeStatistics;
+        quint64 m_syncNativeCallsCount;
+        // Torrents whose outdated caches were read, they are refreshed on the next state update
+        QSet<InfoHash> m_outdatedCachesTorrents;
         QElapsedTimer m_statsUpdateTimer;
 
+        // Transfer rate history, only the global one is persisted
+        TimeSeries m_transferRateHistory;
+        QHash<InfoHash, TimeSeries> m_torrentTransferRateHistory;
+        qint64 m_transferRateHistorySaveTime;
+
         SessionStatus m_status;
         CacheStatus m_cacheStatus;
 
@@ -0,0 +1,291 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "storagejobscheduler.h"
+
+#include <algorithm>
+
+#include <QRunnable>
+
+#include "base/global.h"
+#include "base/utils/fs.h"
+
+using namespace BitTorrent;
+
+namespace
+{
+    class ResolveDevicesTask : public QRunnable
+    {
+    public:
+        ResolveDevicesTask(QObject *receiver, const int jobId, const QStringList &paths)
+            : m_receiver(receiver)
+            , m_jobId(jobId)
+            , m_paths(paths)
+        {
+        }
+
+        void run() override
+        {
+            QStringList devices;
+            for (const QString &path : m_paths) {
+                const QString device = Utils::Fs::deviceId(path);
+                if (!devices.contains(device))
+                    devices << device;
+            }
+
+            QMetaObject::invokeMethod(m_receiver, "handleDevicesResolved", Qt::QueuedConnection
+                , Q_ARG(int, m_jobId), Q_ARG(QStringList, devices));
+        }
+
+    private:
+        QObject *const m_receiver;
+        const int m_jobId;
+        const QStringList m_paths;
+    };
+}
+
+StorageJobScheduler::StorageJobScheduler(QObject *parent)
+    : QObject(parent)
+    , m_maxJobsPerDevice(1)
+    , m_lastJobId(0)
+    , m_isQueuePositionsOutdated(false)
+{
+    qRegisterMetaType<StorageJob>();
+
+    // stat() can hang on unreachable network file systems, one such call at a time is enough
+    m_threadPool.setMaxThreadCount(1);
+}
+
+StorageJobScheduler::~StorageJobScheduler()
+{
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
+}
+
+int StorageJobScheduler::maxJobsPerDevice() const
+{
+    return m_maxJobsPerDevice;
+}
+
+void StorageJobScheduler::setMaxJobsPerDevice(const int value)
+{
+    const int maxJobs = std::max(1, value);
+    if (maxJobs == m_maxJobsPerDevice) return;
+
+    m_maxJobsPerDevice = maxJobs;
+    startJobs();
+}
+
+bool StorageJobScheduler::addJob(const StorageJob &job)
+{
+    int &queuedJobTypes = m_queuedJobTypes[job.torrentHash];
+    if (queuedJobTypes & (1 << job.type)) return false;
+
+    queuedJobTypes |= (1 << job.type);
+
+    const QueuedJob queuedJob {job, ++m_lastJobId, {}, false};
+    m_queue.append(queuedJob);
+    m_isQueuePositionsOutdated = true;
+
+    m_threadPool.start(new ResolveDevicesTask(this, queuedJob.id, job.paths));
+    return true;
+}
+
+void StorageJobScheduler::handleDevicesResolved(const int jobId, const QStringList &devices)
+{
+    const auto iter = std::find_if(m_queue.begin(), m_queue.end()
+        , [jobId](const QueuedJob &queuedJob) { return (queuedJob.id == jobId); });
+    if (iter == m_queue.end()) return; // the job was cancelled meanwhile
+
+    iter->devices = devices;
+    iter->isResolved = true;
+    startJobs();
+}
+
+void StorageJobScheduler::finishJob(const InfoHash &torrentHash, const StorageJob::Type type)
+{
+    for (auto i = m_runningJobs.find(torrentHash); (i != m_runningJobs.end()) && (i.key() == torrentHash); ++i) {
+        if (i->job.type != type) continue;
+
+        releaseDevices(i->devices);
+        m_runningJobs.erase(i);
+        startJobs();
+        return;
+    }
+}
+
+QList<StorageJob> StorageJobScheduler::cancelJobs(const InfoHash &torrentHash)
+{
+    QList<StorageJob> cancelledJobs;
+    if (!m_queuedJobTypes.remove(torrentHash)) return cancelledJobs;
+
+    for (auto i = m_queue.begin(); i != m_queue.end();) {
+        if (i->job.torrentHash == torrentHash) {
+            cancelledJobs << i->job;
+            i = m_queue.erase(i);
+        }
+        else {
+            ++i;
+        }
+    }
+
+    m_isQueuePositionsOutdated = true;
+    return cancelledJobs;
+}
+
+void StorageJobScheduler::removeJobs(const InfoHash &torrentHash)
+{
+    cancelJobs(torrentHash);
+
+    if (!m_runningJobs.contains(torrentHash)) return;
+
+    for (const QueuedJob &runningJob : asConst(m_runningJobs.values(torrentHash)))
+        releaseDevices(runningJob.devices);
+    m_runningJobs.remove(torrentHash);
+    startJobs();
+}
+
+int StorageJobScheduler::queuePosition(const InfoHash &torrentHash) const
+{
+    if (!m_queuedJobTypes.contains(torrentHash)) return -1;
+
+    updateQueuePositions();
+    return m_queuePositions.value(torrentHash, -1);
+}
+
+bool StorageJobScheduler::setQueuePosition(const InfoHash &torrentHash, const int position)
+{
+    const int currentPosition = queuePosition(torrentHash);
+    if (currentPosition < 0) return false;
+
+    const int newPosition = qBound(0, position, (m_queue.size() - 1));
+    if (newPosition != currentPosition) {
+        m_queue.move(currentPosition, newPosition);
+        m_isQueuePositionsOutdated = true;
+    }
+
+    return true;
+}
+
+bool StorageJobScheduler::isJobRunning(const InfoHash &torrentHash) const
+{
+    return m_runningJobs.contains(torrentHash);
+}
+
+QList<StorageJob> StorageJobScheduler::queuedJobs() const
+{
+    QList<StorageJob> jobs;
+    jobs.reserve(m_queue.size());
+    for (const QueuedJob &queuedJob : asConst(m_queue))
+        jobs << queuedJob.job;
+    return jobs;
+}
+
+QList<StorageJob> StorageJobScheduler::runningJobs() const
+{
+    QList<StorageJob> jobs;
+    jobs.reserve(m_runningJobs.size());
+    for (const QueuedJob &runningJob : asConst(m_runningJobs))
+        jobs << runningJob.job;
+    return jobs;
+}
+
+void StorageJobScheduler::startJobs()
+{
+    QList<StorageJob> startedJobs;
+    for (auto i = m_queue.begin(); i != m_queue.end();) {
+        if (!canStart(*i)) {
+            ++i;
+            continue;
+        }
+
+        for (const QString &device : asConst(i->devices))
+            ++m_deviceJobsCount[device];
+
+        const InfoHash torrentHash = i->job.torrentHash;
+        int &queuedJobTypes = m_queuedJobTypes[torrentHash];
+        queuedJobTypes &= ~(1 << i->job.type);
+        if (queuedJobTypes == 0)
+            m_queuedJobTypes.remove(torrentHash);
+
+        m_runningJobs.insert(torrentHash, *i);
+        startedJobs << i->job;
+        i = m_queue.erase(i);
+    }
+
+    if (startedJobs.isEmpty()) return;
+
+    // The jobs are announced once the queue is consistent
+    // since the owner can finish them right away
+    m_isQueuePositionsOutdated = true;
+    for (const StorageJob &job : asConst(startedJobs))
+        emit jobStarted(job);
+}
+
+bool StorageJobScheduler::canStart(const QueuedJob &queuedJob) const
+{
+    if (!queuedJob.isResolved)
+        return false;
+
+    // Jobs of the same torrent never run in parallel
+    if (m_runningJobs.contains(queuedJob.job.torrentHash))
+        return false;
+
+    for (const QString &device : queuedJob.devices) {
+        if (m_deviceJobsCount.value(device) >= m_maxJobsPerDevice)
+            return false;
+    }
+
+    return true;
+}
+
+void StorageJobScheduler::releaseDevices(const QStringList &devices)
+{
+    for (const QString &device : devices) {
+        const auto iter = m_deviceJobsCount.find(device);
+        if (iter == m_deviceJobsCount.end()) continue;
+
+        if (--iter.value() <= 0)
+            m_deviceJobsCount.erase(iter);
+    }
+}
+
+void StorageJobScheduler::updateQueuePositions() const
+{
+    if (!m_isQueuePositionsOutdated) return;
+
+    m_queuePositions.clear();
+    for (int i = 0; i < m_queue.size(); ++i) {
+        const InfoHash &torrentHash = m_queue[i].job.torrentHash;
+        if (!m_queuePositions.contains(torrentHash))
+            m_queuePositions.insert(torrentHash, i);
+    }
+
+    m_isQueuePositionsOutdated = false;
+}
@@ -0,0 +1,125 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+
+#include "infohash.h"
+
+namespace BitTorrent
+{
+    struct StorageJob
+    {
+        enum Type
+        {
+            Recheck,
+            Move
+        };
+
+        InfoHash torrentHash;
+        Type type = Recheck;
+        // Locations of the data the job reads or writes
+        QStringList paths;
+    };
+
+    // Queues the torrent rechecks and storage moves and limits how many
+    // of them run at once on the same file system device, since parallel
+    // jobs on the same disk are slower than sequential ones.
+    // The owner does the actual work when a job is started
+    // and reports its end with finishJob().
+    // The devices of the job paths are resolved on a worker thread,
+    // a job waits in the queue until they are known.
+    class StorageJobScheduler : public QObject
+    {
+        Q_OBJECT
+        Q_DISABLE_COPY(StorageJobScheduler)
+
+    public:
+        explicit StorageJobScheduler(QObject *parent = nullptr);
+        ~StorageJobScheduler() override;
+
+        int maxJobsPerDevice() const;
+        void setMaxJobsPerDevice(int value);
+
+        // Returns false if the same job is already queued
+        bool addJob(const StorageJob &job);
+        void finishJob(const InfoHash &torrentHash, StorageJob::Type type);
+        // Cancels the queued jobs of the torrent and returns them
+        QList<StorageJob> cancelJobs(const InfoHash &torrentHash);
+        // Cancels the queued jobs of the torrent and forgets the running ones
+        void removeJobs(const InfoHash &torrentHash);
+
+        // Returns -1 if the torrent has no queued job
+        int queuePosition(const InfoHash &torrentHash) const;
+        bool setQueuePosition(const InfoHash &torrentHash, int position);
+        bool isJobRunning(const InfoHash &torrentHash) const;
+
+        QList<StorageJob> queuedJobs() const;
+        QList<StorageJob> runningJobs() const;
+
+    signals:
+        void jobStarted(const BitTorrent::StorageJob &job);
+
+    private slots:
+        void handleDevicesResolved(int jobId, const QStringList &devices);
+
+    private:
+        struct QueuedJob
+        {
+            StorageJob job;
+            int id;
+            QStringList devices;
+            bool isResolved;
+        };
+
+        void startJobs();
+        bool canStart(const QueuedJob &queuedJob) const;
+        void releaseDevices(const QStringList &devices);
+        void updateQueuePositions() const;
+
+        int m_maxJobsPerDevice;
+        int m_lastJobId;
+        QThreadPool m_threadPool;
+        QList<QueuedJob> m_queue;
+        // Types of the queued jobs of each torrent, as bit flags
+        QHash<InfoHash, int> m_queuedJobTypes;
+        QMultiHash<InfoHash, QueuedJob> m_runningJobs;
+        QHash<QString, int> m_deviceJobsCount;
+        mutable QHash<InfoHash, int> m_queuePositions;
+        mutable bool m_isQueuePositionsOutdated;
+    };
+}
+
+Q_DECLARE_METATYPE(BitTorrent::StorageJob)
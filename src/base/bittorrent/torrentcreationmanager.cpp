@@ -0,0 +1,329 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "torrentcreationmanager.h"
+
+#include <algorithm>
+
+#include <QUuid>
+
+#include "base/global.h"
+#include "base/logger.h"
+#include "base/utils/fs.h"
+#include "addtorrentparams.h"
+#include "session.h"
+#include "torrentinfo.h"
+
+#define SETTINGS_KEY(name) "BitTorrent/TorrentCreator/" name
+
+using namespace BitTorrent;
+
+namespace
+{
+    // Finished, failed and cancelled jobs are forgotten after a while
+    // so that a long running instance doesn't accumulate them
+    const int FINISHED_JOB_TTL = 60 * 60; // in seconds
+    const int MAX_FINISHED_JOBS = 100;
+    const int PRUNE_INTERVAL = 5 * 60 * 1000; // in milliseconds
+
+    bool isJobDone(const TorrentCreationJob &job)
+    {
+        return ((job.status == TorrentCreationStatus::Finished)
+            || (job.status == TorrentCreationStatus::Failed)
+            || (job.status == TorrentCreationStatus::Cancelled));
+    }
+}
+
+qlonglong TorrentCreationJob::throughput() const
+{
+    if (status != TorrentCreationStatus::Finished)
+        return 0;
+
+    const qint64 elapsedMSecs = std::max<qint64>(1, timeStarted.msecsTo(timeFinished));
+    return (totalSize * 1000 / elapsedMSecs);
+}
+
+TorrentCreationManager *TorrentCreationManager::m_instance = nullptr;
+
+TorrentCreationManager::TorrentCreationManager()
+    : m_maxConcurrentJobs(SETTINGS_KEY("MaxConcurrentJobs"), 1
+        , [](const int value) { return std::max(1, value); })
+{
+    m_pruneTimer.setInterval(PRUNE_INTERVAL);
+    connect(&m_pruneTimer, &QTimer::timeout, this, &TorrentCreationManager::pruneFinishedJobs);
+    m_pruneTimer.start();
+}
+
+TorrentCreationManager::~TorrentCreationManager()
+{
+    // the running jobs could still write their files
+    m_queuedJobs.clear();
+    qDeleteAll(m_runningJobs);
+
+    for (const TorrentCreationJob &job : asConst(m_jobs))
+        removeJobFile(job);
+    for (const QString &path : asConst(m_deletedJobFiles))
+        Utils::Fs::forceRemove(path);
+}
+
+void TorrentCreationManager::initInstance()
+{
+    if (!m_instance)
+        m_instance = new TorrentCreationManager;
+}
+
+void TorrentCreationManager::freeInstance()
+{
+    // running creator threads are children of the manager,
+    // they are interrupted and waited for on deletion
+    delete m_instance;
+    m_instance = nullptr;
+}
+
+TorrentCreationManager *TorrentCreationManager::instance()
+{
+    return m_instance;
+}
+
+QString TorrentCreationManager::addJob(const TorrentCreatorParams &params, const bool startSeeding, const bool ignoreShareLimits)
+{
+    TorrentCreationJob job;
+    job.id = QUuid::createUuid().toString().mid(1, 36);
+    job.params = params;
+    if (job.params.savePath.isEmpty()) {
+        job.params.savePath = Utils::Fs::tempPath() + job.id + QLatin1String(".torrent");
+        job.isTorrentFileTemporary = true;
+    }
+    job.startSeeding = startSeeding;
+    job.ignoreShareLimits = ignoreShareLimits;
+    job.timeAdded = QDateTime::currentDateTime();
+
+    pruneFinishedJobs();
+
+    m_jobs.insert(job.id, job);
+    m_queuedJobs.enqueue(job.id);
+    startQueuedJobs();
+
+    return job.id;
+}
+
+bool TorrentCreationManager::cancelJob(const QString &id)
+{
+    const auto iter = m_jobs.find(id);
+    if (iter == m_jobs.end())
+        return false;
+
+    switch (iter->status) {
+    case TorrentCreationStatus::Queued:
+        m_queuedJobs.removeOne(id);
+        iter->status = TorrentCreationStatus::Cancelled;
+        iter->timeFinished = QDateTime::currentDateTime();
+        return true;
+    case TorrentCreationStatus::Running:
+        // the job is marked as cancelled once its thread finishes
+        m_runningJobs[id]->requestInterruption();
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool TorrentCreationManager::deleteJob(const QString &id)
+{
+    if (!m_jobs.contains(id))
+        return false;
+
+    cancelJob(id);
+    const TorrentCreationJob job = m_jobs.take(id);
+    if (job.isTorrentFileTemporary && m_runningJobs.contains(id))
+        m_deletedJobFiles.insert(id, job.params.savePath);
+    else
+        removeJobFile(job);
+
+    return true;
+}
+
+bool TorrentCreationManager::hasJob(const QString &id) const
+{
+    return m_jobs.contains(id);
+}
+
+TorrentCreationJob TorrentCreationManager::job(const QString &id) const
+{
+    return m_jobs.value(id);
+}
+
+QList<TorrentCreationJob> TorrentCreationManager::jobs() const
+{
+    QList<TorrentCreationJob> jobs = m_jobs.values();
+    std::sort(jobs.begin(), jobs.end(), [](const TorrentCreationJob &left, const TorrentCreationJob &right)
+    {
+        return (left.timeAdded < right.timeAdded);
+    });
+    return jobs;
+}
+
+int TorrentCreationManager::maxConcurrentJobs() const
+{
+    return m_maxConcurrentJobs;
+}
+
+void TorrentCreationManager::setMaxConcurrentJobs(const int max)
+{
+    if (max == m_maxConcurrentJobs)
+        return;
+
+    m_maxConcurrentJobs = std::max(1, max);
+    startQueuedJobs();
+}
+
+void TorrentCreationManager::startQueuedJobs()
+{
+    while (!m_queuedJobs.isEmpty() && (m_runningJobs.size() < m_maxConcurrentJobs)) {
+        const QString id = m_queuedJobs.dequeue();
+        TorrentCreationJob &job = m_jobs[id];
+        job.status = TorrentCreationStatus::Running;
+        job.timeStarted = QDateTime::currentDateTime();
+
+        auto *thread = new TorrentCreatorThread(this);
+        connect(thread, &TorrentCreatorThread::updateProgress, this, [this, id](const int progress)
+        {
+            const auto iter = m_jobs.find(id);
+            if (iter != m_jobs.end())
+                iter->progress = progress;
+        });
+        connect(thread, &TorrentCreatorThread::creationSuccess, this, [this, id](const QString &path, const QString &branchPath)
+        {
+            handleCreationSuccess(id, path, branchPath);
+        });
+        connect(thread, &TorrentCreatorThread::creationFailure, this, [this, id](const QString &msg)
+        {
+            handleCreationFailure(id, msg);
+        });
+        connect(thread, &QThread::finished, this, [this, id]() { handleThreadFinished(id); });
+        connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+
+        m_runningJobs.insert(id, thread);
+        thread->create(job.params);
+    }
+}
+
+void TorrentCreationManager::handleCreationSuccess(const QString &id, const QString &path, const QString &branchPath)
+{
+    const auto iter = m_jobs.find(id);
+    if (iter == m_jobs.end())
+        return;
+
+    const TorrentInfo torrentInfo = TorrentInfo::loadFromFile(Utils::Fs::toNativePath(path));
+    if (!torrentInfo.isValid()) {
+        handleCreationFailure(id, tr("Created torrent is invalid."));
+        return;
+    }
+
+    iter->status = TorrentCreationStatus::Finished;
+    iter->progress = 100;
+    iter->totalSize = torrentInfo.totalSize();
+    iter->timeFinished = QDateTime::currentDateTime();
+
+    if (iter->startSeeding) {
+        AddTorrentParams params;
+        params.savePath = branchPath;
+        params.skipChecking = true;
+        params.ignoreShareLimits = iter->ignoreShareLimits;
+
+        Session::instance()->addTorrent(torrentInfo, params);
+    }
+
+    Logger::instance()->addMessage(tr("Torrent created: '%1'").arg(Utils::Fs::toNativePath(path)));
+    emit jobFinished(id);
+}
+
+void TorrentCreationManager::handleCreationFailure(const QString &id, const QString &msg)
+{
+    const auto iter = m_jobs.find(id);
+    if (iter == m_jobs.end())
+        return;
+
+    iter->status = TorrentCreationStatus::Failed;
+    iter->errorMessage = msg;
+    iter->timeFinished = QDateTime::currentDateTime();
+
+    Logger::instance()->addMessage(tr("Torrent creation failed: '%1'. Reason: %2")
+        .arg(Utils::Fs::toNativePath(iter->params.savePath), msg), Log::WARNING);
+    emit jobFailed(id, msg);
+}
+
+void TorrentCreationManager::handleThreadFinished(const QString &id)
+{
+    m_runningJobs.remove(id);
+
+    const QString deletedJobFile = m_deletedJobFiles.take(id);
+    if (!deletedJobFile.isEmpty())
+        Utils::Fs::forceRemove(deletedJobFile);
+
+    const auto iter = m_jobs.find(id);
+    if ((iter != m_jobs.end()) && (iter->status == TorrentCreationStatus::Running)) {
+        // the thread was interrupted
+        iter->status = TorrentCreationStatus::Cancelled;
+        iter->timeFinished = QDateTime::currentDateTime();
+    }
+
+    startQueuedJobs();
+}
+
+void TorrentCreationManager::pruneFinishedJobs()
+{
+    QList<TorrentCreationJob> doneJobs;
+    for (const TorrentCreationJob &job : asConst(m_jobs)) {
+        if (isJobDone(job))
+            doneJobs << job;
+    }
+
+    // most recently finished first
+    std::sort(doneJobs.begin(), doneJobs.end(), [](const TorrentCreationJob &left, const TorrentCreationJob &right)
+    {
+        return (left.timeFinished > right.timeFinished);
+    });
+
+    const QDateTime expiryTime = QDateTime::currentDateTime().addSecs(-FINISHED_JOB_TTL);
+    for (int i = 0; i < doneJobs.size(); ++i) {
+        const TorrentCreationJob &job = doneJobs[i];
+        if ((i < MAX_FINISHED_JOBS) && (job.timeFinished >= expiryTime))
+            continue;
+
+        m_jobs.remove(job.id);
+        removeJobFile(job);
+    }
+}
+
+void TorrentCreationManager::removeJobFile(const TorrentCreationJob &job)
+{
+    if (job.isTorrentFileTemporary)
+        Utils::Fs::forceRemove(job.params.savePath);
+}
@@ -0,0 +1,124 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QTimer>
+
+#include "base/settingvalue.h"
+#include "torrentcreatorthread.h"
+
+namespace BitTorrent
+{
+    enum class TorrentCreationStatus
+    {
+        Queued,
+        Running,
+        Finished,
+        Failed,
+        Cancelled
+    };
+
+    struct TorrentCreationJob
+    {
+        QString id;
+        TorrentCreatorParams params;
+        bool startSeeding = false;
+        bool ignoreShareLimits = false;
+        // The torrent file was put in the temporary folder, it is removed along with the job
+        bool isTorrentFileTemporary = false;
+
+        TorrentCreationStatus status = TorrentCreationStatus::Queued;
+        int progress = 0;
+        QString errorMessage;
+        qlonglong totalSize = 0;
+        QDateTime timeAdded;
+        QDateTime timeStarted;
+        QDateTime timeFinished;
+
+        // average hashing speed in bytes/s, known once the job is finished
+        qlonglong throughput() const;
+    };
+
+    // Runs torrent creation jobs in the background, a limited number at a time
+    // so that several jobs don't compete for the same disks
+    class TorrentCreationManager : public QObject
+    {
+        Q_OBJECT
+        Q_DISABLE_COPY(TorrentCreationManager)
+
+    public:
+        static void initInstance();
+        static void freeInstance();
+        static TorrentCreationManager *instance();
+
+        // The torrent file is created in the temporary folder if params.savePath is empty
+        QString addJob(const TorrentCreatorParams &params, bool startSeeding, bool ignoreShareLimits);
+        bool cancelJob(const QString &id);
+        bool deleteJob(const QString &id);
+
+        bool hasJob(const QString &id) const;
+        TorrentCreationJob job(const QString &id) const;
+        QList<TorrentCreationJob> jobs() const;
+
+        int maxConcurrentJobs() const;
+        void setMaxConcurrentJobs(int max);
+
+    signals:
+        void jobFinished(const QString &id);
+        void jobFailed(const QString &id, const QString &reason);
+
+    private:
+        TorrentCreationManager();
+        ~TorrentCreationManager() override;
+
+        void startQueuedJobs();
+        void handleCreationSuccess(const QString &id, const QString &path, const QString &branchPath);
+        void handleCreationFailure(const QString &id, const QString &msg);
+        void handleThreadFinished(const QString &id);
+        void pruneFinishedJobs();
+        void removeJobFile(const TorrentCreationJob &job);
+
+        static TorrentCreationManager *m_instance;
+
+        CachedSettingValue<int> m_maxConcurrentJobs;
+        QHash<QString, TorrentCreationJob> m_jobs;
+        QQueue<QString> m_queuedJobs;
+        QHash<QString, TorrentCreatorThread *> m_runningJobs;
+        // Temporary files of the jobs deleted while running, removed once their thread is done
+        QHash<QString, QString> m_deletedJobFiles;
+        QTimer m_pruneTimer;
+    };
+}
@@ -28,34 +28,73 @@
 
 #include "torrentcreatorthread.h"
 
+#include <algorithm>
 #include <fstream>
+#include <vector>
 
 #include <libtorrent/bencode.hpp>
 #include <libtorrent/create_torrent.hpp>
+#include <libtorrent/hasher.hpp>
 #include <libtorrent/storage.hpp>
 #include <libtorrent/torrent_info.hpp>
 
+#include <QAtomicInt>
+#include <QByteArray>
 #include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
 #include <QHash>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
 
 #include "base/global.h"
 #include "base/utils/fs.h"
 #include "base/utils/misc.h"
 #include "base/utils/string.h"
 
+namespace libt = libtorrent;
+
 namespace
 {
+    // upper bound of the piece data read ahead of the hashing threads
+    const qint64 MAX_QUEUED_PIECES_SIZE = 256 * 1024 * 1024;
+
     // do not include files and folders whose
     // name starts with a .
     bool fileFilter(const std::string &f)
     {
         return !Utils::Fs::fileName(QString::fromStdString(f)).startsWith('.');
     }
+
+    class PieceHasher final : public QRunnable
+    {
+    public:
+        PieceHasher(const QByteArray &data, libt::sha1_hash &result, QSemaphore &freeSlots, QAtomicInt &hashedCount)
+            : m_data(data)
+            , m_result(result)
+            , m_freeSlots(freeSlots)
+            , m_hashedCount(hashedCount)
+        {
+        }
+
+        void run() override
+        {
+            m_result = libt::hasher(m_data.constData(), m_data.size()).final();
+            m_data.clear();
+
+            m_hashedCount.ref();
+            m_freeSlots.release();
+        }
+
+    private:
+        QByteArray m_data;
+        libt::sha1_hash &m_result;
+        QSemaphore &m_freeSlots;
+        QAtomicInt &m_hashedCount;
+    };
 }
 
-namespace libt = libtorrent;
 using namespace BitTorrent;
 
 TorrentCreatorThread::TorrentCreatorThread(QObject *parent)
@@ -151,8 +190,8 @@ void TorrentCreatorThread::run()
         if (isInterruptionRequested()) return;
 
         // calculate the hash for all pieces
-        libt::set_piece_hashes(newTorrent, Utils::Fs::toNativePath(parentPath).toStdString()
-            , [this, &newTorrent](const int n) { sendProgressSignal(n, newTorrent.num_pieces()); });
+        if (!hashPieces(newTorrent, Utils::Fs::toNativePath(parentPath).toStdString()))
+            return;
         // Set qBittorrent as creator and add user comment to
         // torrent_info structure
         newTorrent.set_creator(creatorStr.toUtf8().constData());
@@ -194,6 +233,103 @@ void TorrentCreatorThread::run()
     }
 }
 
+// Files are read sequentially on this thread while the pieces are hashed
+// independently by a pool of worker threads. The amount of data waiting
+// to be hashed is bounded so memory usage does not depend on torrent size.
+bool TorrentCreatorThread::hashPieces(libt::create_torrent &newTorrent, const std::string &basePath)
+{
+    const libt::file_storage &fs = newTorrent.files();
+    const int numPieces = newTorrent.num_pieces();
+    const int threadCount = (m_params.hashingThreadCount > 0)
+        ? m_params.hashingThreadCount : std::max(1, QThread::idealThreadCount());
+    const int maxQueuedPieces = std::max(2, static_cast<int>(std::min<qint64>((threadCount * 4)
+        , (MAX_QUEUED_PIECES_SIZE / fs.piece_length()))));
+
+    std::vector<libt::sha1_hash> pieceHashes(numPieces);
+    QSemaphore freeSlots(maxQueuedPieces);
+    QAtomicInt hashedCount(0);
+    int reportedCount = 0;
+    QThreadPool hashingPool;
+    hashingPool.setMaxThreadCount(threadCount);
+
+    const auto cancel = [&hashingPool]()
+    {
+        hashingPool.clear();
+        hashingPool.waitForDone();
+    };
+
+    int pieceIndex = 0;
+    QByteArray pieceData;
+    pieceData.reserve(fs.piece_length());
+
+    const auto submitPiece = [&]()
+    {
+        freeSlots.acquire();
+        hashingPool.start(new PieceHasher(pieceData, pieceHashes[pieceIndex], freeSlots, hashedCount));
+        pieceData = QByteArray();
+        pieceData.reserve(fs.piece_length());
+        ++pieceIndex;
+
+        const int currentCount = hashedCount.load();
+        if (currentCount != reportedCount) {
+            reportedCount = currentCount;
+            sendProgressSignal(currentCount, numPieces);
+        }
+    };
+
+    for (int fileIndex = 0; fileIndex < fs.num_files(); ++fileIndex) {
+        qint64 remaining = fs.file_size(fileIndex);
+
+        if (fs.pad_file_at(fileIndex)) {
+            while (remaining > 0) {
+                const int chunkSize = static_cast<int>(std::min<qint64>(remaining, (fs.piece_size(pieceIndex) - pieceData.size())));
+                pieceData.append(QByteArray(chunkSize, '\0'));
+                remaining -= chunkSize;
+                if (pieceData.size() == fs.piece_size(pieceIndex))
+                    submitPiece();
+            }
+            continue;
+        }
+
+        const QString filePath = QString::fromStdString(fs.file_path(fileIndex, basePath));
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            cancel();
+            throw std::runtime_error(tr("Failed to read file '%1': %2").arg(filePath, file.errorString()).toStdString());
+        }
+
+        while (remaining > 0) {
+            if (isInterruptionRequested()) {
+                cancel();
+                return false;
+            }
+
+            const int offset = pieceData.size();
+            const int chunkSize = static_cast<int>(std::min<qint64>(remaining, (fs.piece_size(pieceIndex) - offset)));
+            pieceData.resize(offset + chunkSize);
+            if (file.read((pieceData.data() + offset), chunkSize) != chunkSize) {
+                cancel();
+                throw std::runtime_error(tr("Failed to read file '%1': %2").arg(filePath, file.errorString()).toStdString());
+            }
+
+            remaining -= chunkSize;
+            if (pieceData.size() == fs.piece_size(pieceIndex))
+                submitPiece();
+        }
+    }
+
+    hashingPool.waitForDone();
+    if (isInterruptionRequested())
+        return false;
+
+    Q_ASSERT(pieceIndex == numPieces);
+    for (int i = 0; i < numPieces; ++i)
+        newTorrent.set_hash(i, pieceHashes[i]);
+    sendProgressSignal(numPieces, numPieces);
+
+    return true;
+}
+
 int TorrentCreatorThread::calculateTotalPieces(const QString &inputPath, const int pieceSize, const bool isAlignmentOptimized)
 {
     if (inputPath.isEmpty())
@@ -29,22 +29,31 @@
 #ifndef BITTORRENT_TORRENTCREATORTHREAD_H
 #define BITTORRENT_TORRENTCREATORTHREAD_H
 
+#include <string>
+
 #include <QStringList>
 #include <QThread>
 
+namespace libtorrent
+{
+    struct create_torrent;
+}
+
 namespace BitTorrent
 {
     struct TorrentCreatorParams
     {
-        bool isPrivate;
-        bool isAlignmentOptimized;
-        int pieceSize;
+        bool isPrivate = false;
+        bool isAlignmentOptimized = false;
+        int pieceSize = 0;
         QString inputPath;
         QString savePath;
         QString comment;
         QString source;
         QStringList trackers;
         QStringList urlSeeds;
+        // Threads hashing the pieces, 0 for one per CPU core
+        int hashingThreadCount = 0;
     };
 
     class TorrentCreatorThread : public QThread
@@ -69,6 +78,7 @@ namespace BitTorrent
 
     private:
         void sendProgressSignal(int currentPieceIdx, int totalPieces);
+        bool hashPieces(libtorrent::create_torrent &newTorrent, const std::string &basePath);
 
         TorrentCreatorParams m_params;
     };
@@ -78,6 +78,14 @@ namespace
             entryList.emplace_back(setValue.toStdString());
         return entryList;
     }
+
+    // The lowest positive limit, the other values mean no limit
+    int effectiveRateLimit(const int ownLimit, const int scheduledLimit)
+    {
+        if (scheduledLimit <= 0) return ownLimit;
+        if (ownLimit <= 0) return scheduledLimit;
+        return std::min(ownLimit, scheduledLimit);
+    }
 }
 
 // AddTorrentData
@@ -163,6 +171,12 @@ TorrentHandle::TorrentHandle(Session *session, const libtorrent::torrent_handle
     , m_hasRootFolder(params.hasRootFolder)
     , m_needsToSetFirstLastPiecePriority(false)
     , m_needsToStartForced(params.forced)
+    , m_isTrackerEntriesOutdated(true)
+    , m_isFilesProgressOutdated(true)
+    , m_downloadLimit(0)
+    , m_uploadLimit(0)
+    , m_scheduledDownloadLimit(0)
+    , m_scheduledUploadLimit(0)
 {
     if (m_useAutoTMM)
         m_savePath = Utils::Fs::toNativePath(m_session->categorySavePath(m_category));
@@ -170,6 +184,13 @@ TorrentHandle::TorrentHandle(Session *session, const libtorrent::torrent_handle
     updateStatus();
     m_hash = InfoHash(m_nativeStatus.info_hash);
 
+    m_session->handleTorrentSyncNativeCall(this, "download_limit");
+    m_downloadLimit = m_nativeHandle.download_limit();
+    m_session->handleTorrentSyncNativeCall(this, "upload_limit");
+    m_uploadLimit = m_nativeHandle.upload_limit();
+    // the tracker entries are filled on the next state update
+    m_session->handleTorrentCachesOutdated(this);
+
     // NB: the following two if statements are present because we don't want
     // to set either sequential download or first/last piece priority to false
     // if their respective flags in data are false when a torrent is being
@@ -345,13 +366,9 @@ QString TorrentHandle::nativeActualSavePath() const
 
 QList<TrackerEntry> TorrentHandle::trackers() const
 {
-    QList<TrackerEntry> entries;
-    const std::vector<libt::announce_entry> announces = m_nativeHandle.trackers();
-
-    for (const libt::announce_entry &tracker : announces)
-        entries << tracker;
-
-    return entries;
+    if (m_isTrackerEntriesOutdated)
+        m_session->handleTorrentCachesOutdated(this);
+    return m_trackerEntries;
 }
 
 QHash<QString, TrackerInfo> TorrentHandle::trackerInfos() const
@@ -367,8 +384,11 @@ void TorrentHandle::addTrackers(const QList<TrackerEntry> &trackers)
             addedTrackers << tracker;
     }
 
-    if (!addedTrackers.isEmpty())
+    if (!addedTrackers.isEmpty()) {
+        m_isTrackerEntriesOutdated = true;
+        m_session->handleTorrentCachesOutdated(this);
         m_session->handleTorrentTrackersAdded(this, addedTrackers);
+    }
 }
 
 void TorrentHandle::replaceTrackers(const QList<TrackerEntry> &trackers)
@@ -386,6 +406,10 @@ void TorrentHandle::replaceTrackers(const QList<TrackerEntry> &trackers)
     }
 
     m_nativeHandle.replace_trackers(announces);
+    // the new entries are known already, their states come with the next refresh
+    m_trackerEntries = trackers;
+    m_isTrackerEntriesOutdated = true;
+    m_session->handleTorrentCachesOutdated(this);
     if (addedTrackers.isEmpty() && existingTrackers.isEmpty()) {
         m_session->handleTorrentTrackersChanged(this);
     }
@@ -403,6 +427,8 @@ bool TorrentHandle::addTracker(const TrackerEntry &tracker)
         return false;
 
     m_nativeHandle.add_tracker(tracker.nativeEntry());
+    // keeps the duplicates out until the entries are refreshed
+    m_trackerEntries << tracker;
     return true;
 }
 
@@ -776,7 +802,7 @@ void TorrentHandle::updateState()
     if (m_nativeStatus.state == libt::torrent_status::checking_resume_data) {
         m_state = TorrentState::CheckingResumeData;
     }
-    else if (isMoveInProgress()) {
+    else if (isMoveRunning()) {
         m_state = TorrentState::Moving;
     }
     else if (isPaused()) {
@@ -924,21 +950,22 @@ qulonglong TorrentHandle::eta() const
 
 QVector<qreal> TorrentHandle::filesProgress() const
 {
-    std::vector<boost::int64_t> fp;
-    m_nativeHandle.file_progress(fp, libt::torrent_handle::piece_granularity);
+    if (!hasMetadata())
+        return {};
 
-    const int count = static_cast<int>(fp.size());
-    QVector<qreal> result;
-    result.reserve(count);
-    for (int i = 0; i < count; ++i) {
-        const qlonglong size = fileSize(i);
-        if ((size <= 0) || (fp[i] == size))
-            result << 1;
+    const int count = filesCount();
+    if (m_isFilesProgressOutdated || (m_filesProgress.size() != count)) {
+        if (isFilesProgressKnown())
+            updateFilesProgress();
         else
-            result << (fp[i] / static_cast<qreal>(size));
+            m_session->handleTorrentCachesOutdated(this);
     }
 
-    return result;
+    // until the first refresh
+    if (m_filesProgress.size() != count)
+        return QVector<qreal>(count, 0);
+
+    return m_filesProgress;
 }
 
 int TorrentHandle::seedsCount() const
@@ -1019,12 +1046,12 @@ int TorrentHandle::timeSinceActivity() const
 
 int TorrentHandle::downloadLimit() const
 {
-    return m_nativeHandle.download_limit();
+    return m_downloadLimit;
 }
 
 int TorrentHandle::uploadLimit() const
 {
-    return m_nativeHandle.upload_limit();
+    return m_uploadLimit;
 }
 
 bool TorrentHandle::superSeeding() const
@@ -1219,13 +1246,7 @@ void TorrentHandle::forceRecheck()
 {
     if (!hasMetadata()) return;
 
-    m_nativeHandle.force_recheck();
-    m_unchecked = false;
-
-    if (isPaused()) {
-        m_nativeHandle.stop_when_ready(true);
-        resume_impl(true, true);
-    }
+    m_session->handleTorrentStorageJobRequested(this, StorageJob::Recheck, {nativeActualSavePath()});
 }
 
 void TorrentHandle::setSequentialDownload(bool b)
@@ -1333,15 +1354,60 @@ void TorrentHandle::moveStorage(const QString &newPath, bool overwrite)
         if (QDir(oldPath) == QDir(newPath)) return;
 
         qDebug("move storage: %s to %s", qUtf8Printable(oldPath), qUtf8Printable(newPath));
-        // Actually move the storage
-        m_nativeHandle.move_storage(newPath.toUtf8().constData()
-                                    , (overwrite ? libt::always_replace_files : libt::dont_replace));
         m_moveStorageInfo.oldPath = oldPath;
         m_moveStorageInfo.newPath = newPath;
-        updateState();
+        m_moveStorageInfo.overwrite = overwrite;
+        m_moveStorageInfo.isStarted = false;
+        // The storage is actually moved once the job is started
+        m_session->handleTorrentStorageJobRequested(this, StorageJob::Move, {oldPath, newPath});
+    }
+}
+
+void TorrentHandle::handleStorageJobStarted(const StorageJob::Type type)
+{
+    switch (type) {
+    case StorageJob::Recheck:
+        if (!hasMetadata()) {
+            m_session->handleTorrentStorageJobFinished(this, type);
+            return;
+        }
+
+        m_nativeHandle.force_recheck();
+        m_unchecked = false;
+
+        if (isPaused()) {
+            m_nativeHandle.stop_when_ready(true);
+            resume_impl(true, true);
+        }
+        break;
+    case StorageJob::Move: {
+            qDebug("start moving storage to %s", qUtf8Printable(m_moveStorageInfo.newPath));
+            m_moveStorageInfo.isStarted = true;
+            m_nativeHandle.move_storage(m_moveStorageInfo.newPath.toUtf8().constData()
+                                        , (m_moveStorageInfo.overwrite ? libt::always_replace_files : libt::dont_replace));
+
+            const TorrentState oldState = m_state;
+            updateState();
+            if (m_state != oldState)
+                m_session->handleTorrentStateChanged(this);
+        }
+        break;
     }
 }
 
+void TorrentHandle::handleStorageJobCancelled(const StorageJob::Type type)
+{
+    if (type != StorageJob::Move) return;
+
+    qDebug("cancel moving storage to %s", qUtf8Printable(m_moveStorageInfo.newPath));
+    m_moveStorageInfo.newPath.clear();
+    m_moveStorageInfo.queuedPath.clear();
+    updateStatus();
+
+    while (!isMoveInProgress() && (m_renameCount == 0) && !m_moveFinishedTriggers.isEmpty())
+        m_moveFinishedTriggers.takeFirst()();
+}
+
 void TorrentHandle::renameFile(int index, const QString &name)
 {
     ++m_renameCount;
@@ -1349,20 +1415,16 @@ void TorrentHandle::renameFile(int index, const QString &name)
     m_nativeHandle.rename_file(index, Utils::Fs::toNativePath(name).toStdString());
 }
 
-bool TorrentHandle::saveTorrentFile(const QString &path)
+QByteArray TorrentHandle::torrentFileData() const
 {
-    if (!m_torrentInfo.isValid()) return false;
+    if (!m_torrentInfo.isValid()) return {};
 
     libt::create_torrent torrentCreator = libt::create_torrent(*(m_torrentInfo.nativeInfo()), true);
     libt::entry torrentEntry = torrentCreator.generate();
 
-    QVector<char> out;
+    QByteArray out;
     libt::bencode(std::back_inserter(out), torrentEntry);
-    QFile torrentFile(path);
-    if (!out.empty() && torrentFile.open(QIODevice::WriteOnly))
-        return (torrentFile.write(&out[0], out.size()) == out.size());
-
-    return false;
+    return out;
 }
 
 void TorrentHandle::handleStateUpdate(const libt::torrent_status &nativeStatus)
@@ -1372,6 +1434,8 @@ void TorrentHandle::handleStateUpdate(const libt::torrent_status &nativeStatus)
 
 void TorrentHandle::handleStorageMovedAlert(const libtorrent::storage_moved_alert *p)
 {
+    m_session->handleTorrentStorageJobFinished(this, StorageJob::Move);
+
     if (!isMoveInProgress()) {
         qWarning() << "Unexpected " << Q_FUNC_INFO << " call.";
         return;
@@ -1413,6 +1477,8 @@ void TorrentHandle::handleStorageMovedAlert(const libtorrent::storage_moved_aler
 
 void TorrentHandle::handleStorageMovedFailedAlert(const libtorrent::storage_moved_failed_alert *p)
 {
+    m_session->handleTorrentStorageJobFinished(this, StorageJob::Move);
+
     if (!isMoveInProgress()) {
         qWarning() << "Unexpected " << Q_FUNC_INFO << " call.";
         return;
@@ -1440,6 +1506,7 @@ void TorrentHandle::handleTrackerReplyAlert(const libtorrent::tracker_reply_aler
     // Connection was successful now. Remove possible old errors
     m_trackerInfos[trackerUrl].lastMessage.clear(); // Reset error/warning message
     m_trackerInfos[trackerUrl].numPeers = p->num_peers;
+    m_isTrackerEntriesOutdated = true;
 
     m_session->handleTorrentTrackerReply(this, trackerUrl);
 }
@@ -1451,6 +1518,7 @@ void TorrentHandle::handleTrackerWarningAlert(const libtorrent::tracker_warning_
 
     // Connection was successful now but there is a warning message
     m_trackerInfos[trackerUrl].lastMessage = message; // Store warning message
+    m_isTrackerEntriesOutdated = true;
 
     m_session->handleTorrentTrackerWarning(this, trackerUrl);
 }
@@ -1461,6 +1529,7 @@ void TorrentHandle::handleTrackerErrorAlert(const libtorrent::tracker_error_aler
     const QString message = p->error_message();
 
     m_trackerInfos[trackerUrl].lastMessage = message;
+    m_isTrackerEntriesOutdated = true;
 
     m_session->handleTorrentTrackerError(this, trackerUrl);
 }
@@ -1496,6 +1565,7 @@ void TorrentHandle::handleTorrentCheckedAlert(const libtorrent::torrent_checked_
         manageIncompleteFiles();
     }
 
+    m_session->handleTorrentStorageJobFinished(this, StorageJob::Recheck);
     m_session->handleTorrentChecked(this);
 }
 
@@ -1566,6 +1636,11 @@ void TorrentHandle::handleSaveResumeDataAlert(const libtorrent::save_resume_data
     else {
         auto savePath = resumeData.find_key("save_path")->string();
         resumeData["save_path"] = Profile::instance().toPortablePath(QString::fromStdString(savePath)).toStdString();
+        // The caps of the bandwidth scheduler aren't persisted
+        if ((m_scheduledDownloadLimit > 0) || (m_scheduledUploadLimit > 0)) {
+            resumeData["download_rate_limit"] = m_downloadLimit;
+            resumeData["upload_rate_limit"] = m_uploadLimit;
+        }
     }
     resumeData["qBt-savePath"] = m_useAutoTMM ? "" : Profile::instance().toPortablePath(m_savePath).toStdString();
     resumeData["qBt-ratioLimit"] = static_cast<int>(m_ratioLimit * 1000);
@@ -1575,7 +1650,7 @@ void TorrentHandle::handleSaveResumeDataAlert(const libtorrent::save_resume_data
     resumeData["qBt-name"] = m_name.toStdString();
     resumeData["qBt-seedStatus"] = m_hasSeedStatus;
     resumeData["qBt-tempPathDisabled"] = m_tempPathDisabled;
-    resumeData["qBt-queuePosition"] = (nativeHandle().queue_position() + 1); // qBt starts queue at 1
+    resumeData["qBt-queuePosition"] = queuePosition(); // qBt starts queue at 1
     resumeData["qBt-hasRootFolder"] = m_hasRootFolder;
 
     m_session->handleTorrentResumeDataReady(this, resumeData);
@@ -1627,7 +1702,7 @@ void TorrentHandle::handleFileRenamedAlert(const libtorrent::file_renamed_alert
 
     // We don't really need to call updateStatus() in this place.
     // All we need to do is make sure we have a valid instance of the TorrentInfo object.
-    m_torrentInfo = TorrentInfo {m_nativeHandle.torrent_file()};
+    updateTorrentInfo();
 
     --m_renameCount;
     while (!isMoveInProgress() && (m_renameCount == 0) && !m_moveFinishedTriggers.isEmpty())
@@ -1647,7 +1722,8 @@ void TorrentHandle::handleFileCompletedAlert(const libtorrent::file_completed_al
 {
     // We don't really need to call updateStatus() in this place.
     // All we need to do is make sure we have a valid instance of the TorrentInfo object.
-    m_torrentInfo = TorrentInfo {m_nativeHandle.torrent_file()};
+    updateTorrentInfo();
+    m_isFilesProgressOutdated = true;
 
     qDebug("A file completed download in torrent \"%s\"", qUtf8Printable(name()));
     if (m_session->isAppendExtensionEnabled()) {
@@ -1838,11 +1914,69 @@ void TorrentHandle::updateTorrentInfo()
     m_torrentInfo = TorrentInfo(m_nativeStatus.torrent_file.lock());
 }
 
+void TorrentHandle::refreshCaches()
+{
+    if (m_isTrackerEntriesOutdated)
+        updateTrackerEntries();
+    if (m_isFilesProgressOutdated && hasMetadata())
+        updateFilesProgress();
+}
+
+// Nothing or everything is downloaded, the file progress is known without asking libtorrent
+bool TorrentHandle::isFilesProgressKnown() const
+{
+    return ((m_nativeStatus.total_done == 0) || (m_nativeStatus.total_done >= totalSize()));
+}
+
+void TorrentHandle::updateFilesProgress() const
+{
+    const int count = filesCount();
+    m_filesProgress.clear();
+    m_filesProgress.reserve(count);
+    if (isFilesProgressKnown()) {
+        const bool isComplete = (m_nativeStatus.total_done > 0);
+        for (int i = 0; i < count; ++i)
+            m_filesProgress << ((isComplete || (fileSize(i) <= 0)) ? 1 : 0);
+    }
+    else {
+        m_session->handleTorrentSyncNativeCall(this, "file_progress");
+        std::vector<boost::int64_t> fp;
+        m_nativeHandle.file_progress(fp, libt::torrent_handle::piece_granularity);
+
+        for (int i = 0; i < static_cast<int>(fp.size()); ++i) {
+            const qlonglong size = fileSize(i);
+            if ((size <= 0) || (fp[i] == size))
+                m_filesProgress << 1;
+            else
+                m_filesProgress << (fp[i] / static_cast<qreal>(size));
+        }
+    }
+
+    m_isFilesProgressOutdated = false;
+}
+
+void TorrentHandle::updateTrackerEntries()
+{
+    m_session->handleTorrentSyncNativeCall(this, "trackers");
+    const std::vector<libt::announce_entry> announces = m_nativeHandle.trackers();
+
+    m_trackerEntries.clear();
+    m_trackerEntries.reserve(static_cast<int>(announces.size()));
+    for (const libt::announce_entry &tracker : announces)
+        m_trackerEntries << tracker;
+    m_isTrackerEntriesOutdated = false;
+}
+
 bool TorrentHandle::isMoveInProgress() const
 {
     return !m_moveStorageInfo.newPath.isEmpty();
 }
 
+bool TorrentHandle::isMoveRunning() const
+{
+    return (isMoveInProgress() && m_moveStorageInfo.isStarted);
+}
+
 bool TorrentHandle::useTempPath() const
 {
     return !m_tempPathDisabled && m_session->isTempPathEnabled() && !(isSeed() || m_hasSeedStatus);
@@ -1850,11 +1984,28 @@ bool TorrentHandle::useTempPath() const
 
 void TorrentHandle::updateStatus()
 {
+    m_session->handleTorrentSyncNativeCall(this, "status");
     updateStatus(m_nativeHandle.status());
 }
 
 void TorrentHandle::updateStatus(const libtorrent::torrent_status &nativeStatus)
 {
+    if (nativeStatus.total_done != m_nativeStatus.total_done)
+        m_isFilesProgressOutdated = true;
+    // the tracker states (e.g. "updating") change without any alert when announces start or stop
+    if ((nativeStatus.announcing_to_trackers != m_nativeStatus.announcing_to_trackers)
+        || (nativeStatus.paused != m_nativeStatus.paused)) {
+        m_isTrackerEntriesOutdated = true;
+    }
+
+    // the check can end without torrent_checked_alert, e.g. when the torrent is stopped
+    const bool checkingStopped = (m_nativeStatus.state == libt::torrent_status::checking_files)
+        && (nativeStatus.state != libt::torrent_status::checking_files)
+        && (nativeStatus.state != libt::torrent_status::checking_resume_data);
+
+    const TorrentState oldState = m_state;
+    const bool wasActive = isActive();
+    const bool wasPaused = isPaused();
     m_nativeStatus = nativeStatus;
 
     updateState();
@@ -1866,6 +2017,13 @@ void TorrentHandle::updateStatus(const libtorrent::torrent_status &nativeStatus)
         m_unchecked = false;
     else if (isDownloading())
         m_unchecked = true;
+
+    // the paused state doesn't always change the torrent state, e.g. of an errored torrent
+    if ((m_state != oldState) || (isActive() != wasActive) || (isPaused() != wasPaused))
+        m_session->handleTorrentStateChanged(this);
+
+    if (checkingStopped)
+        m_session->handleTorrentStorageJobFinished(this, StorageJob::Recheck);
 }
 
 void TorrentHandle::setRatioLimit(qreal limit)
@@ -1896,12 +2054,27 @@ void TorrentHandle::setSeedingTimeLimit(int limit)
 
 void TorrentHandle::setUploadLimit(int limit)
 {
-    m_nativeHandle.set_upload_limit(limit);
+    m_uploadLimit = limit;
+    m_nativeHandle.set_upload_limit(effectiveRateLimit(m_uploadLimit, m_scheduledUploadLimit));
 }
 
 void TorrentHandle::setDownloadLimit(int limit)
 {
-    m_nativeHandle.set_download_limit(limit);
+    m_downloadLimit = limit;
+    m_nativeHandle.set_download_limit(effectiveRateLimit(m_downloadLimit, m_scheduledDownloadLimit));
+}
+
+void TorrentHandle::setScheduledLimits(const int downloadLimit, const int uploadLimit)
+{
+    if (downloadLimit != m_scheduledDownloadLimit) {
+        m_scheduledDownloadLimit = downloadLimit;
+        m_nativeHandle.set_download_limit(effectiveRateLimit(m_downloadLimit, m_scheduledDownloadLimit));
+    }
+
+    if (uploadLimit != m_scheduledUploadLimit) {
+        m_scheduledUploadLimit = uploadLimit;
+        m_nativeHandle.set_upload_limit(effectiveRateLimit(m_uploadLimit, m_scheduledUploadLimit));
+    }
 }
 
 void TorrentHandle::setSuperSeeding(bool enable)
@@ -46,6 +46,7 @@
 #include "base/tristatebool.h"
 #include "private/speedmonitor.h"
 #include "infohash.h"
+#include "storagejobscheduler.h"
 #include "torrentinfo.h"
 
 class QBitArray;
@@ -262,6 +263,8 @@ namespace BitTorrent
         QVector<int> filePriorities() const;
 
         TorrentInfo info() const;
+        // bencoded .torrent file, empty when the metadata isn't known yet
+        QByteArray torrentFileData() const;
         bool isSeed() const;
         bool isPaused() const;
         bool isResumed() const;
@@ -337,7 +340,6 @@ namespace BitTorrent
         void forceDHTAnnounce();
         void forceRecheck();
         void renameFile(int index, const QString &name);
-        bool saveTorrentFile(const QString &path);
         void prioritizeFiles(const QVector<int> &priorities);
         void setRatioLimit(qreal limit);
         void setSeedingTimeLimit(int limit);
@@ -360,9 +362,15 @@ namespace BitTorrent
 
         void handleAlert(libtorrent::alert *a);
         void handleStateUpdate(const libtorrent::torrent_status &nativeStatus);
+        // Refills the outdated tracker and file progress caches, readers only get the cached values
+        void refreshCaches();
         void handleTempPathChanged();
         void handleCategorySavePathChanged();
         void handleAppendExtensionToggled();
+        void handleStorageJobStarted(StorageJob::Type type);
+        void handleStorageJobCancelled(StorageJob::Type type);
+        // Caps of the active category and tag rules of the bandwidth scheduler, 0 means no cap
+        void setScheduledLimits(int downloadLimit, int uploadLimit);
         void saveResumeData();
 
         /**
@@ -380,6 +388,9 @@ namespace BitTorrent
         void updateStatus(const libtorrent::torrent_status &nativeStatus);
         void updateState();
         void updateTorrentInfo();
+        void updateTrackerEntries();
+        void updateFilesProgress() const;
+        bool isFilesProgressKnown() const;
 
         void handleStorageMovedAlert(const libtorrent::storage_moved_alert *p);
         void handleStorageMovedFailedAlert(const libtorrent::storage_moved_failed_alert *p);
@@ -400,7 +411,10 @@ namespace BitTorrent
         void handleStatsAlert(const libtorrent::stats_alert *p);
 
         void resume_impl(bool forced, bool uploadMode);
+        // The move is requested, it may still wait in the storage job queue
         bool isMoveInProgress() const;
+        // The storage is actually being moved
+        bool isMoveRunning() const;
         QString nativeActualSavePath() const;
 
         void adjustActualSavePath();
@@ -429,7 +443,10 @@ namespace BitTorrent
             // queuedPath is where files should be moved to,
             // when current moving is completed
             QString queuedPath;
+            bool overwrite = true;
             bool queuedOverwrite = true;
+            // the storage job is started, until then the torrent keeps its state
+            bool isStarted = false;
         } m_moveStorageInfo;
 
         // m_moveFinishedTriggers is activated only when the following conditions are met:
@@ -455,6 +472,22 @@ namespace BitTorrent
 
         QHash<QString, TrackerInfo> m_trackerInfos;
 
+        // Snapshots of the libtorrent state that is not part of torrent_status,
+        // alerts and status updates only mark them as outdated and they are
+        // refreshed by the getters, so nothing blocks on the network thread
+        // until they are actually needed
+        QList<TrackerEntry> m_trackerEntries;
+        bool m_isTrackerEntriesOutdated;
+        mutable QVector<qreal> m_filesProgress;
+        mutable bool m_isFilesProgressOutdated;
+
+        // Own rate limits of the torrent, the native ones are lowered
+        // while the bandwidth scheduler caps the torrent
+        int m_downloadLimit;
+        int m_uploadLimit;
+        int m_scheduledDownloadLimit;
+        int m_scheduledUploadLimit;
+
         enum StartupState
         {
             NotStarted,
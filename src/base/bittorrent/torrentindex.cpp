@@ -0,0 +1,238 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "torrentindex.h"
+
+#include "base/global.h"
+#include "session.h"
+#include "torrenthandle.h"
+
+using namespace BitTorrent;
+
+namespace
+{
+    // Same classification as TorrentFilter::match()
+    uint torrentStates(const TorrentHandle *torrent)
+    {
+        uint states = (1 << TorrentFilter::All);
+        if (torrent->isDownloading())
+            states |= (1 << TorrentFilter::Downloading);
+        if (torrent->isUploading())
+            states |= (1 << TorrentFilter::Seeding);
+        if (torrent->isCompleted())
+            states |= (1 << TorrentFilter::Completed);
+        if (torrent->isResumed())
+            states |= (1 << TorrentFilter::Resumed);
+        if (torrent->isPaused())
+            states |= (1 << TorrentFilter::Paused);
+        if (torrent->isActive())
+            states |= (1 << TorrentFilter::Active);
+        if (torrent->isInactive())
+            states |= (1 << TorrentFilter::Inactive);
+        if (torrent->isErrored())
+            states |= (1 << TorrentFilter::Errored);
+        return states;
+    }
+}
+
+void TorrentIndex::addTorrent(const TorrentHandle *torrent)
+{
+    const InfoHash hash = torrent->hash();
+    if (m_torrentStates.contains(hash)) return;
+
+    const uint states = torrentStates(torrent);
+    m_torrentStates.insert(hash, states);
+    for (int i = 0; i < StatesCount; ++i) {
+        if (states & (1 << i))
+            m_stateIndex[i].insert(hash);
+    }
+
+    insertCategory(hash, torrent->category());
+
+    const QSet<QString> tags = torrent->tags();
+    if (tags.isEmpty()) {
+        insertItem(m_tagIndex, "", hash);
+    }
+    else {
+        for (const QString &tag : tags)
+            insertItem(m_tagIndex, tag, hash);
+    }
+}
+
+void TorrentIndex::removeTorrent(const TorrentHandle *torrent)
+{
+    const InfoHash hash = torrent->hash();
+    const auto statesIter = m_torrentStates.find(hash);
+    if (statesIter == m_torrentStates.end()) return;
+
+    for (int i = 0; i < StatesCount; ++i) {
+        if (statesIter.value() & (1 << i))
+            m_stateIndex[i].remove(hash);
+    }
+    m_torrentStates.erase(statesIter);
+
+    eraseCategory(hash, torrent->category());
+
+    const QSet<QString> tags = torrent->tags();
+    if (tags.isEmpty()) {
+        eraseItem(m_tagIndex, "", hash);
+    }
+    else {
+        for (const QString &tag : tags)
+            eraseItem(m_tagIndex, tag, hash);
+    }
+}
+
+void TorrentIndex::updateCategory(const TorrentHandle *torrent, const QString &oldCategory)
+{
+    const InfoHash hash = torrent->hash();
+    if (!m_torrentStates.contains(hash)) return;
+
+    eraseCategory(hash, oldCategory);
+    insertCategory(hash, torrent->category());
+}
+
+void TorrentIndex::addTag(const TorrentHandle *torrent, const QString &tag)
+{
+    const InfoHash hash = torrent->hash();
+    if (!m_torrentStates.contains(hash)) return;
+
+    // The torrent already has the new tag
+    if (torrent->tags().size() == 1)
+        eraseItem(m_tagIndex, "", hash);
+    insertItem(m_tagIndex, tag, hash);
+}
+
+void TorrentIndex::removeTag(const TorrentHandle *torrent, const QString &tag)
+{
+    const InfoHash hash = torrent->hash();
+    if (!m_torrentStates.contains(hash)) return;
+
+    eraseItem(m_tagIndex, tag, hash);
+    if (torrent->tags().isEmpty())
+        insertItem(m_tagIndex, "", hash);
+}
+
+bool TorrentIndex::updateState(const TorrentHandle *torrent)
+{
+    const InfoHash hash = torrent->hash();
+    const auto statesIter = m_torrentStates.find(hash);
+    if (statesIter == m_torrentStates.end()) return false;
+
+    const uint states = torrentStates(torrent);
+    const uint changedStates = (statesIter.value() ^ states);
+    if (changedStates == 0) return false;
+
+    for (int i = 0; i < StatesCount; ++i) {
+        if (!(changedStates & (1 << i))) continue;
+
+        if (states & (1 << i))
+            m_stateIndex[i].insert(hash);
+        else
+            m_stateIndex[i].remove(hash);
+    }
+    statesIter.value() = states;
+    return true;
+}
+
+int TorrentIndex::torrentsCount() const
+{
+    return m_torrentStates.size();
+}
+
+QSet<InfoHash> TorrentIndex::categoryTorrents(const QString &category, const bool withSubcategories) const
+{
+    if (withSubcategories && !category.isEmpty())
+        return m_categoryTreeIndex.value(category);
+    return m_categoryIndex.value(category);
+}
+
+int TorrentIndex::categoryTorrentsCount(const QString &category, const bool withSubcategories) const
+{
+    const QHash<QString, QSet<InfoHash>> &index = (withSubcategories && !category.isEmpty())
+            ? m_categoryTreeIndex : m_categoryIndex;
+    const auto iter = index.find(category);
+    return ((iter != index.end()) ? iter->size() : 0);
+}
+
+QSet<InfoHash> TorrentIndex::tagTorrents(const QString &tag) const
+{
+    return m_tagIndex.value(tag);
+}
+
+int TorrentIndex::tagTorrentsCount(const QString &tag) const
+{
+    const auto iter = m_tagIndex.find(tag);
+    return ((iter != m_tagIndex.end()) ? iter->size() : 0);
+}
+
+QSet<InfoHash> TorrentIndex::stateTorrents(const TorrentFilter::Type state) const
+{
+    Q_ASSERT((state >= 0) && (state < StatesCount));
+    return m_stateIndex[state];
+}
+
+int TorrentIndex::stateTorrentsCount(const TorrentFilter::Type state) const
+{
+    Q_ASSERT((state >= 0) && (state < StatesCount));
+    return m_stateIndex[state].size();
+}
+
+void TorrentIndex::insertCategory(const InfoHash &hash, const QString &category)
+{
+    insertItem(m_categoryIndex, category, hash);
+    if (category.isEmpty()) return;
+
+    for (const QString &parentCategory : asConst(Session::expandCategory(category)))
+        insertItem(m_categoryTreeIndex, parentCategory, hash);
+}
+
+void TorrentIndex::eraseCategory(const InfoHash &hash, const QString &category)
+{
+    eraseItem(m_categoryIndex, category, hash);
+    if (category.isEmpty()) return;
+
+    for (const QString &parentCategory : asConst(Session::expandCategory(category)))
+        eraseItem(m_categoryTreeIndex, parentCategory, hash);
+}
+
+void TorrentIndex::insertItem(QHash<QString, QSet<InfoHash>> &index, const QString &key, const InfoHash &hash)
+{
+    index[key].insert(hash);
+}
+
+void TorrentIndex::eraseItem(QHash<QString, QSet<InfoHash>> &index, const QString &key, const InfoHash &hash)
+{
+    const auto iter = index.find(key);
+    if (iter == index.end()) return;
+
+    iter->remove(hash);
+    if (iter->isEmpty())
+        index.erase(iter);
+}
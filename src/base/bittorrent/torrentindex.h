@@ -0,0 +1,91 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+#include "base/torrentfilter.h"
+#include "infohash.h"
+
+namespace BitTorrent
+{
+    class TorrentHandle;
+
+    // Secondary indexes of the session torrents by category, tag and state.
+    // Session keeps them up to date from the torrent change handlers, so the
+    // filters and the counters don't need to look at every torrent.
+    class TorrentIndex
+    {
+        Q_DISABLE_COPY(TorrentIndex)
+
+    public:
+        TorrentIndex() = default;
+
+        void addTorrent(const TorrentHandle *torrent);
+        void removeTorrent(const TorrentHandle *torrent);
+        void updateCategory(const TorrentHandle *torrent, const QString &oldCategory);
+        void addTag(const TorrentHandle *torrent, const QString &tag);
+        void removeTag(const TorrentHandle *torrent, const QString &tag);
+        // Returns true if the torrent has moved to other state sets
+        bool updateState(const TorrentHandle *torrent);
+
+        int torrentsCount() const;
+
+        // Empty category means uncategorized torrents. With subcategories
+        // the torrents of all the nested categories are included too.
+        QSet<InfoHash> categoryTorrents(const QString &category, bool withSubcategories = false) const;
+        int categoryTorrentsCount(const QString &category, bool withSubcategories = false) const;
+
+        // Empty tag means untagged torrents
+        QSet<InfoHash> tagTorrents(const QString &tag) const;
+        int tagTorrentsCount(const QString &tag) const;
+
+        QSet<InfoHash> stateTorrents(TorrentFilter::Type state) const;
+        int stateTorrentsCount(TorrentFilter::Type state) const;
+
+    private:
+        static const int StatesCount = TorrentFilter::Errored + 1;
+
+        void insertCategory(const InfoHash &hash, const QString &category);
+        void eraseCategory(const InfoHash &hash, const QString &category);
+        static void insertItem(QHash<QString, QSet<InfoHash>> &index, const QString &key, const InfoHash &hash);
+        static void eraseItem(QHash<QString, QSet<InfoHash>> &index, const QString &key, const InfoHash &hash);
+
+        QHash<InfoHash, uint> m_torrentStates;
+        QSet<InfoHash> m_stateIndex[StatesCount];
+        // Torrents by their own category
+        QHash<QString, QSet<InfoHash>> m_categoryIndex;
+        // Torrents by their category and all its parent categories
+        QHash<QString, QSet<InfoHash>> m_categoryTreeIndex;
+        QHash<QString, QSet<InfoHash>> m_tagIndex;
+    };
+}
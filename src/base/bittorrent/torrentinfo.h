@@ -111,4 +111,6 @@ namespace BitTorrent
     };
 }
 
+Q_DECLARE_METATYPE(BitTorrent::TorrentInfo)
+
 #endif // BITTORRENT_TORRENTINFO_H
@@ -131,6 +131,12 @@ Http::Response Tracker::processRequest(const Http::Request &request, const Http:
     return response();
 }
 
+void Tracker::processRequest(const Http::Request &request, const Http::Environment &env, const ResponseCallback &callback)
+{
+    // The announces are always answered at once
+    callback(processRequest(request, env));
+}
+
 void Tracker::respondToAnnounceRequest()
 {
     QMap<QString, QByteArray> queryParams;
@@ -88,6 +88,7 @@ namespace BitTorrent
 
         bool start();
         Http::Response processRequest(const Http::Request &request, const Http::Environment &env);
+        void processRequest(const Http::Request &request, const Http::Environment &env, const ResponseCallback &callback) override;
 
     private:
         void respondToAnnounceRequest();
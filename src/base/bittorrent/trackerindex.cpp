@@ -0,0 +1,265 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "trackerindex.h"
+
+#include <QUrl>
+
+#include "base/global.h"
+#include "torrenthandle.h"
+#include "trackerentry.h"
+
+using namespace BitTorrent;
+
+namespace
+{
+    template <typename Key>
+    void insertItem(QHash<Key, QSet<InfoHash>> &index, const Key &key, const InfoHash &hash)
+    {
+        index[key].insert(hash);
+    }
+
+    template <typename Key>
+    void eraseItem(QHash<Key, QSet<InfoHash>> &index, const Key &key, const InfoHash &hash)
+    {
+        const auto iter = index.find(key);
+        if (iter == index.end()) return;
+
+        iter->remove(hash);
+        if (iter->isEmpty())
+            index.erase(iter);
+    }
+}
+
+void TrackerIndex::addTorrent(const TorrentHandle *torrent)
+{
+    const InfoHash hash = torrent->hash();
+    if (m_torrentTrackers.contains(hash)) return;
+
+    const QSet<QString> urls = trackerUrls(torrent);
+    m_torrentTrackers.insert(hash, urls);
+    if (urls.isEmpty()) {
+        insertItem(m_hostTorrents, QString(""), hash);
+    }
+    else {
+        for (const QString &host : asConst(hostsFromUrls(urls)))
+            insertItem(m_hostTorrents, host, hash);
+    }
+}
+
+void TrackerIndex::removeTorrent(const InfoHash &hash)
+{
+    if (!m_torrentTrackers.contains(hash)) return;
+
+    setTorrentTrackers(hash, {});
+    eraseItem(m_hostTorrents, QString(""), hash);
+    m_torrentTrackers.remove(hash);
+}
+
+void TrackerIndex::updateTorrent(const TorrentHandle *torrent)
+{
+    const InfoHash hash = torrent->hash();
+    if (!m_torrentTrackers.contains(hash)) return;
+
+    setTorrentTrackers(hash, trackerUrls(torrent));
+}
+
+void TrackerIndex::setTrackerWorking(const InfoHash &hash, const QString &trackerUrl)
+{
+    eraseTrackerStatus(m_errors, hash, trackerUrl);
+    eraseTrackerStatus(m_warnings, hash, trackerUrl);
+}
+
+void TrackerIndex::setTrackerError(const InfoHash &hash, const QString &trackerUrl)
+{
+    if (!m_torrentTrackers.value(hash).contains(trackerUrl)) return;
+
+    insertTrackerStatus(m_errors, hash, trackerUrl);
+}
+
+void TrackerIndex::setTrackerWarning(const InfoHash &hash, const QString &trackerUrl)
+{
+    if (!m_torrentTrackers.value(hash).contains(trackerUrl)) return;
+
+    insertTrackerStatus(m_warnings, hash, trackerUrl);
+}
+
+QStringList TrackerIndex::hosts() const
+{
+    QStringList result;
+    result.reserve(m_hostTorrents.size());
+    for (auto i = m_hostTorrents.cbegin(); i != m_hostTorrents.cend(); ++i) {
+        if (!i.key().isEmpty())
+            result << i.key();
+    }
+
+    return result;
+}
+
+QSet<InfoHash> TrackerIndex::hostTorrents(const QString &host) const
+{
+    return m_hostTorrents.value(host);
+}
+
+int TrackerIndex::hostTorrentsCount(const QString &host) const
+{
+    const auto iter = m_hostTorrents.find(host);
+    return ((iter != m_hostTorrents.end()) ? iter->size() : 0);
+}
+
+int TrackerIndex::hostErroredTorrentsCount(const QString &host) const
+{
+    const auto iter = m_errors.hostTorrents.find(host);
+    return ((iter != m_errors.hostTorrents.end()) ? iter->size() : 0);
+}
+
+int TrackerIndex::hostWarnedTorrentsCount(const QString &host) const
+{
+    const auto iter = m_warnings.hostTorrents.find(host);
+    return ((iter != m_warnings.hostTorrents.end()) ? iter->size() : 0);
+}
+
+QSet<InfoHash> TrackerIndex::erroredTorrents() const
+{
+    return m_errors.torrentTrackers.keys().toSet();
+}
+
+int TrackerIndex::erroredTorrentsCount() const
+{
+    return m_errors.torrentTrackers.size();
+}
+
+QSet<InfoHash> TrackerIndex::warnedTorrents() const
+{
+    return m_warnings.torrentTrackers.keys().toSet();
+}
+
+int TrackerIndex::warnedTorrentsCount() const
+{
+    return m_warnings.torrentTrackers.size();
+}
+
+QString TrackerIndex::hostFromUrl(const QString &trackerUrl)
+{
+    const QUrl url(trackerUrl);
+    const QString longHost = url.host().toLower();
+    const QString tld = url.topLevelDomain();
+    // We get empty tld when it is invalid or an IPv4/IPv6 address,
+    // so just return the full host
+    if (tld.isEmpty())
+        return longHost;
+    // We want the domain + tld. Subdomains should be disregarded
+    const int index = longHost.lastIndexOf('.', -(tld.size() + 1));
+    if (index == -1)
+        return longHost;
+    return longHost.mid(index + 1);
+}
+
+void TrackerIndex::setTorrentTrackers(const InfoHash &hash, const QSet<QString> &trackerUrls)
+{
+    QSet<QString> &currentUrls = m_torrentTrackers[hash];
+    if (currentUrls == trackerUrls) return;
+
+    const QSet<QString> currentHosts = hostsFromUrls(currentUrls);
+    const QSet<QString> newHosts = hostsFromUrls(trackerUrls);
+
+    for (const QString &url : asConst(currentUrls)) {
+        if (!trackerUrls.contains(url)) {
+            eraseTrackerStatus(m_errors, hash, url);
+            eraseTrackerStatus(m_warnings, hash, url);
+        }
+    }
+
+    for (const QString &host : currentHosts) {
+        if (!newHosts.contains(host))
+            eraseItem(m_hostTorrents, host, hash);
+    }
+    for (const QString &host : newHosts) {
+        if (!currentHosts.contains(host))
+            insertItem(m_hostTorrents, host, hash);
+    }
+
+    // Trackerless transitions
+    if (currentUrls.isEmpty())
+        eraseItem(m_hostTorrents, QString(""), hash);
+    else if (trackerUrls.isEmpty())
+        insertItem(m_hostTorrents, QString(""), hash);
+
+    currentUrls = trackerUrls;
+}
+
+void TrackerIndex::insertTrackerStatus(StatusIndex &index, const InfoHash &hash, const QString &trackerUrl)
+{
+    index.torrentTrackers[hash].insert(trackerUrl);
+    insertItem(index.hostTorrents, hostFromUrl(trackerUrl), hash);
+}
+
+void TrackerIndex::eraseTrackerStatus(StatusIndex &index, const InfoHash &hash, const QString &trackerUrl)
+{
+    const auto iter = index.torrentTrackers.find(hash);
+    if ((iter == index.torrentTrackers.end()) || !iter->remove(trackerUrl)) return;
+
+    // The torrent stays in the host set while another tracker of the host has the status
+    const QString host = hostFromUrl(trackerUrl);
+    bool hostHasStatus = false;
+    for (const QString &url : asConst(*iter)) {
+        if (hostFromUrl(url) == host) {
+            hostHasStatus = true;
+            break;
+        }
+    }
+    if (!hostHasStatus)
+        eraseItem(index.hostTorrents, host, hash);
+
+    if (iter->isEmpty())
+        index.torrentTrackers.erase(iter);
+}
+
+QSet<QString> TrackerIndex::hostsFromUrls(const QSet<QString> &trackerUrls)
+{
+    // Empty host is reserved for the trackerless torrents
+    QSet<QString> hosts;
+    hosts.reserve(trackerUrls.size());
+    for (const QString &url : trackerUrls) {
+        const QString host = hostFromUrl(url);
+        if (!host.isEmpty())
+            hosts.insert(host);
+    }
+    return hosts;
+}
+
+QSet<QString> TrackerIndex::trackerUrls(const TorrentHandle *torrent)
+{
+    const QList<TrackerEntry> trackers = torrent->trackers();
+    QSet<QString> urls;
+    urls.reserve(trackers.size());
+    for (const TrackerEntry &tracker : trackers)
+        urls.insert(tracker.url());
+    return urls;
+}
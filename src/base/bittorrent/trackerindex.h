@@ -0,0 +1,98 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "infohash.h"
+
+namespace BitTorrent
+{
+    class TorrentHandle;
+
+    // Index of the session torrents by tracker host, along with the torrents
+    // which have errored or warned trackers. Session keeps it up to date
+    // from the tracker changes and the tracker alerts.
+    class TrackerIndex
+    {
+        Q_DISABLE_COPY(TrackerIndex)
+
+    public:
+        TrackerIndex() = default;
+
+        void addTorrent(const TorrentHandle *torrent);
+        void removeTorrent(const InfoHash &hash);
+        // Synchronizes the index with the current trackers of the torrent
+        void updateTorrent(const TorrentHandle *torrent);
+
+        void setTrackerWorking(const InfoHash &hash, const QString &trackerUrl);
+        void setTrackerError(const InfoHash &hash, const QString &trackerUrl);
+        void setTrackerWarning(const InfoHash &hash, const QString &trackerUrl);
+
+        QStringList hosts() const;
+        // Empty host means trackerless torrents
+        QSet<InfoHash> hostTorrents(const QString &host) const;
+        int hostTorrentsCount(const QString &host) const;
+        int hostErroredTorrentsCount(const QString &host) const;
+        int hostWarnedTorrentsCount(const QString &host) const;
+
+        QSet<InfoHash> erroredTorrents() const;
+        int erroredTorrentsCount() const;
+        QSet<InfoHash> warnedTorrents() const;
+        int warnedTorrentsCount() const;
+
+        // Returns the registrable part of the tracker host (e.g. "tracker.example.com"
+        // gives "example.com"), or the full host when it is an IP address
+        static QString hostFromUrl(const QString &trackerUrl);
+
+    private:
+        struct StatusIndex
+        {
+            // Tracker URLs having the status, by torrent
+            QHash<InfoHash, QSet<QString>> torrentTrackers;
+            // Torrents having at least one tracker of the host with the status
+            QHash<QString, QSet<InfoHash>> hostTorrents;
+        };
+
+        void setTorrentTrackers(const InfoHash &hash, const QSet<QString> &trackerUrls);
+        static void insertTrackerStatus(StatusIndex &index, const InfoHash &hash, const QString &trackerUrl);
+        static void eraseTrackerStatus(StatusIndex &index, const InfoHash &hash, const QString &trackerUrl);
+        static QSet<QString> hostsFromUrls(const QSet<QString> &trackerUrls);
+        static QSet<QString> trackerUrls(const TorrentHandle *torrent);
+
+        QHash<InfoHash, QSet<QString>> m_torrentTrackers;
+        QHash<QString, QSet<InfoHash>> m_hostTorrents;
+        StatusIndex m_errors;
+        StatusIndex m_warnings;
+    };
+}
@@ -0,0 +1,374 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "diskspacemonitor.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QStringList>
+#include <QVector>
+
+#if defined(Q_OS_WIN)
+#include <QStorageInfo>
+#else
+#include <sys/statvfs.h>
+#endif
+
+#include "base/global.h"
+#include "base/utils/fs.h"
+
+namespace
+{
+    // The values are refreshed at least this often while paths are watched
+    const int DEFAULT_REFRESH_INTERVAL = 5000;
+    // An explicit refresh isn't started sooner than this after the previous one
+    const int MIN_REFRESH_INTERVAL = 1000;
+    // The low state is left only above the reserve plus this margin, so a free space
+    // hovering around the reserve doesn't pause and resume the downloads again and again
+    const int RECOVERY_MARGIN_PERCENT = 5;
+    const qint64 MIN_RECOVERY_MARGIN = 16 * 1024 * 1024;
+
+    bool statFileSystem(const QString &path, DiskSpaceMonitor::Stats &stats)
+    {
+        // Use the nearest existing folder, e.g. for a save path that isn't created yet
+        QFileInfo pathInfo(path);
+        while (!pathInfo.exists()) {
+            const QString parentPath = pathInfo.absolutePath();
+            if (parentPath == pathInfo.absoluteFilePath())
+                return false;
+            pathInfo.setFile(parentPath);
+        }
+
+#if defined(Q_OS_WIN)
+        // There is no statvfs() here and QStorageInfo asks for the volume only
+        const QStorageInfo storage(pathInfo.absoluteFilePath());
+        if (!storage.isValid() || !storage.isReady())
+            return false;
+
+        stats.bytesFree = storage.bytesAvailable();
+        stats.bytesTotal = storage.bytesTotal();
+#else
+        struct ::statvfs buf;
+        if (::statvfs(QFile::encodeName(pathInfo.absoluteFilePath()).constData(), &buf) != 0) {
+            const auto err = errno;
+            qDebug("Could not get file system stats for path '%s'. Error: %s"
+                   , qUtf8Printable(path), qUtf8Printable(strerror(err)));
+            return false;
+        }
+
+        // The blocks reserved for the superuser aren't available
+        stats.bytesFree = static_cast<qint64>(buf.f_bavail) * buf.f_frsize;
+        stats.bytesTotal = static_cast<qint64>(buf.f_blocks) * buf.f_frsize;
+#endif
+        return true;
+    }
+
+    class RefreshTask : public QRunnable
+    {
+    public:
+        RefreshTask(QObject *receiver, const DiskSpaceMonitor::StatProvider &provider, const QStringList &paths)
+            : m_receiver(receiver)
+            , m_provider(provider)
+            , m_paths(paths)
+        {
+        }
+
+        void run() override
+        {
+            QList<qint64> freeSpaces;
+            freeSpaces.reserve(m_paths.size());
+            for (const QString &path : m_paths) {
+                DiskSpaceMonitor::Stats stats;
+                freeSpaces << (m_provider(path, stats) ? stats.bytesFree : -1);
+            }
+
+            QMetaObject::invokeMethod(m_receiver, "handleRefreshFinished", Qt::QueuedConnection
+                , Q_ARG(QStringList, m_paths), Q_ARG(QList<qint64>, freeSpaces));
+        }
+
+    private:
+        QObject *const m_receiver;
+        const DiskSpaceMonitor::StatProvider m_provider;
+        const QStringList m_paths;
+    };
+
+    class ResolveDeviceTask : public QRunnable
+    {
+    public:
+        ResolveDeviceTask(QObject *receiver, const DiskSpaceMonitor::DeviceProvider &provider, const QString &path)
+            : m_receiver(receiver)
+            , m_provider(provider)
+            , m_path(path)
+        {
+        }
+
+        void run() override
+        {
+            const QString device = m_provider(m_path);
+            QMetaObject::invokeMethod(m_receiver, "handleDeviceResolved", Qt::QueuedConnection
+                , Q_ARG(QString, m_path), Q_ARG(QString, device));
+        }
+
+    private:
+        QObject *const m_receiver;
+        const DiskSpaceMonitor::DeviceProvider m_provider;
+        const QString m_path;
+    };
+}
+
+DiskSpaceMonitor *DiskSpaceMonitor::m_instance = nullptr;
+
+DiskSpaceMonitor::DiskSpaceMonitor(const StatProvider &statProvider, const DeviceProvider &deviceProvider
+    , QObject *parent)
+    : QObject(parent)
+    , m_statProvider(statProvider ? statProvider : StatProvider(statFileSystem))
+    , m_deviceProvider(deviceProvider ? deviceProvider : DeviceProvider(Utils::Fs::deviceId))
+    , m_refreshInterval(DEFAULT_REFRESH_INTERVAL)
+    , m_isRefreshing(false)
+    , m_isRefreshRequested(false)
+{
+    qRegisterMetaType<QList<qint64>>();
+
+    // A single thread, so a slow file system delays only the next refresh
+    m_threadPool.setMaxThreadCount(1);
+
+    m_refreshTimer.setSingleShot(true);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &DiskSpaceMonitor::startRefresh);
+}
+
+DiskSpaceMonitor::~DiskSpaceMonitor()
+{
+    qDebug("Deleting disk space monitor...");
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
+}
+
+void DiskSpaceMonitor::initInstance()
+{
+    if (!m_instance)
+        m_instance = new DiskSpaceMonitor;
+}
+
+void DiskSpaceMonitor::freeInstance()
+{
+    if (m_instance) {
+        delete m_instance;
+        m_instance = nullptr;
+    }
+}
+
+DiskSpaceMonitor *DiskSpaceMonitor::instance()
+{
+    return m_instance;
+}
+
+void DiskSpaceMonitor::watchPath(const QString &path)
+{
+    if (path.isEmpty()) return;
+
+    const QString watchedPath = Utils::Fs::expandPathAbs(path);
+    auto it = m_watchedPaths.find(watchedPath);
+    if (it != m_watchedPaths.end()) {
+        ++it->watchCount;
+        return;
+    }
+
+    m_watchedPaths.insert(watchedPath, {1, 0, -1, false});
+    refresh();
+}
+
+void DiskSpaceMonitor::unwatchPath(const QString &path)
+{
+    if (path.isEmpty()) return;
+
+    auto it = m_watchedPaths.find(Utils::Fs::expandPathAbs(path));
+    if (it == m_watchedPaths.end()) return;
+
+    if (--it->watchCount <= 0)
+        m_watchedPaths.erase(it);
+}
+
+bool DiskSpaceMonitor::isWatched(const QString &path) const
+{
+    return m_watchedPaths.contains(Utils::Fs::expandPathAbs(path));
+}
+
+qint64 DiskSpaceMonitor::reserve(const QString &path) const
+{
+    const auto it = m_watchedPaths.constFind(Utils::Fs::expandPathAbs(path));
+    return (it != m_watchedPaths.cend()) ? it->reserve : 0;
+}
+
+void DiskSpaceMonitor::setReserve(const QString &path, qint64 bytes)
+{
+    const QString watchedPath = Utils::Fs::expandPathAbs(path);
+    auto it = m_watchedPaths.find(watchedPath);
+    if (it == m_watchedPaths.end()) return;
+
+    bytes = qMax<qint64>(0, bytes);
+    if (it->reserve == bytes) return;
+
+    it->reserve = bytes;
+    const bool wasLow = it->isLow;
+    updateLowState(*it);
+    if (it->isLow == wasLow) return;
+
+    const qint64 bytesFree = it->bytesFree;
+    if (wasLow)
+        emit diskSpaceRecovered(watchedPath, bytesFree);
+    else
+        emit lowDiskSpace(watchedPath, bytesFree, bytes);
+}
+
+bool DiskSpaceMonitor::isLowOnSpace(const QString &path) const
+{
+    const auto it = m_watchedPaths.constFind(Utils::Fs::expandPathAbs(path));
+    return (it != m_watchedPaths.cend()) && it->isLow;
+}
+
+qint64 DiskSpaceMonitor::freeSpace(const QString &path) const
+{
+    const auto it = m_watchedPaths.constFind(Utils::Fs::expandPathAbs(path));
+    return (it != m_watchedPaths.cend()) ? it->bytesFree : -1;
+}
+
+int DiskSpaceMonitor::refreshInterval() const
+{
+    return m_refreshInterval;
+}
+
+void DiskSpaceMonitor::setRefreshInterval(const int msecs)
+{
+    m_refreshInterval = qMax(MIN_REFRESH_INTERVAL, msecs);
+    if (m_refreshTimer.isActive() && (m_refreshTimer.remainingTime() > m_refreshInterval))
+        m_refreshTimer.start(m_refreshInterval);
+}
+
+void DiskSpaceMonitor::resolveDevice(const QString &path)
+{
+    const QString resolvedPath = Utils::Fs::expandPathAbs(path);
+    if (m_resolvingDevices.contains(resolvedPath)) return;
+
+    m_resolvingDevices.insert(resolvedPath);
+    m_threadPool.start(new ResolveDeviceTask(this, m_deviceProvider, resolvedPath));
+}
+
+void DiskSpaceMonitor::refresh()
+{
+    if (m_watchedPaths.isEmpty()) return;
+
+    if (m_isRefreshing) {
+        m_isRefreshRequested = true;
+        return;
+    }
+
+    const int delay = m_lastRefreshTime.isValid()
+        ? static_cast<int>(qMax<qint64>(0, (MIN_REFRESH_INTERVAL - m_lastRefreshTime.elapsed())))
+        : 0;
+    if (!m_refreshTimer.isActive() || (m_refreshTimer.remainingTime() > delay))
+        m_refreshTimer.start(delay);
+}
+
+void DiskSpaceMonitor::startRefresh()
+{
+    if (m_isRefreshing || m_watchedPaths.isEmpty()) return;
+
+    m_isRefreshing = true;
+    m_lastRefreshTime.start();
+    m_threadPool.start(new RefreshTask(this, m_statProvider, m_watchedPaths.keys()));
+}
+
+void DiskSpaceMonitor::handleRefreshFinished(const QStringList &paths, const QList<qint64> &freeSpaces)
+{
+    m_isRefreshing = false;
+
+    // The signals are emitted once the state is consistent since their receivers may change the watches
+    struct Change
+    {
+        QString path;
+        WatchedPath state;
+        bool wasLow;
+    };
+    QVector<Change> changes;
+    for (int i = 0; i < paths.size(); ++i) {
+        auto it = m_watchedPaths.find(paths[i]);
+        if ((it == m_watchedPaths.end()) || (it->bytesFree == freeSpaces[i]))
+            continue; // it was unwatched in the meantime or hasn't changed
+
+        const bool wasLow = it->isLow;
+        it->bytesFree = freeSpaces[i];
+        updateLowState(*it);
+        changes.append({paths[i], *it, wasLow});
+    }
+
+    if (m_isRefreshRequested) {
+        m_isRefreshRequested = false;
+        refresh();
+    }
+    else if (!m_watchedPaths.isEmpty()) {
+        m_refreshTimer.start(m_refreshInterval);
+    }
+
+    for (const Change &change : asConst(changes)) {
+        emit freeSpaceChanged(change.path, change.state.bytesFree);
+        if (change.state.isLow == change.wasLow) continue;
+
+        if (change.state.isLow)
+            emit lowDiskSpace(change.path, change.state.bytesFree, change.state.reserve);
+        else
+            emit diskSpaceRecovered(change.path, change.state.bytesFree);
+    }
+}
+
+void DiskSpaceMonitor::handleDeviceResolved(const QString &path, const QString &device)
+{
+    m_resolvingDevices.remove(path);
+    emit deviceResolved(path, device);
+}
+
+void DiskSpaceMonitor::updateLowState(WatchedPath &watchedPath)
+{
+    // The state is kept while the free space is unknown
+    if (watchedPath.bytesFree < 0) return;
+
+    if (watchedPath.reserve <= 0) {
+        watchedPath.isLow = false;
+        return;
+    }
+
+    const qint64 threshold = watchedPath.isLow
+        ? (watchedPath.reserve + qMax(MIN_RECOVERY_MARGIN, (watchedPath.reserve * RECOVERY_MARGIN_PERCENT / 100)))
+        : watchedPath.reserve;
+    watchedPath.isLow = (watchedPath.bytesFree < threshold);
+}
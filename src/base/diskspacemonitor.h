@@ -0,0 +1,133 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+
+class QStringList;
+
+// Keeps the free space of the file systems containing the watched paths.
+// The file systems are queried on a worker thread at a bounded rate, so the
+// cached values can be served at once from any code running on the main thread.
+// Paths are compared after Utils::Fs::expandPathAbs().
+class DiskSpaceMonitor : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(DiskSpaceMonitor)
+
+public:
+    struct Stats
+    {
+        qint64 bytesFree;
+        qint64 bytesTotal;
+    };
+
+    // Blocking query of the file system containing the path, it's called from the worker thread
+    using StatProvider = std::function<bool (const QString &path, Stats &stats)>;
+    // Blocking query of the device containing the path, it's called from the worker thread
+    using DeviceProvider = std::function<QString (const QString &path)>;
+
+    // The default providers ask the system, other ones can be used to simulate file systems
+    explicit DiskSpaceMonitor(const StatProvider &statProvider = {}, const DeviceProvider &deviceProvider = {}
+        , QObject *parent = nullptr);
+    ~DiskSpaceMonitor();
+
+    static void initInstance();
+    static void freeInstance();
+    static DiskSpaceMonitor *instance();
+
+    // The watches are counted, a path is watched until each watchPath() is matched by unwatchPath()
+    void watchPath(const QString &path);
+    void unwatchPath(const QString &path);
+    bool isWatched(const QString &path) const;
+
+    // The low disk space state is entered when the free space drops below the reserve
+    // of the path and left once it's back above the reserve plus a margin, 0 disables it
+    qint64 reserve(const QString &path) const;
+    void setReserve(const QString &path, qint64 bytes);
+    bool isLowOnSpace(const QString &path) const;
+
+    // Returns the last known free space of a watched path, -1 if it isn't known yet
+    qint64 freeSpace(const QString &path) const;
+
+    int refreshInterval() const;
+    void setRefreshInterval(int msecs);
+
+    // Looks up the device containing the path, the result comes with deviceResolved()
+    void resolveDevice(const QString &path);
+
+public slots:
+    // Requests the values sooner than the regular refresh
+    void refresh();
+
+signals:
+    void freeSpaceChanged(const QString &path, qint64 bytesFree);
+    void lowDiskSpace(const QString &path, qint64 bytesFree, qint64 reserve);
+    void diskSpaceRecovered(const QString &path, qint64 bytesFree);
+    // The device is empty if it couldn't be determined
+    void deviceResolved(const QString &path, const QString &device);
+
+private slots:
+    void handleRefreshFinished(const QStringList &paths, const QList<qint64> &freeSpaces);
+    void handleDeviceResolved(const QString &path, const QString &device);
+
+private:
+    struct WatchedPath
+    {
+        int watchCount;
+        qint64 reserve;
+        qint64 bytesFree;
+        bool isLow;
+    };
+
+    void startRefresh();
+    void updateLowState(WatchedPath &watchedPath);
+
+    StatProvider m_statProvider;
+    DeviceProvider m_deviceProvider;
+    QThreadPool m_threadPool;
+    QHash<QString, WatchedPath> m_watchedPaths;
+    QSet<QString> m_resolvingDevices;
+    QTimer m_refreshTimer;
+    QElapsedTimer m_lastRefreshTime;
+    int m_refreshInterval;
+    bool m_isRefreshing;
+    bool m_isRefreshRequested;
+
+    static DiskSpaceMonitor *m_instance;
+};
@@ -36,9 +36,12 @@
 #include <sys/param.h>
 #endif
 
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QRunnable>
+
 #include "base/algorithm.h"
 #include "base/bittorrent/magneturi.h"
-#include "base/bittorrent/torrentinfo.h"
 #include "base/global.h"
 #include "base/logger.h"
 #include "base/preferences.h"
@@ -48,6 +51,29 @@ namespace
 {
     const int WATCH_INTERVAL = 10000; // 10 sec
     const int MAX_PARTIAL_RETRIES = 5;
+
+    const int TorrentInfoTypeId = qRegisterMetaType<BitTorrent::TorrentInfo>("BitTorrent::TorrentInfo");
+
+    class TorrentParser : public QRunnable
+    {
+    public:
+        TorrentParser(QObject *receiver, const QString &path)
+            : m_receiver(receiver)
+            , m_path(path)
+        {
+        }
+
+        void run() override
+        {
+            const BitTorrent::TorrentInfo torrentInfo = BitTorrent::TorrentInfo::loadFromFile(m_path);
+            QMetaObject::invokeMethod(m_receiver, "handleParsedTorrent", Qt::QueuedConnection
+                                      , Q_ARG(QString, m_path), Q_ARG(BitTorrent::TorrentInfo, torrentInfo));
+        }
+
+    private:
+        QObject *m_receiver;
+        const QString m_path;
+    };
 }
 
 FileSystemWatcher::FileSystemWatcher(QObject *parent)
@@ -59,6 +85,11 @@ FileSystemWatcher::FileSystemWatcher(QObject *parent)
     connect(&m_partialTorrentTimer, &QTimer::timeout, this, &FileSystemWatcher::processPartialTorrents);
 
     connect(&m_watchTimer, &QTimer::timeout, this, &FileSystemWatcher::scanNetworkFolders);
+
+    // Coalesce the results of the parsing jobs finished within one event loop iteration
+    m_notificationTimer.setSingleShot(true);
+    m_notificationTimer.setInterval(0);
+    connect(&m_notificationTimer, &QTimer::timeout, this, &FileSystemWatcher::notifyAdded);
 }
 
 QStringList FileSystemWatcher::directories() const
@@ -96,6 +127,8 @@ void FileSystemWatcher::addPath(const QString &path)
 
 void FileSystemWatcher::removePath(const QString &path)
 {
+    m_folderListings.remove(QDir(path).absolutePath());
+
     if (m_watchedFolders.removeOne(path)) {
         if (m_watchedFolders.isEmpty())
             m_watchTimer.stop();
@@ -119,25 +152,27 @@ void FileSystemWatcher::scanNetworkFolders()
 
 void FileSystemWatcher::processPartialTorrents()
 {
-    QStringList noLongerPartial;
-
     // Check which torrents are still partial
-    Dict::removeIf(m_partialTorrents, [&noLongerPartial](const QString &torrentPath, int &value)
+    Dict::removeIf(m_partialTorrents, [this](const QString &torrentPath, PartialTorrent &partialTorrent)
     {
-        if (!QFile::exists(torrentPath))
+        const QFileInfo fileInfo(torrentPath);
+        if (!fileInfo.exists())
             return true;
 
-        if (BitTorrent::TorrentInfo::loadFromFile(torrentPath).isValid()) {
-            noLongerPartial << torrentPath;
-            return true;
+        // Reparse only if the file has been written to since the last attempt
+        const FileState state {fileInfo.size(), fileInfo.lastModified()};
+        if (!(state == partialTorrent.state)) {
+            partialTorrent.state = state;
+            parseTorrent(torrentPath, state);
+            return false;
         }
 
-        if (value >= MAX_PARTIAL_RETRIES) {
+        if (partialTorrent.retries >= MAX_PARTIAL_RETRIES) {
             QFile::rename(torrentPath, torrentPath + ".qbt_rejected");
             return true;
         }
 
-        ++value;
+        ++partialTorrent.retries;
         return false;
     });
 
@@ -150,29 +185,94 @@ void FileSystemWatcher::processPartialTorrents()
         qDebug("Still %d partial torrents after delayed processing.", m_partialTorrents.count());
         m_partialTorrentTimer.start(WATCH_INTERVAL);
     }
-
-    // Notify of new torrents
-    if (!noLongerPartial.isEmpty())
-        emit torrentsAdded(noLongerPartial);
 }
 
 void FileSystemWatcher::processTorrentsInDir(const QDir &dir)
 {
-    QStringList torrents;
-    const QStringList files = dir.entryList({"*.torrent", "*.magnet"}, QDir::Files);
-    for (const QString &file : files) {
-        const QString fileAbsPath = dir.absoluteFilePath(file);
-        if (file.endsWith(".magnet"))
-            torrents << fileAbsPath;
-        else if (BitTorrent::TorrentInfo::loadFromFile(fileAbsPath).isValid())
-            torrents << fileAbsPath;
-        else if (!m_partialTorrents.contains(fileAbsPath))
-            m_partialTorrents[fileAbsPath] = 0;
+    QHash<QString, FileState> &listing = m_folderListings[dir.absolutePath()];
+    QHash<QString, FileState> newListing;
+
+    const QFileInfoList files = dir.entryInfoList({"*.torrent", "*.magnet"}, QDir::Files);
+    for (const QFileInfo &fileInfo : files) {
+        const FileState state {fileInfo.size(), fileInfo.lastModified()};
+        const QString fileName = fileInfo.fileName();
+        newListing.insert(fileName, state);
+
+        // Already seen in this state, nothing to do
+        const auto it = listing.constFind(fileName);
+        if ((it != listing.cend()) && (it.value() == state))
+            continue;
+
+        const QString fileAbsPath = fileInfo.absoluteFilePath();
+        if (fileName.endsWith(".magnet")) {
+            m_addedMagnetFiles << fileAbsPath;
+            scheduleNotification();
+        }
+        else if (!m_partialTorrents.contains(fileAbsPath)) {
+            // partial torrents are taken care of by processPartialTorrents()
+            parseTorrent(fileAbsPath, state);
+        }
     }
 
-    if (!torrents.empty())
-        emit torrentsAdded(torrents);
+    listing = newListing;
+}
 
-    if (!m_partialTorrents.empty() && !m_partialTorrentTimer.isActive())
+void FileSystemWatcher::parseTorrent(const QString &path, const FileState &state)
+{
+    if (m_parsingTorrents.contains(path)) {
+        m_changedParsingTorrents.insert(path);
+        return;
+    }
+
+    m_parsingTorrents.insert(path, state);
+    m_parsingPool.start(new TorrentParser(this, path));
+}
+
+void FileSystemWatcher::handleParsedTorrent(const QString &path, const BitTorrent::TorrentInfo &torrentInfo)
+{
+    // The state is the one the file had before it was read, so a file that got
+    // completed during the parsing isn't mistaken for an unchanged partial one
+    const FileState state = m_parsingTorrents.take(path);
+
+    if (m_changedParsingTorrents.remove(path)) {
+        const QFileInfo fileInfo(path);
+        if (fileInfo.exists()) {
+            parseTorrent(path, {fileInfo.size(), fileInfo.lastModified()});
+            return;
+        }
+    }
+
+    if (torrentInfo.isValid()) {
+        m_partialTorrents.remove(path);
+        m_addedTorrents.insert(path, torrentInfo);
+        scheduleNotification();
+        return;
+    }
+
+    if (!m_partialTorrents.contains(path))
+        m_partialTorrents.insert(path, {state, 0});
+
+    if (!m_partialTorrentTimer.isActive())
         m_partialTorrentTimer.start(WATCH_INTERVAL);
 }
+
+void FileSystemWatcher::scheduleNotification()
+{
+    if (!m_notificationTimer.isActive())
+        m_notificationTimer.start();
+}
+
+void FileSystemWatcher::notifyAdded()
+{
+    if (!m_addedTorrents.isEmpty()) {
+        const QHash<QString, BitTorrent::TorrentInfo> torrents = m_addedTorrents;
+        m_addedTorrents.clear();
+        emit torrentsAdded(torrents);
+    }
+
+    if (!m_addedMagnetFiles.isEmpty()) {
+        const QStringList magnetFiles = m_addedMagnetFiles;
+        m_addedMagnetFiles.clear();
+        emit magnetFilesAdded(magnetFiles);
+    }
+}
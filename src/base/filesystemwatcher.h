@@ -29,15 +29,24 @@
 #ifndef FILESYSTEMWATCHER_H
 #define FILESYSTEMWATCHER_H
 
+#include <QDateTime>
 #include <QDir>
 #include <QFileSystemWatcher>
 #include <QHash>
+#include <QSet>
 #include <QStringList>
+#include <QThreadPool>
 #include <QTimer>
 
+#include "base/bittorrent/torrentinfo.h"
+
 /*
  * Subclassing QFileSystemWatcher in order to support Network File
  * System watching (NFS, CIFS) on Linux and Mac OS.
+ *
+ * Each scan is diffed against the cached listing of the folder so only
+ * new or modified files are processed, and .torrent files are parsed
+ * in a thread pool.
  */
 class FileSystemWatcher : public QFileSystemWatcher
 {
@@ -51,22 +60,61 @@ public:
     void removePath(const QString &path);
 
 signals:
-    void torrentsAdded(const QStringList &pathList);
+    void torrentsAdded(const QHash<QString, BitTorrent::TorrentInfo> &torrents);
+    void magnetFilesAdded(const QStringList &pathList);
 
 protected slots:
     void scanLocalFolder(const QString &path);
     void processPartialTorrents();
     void scanNetworkFolders();
 
+private slots:
+    void notifyAdded();
+
 private:
+    struct FileState
+    {
+        qint64 size;
+        QDateTime lastModified;
+
+        bool operator==(const FileState &other) const
+        {
+            return (size == other.size) && (lastModified == other.lastModified);
+        }
+    };
+
+    struct PartialTorrent
+    {
+        FileState state;
+        int retries;
+    };
+
     void processTorrentsInDir(const QDir &dir);
+    void parseTorrent(const QString &path, const FileState &state);
+    Q_INVOKABLE void handleParsedTorrent(const QString &path, const BitTorrent::TorrentInfo &torrentInfo);
+    void scheduleNotification();
+
+    // Last seen state of the files in each folder
+    QHash<QString, QHash<QString, FileState>> m_folderListings;
 
     // Partial torrents
-    QHash<QString, int> m_partialTorrents;
+    QHash<QString, PartialTorrent> m_partialTorrents;
     QTimer m_partialTorrentTimer;
 
     QList<QDir> m_watchedFolders;
     QTimer m_watchTimer;
+
+    // Files being parsed with their state when the parsing was queued,
+    // those that changed meanwhile are parsed again once it is done
+    QHash<QString, FileState> m_parsingTorrents;
+    QSet<QString> m_changedParsingTorrents;
+    // Results waiting to be reported
+    QHash<QString, BitTorrent::TorrentInfo> m_addedTorrents;
+    QStringList m_addedMagnetFiles;
+    QTimer m_notificationTimer;
+
+    // Must stay the last member: it waits for the running jobs on destruction
+    QThreadPool m_parsingPool;
 };
 
 #endif // FILESYSTEMWATCHER_H
@@ -0,0 +1,198 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "hookexecutor.h"
+
+#include <algorithm>
+
+#include <QProcess>
+
+#include "base/global.h"
+#include "base/logger.h"
+
+namespace
+{
+    const int DEFAULT_MAX_PROCESSES = 4;
+    const int SHUTDOWN_TIMEOUT = 10000; // ms
+    const int SHUTDOWN_POLL_INTERVAL = 100; // ms
+}
+
+HookExecutor::HookExecutor(QObject *parent)
+    : QObject(parent)
+    , m_maxProcesses(DEFAULT_MAX_PROCESSES)
+    , m_burstRuns(0)
+    , m_burstFailures(0)
+    , m_burstTotalTime(0)
+    , m_burstMaxTime(0)
+{
+}
+
+HookExecutor::~HookExecutor()
+{
+    // The queued jobs are still started within the process limit as slots free up,
+    // the ones left when the timeout expires are dropped
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_queue.isEmpty() && !m_runningJobs.isEmpty() && !timer.hasExpired(SHUTDOWN_TIMEOUT)) {
+        // finished() is emitted from waitForFinished(), which starts the next queued jobs
+        for (QProcess *process : asConst(m_runningJobs.keys())) {
+            if (m_runningJobs.contains(process))
+                process->waitForFinished(SHUTDOWN_POLL_INTERVAL);
+        }
+    }
+
+    if (!m_queue.isEmpty()) {
+        LogMsg(tr("%1 queued external programs were not run because qBittorrent is exiting")
+               .arg(m_queue.size()), Log::WARNING);
+        m_queue.clear();
+    }
+
+    logStatistics();
+
+    // The programs must not be killed when qBittorrent exits,
+    // so the processes are released without being deleted
+    for (QProcess *process : asConst(m_runningJobs.keys())) {
+        process->waitForBytesWritten(1000);
+        process->disconnect(this);
+        process->setParent(nullptr);
+    }
+}
+
+void HookExecutor::setMaxProcesses(const int count)
+{
+    m_maxProcesses = std::max(1, count);
+    startQueuedJobs();
+}
+
+void HookExecutor::enqueue(const Job &job)
+{
+    m_queue.enqueue(job);
+    startQueuedJobs();
+}
+
+QProcess *HookExecutor::startProcess(const Job &job)
+{
+    auto *process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    if (job.input.isEmpty())
+        process->setStandardInputFile(QProcess::nullDevice());
+
+    RunningJob &runningJob = m_runningJobs[process];
+    runningJob.hookName = job.hookName;
+    runningJob.description = job.description;
+    runningJob.timer.start();
+
+    connect(process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished)
+            , this, [this, process](const int exitCode, const QProcess::ExitStatus exitStatus)
+    {
+        if (exitStatus == QProcess::CrashExit)
+            handleProcessFinished(process, true, tr("the program crashed"));
+        else if (exitCode != 0)
+            handleProcessFinished(process, true, tr("exit code %1").arg(exitCode));
+        else
+            handleProcessFinished(process, false, {});
+    });
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 6, 0))
+    connect(process, &QProcess::errorOccurred, this, [this, process](const QProcess::ProcessError error)
+#else
+    connect(process, static_cast<void (QProcess::*)(QProcess::ProcessError)>(&QProcess::error)
+            , this, [this, process](const QProcess::ProcessError error)
+#endif
+    {
+        // the other errors are followed by finished()
+        if (error == QProcess::FailedToStart)
+            handleProcessFinished(process, true, process->errorString());
+    });
+
+    process->start(job.program, job.arguments);
+    if (!job.input.isEmpty()) {
+        process->write(job.input);
+        process->closeWriteChannel();
+    }
+
+    return process;
+}
+
+void HookExecutor::startQueuedJobs()
+{
+    while (!m_queue.isEmpty() && (m_runningJobs.size() < m_maxProcesses))
+        startProcess(m_queue.dequeue());
+}
+
+void HookExecutor::handleProcessFinished(QProcess *process, const bool failed, const QString &reason)
+{
+    const auto iter = m_runningJobs.find(process);
+    if (iter == m_runningJobs.end()) return;
+
+    const QString hookName = iter->hookName;
+    const QString description = iter->description;
+    const qint64 elapsed = iter->timer.elapsed();
+    m_runningJobs.erase(iter);
+    process->deleteLater();
+
+    Statistics &stats = m_statistics[hookName];
+    ++stats.runs;
+    stats.totalTime += elapsed;
+    stats.maxTime = std::max(stats.maxTime, elapsed);
+
+    ++m_burstRuns;
+    m_burstTotalTime += elapsed;
+    m_burstMaxTime = std::max(m_burstMaxTime, elapsed);
+
+    if (failed) {
+        ++stats.failures;
+        ++m_burstFailures;
+        LogMsg(tr("External program (%1) failed after %2 ms: %3").arg(description).arg(elapsed).arg(reason), Log::WARNING);
+    }
+    else {
+        LogMsg(tr("External program (%1) finished in %2 ms").arg(description).arg(elapsed), Log::INFO);
+    }
+
+    startQueuedJobs();
+
+    if (m_queue.isEmpty() && m_runningJobs.isEmpty()) {
+        if (m_burstRuns > 1) {
+            LogMsg(tr("Ran %1 external programs, %2 failed. Average time: %3 ms, longest: %4 ms")
+                   .arg(m_burstRuns).arg(m_burstFailures).arg(m_burstTotalTime / m_burstRuns).arg(m_burstMaxTime));
+        }
+        m_burstRuns = 0;
+        m_burstFailures = 0;
+        m_burstTotalTime = 0;
+        m_burstMaxTime = 0;
+    }
+}
+
+void HookExecutor::logStatistics() const
+{
+    for (auto i = m_statistics.cbegin(); i != m_statistics.cend(); ++i) {
+        const Statistics &stats = i.value();
+        LogMsg(tr("External programs run on %1: %2 runs, %3 failed. Average time: %4 ms, longest: %5 ms")
+               .arg(i.key()).arg(stats.runs).arg(stats.failures).arg(stats.totalTime / stats.runs).arg(stats.maxTime));
+    }
+}
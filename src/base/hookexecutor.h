@@ -0,0 +1,98 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QStringList>
+
+class QProcess;
+
+// Runs external programs (e.g. the one started when a torrent finishes)
+// with a bounded number of concurrent processes, the other jobs are queued.
+// The programs share the standard output of qBittorrent, like detached ones.
+class HookExecutor : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HookExecutor)
+
+public:
+    struct Job
+    {
+        QString hookName; // the statistics are kept per hook
+        QString description; // used in the log messages, e.g. the torrent name
+        QString program;
+        QStringList arguments;
+        QByteArray input; // written to the standard input of the program
+    };
+
+    explicit HookExecutor(QObject *parent = nullptr);
+    ~HookExecutor() override;
+
+    void setMaxProcesses(int count);
+
+    void enqueue(const Job &job);
+
+private:
+    struct RunningJob
+    {
+        QString hookName;
+        QString description;
+        QElapsedTimer timer;
+    };
+
+    struct Statistics
+    {
+        int runs = 0;
+        int failures = 0;
+        qint64 totalTime = 0; // ms
+        qint64 maxTime = 0; // ms
+    };
+
+    QProcess *startProcess(const Job &job);
+    void startQueuedJobs();
+    void handleProcessFinished(QProcess *process, bool failed, const QString &reason);
+    void logStatistics() const;
+
+    int m_maxProcesses;
+    QQueue<Job> m_queue;
+    QHash<QProcess *, RunningJob> m_runningJobs;
+    // since startup, reported in the log on exit
+    QHash<QString, Statistics> m_statistics;
+    // jobs finished since the queue was last drained, they are summarized in the log
+    int m_burstRuns;
+    int m_burstFailures;
+    qint64 m_burstTotalTime;
+    qint64 m_burstMaxTime;
+};
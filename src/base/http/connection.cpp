@@ -30,6 +30,7 @@
 
 #include "connection.h"
 
+#include <QPointer>
 #include <QTcpSocket>
 
 #include "base/logger.h"
@@ -43,6 +44,8 @@ Connection::Connection(QTcpSocket *socket, IRequestHandler *requestHandler, QObj
     : QObject(parent)
     , m_socket(socket)
     , m_requestHandler(requestHandler)
+    , m_isResponsePending(false)
+    , m_isProcessing(false)
 {
     m_socket->setParent(this);
     m_idleTimer.start();
@@ -59,7 +62,15 @@ void Connection::read()
     m_idleTimer.restart();
     m_receivedData.append(m_socket->readAll());
 
-    while (!m_receivedData.isEmpty()) {
+    if (!m_isResponsePending)
+        processReceivedData();
+}
+
+void Connection::processReceivedData()
+{
+    m_isProcessing = true;
+
+    while (!m_receivedData.isEmpty() && !m_isResponsePending) {
         const RequestParser::ParseResult result = RequestParser::parse(m_receivedData);
 
         switch (result.status) {
@@ -76,6 +87,7 @@ void Connection::read()
                     m_socket->close();
                 }
             }
+            m_isProcessing = false;
             return;
 
         case RequestParser::ParseStatus::BadRequest: {
@@ -88,28 +100,49 @@ void Connection::read()
                 sendResponse(resp);
                 m_socket->close();
             }
+            m_isProcessing = false;
             return;
 
         case RequestParser::ParseStatus::OK: {
                 const Environment env {m_socket->localAddress(), m_socket->localPort(), m_socket->peerAddress(), m_socket->peerPort()};
-
-                Response resp = m_requestHandler->processRequest(result.request, env);
-
-                if (acceptsGzipEncoding(result.request.headers["accept-encoding"]))
-                    resp.headers[HEADER_CONTENT_ENCODING] = "gzip";
-
-                resp.headers[HEADER_CONNECTION] = "keep-alive";
-
-                sendResponse(resp);
+                const bool acceptsGzip = acceptsGzipEncoding(result.request.headers["accept-encoding"]);
                 m_receivedData = m_receivedData.mid(result.frameSize);
+
+                // The connection may be dropped before a deferred response is ready
+                m_isResponsePending = true;
+                const QPointer<Connection> connection {this};
+                m_requestHandler->processRequest(result.request, env, [connection, acceptsGzip](const Response &response)
+                {
+                    if (connection)
+                        connection->finishRequest(response, acceptsGzip);
+                });
             }
             break;
 
         default:
             Q_ASSERT(false);
+            m_isProcessing = false;
             return;
         }
     }
+
+    m_isProcessing = false;
+}
+
+void Connection::finishRequest(Response response, const bool acceptsGzip)
+{
+    if (acceptsGzip)
+        response.headers[HEADER_CONTENT_ENCODING] = "gzip";
+
+    response.headers[HEADER_CONNECTION] = "keep-alive";
+
+    sendResponse(response);
+    m_isResponsePending = false;
+    m_idleTimer.restart();
+
+    // The requests received meanwhile are processed once a deferred response is sent
+    if (!m_isProcessing)
+        processReceivedData();
 }
 
 void Connection::sendResponse(const Response &response) const
@@ -119,7 +152,7 @@ void Connection::sendResponse(const Response &response) const
 
 bool Connection::hasExpired(const qint64 timeout) const
 {
-    return m_idleTimer.hasExpired(timeout);
+    return !m_isResponsePending && m_idleTimer.hasExpired(timeout);
 }
 
 bool Connection::isClosed() const
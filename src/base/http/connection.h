@@ -59,12 +59,17 @@ namespace Http
 
     private:
         static bool acceptsGzipEncoding(QString codings);
+        void processReceivedData();
+        void finishRequest(Response response, bool acceptsGzip);
         void sendResponse(const Response &response) const;
 
         QTcpSocket *m_socket;
         IRequestHandler *m_requestHandler;
         QByteArray m_receivedData;
         QElapsedTimer m_idleTimer;
+        // The requests are answered in order, the next one waits for the pending response
+        bool m_isResponsePending;
+        bool m_isProcessing;
     };
 }
 
@@ -79,3 +79,8 @@ InternalServerErrorHTTPError::InternalServerErrorHTTPError(const QString &messag
     : HTTPError(500, QLatin1String("Internal Server Error"), message)
 {
 }
+
+ServiceUnavailableHTTPError::ServiceUnavailableHTTPError(const QString &message)
+    : HTTPError(503, QLatin1String("Service Unavailable"), message)
+{
+}
@@ -84,3 +84,9 @@ class InternalServerErrorHTTPError : public HTTPError
 public:
     explicit InternalServerErrorHTTPError(const QString &message = "");
 };
+
+class ServiceUnavailableHTTPError : public HTTPError
+{
+public:
+    explicit ServiceUnavailableHTTPError(const QString &message = "");
+};
@@ -29,6 +29,8 @@
 #ifndef HTTP_IREQUESTHANDLER_H
 #define HTTP_IREQUESTHANDLER_H
 
+#include <functional>
+
 #include "types.h"
 
 namespace Http
@@ -36,8 +38,13 @@ namespace Http
     class IRequestHandler
     {
     public:
+        using ResponseCallback = std::function<void (const Response &response)>;
+
         virtual ~IRequestHandler() {}
-        virtual Response processRequest(const Request &request, const Environment &env) = 0;
+
+        // The callback may be called after returning, e.g. once a computation on another
+        // thread is done. The connection doesn't process its next request meanwhile.
+        virtual void processRequest(const Request &request, const Environment &env, const ResponseCallback &callback) = 0;
     };
 }
 
@@ -0,0 +1,71 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "latencyhistogram.h"
+
+#include <algorithm>
+
+const std::array<qint64, LatencyHistogram::BUCKET_COUNT> &LatencyHistogram::bucketBounds()
+{
+    static const std::array<qint64, BUCKET_COUNT> bounds {{
+        100, 500, 1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 5000000
+    }};
+    return bounds;
+}
+
+void LatencyHistogram::record(const qint64 usecs)
+{
+    const auto &bounds = bucketBounds();
+    const auto boundIter = std::lower_bound(bounds.cbegin(), bounds.cend(), usecs);
+    if (boundIter != bounds.cend())
+        ++m_buckets[boundIter - bounds.cbegin()];
+
+    ++m_count;
+    m_sum += std::max<qint64>(0, usecs);
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return m_count;
+}
+
+quint64 LatencyHistogram::sum() const
+{
+    return m_sum;
+}
+
+quint64 LatencyHistogram::cumulativeCount(const int index) const
+{
+    Q_ASSERT((index >= 0) && (index < BUCKET_COUNT));
+
+    quint64 result = 0;
+    for (int i = 0; i <= index; ++i)
+        result += m_buckets[i];
+    return result;
+}
@@ -1,6 +1,6 @@
 /*
  * Bittorrent Client using Qt and libtorrent.
- * Copyright (C) 2018  Thomas Piccirello <thomas.piccirello@gmail.com>
+ * Copyright (C) 2019  qBittorrent project
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License
@@ -26,13 +26,31 @@
  * exception statement from your version.
  */
 
-#include "freediskspacechecker.h"
 
-#include "base/bittorrent/session.h"
-#include "base/utils/fs.h"
+#pragma once
 
-void FreeDiskSpaceChecker::check()
+#include <array>
+
+#include <QtGlobal>
+
+// Fixed-bucket histogram of durations, recorded in microseconds
+class LatencyHistogram
 {
-    const qint64 freeDiskSpace = Utils::Fs::freeDiskSpaceOnPath(BitTorrent::Session::instance()->defaultSavePath());
-    emit checked(freeDiskSpace);
-}
+public:
+    static const int BUCKET_COUNT = 12;
+
+    // upper bounds (inclusive) of the buckets, the last bucket is followed by an implicit +Inf one
+    static const std::array<qint64, BUCKET_COUNT> &bucketBounds();
+
+    void record(qint64 usecs);
+
+    quint64 count() const;
+    quint64 sum() const;
+    // number of samples that are less than or equal to bucketBounds()[index]
+    quint64 cumulativeCount(int index) const;
+
+private:
+    std::array<quint64, BUCKET_COUNT> m_buckets {};
+    quint64 m_count = 0;
+    quint64 m_sum = 0;
+};
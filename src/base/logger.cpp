@@ -59,6 +59,16 @@ void Logger::addPeer(const QString &ip, bool blocked, const QString &reason)
     emit newLogPeer(temp);
 }
 
+void Logger::addDroppedMessage()
+{
+    ++m_droppedMessagesCount;
+}
+
+quint64 Logger::droppedMessagesCount() const
+{
+    return m_droppedMessagesCount;
+}
+
 QVector<Log::Msg> Logger::getMessages(int lastKnownId) const
 {
     QReadLocker locker(&m_lock);
@@ -1,6 +1,8 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
+
 #include <QObject>
 #include <QReadWriteLock>
 #include <QString>
@@ -55,6 +57,11 @@ public:
     QVector<Log::Msg> getMessages(int lastKnownId = -1) const;
     QVector<Log::Peer> getPeers(int lastKnownId = -1) const;
 
+    // Messages a consumer of the log had to discard, e.g. because the log file
+    // couldn't keep up. Thread-safe.
+    void addDroppedMessage();
+    quint64 droppedMessagesCount() const;
+
 signals:
     void newLogMessage(const Log::Msg &message);
     void newLogPeer(const Log::Peer &peer);
@@ -69,6 +76,7 @@ private:
     mutable QReadWriteLock m_lock;
     int m_msgCounter;
     int m_peerCounter;
+    std::atomic<quint64> m_droppedMessagesCount {0};
 };
 
 // Helper function
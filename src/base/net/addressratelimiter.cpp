@@ -0,0 +1,176 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "addressratelimiter.h"
+
+#include <algorithm>
+
+#include <QHostAddress>
+
+using namespace Net;
+
+namespace
+{
+    // The buckets that are full again are looked for at most this often once the table is full
+    const qint64 PRUNE_INTERVAL = 1000;
+
+    QString addressKey(const QHostAddress &address)
+    {
+        bool isIPv4 = false;
+        const quint32 ipv4 = address.toIPv4Address(&isIPv4);
+        if (isIPv4)
+            return QHostAddress(ipv4).toString();
+        return address.toString();
+    }
+
+    QString ipv6SubnetKey(const QHostAddress &address, const int prefixLength)
+    {
+        Q_IPV6ADDR ipv6 = address.toIPv6Address();
+        for (int i = (prefixLength / 8); i < 16; ++i)
+            ipv6[i] = 0;
+        return QHostAddress(ipv6).toString() + QLatin1Char('/') + QString::number(prefixLength);
+    }
+}
+
+AddressRateLimiter::AddressRateLimiter(const Limits &limits, const Clock &clock)
+    : m_limits(limits)
+    , m_clock(clock)
+    , m_lastPruneTime(0)
+{
+    if (!m_clock) {
+        m_elapsedTimer.start();
+        m_clock = [this]() { return m_elapsedTimer.elapsed(); };
+    }
+    m_lastPruneTime = m_clock() - PRUNE_INTERVAL;
+}
+
+AddressRateLimiter::AcquireResult AddressRateLimiter::tryAcquire(const QHostAddress &address)
+{
+    const qint64 now = m_clock();
+    const QVector<BucketKey> keys = bucketKeys(address);
+
+    // A refused attempt doesn't create buckets, they would be full anyway
+    int missingCount = 0;
+    for (const BucketKey &key : keys) {
+        const auto it = m_buckets.constFind(key.key);
+        if (it == m_buckets.cend()) {
+            ++missingCount;
+            continue;
+        }
+        if (tokensAt(*it, now) < 1)
+            return AcquireResult::RateLimited;
+    }
+
+    if ((m_buckets.size() + missingCount) > m_limits.maxBuckets) {
+        if ((now - m_lastPruneTime) >= PRUNE_INTERVAL)
+            prune(now);
+        if ((m_buckets.size() + missingCount) > m_limits.maxBuckets)
+            return AcquireResult::TableFull;
+    }
+
+    for (const BucketKey &key : keys) {
+        auto it = m_buckets.find(key.key);
+        if (it == m_buckets.end()) {
+            m_buckets.insert(key.key, {static_cast<double>(key.capacity - 1), key.capacity, now});
+            continue;
+        }
+
+        it->tokens = tokensAt(*it, now) - 1;
+        it->lastUsed = now;
+    }
+
+    return AcquireResult::Acquired;
+}
+
+void AddressRateLimiter::release(const QHostAddress &address)
+{
+    const qint64 now = m_clock();
+    const QVector<BucketKey> keys = bucketKeys(address);
+    for (const BucketKey &key : keys)
+        giveBack(key.key, now);
+}
+
+int AddressRateLimiter::availableTokens(const QHostAddress &address) const
+{
+    const auto it = m_buckets.constFind(addressKey(address));
+    if (it == m_buckets.cend())
+        return m_limits.addressCapacity;
+    return static_cast<int>(tokensAt(*it, m_clock()));
+}
+
+int AddressRateLimiter::bucketCount() const
+{
+    return m_buckets.size();
+}
+
+QVector<AddressRateLimiter::BucketKey> AddressRateLimiter::bucketKeys(const QHostAddress &address) const
+{
+    bool isIPv4 = false;
+    const quint32 ipv4 = address.toIPv4Address(&isIPv4);
+    if (isIPv4) {
+        return {{QHostAddress(ipv4).toString(), m_limits.addressCapacity}
+            , {(QHostAddress(ipv4 & 0xFFFFFF00).toString() + QLatin1String("/24")), m_limits.subnetCapacity}};
+    }
+
+    return {{address.toString(), m_limits.addressCapacity}
+        , {ipv6SubnetKey(address, 64), m_limits.subnetCapacity}
+        , {ipv6SubnetKey(address, 48), m_limits.wideSubnetCapacity}};
+}
+
+double AddressRateLimiter::tokensAt(const Bucket &bucket, const qint64 now) const
+{
+    const double refilled = (m_limits.refillTime > 0)
+        ? (static_cast<double>(now - bucket.lastUsed) * bucket.capacity / m_limits.refillTime)
+        : bucket.capacity;
+    return std::min<double>(bucket.capacity, (bucket.tokens + refilled));
+}
+
+void AddressRateLimiter::giveBack(const QString &key, const qint64 now)
+{
+    auto it = m_buckets.find(key);
+    if (it == m_buckets.end()) return;
+
+    it->tokens = std::min<double>(it->capacity, (tokensAt(*it, now) + 1));
+    it->lastUsed = now;
+    if (it->tokens >= it->capacity)
+        m_buckets.erase(it);
+}
+
+void AddressRateLimiter::prune(const qint64 now)
+{
+    m_lastPruneTime = now;
+
+    // Only the buckets that are full again are forgotten, dropping a drained one would lift its limit
+    for (auto it = m_buckets.begin(); it != m_buckets.end();) {
+        if (tokensAt(*it, now) >= it->capacity)
+            it = m_buckets.erase(it);
+        else
+            ++it;
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+class QHostAddress;
+
+namespace Net
+{
+    // Token buckets limiting the rate of an action per client address and per subnet
+    // (/24 for IPv4, /64 and /48 for IPv6), so neighbouring addresses share a part of the limit.
+    // A full bucket is the same as no bucket, so only the drained ones are kept. They are never
+    // dropped before they are full again: once their count reaches the maximum, the addresses
+    // that would need new buckets are refused until some of them refill.
+    class AddressRateLimiter
+    {
+        Q_DISABLE_COPY(AddressRateLimiter)
+
+    public:
+        // Monotonic time in milliseconds
+        using Clock = std::function<qint64 ()>;
+
+        struct Limits
+        {
+            int addressCapacity;
+            int subnetCapacity;
+            // Capacity of the IPv6 /48 subnets, a single site often gets a whole /48
+            int wideSubnetCapacity;
+            // Time for an empty bucket to be full again, in milliseconds
+            qint64 refillTime;
+            int maxBuckets;
+        };
+
+        enum class AcquireResult
+        {
+            Acquired,
+            RateLimited,
+            // There is no room left to track the address
+            TableFull
+        };
+
+        explicit AddressRateLimiter(const Limits &limits, const Clock &clock = {});
+
+        // Takes a token from every bucket of the address, fails if one of them is empty
+        AcquireResult tryAcquire(const QHostAddress &address);
+        // Gives back a token taken by tryAcquire(), e.g. when the attempt turned out legitimate
+        void release(const QHostAddress &address);
+        // Tokens left in the bucket of the address itself
+        int availableTokens(const QHostAddress &address) const;
+        int bucketCount() const;
+
+    private:
+        struct Bucket
+        {
+            double tokens;
+            int capacity;
+            qint64 lastUsed;
+        };
+
+        struct BucketKey
+        {
+            QString key;
+            int capacity;
+        };
+
+        QVector<BucketKey> bucketKeys(const QHostAddress &address) const;
+        double tokensAt(const Bucket &bucket, qint64 now) const;
+        void giveBack(const QString &key, qint64 now);
+        void prune(qint64 now);
+
+        const Limits m_limits;
+        Clock m_clock;
+        QElapsedTimer m_elapsedTimer;
+        QHash<QString, Bucket> m_buckets;
+        qint64 m_lastPruneTime;
+    };
+}
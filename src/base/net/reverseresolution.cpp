@@ -30,60 +30,139 @@
 
 #include <QDebug>
 #include <QHostInfo>
-#include <QString>
-
-const int CACHE_SIZE = 500;
+#include <QRunnable>
+#include <QStringList>
 
 using namespace Net;
 
-static inline bool isUsefulHostName(const QString &hostname, const QString &ip)
+namespace
 {
-    return (!hostname.isEmpty() && (hostname != ip));
+    const int CACHE_SIZE = 512 * 1024; // in bytes
+    const int MAX_LOOKUP_THREADS = 4;
+    // Failed lookups are retried after this delay
+    const qint64 FAILED_LOOKUP_TTL = 10 * 60 * 1000;
+    // The results are reported in batches at most once per interval
+    const int REPORT_INTERVAL = 250;
+
+    QString lookupHostName(const QString &ip)
+    {
+        const QHostInfo hostInfo = QHostInfo::fromName(ip);
+        if (hostInfo.error() != QHostInfo::NoError) {
+            qDebug() << "DNS Reverse resolution error: " << hostInfo.errorString();
+            return {};
+        }
+
+        const QString hostName = hostInfo.hostName();
+        return (hostName != ip) ? hostName : QString();
+    }
+
+    class LookupTask : public QRunnable
+    {
+    public:
+        LookupTask(QObject *receiver, const ReverseResolution::Resolver &resolver, const QString &ip)
+            : m_receiver(receiver)
+            , m_resolver(resolver)
+            , m_ip(ip)
+        {
+        }
+
+        void run() override
+        {
+            const QString hostName = m_resolver(m_ip);
+            QMetaObject::invokeMethod(m_receiver, "handleLookupFinished", Qt::QueuedConnection
+                , Q_ARG(QString, m_ip), Q_ARG(QString, hostName));
+        }
+
+    private:
+        QObject *const m_receiver;
+        const ReverseResolution::Resolver m_resolver;
+        const QString m_ip;
+    };
 }
 
-ReverseResolution::ReverseResolution(QObject *parent)
+ReverseResolution *ReverseResolution::m_instance = nullptr;
+
+ReverseResolution::ReverseResolution(const Resolver &resolver, QObject *parent)
     : QObject(parent)
+    , m_resolver(resolver ? resolver : Resolver(lookupHostName))
 {
+    m_threadPool.setMaxThreadCount(MAX_LOOKUP_THREADS);
+    m_clock.start();
     m_cache.setMaxCost(CACHE_SIZE);
+
+    m_reportTimer.setSingleShot(true);
+    m_reportTimer.setInterval(REPORT_INTERVAL);
+    connect(&m_reportTimer, &QTimer::timeout, this, &ReverseResolution::reportResults);
 }
 
 ReverseResolution::~ReverseResolution()
 {
     qDebug("Deleting host name resolver...");
+    // Only the running lookups are waited for. QHostInfo::fromName() can't be
+    // interrupted, so exiting can be delayed up to the timeout of the system resolver.
+    m_threadPool.clear();
 }
 
-void ReverseResolution::resolve(const QString &ip)
+void ReverseResolution::initInstance()
 {
-    if (m_cache.contains(ip)) {
-        const QString &hostname = *m_cache.object(ip);
-        qDebug() << "Resolved host name using cache: " << ip << " -> " << hostname;
-        if (isUsefulHostName(hostname, ip))
-            emit ipResolved(ip, hostname);
-    }
-    else {
-        // Actually resolve the ip
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 9, 0))
-        m_lookups.insert(QHostInfo::lookupHost(ip, this, &ReverseResolution::hostResolved), ip);
-#else
-        m_lookups.insert(QHostInfo::lookupHost(ip, this, SLOT(hostResolved(QHostInfo))), ip);
-#endif
+    if (!m_instance)
+        m_instance = new ReverseResolution;
+}
+
+void ReverseResolution::freeInstance()
+{
+    if (m_instance) {
+        delete m_instance;
+        m_instance = nullptr;
     }
 }
 
-void ReverseResolution::hostResolved(const QHostInfo &host)
+ReverseResolution *ReverseResolution::instance()
 {
-    const QString ip = m_lookups.take(host.lookupId());
-    Q_ASSERT(!ip.isNull());
+    return m_instance;
+}
+
+QHash<QString, QString> ReverseResolution::resolve(const QStringList &ips)
+{
+    QHash<QString, QString> hostNames;
+    for (const QString &ip : ips) {
+        const CacheEntry *entry = m_cache.object(ip);
+        if (entry && ((entry->expirationTime < 0) || (entry->expirationTime > m_clock.elapsed()))) {
+            if (!entry->hostName.isEmpty())
+                hostNames.insert(ip, entry->hostName);
+            continue;
+        }
+
+        if (m_pendingLookups.contains(ip)) continue;
 
-    if (host.error() != QHostInfo::NoError) {
-        qDebug() << "DNS Reverse resolution error: " << host.errorString();
-        return;
+        m_pendingLookups.insert(ip);
+        m_threadPool.start(new LookupTask(this, m_resolver, ip));
     }
 
-    const QString hostname = host.hostName();
+    return hostNames;
+}
+
+void ReverseResolution::handleLookupFinished(const QString &ip, const QString &hostName)
+{
+    m_pendingLookups.remove(ip);
+
+    qDebug() << Q_FUNC_INFO << ip << QString("->") << hostName;
+    const qint64 expirationTime = hostName.isEmpty() ? (m_clock.elapsed() + FAILED_LOOKUP_TTL) : -1;
+    const int cost = static_cast<int>(sizeof(CacheEntry) + ((ip.size() + hostName.size()) * sizeof(QChar)));
+    m_cache.insert(ip, new CacheEntry {hostName, expirationTime}, cost);
+
+    if (hostName.isEmpty()) return;
+
+    m_unreportedHostNames.insert(ip, hostName);
+    if (!m_reportTimer.isActive())
+        m_reportTimer.start();
+}
+
+void ReverseResolution::reportResults()
+{
+    if (m_unreportedHostNames.isEmpty()) return;
 
-    qDebug() << Q_FUNC_INFO << ip << QString("->") << hostname;
-    m_cache.insert(ip, new QString(hostname));
-    if (isUsefulHostName(hostname, ip))
-        emit ipResolved(ip, hostname);
+    const QHash<QString, QString> hostNames = m_unreportedHostNames;
+    m_unreportedHostNames.clear();
+    emit hostNamesResolved(hostNames);
 }
@@ -29,34 +29,73 @@
 #ifndef NET_REVERSERESOLUTION_H
 #define NET_REVERSERESOLUTION_H
 
+#include <functional>
+
 #include <QCache>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
 
-class QHostInfo;
-class QString;
+class QStringList;
 
 namespace Net
 {
+    // Resolves the host names of IP addresses on a dedicated thread pool.
+    // Simultaneous requests of the same address share one lookup and the results,
+    // the failed ones for a limited time, are kept in a cache limited in bytes.
     class ReverseResolution : public QObject
     {
         Q_OBJECT
         Q_DISABLE_COPY(ReverseResolution)
 
     public:
-        explicit ReverseResolution(QObject *parent = nullptr);
+        // Blocking lookup of the host name of the address, empty if it has none.
+        // It's called from the pool threads.
+        using Resolver = std::function<QString (const QString &ip)>;
+
+        // The default resolver asks the system, another one can be used to avoid network access
+        explicit ReverseResolution(const Resolver &resolver = {}, QObject *parent = nullptr);
         ~ReverseResolution();
 
-        void resolve(const QString &ip);
+        static void initInstance();
+        static void freeInstance();
+        static ReverseResolution *instance();
+
+        // Returns the known host names of the addresses and starts resolving
+        // the other ones, their host names are reported by hostNamesResolved()
+        QHash<QString, QString> resolve(const QStringList &ips);
 
     signals:
-        void ipResolved(const QString &ip, const QString &hostname);
+        // The results are reported in batches, only the addresses having a host name are included
+        void hostNamesResolved(const QHash<QString, QString> &hostNames);
 
     private slots:
-        void hostResolved(const QHostInfo &host);
+        void handleLookupFinished(const QString &ip, const QString &hostName);
 
     private:
-        QHash<int /* LookupID */, QString /* IP */> m_lookups;
-        QCache<QString /* IP */, QString /* HostName */> m_cache;
+        struct CacheEntry
+        {
+            // Empty if the lookup failed
+            QString hostName;
+            // Milliseconds of m_clock, -1 if the entry doesn't expire
+            qint64 expirationTime;
+        };
+
+        void reportResults();
+
+        Resolver m_resolver;
+        QThreadPool m_threadPool;
+        QElapsedTimer m_clock;
+        QCache<QString /* IP */, CacheEntry> m_cache;
+        QSet<QString> m_pendingLookups;
+        QHash<QString, QString> m_unreportedHostNames;
+        QTimer m_reportTimer;
+
+        static ReverseResolution *m_instance;
     };
 }
 
@@ -130,7 +130,7 @@ void Smtp::sendMail(const QString &from, const QString &to, const QString &subje
 {
     const Preferences *const pref = Preferences::instance();
     QTextCodec *latin1 = QTextCodec::codecForName("latin1");
-    m_message = "Date: " + getCurrentDateTime().toLatin1() + "\r\n"
+    QByteArray message = "Date: " + getCurrentDateTime().toLatin1() + "\r\n"
                 + encodeMimeHeader("From", from, latin1)
                 + encodeMimeHeader("Subject", subject, latin1)
                 + encodeMimeHeader("To", to, latin1)
@@ -143,7 +143,15 @@ void Smtp::sendMail(const QString &from, const QString &to, const QString &subje
     QByteArray b = crlfBody.replace("\n", "\r\n").toUtf8().toBase64();
     int ct = b.length();
     for (int i = 0; i < ct; i += 78)
-        m_message += b.mid(i, 78);
+        message += b.mid(i, 78);
+
+    if (m_socket->state() != QAbstractSocket::UnconnectedState) {
+        // The session is already open, the mail is sent after the current one
+        m_pendingMails.enqueue({from, to, message});
+        return;
+    }
+
+    m_message = message;
     m_from = from;
     m_rcpt = to;
     // Authentication
@@ -221,10 +229,7 @@ void Smtp::readyRead()
         case AuthSent:
         case Authenticated:
             if (code[0] == '2') {
-                qDebug() << "Sending <mail from>...";
-                m_socket->write("mail from:<" + m_from.toLatin1() + ">\r\n");
-                m_socket->flush();
-                m_state = Rcpt;
+                sendMailFrom();
             }
             else {
                 // Authentication failed!
@@ -266,7 +271,15 @@ void Smtp::readyRead()
             }
             break;
         case Quit:
-            if (code[0] == '2') {
+            if ((code[0] == '2') && !m_pendingMails.isEmpty()) {
+                // Reuse the session for the next mail
+                const Mail mail = m_pendingMails.dequeue();
+                m_message = mail.message;
+                m_from = mail.from;
+                m_rcpt = mail.rcpt;
+                sendMailFrom();
+            }
+            else if (code[0] == '2') {
                 m_socket->write("QUIT\r\n");
                 m_socket->flush();
                 // here, we just close.
@@ -501,6 +514,19 @@ void Smtp::authLogin()
     }
 }
 
+bool Smtp::canSendMail() const
+{
+    return (m_state != Close);
+}
+
+void Smtp::sendMailFrom()
+{
+    qDebug() << "Sending <mail from>...";
+    m_socket->write("mail from:<" + m_from.toLatin1() + ">\r\n");
+    m_socket->flush();
+    m_state = Rcpt;
+}
+
 void Smtp::logError(const QString &msg)
 {
     qDebug() << "Email Notification Error:" << msg;
@@ -538,6 +564,11 @@ void Smtp::error(QAbstractSocket::SocketError socketError)
 {
     // Getting a remote host closed error is apparently normal, even when successfully sending
     // an email
-    if (socketError != QAbstractSocket::RemoteHostClosedError)
+    if (socketError != QAbstractSocket::RemoteHostClosedError) {
         logError(m_socket->errorString());
+        m_state = Close;
+        // disconnected() isn't emitted when the connection couldn't be established
+        if (m_socket->state() == QAbstractSocket::UnconnectedState)
+            deleteLater();
+    }
 }
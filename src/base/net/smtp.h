@@ -38,6 +38,7 @@
 #include <QHash>
 #include <QMetaType>
 #include <QObject>
+#include <QQueue>
 #include <QString>
 
 #ifndef QT_NO_OPENSSL
@@ -57,7 +58,10 @@ namespace Net
         Smtp(QObject *parent = nullptr);
         ~Smtp();
 
+        // Mails sent while the connection is open are delivered in the same SMTP session
         void sendMail(const QString &from, const QString &to, const QString &subject, const QString &body);
+        // false once the session is being closed, a new Smtp object is needed then
+        bool canSendMail() const;
 
     private slots:
         void readyRead();
@@ -90,6 +94,13 @@ namespace Net
             AuthCramMD5
         };
 
+        struct Mail
+        {
+            QString from;
+            QString rcpt;
+            QByteArray message;
+        };
+
         QByteArray encodeMimeHeader(const QString &key, const QString &value, QTextCodec *latin1, const QByteArray &prefix = QByteArray());
         void ehlo();
         void helo();
@@ -99,10 +110,12 @@ namespace Net
         void authCramMD5(const QByteArray &challenge = QByteArray());
         void authPlain();
         void authLogin();
+        void sendMailFrom();
         void logError(const QString &msg);
         QString getCurrentDateTime() const;
 
         QByteArray m_message;
+        QQueue<Mail> m_pendingMails;
 #ifndef QT_NO_OPENSSL
         QSslSocket *m_socket;
 #else
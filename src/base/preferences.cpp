@@ -635,6 +635,18 @@ void Preferences::setWebUIHostHeaderValidationEnabled(const bool enabled)
     setValue("Preferences/WebUI/HostHeaderValidation", enabled);
 }
 
+int Preferences::getWebUiMaxSessions() const
+{
+    // A value below 1 can only come from an edited configuration, the default is used instead
+    const int count = value("Preferences/WebUI/MaxSessions", 256).toInt();
+    return (count > 0) ? count : 256;
+}
+
+void Preferences::setWebUiMaxSessions(const int count)
+{
+    setValue("Preferences/WebUI/MaxSessions", count);
+}
+
 bool Preferences::isWebUiHttpsEnabled() const
 {
     return value("Preferences/WebUI/HTTPS/Enabled", false).toBool();
@@ -776,6 +788,26 @@ void Preferences::setAutoRunProgram(const QString &program)
     setValue("AutoRun/program", program);
 }
 
+int Preferences::getAutoRunMaxProcesses() const
+{
+    return value("AutoRun/maxProcesses", 4).toInt();
+}
+
+void Preferences::setAutoRunMaxProcesses(const int count)
+{
+    setValue("AutoRun/maxProcesses", count);
+}
+
+bool Preferences::isAutoRunBatchModeEnabled() const
+{
+    return value("AutoRun/batchMode", false).toBool();
+}
+
+void Preferences::setAutoRunBatchModeEnabled(const bool enabled)
+{
+    setValue("AutoRun/batchMode", enabled);
+}
+
 bool Preferences::shutdownWhenDownloadsComplete() const
 {
     return value("Preferences/Downloads/AutoShutDownOnCompletion", false).toBool();
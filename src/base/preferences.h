@@ -199,6 +199,8 @@ public:
     void setWebUiCSRFProtectionEnabled(bool enabled);
     bool isWebUIHostHeaderValidationEnabled() const;
     void setWebUIHostHeaderValidationEnabled(bool enabled);
+    int getWebUiMaxSessions() const;
+    void setWebUiMaxSessions(int count);
 
     // HTTPS
     bool isWebUiHttpsEnabled() const;
@@ -233,6 +235,10 @@ public:
     void setAutoRunEnabled(bool enabled);
     QString getAutoRunProgram() const;
     void setAutoRunProgram(const QString &program);
+    int getAutoRunMaxProcesses() const;
+    void setAutoRunMaxProcesses(int count);
+    bool isAutoRunBatchModeEnabled() const;
+    void setAutoRunBatchModeEnabled(bool enabled);
     bool shutdownWhenDownloadsComplete() const;
     void setShutdownWhenDownloadsComplete(bool shutdown);
     bool suspendWhenDownloadsComplete() const;
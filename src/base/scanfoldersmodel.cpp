@@ -222,6 +222,7 @@ ScanFoldersModel::PathStatus ScanFoldersModel::addPath(const QString &watchPath,
     if (!m_fsWatcher) {
         m_fsWatcher = new FileSystemWatcher(this);
         connect(m_fsWatcher, &FileSystemWatcher::torrentsAdded, this, &ScanFoldersModel::addTorrentsToSession);
+        connect(m_fsWatcher, &FileSystemWatcher::magnetFilesAdded, this, &ScanFoldersModel::addMagnetsToSession);
     }
 
     beginInsertRows(QModelIndex(), rowCount(), rowCount());
@@ -349,7 +350,25 @@ void ScanFoldersModel::configure()
     }
 }
 
-void ScanFoldersModel::addTorrentsToSession(const QStringList &pathList)
+void ScanFoldersModel::addTorrentsToSession(const QHash<QString, BitTorrent::TorrentInfo> &torrents)
+{
+    // The torrents were already parsed by the watcher so we never read the files again
+    for (auto it = torrents.cbegin(); it != torrents.cend(); ++it) {
+        const QString &file = it.key();
+        qDebug("File %s added", qUtf8Printable(file));
+
+        BitTorrent::AddTorrentParams params;
+        if (downloadInWatchFolder(file))
+            params.savePath = QFileInfo(file).dir().path();
+        else if (!downloadInDefaultFolder(file))
+            params.savePath = downloadPathTorrentFolder(file);
+
+        BitTorrent::Session::instance()->addTorrent(it.value(), params);
+        Utils::Fs::forceRemove(file);
+    }
+}
+
+void ScanFoldersModel::addMagnetsToSession(const QStringList &pathList)
 {
     for (const QString &file : pathList) {
         qDebug("File %s added", qUtf8Printable(file));
@@ -360,29 +379,17 @@ void ScanFoldersModel::addTorrentsToSession(const QStringList &pathList)
         else if (!downloadInDefaultFolder(file))
             params.savePath = downloadPathTorrentFolder(file);
 
-        if (file.endsWith(".magnet")) {
-            QFile f(file);
-            if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                QTextStream str(&f);
-                while (!str.atEnd())
-                    BitTorrent::Session::instance()->addTorrent(str.readLine(), params);
+        QFile f(file);
+        if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QTextStream str(&f);
+            while (!str.atEnd())
+                BitTorrent::Session::instance()->addTorrent(str.readLine(), params);
 
-                f.close();
-                Utils::Fs::forceRemove(file);
-            }
-            else {
-                qDebug("Failed to open magnet file: %s", qUtf8Printable(f.errorString()));
-            }
+            f.close();
+            Utils::Fs::forceRemove(file);
         }
         else {
-            BitTorrent::TorrentInfo torrentInfo = BitTorrent::TorrentInfo::loadFromFile(file);
-            if (torrentInfo.isValid()) {
-                BitTorrent::Session::instance()->addTorrent(torrentInfo, params);
-                Utils::Fs::forceRemove(file);
-            }
-            else {
-                qDebug("Ignoring incomplete torrent file: %s", qUtf8Printable(file));
-            }
+            qDebug("Failed to open magnet file: %s", qUtf8Printable(f.errorString()));
         }
     }
 }
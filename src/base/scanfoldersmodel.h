@@ -30,8 +30,11 @@
 #define SCANFOLDERSMODEL_H
 
 #include <QAbstractListModel>
+#include <QHash>
 #include <QList>
 
+#include "base/bittorrent/torrentinfo.h"
+
 class QStringList;
 class FileSystemWatcher;
 
@@ -92,7 +95,8 @@ public slots:
     void configure();
 
 private slots:
-    void addTorrentsToSession(const QStringList &pathList);
+    void addTorrentsToSession(const QHash<QString, BitTorrent::TorrentInfo> &torrents);
+    void addMagnetsToSession(const QStringList &pathList);
 
 private:
     explicit ScanFoldersModel(QObject *parent = nullptr);
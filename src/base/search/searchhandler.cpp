@@ -36,6 +36,7 @@
 #include "../utils/foreignapps.h"
 #include "../utils/fs.h"
 #include "searchpluginmanager.h"
+#include "searchworker.h"
 
 namespace
 {
@@ -58,9 +59,58 @@ SearchHandler::SearchHandler(const QString &pattern, const QString &category, co
     , m_category {category}
     , m_usedPlugins {usedPlugins}
     , m_manager {manager}
-    , m_searchProcess {new QProcess {this}}
     , m_searchTimeout {new QTimer {this}}
 {
+    m_searchTimeout->setSingleShot(true);
+    connect(m_searchTimeout, &QTimer::timeout, this, &SearchHandler::cancelSearch);
+    m_searchTimeout->start(180000); // 3 min
+
+    SearchWorker *const worker = m_manager->searchWorker();
+    if (worker)
+        startWorkerSearch(worker);
+    else
+        startProcess();
+}
+
+SearchHandler::~SearchHandler()
+{
+    if (m_workerSearchActive && m_worker)
+        m_worker->cancelSearch(m_workerSearchId);
+}
+
+void SearchHandler::startWorkerSearch(SearchWorker *worker)
+{
+    m_worker = worker;
+    connect(worker, &SearchWorker::newSearchResults, this, [this](const int id, const QList<SearchResult> &results)
+    {
+        if (m_workerSearchActive && (id == m_workerSearchId))
+            addResults(results);
+    });
+    connect(worker, &SearchWorker::searchFinished, this, &SearchHandler::workerSearchFinished);
+
+    m_workerSearchId = worker->startSearch(m_pattern, m_category, m_usedPlugins);
+    m_workerSearchActive = true;
+}
+
+void SearchHandler::workerSearchFinished(const int id, const bool ok)
+{
+    if (!m_workerSearchActive || (id != m_workerSearchId))
+        return;
+
+    m_workerSearchActive = false;
+    m_searchTimeout->stop();
+
+    if (ok)
+        emit searchFinished(false);
+    else
+        emit searchFailed();
+}
+
+// One-shot mode: a new nova2.py process is launched for this search only
+void SearchHandler::startProcess()
+{
+    m_searchProcess = new QProcess {this};
+
     // Load environment variables (proxy)
     m_searchProcess->setEnvironment(QProcess::systemEnvironment());
 
@@ -84,22 +134,29 @@ SearchHandler::SearchHandler(const QString &pattern, const QString &category, co
     connect(m_searchProcess, static_cast<void (QProcess::*)(int)>(&QProcess::finished)
             , this, &SearchHandler::processFinished);
 
-    m_searchTimeout->setSingleShot(true);
-    connect(m_searchTimeout, &QTimer::timeout, this, &SearchHandler::cancelSearch);
-    m_searchTimeout->start(180000); // 3 min
-
     // deferred start allows clients to handle starting-related signals
     QTimer::singleShot(0, this, [this]() { m_searchProcess->start(QIODevice::ReadOnly); });
 }
 
 bool SearchHandler::isActive() const
 {
-    return (m_searchProcess->state() != QProcess::NotRunning);
+    return m_workerSearchActive
+            || (m_searchProcess && (m_searchProcess->state() != QProcess::NotRunning));
 }
 
 void SearchHandler::cancelSearch()
 {
-    if ((m_searchProcess->state() == QProcess::NotRunning) || m_searchCancelled)
+    if (m_workerSearchActive) {
+        m_workerSearchActive = false;
+        m_searchCancelled = true;
+        m_searchTimeout->stop();
+        if (m_worker)
+            m_worker->cancelSearch(m_workerSearchId);
+        emit searchFinished(true);
+        return;
+    }
+
+    if (!m_searchProcess || (m_searchProcess->state() == QProcess::NotRunning) || m_searchCancelled)
         return;
 
 #ifdef Q_OS_WIN
@@ -145,10 +202,26 @@ void SearchHandler::readSearchOutput()
             searchResultList << searchResult;
     }
 
-    if (!searchResultList.isEmpty()) {
-        m_results.append(searchResultList);
-        emit newSearchResults(searchResultList);
+    if (!searchResultList.isEmpty())
+        addResults(searchResultList);
+}
+
+void SearchHandler::addResults(const QList<SearchResult> &results)
+{
+    QVector<int> added;
+    QVector<int> updated;
+    m_results.add(results, added, updated);
+
+    if (!added.isEmpty()) {
+        QList<SearchResult> newResults;
+        newResults.reserve(added.size());
+        for (const int index : asConst(added))
+            newResults.append(m_results.at(index));
+        emit newSearchResults(newResults);
     }
+
+    if (!updated.isEmpty())
+        emit searchResultsUpdated(updated);
 }
 
 void SearchHandler::processFailed()
@@ -189,7 +262,7 @@ SearchPluginManager *SearchHandler::manager() const
     return m_manager;
 }
 
-QList<SearchResult> SearchHandler::results() const
+const SearchResultStore &SearchHandler::results() const
 {
     return m_results;
 }
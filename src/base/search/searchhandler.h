@@ -32,22 +32,15 @@
 #include <QByteArray>
 #include <QList>
 #include <QObject>
+#include <QPointer>
+
+#include "searchresultstore.h"
 
 class QProcess;
 class QTimer;
 
-struct SearchResult
-{
-    QString fileName;
-    QString fileUrl;
-    qlonglong fileSize;
-    qlonglong nbSeeders;
-    qlonglong nbLeechers;
-    QString siteUrl;
-    QString descrLink;
-};
-
 class SearchPluginManager;
+class SearchWorker;
 
 class SearchHandler : public QObject
 {
@@ -60,31 +53,46 @@ class SearchHandler : public QObject
                   , const QStringList &usedPlugins, SearchPluginManager *manager);
 
 public:
+    ~SearchHandler() override;
+
     bool isActive() const;
     QString pattern() const;
     SearchPluginManager *manager() const;
-    QList<SearchResult> results() const;
+    const SearchResultStore &results() const;
 
     void cancelSearch();
 
 signals:
     void searchFinished(bool cancelled = false);
     void searchFailed();
+    // Only unique results are reported, they follow the indexes of the store
     void newSearchResults(const QList<SearchResult> &results);
+    // Results merged with duplicates from other engines, by index in the store
+    void searchResultsUpdated(const QVector<int> &indexes);
 
 private:
+    void startProcess();
     void readSearchOutput();
     void processFailed();
     void processFinished(int exitcode);
     bool parseSearchResult(const QString &line, SearchResult &searchResult);
+    void addResults(const QList<SearchResult> &results);
+
+    void startWorkerSearch(SearchWorker *worker);
+    void workerSearchFinished(int id, bool ok);
 
     const QString m_pattern;
     const QString m_category;
     const QStringList m_usedPlugins;
     SearchPluginManager *m_manager;
-    QProcess *m_searchProcess;
+    // searches are run by the shared worker when it is available,
+    // by a dedicated process otherwise
+    QPointer<SearchWorker> m_worker;
+    int m_workerSearchId = 0;
+    bool m_workerSearchActive = false;
+    QProcess *m_searchProcess = nullptr;
     QTimer *m_searchTimeout;
     QByteArray m_searchResultLineTruncated;
     bool m_searchCancelled = false;
-    QList<SearchResult> m_results;
+    SearchResultStore m_results;
 };
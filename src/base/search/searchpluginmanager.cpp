@@ -52,6 +52,7 @@
 #include "base/utils/fs.h"
 #include "searchdownloadhandler.h"
 #include "searchhandler.h"
+#include "searchworker.h"
 
 namespace
 {
@@ -89,6 +90,11 @@ SearchPluginManager::SearchPluginManager()
     Q_ASSERT(!m_instance); // only one instance is allowed
     m_instance = this;
 
+    // the worker has to import the engines again
+    connect(this, &SearchPluginManager::pluginInstalled, this, &SearchPluginManager::reloadSearchWorker);
+    connect(this, &SearchPluginManager::pluginUninstalled, this, &SearchPluginManager::reloadSearchWorker);
+    connect(this, &SearchPluginManager::pluginUpdated, this, &SearchPluginManager::reloadSearchWorker);
+
     updateNova();
     update();
 }
@@ -315,6 +321,23 @@ SearchDownloadHandler *SearchPluginManager::downloadTorrent(const QString &siteU
     return new SearchDownloadHandler {siteUrl, url, this};
 }
 
+SearchWorker *SearchPluginManager::searchWorker()
+{
+    // nova2worker.py is only provided for Python 3
+    if (Utils::ForeignApps::pythonInfo().version.majorNumber() < 3)
+        return nullptr;
+
+    if (!m_searchWorker)
+        m_searchWorker = new SearchWorker {this};
+    return m_searchWorker->isAvailable() ? m_searchWorker : nullptr;
+}
+
+void SearchPluginManager::reloadSearchWorker()
+{
+    if (m_searchWorker)
+        m_searchWorker->reload();
+}
+
 SearchHandler *SearchPluginManager::startSearch(const QString &pattern, const QString &category, const QStringList &usedPlugins)
 {
     // No search pattern entered
@@ -433,10 +456,13 @@ void SearchPluginManager::updateNova()
     updateFile("novaprinter.py", true);
     updateFile("socks.py", false);
 
-    if (Utils::ForeignApps::pythonInfo().version.majorNumber() >= 3)
+    if (Utils::ForeignApps::pythonInfo().version.majorNumber() >= 3) {
+        updateFile("nova2worker.py", true);
         updateFile("sgmllib3.py", false);
-    else
+    }
+    else {
         updateFile("fix_encoding.py", false);
+    }
 }
 
 void SearchPluginManager::update()
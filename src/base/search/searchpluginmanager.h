@@ -51,6 +51,7 @@ struct PluginInfo
 
 class SearchDownloadHandler;
 class SearchHandler;
+class SearchWorker;
 
 class SearchPluginManager : public QObject
 {
@@ -79,6 +80,8 @@ public:
 
     SearchHandler *startSearch(const QString &pattern, const QString &category, const QStringList &usedPlugins);
     SearchDownloadHandler *downloadTorrent(const QString &siteUrl, const QString &url);
+    // nullptr if searches have to be run by dedicated processes (e.g. Python 2 is used)
+    SearchWorker *searchWorker();
 
     static PluginVersion getPluginVersion(const QString &filePath);
     static QString categoryFullName(const QString &categoryName);
@@ -103,6 +106,7 @@ private:
     void parseVersionInfo(const QByteArray &info);
     void installPlugin_impl(const QString &name, const QString &path);
     bool isUpdateNeeded(QString pluginName, PluginVersion newVersion) const;
+    void reloadSearchWorker();
 
     void versionInfoDownloaded(const QString &url, const QByteArray &data);
     void versionInfoDownloadFailed(const QString &url, const QString &reason);
@@ -116,4 +120,5 @@ private:
     const QString m_updateUrl;
 
     QHash<QString, PluginInfo*> m_plugins;
+    SearchWorker *m_searchWorker = nullptr;
 };
@@ -0,0 +1,209 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "searchresultstore.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <QRegularExpression>
+#include <QUrl>
+
+#include "base/bittorrent/infohash.h"
+#include "base/bittorrent/magneturi.h"
+#include "base/utils/string.h"
+
+namespace
+{
+    template <typename LessThan>
+    void insertSorted(QVector<int> &index, const int item, LessThan lessThan)
+    {
+        index.insert(std::upper_bound(index.begin(), index.end(), item, lessThan), item);
+    }
+
+    template <typename LessThan>
+    void removeSorted(QVector<int> &index, const int item, LessThan lessThan)
+    {
+        const auto iter = std::lower_bound(index.begin(), index.end(), item, lessThan);
+        if ((iter != index.end()) && (*iter == item))
+            index.erase(iter);
+    }
+}
+
+int SearchResultStore::size() const
+{
+    return m_results.size();
+}
+
+const SearchResult &SearchResultStore::at(const int index) const
+{
+    return m_results.at(index);
+}
+
+QList<SearchResult> SearchResultStore::results() const
+{
+    return m_results.toList();
+}
+
+void SearchResultStore::add(const QList<SearchResult> &results, QVector<int> &added, QVector<int> &updated)
+{
+    const auto nameLess = [this](const int left, const int right) { return nameLessThan(left, right); };
+    const auto sizeLess = [this](const int left, const int right) { return sizeLessThan(left, right); };
+    const auto seedsLess = [this](const int left, const int right) { return seedsLessThan(left, right); };
+
+    const int firstAddedIndex = m_results.size();
+    for (const SearchResult &result : results) {
+        const QString key = deduplicationKey(result);
+        const auto keyIter = m_keyIndex.constFind(key);
+        if (keyIter == m_keyIndex.cend()) {
+            const int index = m_results.size();
+            m_results.append(result);
+            m_keyIndex.insert(key, index);
+
+            insertSorted(m_byName, index, nameLess);
+            insertSorted(m_bySize, index, sizeLess);
+            insertSorted(m_bySeeds, index, seedsLess);
+            added.append(index);
+            continue;
+        }
+
+        // Engines report the same swarm, adding their counts would be wrong
+        const int index = keyIter.value();
+        SearchResult &existing = m_results[index];
+        const qlonglong nbSeeders = std::max(existing.nbSeeders, result.nbSeeders);
+        const qlonglong nbLeechers = std::max(existing.nbLeechers, result.nbLeechers);
+        const bool descrLinkMissing = existing.descrLink.isEmpty() && !result.descrLink.isEmpty();
+        if ((nbSeeders == existing.nbSeeders) && (nbLeechers == existing.nbLeechers) && !descrLinkMissing)
+            continue;
+
+        if (nbSeeders != existing.nbSeeders) {
+            removeSorted(m_bySeeds, index, seedsLess);
+            existing.nbSeeders = nbSeeders;
+            insertSorted(m_bySeeds, index, seedsLess);
+        }
+        existing.nbLeechers = nbLeechers;
+        if (descrLinkMissing)
+            existing.descrLink = result.descrLink;
+
+        if ((index < firstAddedIndex) && !updated.contains(index))
+            updated.append(index);
+    }
+}
+
+QVector<int> SearchResultStore::query(const SearchResultFilter &filter, const SortField sortField
+                                      , const Qt::SortOrder sortOrder) const
+{
+    QVector<int> insertionOrder;
+    const QVector<int> *order = &insertionOrder;
+    switch (sortField) {
+    case SortField::Name:
+        order = &m_byName;
+        break;
+    case SortField::Size:
+        order = &m_bySize;
+        break;
+    case SortField::Seeds:
+        order = &m_bySeeds;
+        break;
+    default:
+        insertionOrder.resize(m_results.size());
+        std::iota(insertionOrder.begin(), insertionOrder.end(), 0);
+        break;
+    }
+
+    const QStringList nameWords = filter.name.split(QRegularExpression("\\s+"), QString::SkipEmptyParts);
+
+    QVector<int> matched;
+    matched.reserve(order->size());
+    for (const int index : *order) {
+        if (acceptsResult(m_results[index], filter, nameWords))
+            matched.append(index);
+    }
+
+    if (sortOrder == Qt::DescendingOrder)
+        std::reverse(matched.begin(), matched.end());
+
+    return matched;
+}
+
+QString SearchResultStore::deduplicationKey(const SearchResult &result)
+{
+    if (result.fileUrl.startsWith(QLatin1String("magnet:"), Qt::CaseInsensitive)) {
+        const BitTorrent::MagnetUri magnetUri(result.fileUrl);
+        if (magnetUri.isValid())
+            return magnetUri.hash();
+    }
+
+    // QUrl lowercases the scheme and the host
+    return QUrl(result.fileUrl.trimmed()).adjusted(QUrl::RemoveFragment | QUrl::NormalizePathSegments
+                                                   | QUrl::StripTrailingSlash).toString();
+}
+
+bool SearchResultStore::acceptsResult(const SearchResult &result, const SearchResultFilter &filter
+                                      , const QStringList &nameWords)
+{
+    for (const QString &word : nameWords) {
+        if (!result.fileName.contains(word, Qt::CaseInsensitive))
+            return false;
+    }
+
+    // unknown values (-1) only fail the minimum checks
+    if (((filter.minSize > 0) && (result.fileSize < filter.minSize))
+        || ((filter.maxSize >= 0) && (result.fileSize > filter.maxSize))) {
+        return false;
+    }
+
+    if (((filter.minSeeds > 0) && (result.nbSeeders < filter.minSeeds))
+        || ((filter.maxSeeds >= 0) && (result.nbSeeders > filter.maxSeeds))) {
+        return false;
+    }
+
+    return true;
+}
+
+// Ties are broken by the order of arrival so every result has a single position
+bool SearchResultStore::nameLessThan(const int left, const int right) const
+{
+    const int result = Utils::String::naturalCompare(m_results[left].fileName, m_results[right].fileName, Qt::CaseInsensitive);
+    return (result != 0) ? (result < 0) : (left < right);
+}
+
+bool SearchResultStore::sizeLessThan(const int left, const int right) const
+{
+    const qlonglong leftSize = m_results[left].fileSize;
+    const qlonglong rightSize = m_results[right].fileSize;
+    return (leftSize != rightSize) ? (leftSize < rightSize) : (left < right);
+}
+
+bool SearchResultStore::seedsLessThan(const int left, const int right) const
+{
+    const qlonglong leftSeeds = m_results[left].nbSeeders;
+    const qlonglong rightSeeds = m_results[right].nbSeeders;
+    return (leftSeeds != rightSeeds) ? (leftSeeds < rightSeeds) : (left < right);
+}
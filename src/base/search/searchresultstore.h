@@ -0,0 +1,98 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct SearchResult
+{
+    QString fileName;
+    QString fileUrl;
+    qlonglong fileSize;
+    qlonglong nbSeeders;
+    qlonglong nbLeechers;
+    QString siteUrl;
+    QString descrLink;
+};
+
+struct SearchResultFilter
+{
+    // all the words must be contained in the name (case insensitive)
+    QString name;
+    qint64 minSize = 0;
+    qint64 maxSize = -1; // negative value to disable filtering
+    qint64 minSeeds = 0;
+    qint64 maxSeeds = -1; // negative value to disable filtering
+};
+
+// Results of a single search. Duplicates returned by several engines (same
+// info-hash or same torrent URL) are merged into a single result, which keeps
+// the highest seeds/leechers counts reported. Results keep the index they were
+// added at, indexes sorted by name, size and seeds are maintained as they arrive.
+class SearchResultStore
+{
+public:
+    enum class SortField
+    {
+        None, // order of arrival
+        Name,
+        Size,
+        Seeds
+    };
+
+    int size() const;
+    const SearchResult &at(int index) const;
+    QList<SearchResult> results() const;
+
+    // Returns the indexes of the new results and of the merged ones
+    void add(const QList<SearchResult> &results, QVector<int> &added, QVector<int> &updated);
+
+    // Returns the indexes of the results accepted by the filter in the requested order
+    QVector<int> query(const SearchResultFilter &filter, SortField sortField = SortField::None
+                       , Qt::SortOrder sortOrder = Qt::AscendingOrder) const;
+
+private:
+    static QString deduplicationKey(const SearchResult &result);
+    static bool acceptsResult(const SearchResult &result, const SearchResultFilter &filter, const QStringList &nameWords);
+
+    bool nameLessThan(int left, int right) const;
+    bool sizeLessThan(int left, int right) const;
+    bool seedsLessThan(int left, int right) const;
+
+    QVector<SearchResult> m_results;
+    QHash<QString, int> m_keyIndex;
+    QVector<int> m_byName;
+    QVector<int> m_bySize;
+    QVector<int> m_bySeeds;
+};
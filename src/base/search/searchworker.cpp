@@ -0,0 +1,320 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "searchworker.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+
+#include "base/global.h"
+#include "base/logger.h"
+#include "base/utils/foreignapps.h"
+#include "base/utils/fs.h"
+#include "searchpluginmanager.h"
+
+namespace
+{
+    // the worker isn't used anymore after failing this number of times in a row
+    const int MAX_FAILURES = 3;
+    const int IDLE_TIMEOUT = 10 * 60 * 1000; // msecs
+    // limits what a misbehaving engine can write to the log
+    const int MAX_ERROR_LINE_LENGTH = 512;
+    const int MAX_LOGGED_ERRORS = 100; // per worker process
+
+    SearchResult parseSearchResult(const QJsonObject &result)
+    {
+        SearchResult searchResult;
+        searchResult.fileUrl = result.value("link").toString().trimmed();
+        searchResult.fileName = result.value("name").toString().trimmed();
+        searchResult.fileSize = result.value("size").toString().toLongLong();
+        bool ok = false;
+        searchResult.nbSeeders = result.value("seeds").toString().toLongLong(&ok);
+        if (!ok || (searchResult.nbSeeders < 0))
+            searchResult.nbSeeders = -1;
+        searchResult.nbLeechers = result.value("leech").toString().toLongLong(&ok);
+        if (!ok || (searchResult.nbLeechers < 0))
+            searchResult.nbLeechers = -1;
+        searchResult.siteUrl = result.value("engine_url").toString().trimmed();
+        searchResult.descrLink = result.value("desc_link").toString().trimmed();
+
+        return searchResult;
+    }
+}
+
+SearchWorker::SearchWorker(QObject *parent)
+    : QObject {parent}
+    , m_process {new QProcess {this}}
+    , m_idleTimer {new QTimer {this}}
+{
+    // Load environment variables (proxy)
+    m_process->setProcessEnvironment(QProcessEnvironment::systemEnvironment());
+    m_process->setProgram(Utils::ForeignApps::pythonInfo().executableName);
+    m_process->setArguments({Utils::Fs::toNativePath(SearchPluginManager::engineLocation() + "/nova2worker.py")});
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 6, 0))
+    connect(m_process, &QProcess::errorOccurred, this, &SearchWorker::processFailed);
+#else
+    connect(m_process, static_cast<void (QProcess::*)(QProcess::ProcessError)>(&QProcess::error)
+            , this, &SearchWorker::processFailed);
+#endif
+    connect(m_process, &QProcess::started, this, &SearchWorker::processStarted);
+    connect(m_process, &QProcess::readyReadStandardOutput, this, &SearchWorker::readOutput);
+    connect(m_process, &QProcess::readyReadStandardError, this, &SearchWorker::readErrors);
+    connect(m_process, static_cast<void (QProcess::*)(int)>(&QProcess::finished)
+            , this, &SearchWorker::processFinished);
+
+    m_idleTimer->setSingleShot(true);
+    m_idleTimer->setInterval(IDLE_TIMEOUT);
+    connect(m_idleTimer, &QTimer::timeout, this, &SearchWorker::stop);
+}
+
+SearchWorker::~SearchWorker()
+{
+    m_process->disconnect(this);
+    if (m_process->state() != QProcess::NotRunning) {
+        // the worker exits as soon as its input is closed
+        m_process->closeWriteChannel();
+        if (!m_process->waitForFinished(1000))
+            m_process->kill();
+    }
+}
+
+bool SearchWorker::isAvailable() const
+{
+    return (m_failureCount < MAX_FAILURES);
+}
+
+int SearchWorker::startSearch(const QString &pattern, const QString &category, const QStringList &usedPlugins)
+{
+    const int id = ++m_lastSearchId;
+    m_activeSearches.insert(id);
+    m_idleTimer->stop();
+
+    sendRequest({
+        {"op", "search"},
+        {"id", id},
+        {"engines", usedPlugins.join(',')},
+        {"category", category},
+        {"query", pattern}
+    });
+
+    return id;
+}
+
+void SearchWorker::cancelSearch(const int id)
+{
+    if (!m_activeSearches.remove(id))
+        return;
+
+    // engines can't be interrupted, the worker just drops their results
+    if (m_process->state() != QProcess::NotRunning)
+        sendRequest({{"op", "cancel"}, {"id", id}});
+
+    checkIdle();
+}
+
+void SearchWorker::reload()
+{
+    m_reloadRequested = true;
+    checkIdle();
+}
+
+void SearchWorker::start()
+{
+    if ((m_process->state() != QProcess::NotRunning) || m_pendingRequests.isEmpty())
+        return;
+
+    m_output.clear();
+    m_errors.clear();
+    m_loggedErrorCount = 0;
+    m_process->start(QIODevice::ReadWrite);
+}
+
+void SearchWorker::stop()
+{
+    m_idleTimer->stop();
+    if ((m_process->state() == QProcess::NotRunning) || m_stopping)
+        return;
+
+    m_stopping = true;
+    m_pendingRequests.clear();
+    m_process->closeWriteChannel();
+}
+
+void SearchWorker::sendRequest(const QJsonObject &request)
+{
+    const QByteArray data = QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n';
+
+    if ((m_process->state() == QProcess::Running) && !m_stopping) {
+        m_process->write(data);
+        return;
+    }
+
+    // sent once the worker is (re)started, which is deferred
+    // so that the caller knows the search ID when a failure is reported
+    m_pendingRequests.append(data);
+    if ((m_process->state() == QProcess::NotRunning) && (m_pendingRequests.size() == 1))
+        QTimer::singleShot(0, this, &SearchWorker::start);
+}
+
+void SearchWorker::processStarted()
+{
+    for (const QByteArray &request : asConst(m_pendingRequests))
+        m_process->write(request);
+    m_pendingRequests.clear();
+}
+
+void SearchWorker::processFailed(const QProcess::ProcessError error)
+{
+    if (error != QProcess::FailedToStart)
+        return; // processFinished() takes care of the rest
+
+    // there is no point in retrying
+    m_failureCount = MAX_FAILURES;
+    LogMsg(tr("Couldn't start the search worker: %1").arg(m_process->errorString()), Log::WARNING);
+    failActiveSearches();
+}
+
+void SearchWorker::processFinished()
+{
+    if (m_stopping) {
+        m_stopping = false;
+    }
+    else {
+        ++m_failureCount;
+        LogMsg(tr("The search worker exited unexpectedly."), Log::WARNING);
+        failActiveSearches();
+    }
+
+    // searches started while it was stopping
+    start();
+}
+
+void SearchWorker::readOutput()
+{
+    m_output.append(m_process->readAllStandardOutput());
+
+    QHash<int, QList<SearchResult>> results;
+
+    int lineStart = 0;
+    int lineEnd = 0;
+    while ((lineEnd = m_output.indexOf('\n', lineStart)) >= 0) {
+        const QJsonDocument doc = QJsonDocument::fromJson(m_output.mid(lineStart, (lineEnd - lineStart)));
+        lineStart = lineEnd + 1;
+        if (doc.isObject())
+            handleMessage(doc.object(), results);
+    }
+    m_output.remove(0, lineStart);
+
+    for (auto i = results.cbegin(); i != results.cend(); ++i)
+        emit newSearchResults(i.key(), i.value());
+}
+
+void SearchWorker::readErrors()
+{
+    // the pipe is always drained, the errors are only logged up to the limit
+    m_errors.append(m_process->readAllStandardError());
+
+    int lineStart = 0;
+    int lineEnd = 0;
+    while ((lineEnd = m_errors.indexOf('\n', lineStart)) >= 0) {
+        logError(m_errors.mid(lineStart, (lineEnd - lineStart)));
+        lineStart = lineEnd + 1;
+    }
+    m_errors.remove(0, lineStart);
+
+    // don't buffer endless lines
+    if (m_errors.size() > MAX_ERROR_LINE_LENGTH) {
+        logError(m_errors);
+        m_errors.clear();
+    }
+}
+
+void SearchWorker::logError(const QByteArray &line)
+{
+    const QString message = QString::fromUtf8(line.left(MAX_ERROR_LINE_LENGTH)).trimmed();
+    if (message.isEmpty() || (m_loggedErrorCount > MAX_LOGGED_ERRORS))
+        return;
+
+    ++m_loggedErrorCount;
+    if (m_loggedErrorCount > MAX_LOGGED_ERRORS)
+        LogMsg(tr("Too many search engine errors, further ones are not logged."), Log::WARNING);
+    else
+        LogMsg(tr("Search engine error: %1").arg(message), Log::WARNING);
+}
+
+void SearchWorker::handleMessage(const QJsonObject &message, QHash<int, QList<SearchResult>> &results)
+{
+    const int id = message.value("id").toInt();
+    if (!m_activeSearches.contains(id))
+        return; // cancelled search or "ready" message
+
+    const QString type = message.value("type").toString();
+    if (type == QLatin1String("result")) {
+        results[id].append(parseSearchResult(message.value("result").toObject()));
+    }
+    else if (type == QLatin1String("finished")) {
+        const QList<SearchResult> searchResults = results.take(id);
+        if (!searchResults.isEmpty())
+            emit newSearchResults(id, searchResults);
+
+        const bool ok = message.value("ok").toBool();
+        if (ok)
+            m_failureCount = 0;
+
+        m_activeSearches.remove(id);
+        emit searchFinished(id, ok);
+        checkIdle();
+    }
+}
+
+void SearchWorker::failActiveSearches()
+{
+    const QSet<int> searches = m_activeSearches;
+    m_activeSearches.clear();
+    m_pendingRequests.clear();
+
+    for (const int id : searches)
+        emit searchFinished(id, false);
+}
+
+void SearchWorker::checkIdle()
+{
+    if (!m_activeSearches.isEmpty())
+        return;
+
+    if (m_reloadRequested) {
+        m_reloadRequested = false;
+        stop();
+    }
+    else if (m_process->state() != QProcess::NotRunning) {
+        m_idleTimer->start();
+    }
+}
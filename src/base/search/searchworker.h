@@ -0,0 +1,93 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QSet>
+
+#include "searchhandler.h"
+
+class QJsonObject;
+class QTimer;
+
+// Long-lived search process (nova2worker.py) which keeps the engines imported
+// and runs several searches at once. It is started on demand and stopped
+// when idle for a while.
+class SearchWorker : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(SearchWorker)
+
+public:
+    explicit SearchWorker(QObject *parent = nullptr);
+    ~SearchWorker() override;
+
+    // Searches are expected to fall back to the one-shot mode once it returns false
+    bool isAvailable() const;
+
+    int startSearch(const QString &pattern, const QString &category, const QStringList &usedPlugins);
+    void cancelSearch(int id);
+    // Makes the worker reload the engines once the running searches are done
+    void reload();
+
+signals:
+    void newSearchResults(int id, const QList<SearchResult> &results);
+    void searchFinished(int id, bool ok);
+
+private:
+    void start();
+    void stop();
+    void sendRequest(const QJsonObject &request);
+    void processStarted();
+    void processFailed(QProcess::ProcessError error);
+    void processFinished();
+    void readOutput();
+    void readErrors();
+    void logError(const QByteArray &line);
+    void handleMessage(const QJsonObject &message, QHash<int, QList<SearchResult>> &results);
+    void failActiveSearches();
+    void checkIdle();
+
+    QProcess *m_process;
+    QTimer *m_idleTimer;
+    QByteArray m_output;
+    QByteArray m_errors;
+    int m_loggedErrorCount = 0;
+    QList<QByteArray> m_pendingRequests;
+    QSet<int> m_activeSearches;
+    int m_lastSearchId = 0;
+    int m_failureCount = 0;
+    bool m_reloadRequested = false;
+    bool m_stopping = false;
+};
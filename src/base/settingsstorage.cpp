@@ -29,9 +29,21 @@
 
 #include "settingsstorage.h"
 
-#include <memory>
+#include <QtGlobal>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QHash>
+#include <QSaveFile>
 
 #include "global.h"
 #include "logger.h"
@@ -53,6 +65,7 @@ namespace
 
         QVariantHash read();
         bool write(const QVariantHash &data);
+        QString fileName() const;
 
     private:
         // we return actual file names used by QSettings because
@@ -65,6 +78,60 @@ namespace
         const QString m_name;
     };
 
+    // Compact binary representation of settings.
+    // A full snapshot is written only on compaction, regular saves
+    // append the changed keys to a journal which is replayed on load.
+    class JournaledSettings
+    {
+    public:
+        explicit JournaledSettings(const QString &basePath)
+            : m_snapshotPath(basePath + QLatin1String(".dat"))
+            , m_journalPath(basePath + QLatin1String(".journal"))
+        {
+        }
+
+        // returns false if there is no usable snapshot
+        bool read(QVariantHash &data, int &journalRecords, bool &journalDamaged) const;
+        bool append(const QVariantHash &changedValues, const QSet<QString> &removedKeys) const;
+        bool compact(const QVariantHash &data) const;
+        // whether the given file was modified after the binary storage was last written
+        bool isOutdatedBy(const QString &path) const;
+
+    private:
+        const QString m_snapshotPath;
+        const QString m_journalPath;
+    };
+
+    const quint32 BINARY_SETTINGS_MAGIC = 0x51425453; // "QBTS"
+    const quint32 BINARY_SETTINGS_VERSION = 1;
+    const QDataStream::Version BINARY_SETTINGS_STREAM_VERSION = QDataStream::Qt_5_5;
+    // the journal gets folded into the snapshot once it grows beyond this
+    const int MAX_JOURNAL_RECORDS = 1000;
+    // the recent changes get folded into the in-memory base once they grow beyond this
+    const int MAX_RECENT_CHANGES = 64;
+
+    enum JournalOperation : quint8
+    {
+        SetValue = 1,
+        RemoveValue = 2
+    };
+
+    // the journal records must survive a power loss once save() returned
+    bool syncToDisk(QFile &file)
+    {
+#ifdef Q_OS_WIN
+        return (::_commit(file.handle()) == 0);
+#else
+        return (::fsync(file.handle()) == 0);
+#endif
+    }
+
+    QString binaryStorageBasePath(const QString &name)
+    {
+        const QFileInfo iniFileInfo {TransactionalSettings(name).fileName()};
+        return iniFileInfo.absoluteDir().absoluteFilePath(name);
+    }
+
     QString mapKey(const QString &key)
     {
         static const QHash<QString, QString> keyMapping = {
@@ -153,10 +220,26 @@ namespace
 SettingsStorage *SettingsStorage::m_instance = nullptr;
 
 SettingsStorage::SettingsStorage()
-    : m_data {TransactionalSettings(QLatin1String("qBittorrent")).read()}
-    , m_dirty {false}
-    , m_lock {QReadWriteLock::Recursive}
+    : m_binaryBasePath {binaryStorageBasePath(QLatin1String("qBittorrent"))}
+    , m_journalRecords {0}
+    , m_exportPending {false}
 {
+    const TransactionalSettings iniSettings {QLatin1String("qBittorrent")};
+    const JournaledSettings binarySettings {m_binaryBasePath};
+
+    QVariantHash data;
+    bool compactionNeeded = false;
+    if (binarySettings.isOutdatedBy(iniSettings.fileName())
+        || !binarySettings.read(data, m_journalRecords, compactionNeeded)) {
+        // first run with the binary storage or the INI file was edited by the user
+        data = TransactionalSettings(QLatin1String("qBittorrent")).read();
+        compactionNeeded = true;
+    }
+    publish(data);
+
+    if (compactionNeeded && binarySettings.compact(data))
+        m_journalRecords = 0;
+
     m_timer.setSingleShot(true);
     m_timer.setInterval(5 * 1000);
     connect(&m_timer, &QTimer::timeout, this, &SettingsStorage::save);
@@ -165,6 +248,7 @@ SettingsStorage::SettingsStorage()
 SettingsStorage::~SettingsStorage()
 {
     save();
+    exportAll();
 }
 
 void SettingsStorage::initInstance()
@@ -186,46 +270,129 @@ SettingsStorage *SettingsStorage::instance()
 
 bool SettingsStorage::save()
 {
-    if (!m_dirty) return false; // Obtaining the lock is expensive, let's check early
-    QWriteLocker locker(&m_lock);
-    if (!m_dirty) return false; // something might have changed while we were getting the lock
+    QMutexLocker locker(&m_writeLock);
+    if (m_changedValues.isEmpty() && m_removedKeys.isEmpty()) return false;
 
-    TransactionalSettings settings(QLatin1String("qBittorrent"));
-    if (settings.write(m_data)) {
-        m_dirty = false;
-        return true;
+    const JournaledSettings binarySettings {m_binaryBasePath};
+    if (!binarySettings.append(m_changedValues, m_removedKeys)) {
+        m_timer.start();
+        return false;
     }
 
-    m_timer.start();
-    return false;
+    m_journalRecords += m_changedValues.size() + m_removedKeys.size();
+    m_changedValues.clear();
+    m_removedKeys.clear();
+
+    if ((m_journalRecords >= MAX_JOURNAL_RECORDS) && binarySettings.compact(snapshot()->toHash()))
+        m_journalRecords = 0;
+
+    return true;
 }
 
 QVariant SettingsStorage::loadValue(const QString &key, const QVariant &defaultValue) const
 {
-    QReadLocker locker(&m_lock);
-    return m_data.value(mapKey(key), defaultValue);
+    return snapshot()->value(mapKey(key), defaultValue);
 }
 
 void SettingsStorage::storeValue(const QString &key, const QVariant &value)
 {
     const QString realKey = mapKey(key);
-    QWriteLocker locker(&m_lock);
-    if (m_data.value(realKey) != value) {
-        m_dirty = true;
-        m_data.insert(realKey, value);
-        m_timer.start();
-    }
+    QMutexLocker locker(&m_writeLock);
+
+    const DataSnapshot current = snapshot();
+    if (current->value(realKey) == value) return;
+
+    auto *data = new Data(*current);
+    data->recentValues.insert(realKey, value);
+    data->recentlyRemovedKeys.remove(realKey);
+    publish(data);
+
+    m_changedValues.insert(realKey, value);
+    m_removedKeys.remove(realKey);
+    m_exportPending = true;
+    m_timer.start();
 }
 
 void SettingsStorage::removeValue(const QString &key)
 {
     const QString realKey = mapKey(key);
-    QWriteLocker locker(&m_lock);
-    if (m_data.contains(realKey)) {
-        m_dirty = true;
-        m_data.remove(realKey);
-        m_timer.start();
+    QMutexLocker locker(&m_writeLock);
+
+    const DataSnapshot current = snapshot();
+    if (!current->contains(realKey)) return;
+
+    auto *data = new Data(*current);
+    data->recentValues.remove(realKey);
+    data->recentlyRemovedKeys.insert(realKey);
+    publish(data);
+
+    m_changedValues.remove(realKey);
+    m_removedKeys.insert(realKey);
+    m_exportPending = true;
+    m_timer.start();
+}
+
+SettingsStorage::DataSnapshot SettingsStorage::snapshot() const
+{
+    return std::atomic_load(&m_data);
+}
+
+void SettingsStorage::publish(const QVariantHash &data)
+{
+    publish(new Data {std::make_shared<const QVariantHash>(data), {}, {}});
+}
+
+void SettingsStorage::publish(Data *data)
+{
+    if ((data->recentValues.size() + data->recentlyRemovedKeys.size()) > MAX_RECENT_CHANGES) {
+        data->base = std::make_shared<const QVariantHash>(data->toHash());
+        data->recentValues.clear();
+        data->recentlyRemovedKeys.clear();
     }
+
+    std::atomic_store(&m_data, DataSnapshot(data));
+}
+
+bool SettingsStorage::Data::contains(const QString &key) const
+{
+    return recentValues.contains(key)
+        || (!recentlyRemovedKeys.contains(key) && base->contains(key));
+}
+
+QVariant SettingsStorage::Data::value(const QString &key, const QVariant &defaultValue) const
+{
+    const auto iter = recentValues.constFind(key);
+    if (iter != recentValues.cend())
+        return iter.value();
+    if (recentlyRemovedKeys.contains(key))
+        return defaultValue;
+    return base->value(key, defaultValue);
+}
+
+QVariantHash SettingsStorage::Data::toHash() const
+{
+    QVariantHash result = *base;
+    for (const QString &key : recentlyRemovedKeys)
+        result.remove(key);
+    for (auto i = recentValues.cbegin(); i != recentValues.cend(); ++i)
+        result.insert(i.key(), i.value());
+    return result;
+}
+
+void SettingsStorage::exportAll()
+{
+    QMutexLocker locker(&m_writeLock);
+    if (!m_exportPending) return;
+
+    const QVariantHash data = snapshot()->toHash();
+    // Keep the human readable INI file in sync. It has to be written before
+    // the binary snapshot, otherwise it would be considered as edited by the user.
+    if (!TransactionalSettings(QLatin1String("qBittorrent")).write(data))
+        return;
+
+    m_exportPending = false;
+    if (JournaledSettings(m_binaryBasePath).compact(data))
+        m_journalRecords = 0;
 }
 
 QVariantHash TransactionalSettings::read()
@@ -277,6 +444,11 @@ bool TransactionalSettings::write(const QVariantHash &data)
     return QFile::rename(newPath, finalPath);
 }
 
+QString TransactionalSettings::fileName() const
+{
+    return Profile::instance().applicationSettings(m_name)->fileName();
+}
+
 QString TransactionalSettings::deserialize(const QString &name, QVariantHash &data)
 {
     SettingsPtr settings = Profile::instance().applicationSettings(name);
@@ -316,3 +488,129 @@ QString TransactionalSettings::serialize(const QString &name, const QVariantHash
     }
     return QString();
 }
+
+bool JournaledSettings::read(QVariantHash &data, int &journalRecords, bool &journalDamaged) const
+{
+    QFile snapshotFile {m_snapshotPath};
+    if (!snapshotFile.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream snapshotStream {&snapshotFile};
+    snapshotStream.setVersion(BINARY_SETTINGS_STREAM_VERSION);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QVariantHash snapshot;
+    snapshotStream >> magic >> version;
+    if ((magic != BINARY_SETTINGS_MAGIC) || (version != BINARY_SETTINGS_VERSION))
+        return false;
+    snapshotStream >> snapshot;
+    if (snapshotStream.status() != QDataStream::Ok)
+        return false;
+
+    journalRecords = 0;
+    journalDamaged = false;
+
+    QFile journalFile {m_journalPath};
+    if (journalFile.open(QIODevice::ReadOnly)) {
+        QDataStream journalStream {&journalFile};
+        journalStream.setVersion(BINARY_SETTINGS_STREAM_VERSION);
+
+        while (!journalStream.atEnd()) {
+            quint8 operation = 0;
+            QString key;
+            QVariant value;
+            journalStream >> operation >> key;
+            if (operation == SetValue)
+                journalStream >> value;
+
+            if ((journalStream.status() != QDataStream::Ok)
+                || ((operation != SetValue) && (operation != RemoveValue))) {
+                // Incomplete record left by an interrupted write.
+                // Everything before it is still valid.
+                Logger::instance()->addMessage(QObject::tr("Detected unclean program exit. Some of the latest settings changes could be lost.")
+                    , Log::WARNING);
+                journalDamaged = true;
+                break;
+            }
+
+            if (operation == SetValue)
+                snapshot.insert(key, value);
+            else
+                snapshot.remove(key);
+            ++journalRecords;
+        }
+    }
+
+    data = snapshot;
+    return true;
+}
+
+bool JournaledSettings::append(const QVariantHash &changedValues, const QSet<QString> &removedKeys) const
+{
+    QByteArray records;
+    {
+        QDataStream recordStream {&records, QIODevice::WriteOnly};
+        recordStream.setVersion(BINARY_SETTINGS_STREAM_VERSION);
+        for (auto i = changedValues.cbegin(); i != changedValues.cend(); ++i)
+            recordStream << static_cast<quint8>(SetValue) << i.key() << i.value();
+        for (const QString &key : removedKeys)
+            recordStream << static_cast<quint8>(RemoveValue) << key;
+    }
+
+    QFile journalFile {m_journalPath};
+    if (!journalFile.open(QIODevice::WriteOnly | QIODevice::Append)
+        || (journalFile.write(records) != records.size())
+        || !journalFile.flush()
+        || !syncToDisk(journalFile)) {
+        Logger::instance()->addMessage(QObject::tr("An error occurred while trying to write the configuration file. Error: %1")
+                .arg(journalFile.errorString())
+            , Log::CRITICAL);
+        return false;
+    }
+
+    return true;
+}
+
+bool JournaledSettings::compact(const QVariantHash &data) const
+{
+    QSaveFile snapshotFile {m_snapshotPath};
+    if (!snapshotFile.open(QIODevice::WriteOnly)) {
+        Logger::instance()->addMessage(QObject::tr("An access error occurred while trying to write the configuration file."), Log::CRITICAL);
+        return false;
+    }
+
+    QDataStream snapshotStream {&snapshotFile};
+    snapshotStream.setVersion(BINARY_SETTINGS_STREAM_VERSION);
+    snapshotStream << BINARY_SETTINGS_MAGIC << BINARY_SETTINGS_VERSION << data;
+
+    if ((snapshotStream.status() != QDataStream::Ok) || !snapshotFile.commit()) {
+        Logger::instance()->addMessage(QObject::tr("An error occurred while trying to write the configuration file. Error: %1")
+                .arg(snapshotFile.errorString())
+            , Log::CRITICAL);
+        return false;
+    }
+
+    // Replaying the journal over the new snapshot is harmless,
+    // so a failure to remove it at this point isn't a problem.
+    Utils::Fs::forceRemove(m_journalPath);
+    return true;
+}
+
+bool JournaledSettings::isOutdatedBy(const QString &path) const
+{
+    const QFileInfo otherFileInfo {path};
+    if (!otherFileInfo.exists())
+        return false;
+
+    const QFileInfo snapshotFileInfo {m_snapshotPath};
+    if (!snapshotFileInfo.exists())
+        return true;
+
+    QDateTime lastModified = snapshotFileInfo.lastModified();
+    const QFileInfo journalFileInfo {m_journalPath};
+    if (journalFileInfo.exists() && (journalFileInfo.lastModified() > lastModified))
+        lastModified = journalFileInfo.lastModified();
+
+    return (otherFileInfo.lastModified() > lastModified);
+}
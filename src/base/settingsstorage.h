@@ -30,8 +30,11 @@
 #ifndef SETTINGSSTORAGE_H
 #define SETTINGSSTORAGE_H
 
+#include <memory>
+
+#include <QMutex>
 #include <QObject>
-#include <QReadWriteLock>
+#include <QSet>
 #include <QTimer>
 #include <QVariantHash>
 
@@ -54,12 +57,40 @@ public slots:
     bool save();
 
 private:
+    // The values changed since the last consolidation are kept apart from
+    // the bulk of the settings, so a change only copies them
+    struct Data
+    {
+        std::shared_ptr<const QVariantHash> base;
+        QVariantHash recentValues;
+        QSet<QString> recentlyRemovedKeys;
+
+        bool contains(const QString &key) const;
+        QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+        QVariantHash toHash() const;
+    };
+
+    using DataSnapshot = std::shared_ptr<const Data>;
+
+    DataSnapshot snapshot() const;
+    void publish(const QVariantHash &data);
+    void publish(Data *data);
+    void exportAll();
+
     static SettingsStorage *m_instance;
 
-    QVariantHash m_data;
-    bool m_dirty;
+    // Readers never lock: they grab the current immutable snapshot,
+    // writers (serialized by m_writeLock) publish a modified copy.
+    DataSnapshot m_data;
+    QMutex m_writeLock;
+    const QString m_binaryBasePath;
+    // changes not yet appended to the journal
+    QVariantHash m_changedValues;
+    QSet<QString> m_removedKeys;
+    int m_journalRecords;
+    // whether the INI file needs to be rewritten on exit
+    bool m_exportPending;
     QTimer m_timer;
-    mutable QReadWriteLock m_lock;
 };
 
 #endif // SETTINGSSTORAGE_H
@@ -0,0 +1,369 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "timeseries.h"
+
+#include <algorithm>
+
+#include <QDataStream>
+
+namespace
+{
+    const quint32 SERIALIZATION_MAGIC = 0x71545331; // "qTS1"
+    const quint32 SERIALIZATION_VERSION = 1;
+
+    const qint64 PERIODS[TimeSeries::ResolutionsCount] = {0, 60, 3600};
+}
+
+TimeSeries::RingBuffer::RingBuffer(const int capacity, const int channelCount)
+    : m_capacity {std::max(capacity, 1)}
+    , m_channelCount {channelCount}
+    , m_timestamps(m_capacity)
+    , m_values(m_capacity * channelCount)
+{
+}
+
+int TimeSeries::RingBuffer::capacity() const
+{
+    return m_capacity;
+}
+
+int TimeSeries::RingBuffer::size() const
+{
+    return m_size;
+}
+
+void TimeSeries::RingBuffer::clear()
+{
+    m_first = 0;
+    m_size = 0;
+}
+
+void TimeSeries::RingBuffer::push(const qint64 timestamp, const quint64 *values)
+{
+    int pos;
+    if (m_size < m_capacity) {
+        pos = (m_first + m_size) % m_capacity;
+        ++m_size;
+    }
+    else {
+        // overwrite the oldest sample
+        pos = m_first;
+        m_first = (m_first + 1) % m_capacity;
+    }
+
+    m_timestamps[pos] = timestamp;
+    std::copy(values, (values + m_channelCount), (m_values.data() + (pos * m_channelCount)));
+}
+
+qint64 TimeSeries::RingBuffer::timestampAt(const int index) const
+{
+    return m_timestamps[(m_first + index) % m_capacity];
+}
+
+const quint64 *TimeSeries::RingBuffer::valuesAt(const int index) const
+{
+    return m_values.constData() + (((m_first + index) % m_capacity) * m_channelCount);
+}
+
+TimeSeries::TimeSeries(const int channelCount, const std::array<int, ResolutionsCount> &capacities)
+    : m_channelCount {channelCount}
+    , m_buffers {{RingBuffer(capacities[Raw], channelCount)
+                , RingBuffer(capacities[Minute], channelCount)
+                , RingBuffer(capacities[Hour], channelCount)}}
+{
+    for (int i = Minute; i < ResolutionsCount; ++i) {
+        m_accumulators[i].period = PERIODS[i];
+        m_accumulators[i].sums.fill(0, channelCount);
+    }
+}
+
+int TimeSeries::channelCount() const
+{
+    return m_channelCount;
+}
+
+bool TimeSeries::isEmpty() const
+{
+    return (m_buffers[Raw].size() == 0) && (m_buffers[Minute].size() == 0) && (m_buffers[Hour].size() == 0);
+}
+
+int TimeSeries::sampleInterval() const
+{
+    return m_sampleInterval;
+}
+
+void TimeSeries::setSampleInterval(const int msecs)
+{
+    m_sampleInterval = std::max(msecs, 0);
+}
+
+void TimeSeries::addSample(const qint64 timestamp, const quint64 *values)
+{
+    RingBuffer &raw = m_buffers[Raw];
+    if (raw.size() > 0) {
+        const qint64 previousTimestamp = raw.timestampAt(raw.size() - 1);
+        // ignore samples that would break the ordering (e.g. the clock went backwards)
+        if (timestamp < previousTimestamp)
+            return;
+
+        if (m_sampleInterval > 0) {
+            const qint64 missedCount = (((timestamp - previousTimestamp) * 1000) / m_sampleInterval) - 1;
+            if (missedCount > 0)
+                addZeroSamples(previousTimestamp, missedCount);
+        }
+    }
+
+    raw.push(timestamp, values);
+    for (int i = Minute; i < ResolutionsCount; ++i)
+        accumulate(static_cast<Resolution>(i), timestamp, values, 1);
+}
+
+void TimeSeries::addZeroSamples(const qint64 previousTimestamp, const qint64 count)
+{
+    // The missed samples are spread evenly after the previous one, and only
+    // the most recent ones are generated when the gap exceeds a buffer capacity
+    const auto missedTimestamp = [this, previousTimestamp](const qint64 index)
+    {
+        return previousTimestamp + ((index * m_sampleInterval) / 1000);
+    };
+
+    RingBuffer &raw = m_buffers[Raw];
+    const QVector<quint64> zeros(m_channelCount, 0);
+    for (qint64 k = std::max<qint64>(1, (count - raw.capacity() + 1)); k <= count; ++k)
+        raw.push(missedTimestamp(k), zeros.constData());
+
+    for (int i = Minute; i < ResolutionsCount; ++i) {
+        const qint64 period = m_accumulators[i].period;
+        const qint64 firstKeptBucket = (missedTimestamp(count) / period) - m_buffers[i].capacity();
+
+        qint64 k = 1;
+        if ((missedTimestamp(k) / period) < firstKeptBucket) {
+            // ceil() of the index of the first sample of that bucket
+            k = ((((firstKeptBucket * period) - previousTimestamp) * 1000) + m_sampleInterval - 1) / m_sampleInterval;
+        }
+
+        while (k <= count) {
+            const qint64 bucket = missedTimestamp(k) / period;
+            // last index that still falls into the bucket
+            const qint64 lastK = std::min(count
+                , ((((bucket + 1) * period - previousTimestamp) * 1000) - 1) / m_sampleInterval);
+            accumulate(static_cast<Resolution>(i), missedTimestamp(k), nullptr, static_cast<int>(lastK - k + 1));
+            k = lastK + 1;
+        }
+    }
+}
+
+void TimeSeries::accumulate(const Resolution resolution, const qint64 timestamp, const quint64 *values, const int count)
+{
+    Accumulator &acc = m_accumulators[resolution];
+    const qint64 bucket = timestamp / acc.period;
+    if (acc.bucket != bucket) {
+        if (acc.count > 0) {
+            QVector<quint64> averages(m_channelCount);
+            for (int j = 0; j < m_channelCount; ++j)
+                averages[j] = acc.sums[j] / acc.count;
+            m_buffers[resolution].push((acc.bucket * acc.period), averages.constData());
+        }
+
+        acc.bucket = bucket;
+        acc.count = 0;
+        acc.sums.fill(0);
+    }
+
+    if (values) {
+        for (int j = 0; j < m_channelCount; ++j)
+            acc.sums[j] += (values[j] * count);
+    }
+    acc.count += count;
+}
+
+TimeSeries::Resolution TimeSeries::selectResolution(const qint64 from) const
+{
+    Resolution oldest = Raw;
+    qint64 oldestTimestamp = -1;
+    for (int i = Raw; i < ResolutionsCount; ++i) {
+        const RingBuffer &buffer = m_buffers[i];
+        if (buffer.size() == 0)
+            continue;
+
+        const qint64 firstTimestamp = buffer.timestampAt(0);
+        if (firstTimestamp <= from)
+            return static_cast<Resolution>(i);
+
+        if ((oldestTimestamp < 0) || (firstTimestamp < oldestTimestamp)) {
+            oldest = static_cast<Resolution>(i);
+            oldestTimestamp = firstTimestamp;
+        }
+    }
+
+    return oldest;
+}
+
+QVector<TimeSeries::Point> TimeSeries::query(const qint64 from, const qint64 to, int step) const
+{
+    QVector<Point> result;
+    if (to < from)
+        return result;
+
+    step = std::max(step, 1);
+
+    const Resolution resolution = selectResolution(from);
+    const RingBuffer &buffer = m_buffers[resolution];
+
+    // skip the samples preceding the range
+    int first = 0;
+    int last = buffer.size();
+    while (first < last) {
+        const int middle = first + ((last - first) / 2);
+        if (buffer.timestampAt(middle) < from)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    result.reserve(static_cast<int>(std::min<qint64>(((to - from) / step) + 1, buffer.size() - first + 1)));
+
+    qint64 currentStep = -1;
+    int count = 0;
+    QVector<quint64> sums(m_channelCount, 0);
+
+    const auto flush = [&]()
+    {
+        if (count == 0)
+            return;
+
+        Point point {(from + (currentStep * step)), QVector<quint64>(m_channelCount)};
+        for (int j = 0; j < m_channelCount; ++j)
+            point.values[j] = sums[j] / count;
+        result.append(point);
+
+        count = 0;
+        sums.fill(0);
+    };
+
+    const auto add = [&](const qint64 timestamp, const quint64 *values)
+    {
+        const qint64 sampleStep = (timestamp - from) / step;
+        if (sampleStep != currentStep) {
+            flush();
+            currentStep = sampleStep;
+        }
+
+        for (int j = 0; j < m_channelCount; ++j)
+            sums[j] += values[j];
+        ++count;
+    };
+
+    for (int i = first; i < buffer.size(); ++i) {
+        const qint64 timestamp = buffer.timestampAt(i);
+        if (timestamp > to)
+            break;
+        add(timestamp, buffer.valuesAt(i));
+    }
+
+    // the current period is still being accumulated but it is worth showing
+    if (resolution != Raw) {
+        const Accumulator &acc = m_accumulators[resolution];
+        const qint64 timestamp = acc.bucket * acc.period;
+        if ((acc.count > 0) && (timestamp >= from) && (timestamp <= to)) {
+            QVector<quint64> averages(m_channelCount);
+            for (int j = 0; j < m_channelCount; ++j)
+                averages[j] = acc.sums[j] / acc.count;
+            add(timestamp, averages.constData());
+        }
+    }
+
+    flush();
+    return result;
+}
+
+QByteArray TimeSeries::serialize() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    stream << SERIALIZATION_MAGIC << SERIALIZATION_VERSION << static_cast<qint32>(m_channelCount);
+
+    // raw samples are too short-lived to be worth saving
+    for (int i = Minute; i < ResolutionsCount; ++i) {
+        const RingBuffer &buffer = m_buffers[i];
+        stream << static_cast<qint32>(buffer.size());
+        for (int j = 0; j < buffer.size(); ++j) {
+            stream << buffer.timestampAt(j);
+            const quint64 *values = buffer.valuesAt(j);
+            for (int k = 0; k < m_channelCount; ++k)
+                stream << values[k];
+        }
+    }
+
+    return data;
+}
+
+bool TimeSeries::deserialize(const QByteArray &data)
+{
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 channelCount = 0;
+    stream >> magic >> version >> channelCount;
+    if ((stream.status() != QDataStream::Ok) || (magic != SERIALIZATION_MAGIC)
+        || (version != SERIALIZATION_VERSION) || (channelCount != m_channelCount)) {
+        return false;
+    }
+
+    std::array<RingBuffer, ResolutionsCount> buffers = m_buffers;
+    QVector<quint64> values(m_channelCount);
+    for (int i = Minute; i < ResolutionsCount; ++i) {
+        RingBuffer &buffer = buffers[i];
+        buffer.clear();
+
+        qint32 size = 0;
+        stream >> size;
+        for (qint32 j = 0; j < size; ++j) {
+            qint64 timestamp = 0;
+            stream >> timestamp;
+            for (int k = 0; k < m_channelCount; ++k)
+                stream >> values[k];
+            if (stream.status() != QDataStream::Ok)
+                return false;
+
+            if ((buffer.size() == 0) || (timestamp >= buffer.timestampAt(buffer.size() - 1)))
+                buffer.push(timestamp, values.constData());
+        }
+    }
+
+    // keep the samples recorded since startup
+    buffers[Raw] = m_buffers[Raw];
+    m_buffers = buffers;
+    return true;
+}
@@ -0,0 +1,119 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <array>
+
+#include <QByteArray>
+#include <QVector>
+
+// Multi-resolution history of several values sampled together (e.g. transfer rates).
+// Every sample is kept in the "raw" ring buffer while the minute and hour ring
+// buffers receive the averages of the samples that fall into each period.
+// If the sample interval is set, the samples missing from the gaps between
+// two samples are taken as zero values.
+class TimeSeries
+{
+public:
+    enum Resolution
+    {
+        Raw,
+        Minute,
+        Hour,
+
+        ResolutionsCount
+    };
+
+    struct Point
+    {
+        qint64 timestamp; // seconds since epoch
+        QVector<quint64> values;
+    };
+
+    TimeSeries(int channelCount, const std::array<int, ResolutionsCount> &capacities);
+
+    int channelCount() const;
+    bool isEmpty() const;
+
+    // In milliseconds, 0 if the gaps between samples don't mean anything
+    int sampleInterval() const;
+    void setSampleInterval(int msecs);
+
+    void addSample(qint64 timestamp, const quint64 *values);
+
+    // Returns the averages of the samples within [from; to] grouped by "step" seconds.
+    // Points are taken from the finest resolution that still holds "from",
+    // steps without any sample are omitted.
+    QVector<Point> query(qint64 from, qint64 to, int step) const;
+
+    QByteArray serialize() const;
+    bool deserialize(const QByteArray &data);
+
+private:
+    class RingBuffer
+    {
+    public:
+        RingBuffer(int capacity, int channelCount);
+
+        int capacity() const;
+        int size() const;
+        void clear();
+        void push(qint64 timestamp, const quint64 *values);
+        qint64 timestampAt(int index) const;
+        const quint64 *valuesAt(int index) const;
+
+    private:
+        int m_capacity;
+        int m_channelCount;
+        int m_first = 0;
+        int m_size = 0;
+        QVector<qint64> m_timestamps;
+        QVector<quint64> m_values;
+    };
+
+    struct Accumulator
+    {
+        qint64 period = 0;
+        qint64 bucket = -1;
+        int count = 0;
+        QVector<quint64> sums;
+    };
+
+    Resolution selectResolution(qint64 from) const;
+    void addZeroSamples(qint64 previousTimestamp, qint64 count);
+    // Adds "count" samples with the same values, zeros if "values" is null
+    void accumulate(Resolution resolution, qint64 timestamp, const quint64 *values, int count);
+
+    int m_channelCount;
+    int m_sampleInterval = 0;
+    std::array<RingBuffer, ResolutionsCount> m_buffers;
+    // indexed by resolution, the one for raw samples is unused
+    std::array<Accumulator, ResolutionsCount> m_accumulators;
+};
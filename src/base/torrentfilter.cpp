@@ -138,6 +138,26 @@ bool TorrentFilter::setTag(const QString &tag)
     return false;
 }
 
+TorrentFilter::Type TorrentFilter::type() const
+{
+    return m_type;
+}
+
+QStringSet TorrentFilter::hashSet() const
+{
+    return m_hashSet;
+}
+
+QString TorrentFilter::category() const
+{
+    return m_category;
+}
+
+QString TorrentFilter::tag() const
+{
+    return m_tag;
+}
+
 bool TorrentFilter::match(const TorrentHandle *const torrent) const
 {
     if (!torrent) return false;
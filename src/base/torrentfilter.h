@@ -81,6 +81,11 @@ public:
     bool setCategory(const QString &category);
     bool setTag(const QString &tag);
 
+    Type type() const;
+    QStringSet hashSet() const;
+    QString category() const;
+    QString tag() const;
+
     bool match(const BitTorrent::TorrentHandle *torrent) const;
 
 private:
@@ -305,6 +305,34 @@ bool Utils::Fs::isRegularFile(const QString &path)
     return (st.st_mode & S_IFMT) == S_IFREG;
 }
 
+QString Utils::Fs::deviceId(const QString &path)
+{
+    if (path.isEmpty()) return {};
+
+    // Use the nearest existing folder, e.g. for the destination of a move
+    QFileInfo pathInfo(path);
+    while (!pathInfo.exists()) {
+        const QString parentPath = pathInfo.absolutePath();
+        if (parentPath == pathInfo.absoluteFilePath())
+            return {};
+        pathInfo.setFile(parentPath);
+    }
+
+#if defined(Q_OS_WIN)
+    return QStorageInfo(pathInfo.absoluteFilePath()).rootPath();
+#else
+    struct ::stat st;
+    if (::stat(pathInfo.absoluteFilePath().toUtf8().constData(), &st) != 0) {
+        const auto err = errno;
+        qDebug("Could not get file stats for path '%s'. Error: %s"
+               , qUtf8Printable(path), qUtf8Printable(strerror(err)));
+        return {};
+    }
+
+    return QString::number(st.st_dev);
+#endif
+}
+
 #if !defined Q_OS_HAIKU
 bool Utils::Fs::isNetworkFileSystem(const QString &path)
 {
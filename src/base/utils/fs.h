@@ -55,6 +55,9 @@ namespace Utils
         QString expandPath(const QString &path);
         QString expandPathAbs(const QString &path);
         bool isRegularFile(const QString &path);
+        // Returns an identifier of the file system device the path is on
+        // (the path itself doesn't need to exist yet)
+        QString deviceId(const QString &path);
 
         bool smartRemoveEmptyFolderTree(const QString &path);
         bool forceRemove(const QString &filePath);
@@ -41,6 +41,7 @@
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
 #include "base/bittorrent/torrentinfo.h"
+#include "base/diskspacemonitor.h"
 #include "base/global.h"
 #include "base/net/downloadhandler.h"
 #include "base/net/downloadmanager.h"
@@ -116,6 +117,11 @@ AddNewTorrentDialog::AddNewTorrentDialog(const BitTorrent::AddTorrentParams &inP
     m_ui->comboTTM->blockSignals(false);
     populateSavePathComboBox();
     connect(m_ui->savePath, &FileSystemPathEdit::selectedPathChanged, this, &AddNewTorrentDialog::onSavePathChanged);
+    connect(DiskSpaceMonitor::instance(), &DiskSpaceMonitor::freeSpaceChanged, this, [this](const QString &path)
+    {
+        if (path == Utils::Fs::expandPathAbs(m_diskSpacePath))
+            updateDiskSpaceLabel();
+    });
 
     const bool rememberLastSavePath = settings()->loadValue(KEY_REMEMBERLASTSAVEPATH, false).toBool();
     m_ui->checkBoxRememberLastSavePath->setChecked(rememberLastSavePath);
@@ -163,6 +169,7 @@ AddNewTorrentDialog::AddNewTorrentDialog(const BitTorrent::AddTorrentParams &inP
 AddNewTorrentDialog::~AddNewTorrentDialog()
 {
     saveState();
+    DiskSpaceMonitor::instance()->unwatchPath(m_diskSpacePath);
 
     delete m_contentDelegate;
     delete m_ui;
@@ -442,10 +449,17 @@ void AddNewTorrentDialog::updateDiskSpaceLabel()
         }
     }
 
+    // The free space is shown from the cache and updated once known
+    const QString savePath = m_ui->savePath->selectedPath();
+    if (savePath != m_diskSpacePath) {
+        DiskSpaceMonitor::instance()->unwatchPath(m_diskSpacePath);
+        m_diskSpacePath = savePath;
+        DiskSpaceMonitor::instance()->watchPath(m_diskSpacePath);
+    }
+
     QString sizeString = torrentSize ? Utils::Misc::friendlyUnit(torrentSize) : QString(tr("Not Available", "This size is unavailable."));
     sizeString += " (";
-    sizeString += tr("Free space on disk: %1").arg(Utils::Misc::friendlyUnit(Utils::Fs::freeDiskSpaceOnPath(
-                                                                   m_ui->savePath->selectedPath())));
+    sizeString += tr("Free space on disk: %1").arg(Utils::Misc::friendlyUnit(DiskSpaceMonitor::instance()->freeSpace(m_diskSpacePath)));
     sizeString += ')';
     m_ui->labelSize->setText(sizeString);
 }
@@ -113,6 +113,8 @@ private:
     BitTorrent::TorrentInfo m_torrentInfo;
     QByteArray m_headerState;
     int m_oldIndex;
+    // The save path whose free disk space is shown
+    QString m_diskSpacePath;
     QScopedPointer<TorrentFileGuard> m_torrentGuard;
     BitTorrent::AddTorrentParams m_torrentParams;
 };
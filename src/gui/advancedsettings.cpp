@@ -62,6 +62,10 @@ enum AdvSettingsRows
     SAVE_RESUME_DATA_INTERVAL,
     CONFIRM_RECHECK_TORRENT,
     RECHECK_COMPLETED,
+    STORAGE_JOBS_PER_DEVICE,
+    DISK_SPACE_RESERVE,
+    AUTORUN_MAX_PROCESSES,
+    AUTORUN_BATCH_MODE,
 #if defined(Q_OS_WIN) || defined(Q_OS_MAC)
     UPDATE_CHECK,
 #endif
@@ -176,6 +180,12 @@ void AdvancedSettings::saveAdvancedSettings()
     session->setMultiConnectionsPerIpEnabled(checkBoxMultiConnectionsPerIp.isChecked());
     // Recheck torrents on completion
     pref->recheckTorrentsOnCompletion(checkBoxRecheckCompleted.isChecked());
+    // Concurrent checks and moves
+    session->setMaxActiveStorageJobsPerDevice(spinBoxStorageJobsPerDevice.value());
+    session->setDiskSpaceReserve(spinBoxDiskSpaceReserve.value());
+    // External program
+    pref->setAutoRunMaxProcesses(spinBoxAutoRunMaxProcesses.value());
+    pref->setAutoRunBatchModeEnabled(checkBoxAutoRunBatchMode.isChecked());
     // Transfer list refresh interval
     session->setRefreshInterval(spinBoxListRefresh.value());
     // Peer resolution
@@ -408,6 +418,25 @@ void AdvancedSettings::loadAdvancedSettings()
     // Recheck completed torrents
     checkBoxRecheckCompleted.setChecked(pref->recheckTorrentsOnCompletion());
     addRow(RECHECK_COMPLETED, tr("Recheck torrents on completion"), &checkBoxRecheckCompleted);
+    // Concurrent checks and moves
+    spinBoxStorageJobsPerDevice.setMinimum(1);
+    spinBoxStorageJobsPerDevice.setMaximum(64);
+    spinBoxStorageJobsPerDevice.setValue(session->maxActiveStorageJobsPerDevice());
+    addRow(STORAGE_JOBS_PER_DEVICE, tr("Maximum concurrent checks and moves per disk"), &spinBoxStorageJobsPerDevice);
+    // Free disk space reserve
+    spinBoxDiskSpaceReserve.setMinimum(0);
+    spinBoxDiskSpaceReserve.setMaximum(1024 * 1024);
+    spinBoxDiskSpaceReserve.setValue(session->diskSpaceReserve());
+    spinBoxDiskSpaceReserve.setSuffix(tr(" MiB"));
+    spinBoxDiskSpaceReserve.setSpecialValueText(tr("Disabled"));
+    addRow(DISK_SPACE_RESERVE, tr("Pause downloads when free disk space is below"), &spinBoxDiskSpaceReserve);
+    // External program
+    spinBoxAutoRunMaxProcesses.setMinimum(1);
+    spinBoxAutoRunMaxProcesses.setMaximum(64);
+    spinBoxAutoRunMaxProcesses.setValue(pref->getAutoRunMaxProcesses());
+    addRow(AUTORUN_MAX_PROCESSES, tr("Maximum concurrent external programs"), &spinBoxAutoRunMaxProcesses);
+    checkBoxAutoRunBatchMode.setChecked(pref->isAutoRunBatchModeEnabled());
+    addRow(AUTORUN_BATCH_MODE, tr("Run external program once for torrents finished together (list sent as JSON to its input)"), &checkBoxAutoRunBatchMode);
     // Transfer list refresh interval
     spinBoxListRefresh.setMinimum(30);
     spinBoxListRefresh.setMaximum(99999);
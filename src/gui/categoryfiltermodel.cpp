@@ -30,6 +30,7 @@
 
 #include <QHash>
 #include <QIcon>
+#include <QSet>
 
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
@@ -180,10 +181,10 @@ CategoryFilterModel::CategoryFilterModel(QObject *parent)
 
     connect(session, &Session::categoryAdded, this, &CategoryFilterModel::categoryAdded);
     connect(session, &Session::categoryRemoved, this, &CategoryFilterModel::categoryRemoved);
-    connect(session, &Session::torrentCategoryChanged, this, &CategoryFilterModel::torrentCategoryChanged);
+    connect(session, &Session::torrentsCategoryChanged, this, &CategoryFilterModel::torrentsCategoryChanged);
     connect(session, &Session::subcategoriesSupportChanged, this, &CategoryFilterModel::subcategoriesSupportChanged);
     connect(session, &Session::torrentAdded, this, &CategoryFilterModel::torrentAdded);
-    connect(session, &Session::torrentAboutToBeRemoved, this, &CategoryFilterModel::torrentAboutToBeRemoved);
+    connect(session, &Session::torrentsAboutToBeRemoved, this, &CategoryFilterModel::torrentsAboutToBeRemoved);
 
     populate();
 }
@@ -339,37 +340,41 @@ void CategoryFilterModel::torrentAdded(BitTorrent::TorrentHandle *const torrent)
     m_rootItem->childAt(0)->increaseTorrentsCount();
 }
 
-void CategoryFilterModel::torrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent)
+void CategoryFilterModel::torrentsAboutToBeRemoved(const QVector<BitTorrent::TorrentHandle *> &torrents)
 {
-    CategoryModelItem *item = findItem(torrent->category());
-    Q_ASSERT(item);
+    for (BitTorrent::TorrentHandle *const torrent : torrents) {
+        CategoryModelItem *item = findItem(torrent->category());
+        Q_ASSERT(item);
 
-    item->decreaseTorrentsCount();
-    m_rootItem->childAt(0)->decreaseTorrentsCount();
+        item->decreaseTorrentsCount();
+        m_rootItem->childAt(0)->decreaseTorrentsCount();
+    }
 }
 
-void CategoryFilterModel::torrentCategoryChanged(BitTorrent::TorrentHandle *const torrent, const QString &oldCategory)
+void CategoryFilterModel::torrentsCategoryChanged(const QVector<BitTorrent::TorrentHandle *> &torrents, const QStringList &oldCategories)
 {
-    QModelIndex i;
-
-    auto item = findItem(oldCategory);
-    Q_ASSERT(item);
-
-    item->decreaseTorrentsCount();
-    i = index(item);
-    while (i.isValid()) {
-        emit dataChanged(i, i);
-        i = parent(i);
+    QSet<CategoryModelItem *> changedItems;
+    for (int i = 0; i < torrents.size(); ++i) {
+        CategoryModelItem *oldItem = findItem(oldCategories[i]);
+        Q_ASSERT(oldItem);
+        oldItem->decreaseTorrentsCount();
+        changedItems.insert(oldItem);
+
+        CategoryModelItem *newItem = findItem(torrents[i]->category());
+        Q_ASSERT(newItem);
+        newItem->increaseTorrentsCount();
+        changedItems.insert(newItem);
     }
 
-    item = findItem(torrent->category());
-    Q_ASSERT(item);
-
-    item->increaseTorrentsCount();
-    i = index(item);
-    while (i.isValid()) {
-        emit dataChanged(i, i);
-        i = parent(i);
+    // each item and its parents are notified once for the whole batch
+    QSet<CategoryModelItem *> notifiedItems;
+    for (CategoryModelItem *item : asConst(changedItems)) {
+        for (; item && !notifiedItems.contains(item); item = item->parent()) {
+            notifiedItems.insert(item);
+            const QModelIndex i = index(item);
+            if (i.isValid())
+                emit dataChanged(i, i);
+        }
     }
 }
 
@@ -385,45 +390,33 @@ void CategoryFilterModel::populate()
     m_rootItem->clear();
 
     auto session = BitTorrent::Session::instance();
-    auto torrents = session->torrents();
+    const BitTorrent::TorrentIndex &torrentIndex = session->torrentIndex();
     m_isSubcategoriesEnabled = session->isSubcategoriesEnabled();
 
     const QString UID_ALL;
     const QString UID_UNCATEGORIZED(QChar(1));
 
     // All torrents
-    m_rootItem->addChild(UID_ALL, new CategoryModelItem(nullptr, tr("All"), torrents.count()));
+    m_rootItem->addChild(UID_ALL, new CategoryModelItem(nullptr, tr("All"), torrentIndex.torrentsCount()));
 
     // Uncategorized torrents
-    using Torrent = BitTorrent::TorrentHandle;
     m_rootItem->addChild(
                 UID_UNCATEGORIZED
-                , new CategoryModelItem(
-                    nullptr, tr("Uncategorized")
-                    , std::count_if(torrents.begin(), torrents.end()
-                                    , [](Torrent *torrent) { return torrent->category().isEmpty(); })));
+                , new CategoryModelItem(nullptr, tr("Uncategorized"), torrentIndex.categoryTorrentsCount("")));
 
-    using Torrent = BitTorrent::TorrentHandle;
     for (auto i = session->categories().cbegin(); i != session->categories().cend(); ++i) {
         const QString &category = i.key();
         if (m_isSubcategoriesEnabled) {
             CategoryModelItem *parent = m_rootItem;
             for (const QString &subcat : asConst(session->expandCategory(category))) {
                 const QString subcatName = relName(subcat);
-                if (!parent->hasChild(subcatName)) {
-                    new CategoryModelItem(
-                                parent, subcatName
-                                , std::count_if(torrents.begin(), torrents.end()
-                                                , [subcat](Torrent *torrent) { return torrent->category() == subcat; }));
-                }
+                if (!parent->hasChild(subcatName))
+                    new CategoryModelItem(parent, subcatName, torrentIndex.categoryTorrentsCount(subcat));
                 parent = parent->child(subcatName);
             }
         }
         else {
-            new CategoryModelItem(
-                        m_rootItem, category
-                        , std::count_if(torrents.begin(), torrents.end()
-                                        , [category](Torrent *torrent) { return torrent->belongsToCategory(category); }));
+            new CategoryModelItem(m_rootItem, category, torrentIndex.categoryTorrentsCount(category));
         }
     }
 }
@@ -31,6 +31,9 @@
 
 #include <QAbstractItemModel>
 #include <QModelIndex>
+#include <QVector>
+
+class QStringList;
 
 namespace BitTorrent
 {
@@ -64,8 +67,8 @@ private slots:
     void categoryAdded(const QString &categoryName);
     void categoryRemoved(const QString &categoryName);
     void torrentAdded(BitTorrent::TorrentHandle *const torrent);
-    void torrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent);
-    void torrentCategoryChanged(BitTorrent::TorrentHandle *const torrent, const QString &oldCategory);
+    void torrentsAboutToBeRemoved(const QVector<BitTorrent::TorrentHandle *> &torrents);
+    void torrentsCategoryChanged(const QVector<BitTorrent::TorrentHandle *> &torrents, const QStringList &oldCategories);
     void subcategoriesSupportChanged();
 
 private:
@@ -0,0 +1,369 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "peerlistmodel.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "base/bittorrent/peerinfo.h"
+#include "base/bittorrent/torrenthandle.h"
+#include "base/bittorrent/torrentinfo.h"
+#include "base/net/geoipmanager.h"
+#include "guiiconprovider.h"
+#include "peerlistdelegate.h"
+
+namespace
+{
+    QString peerEndpoint(const QString &ip, const ushort port)
+    {
+        if (ip.contains(QLatin1Char(':'))) // IPv6
+            return QString::fromLatin1("[%1]:%2").arg(ip).arg(port);
+        return QString::fromLatin1("%1:%2").arg(ip).arg(port);
+    }
+}
+
+PeerListModel::PeerListModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_resolveCountries(false)
+{
+}
+
+int PeerListModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return m_rows.size();
+}
+
+int PeerListModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return PeerListDelegate::COL_COUNT;
+}
+
+QVariant PeerListModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal)
+        return QVariant();
+
+    if (role == Qt::DisplayRole) {
+        switch (section) {
+        case PeerListDelegate::COUNTRY: return tr("Country"); // Country flag column
+        case PeerListDelegate::IP: return tr("IP");
+        case PeerListDelegate::PORT: return tr("Port");
+        case PeerListDelegate::FLAGS: return tr("Flags");
+        case PeerListDelegate::CONNECTION: return tr("Connection");
+        case PeerListDelegate::CLIENT: return tr("Client", "i.e.: Client application");
+        case PeerListDelegate::PROGRESS: return tr("Progress", "i.e: % downloaded");
+        case PeerListDelegate::DOWN_SPEED: return tr("Down Speed", "i.e: Download speed");
+        case PeerListDelegate::UP_SPEED: return tr("Up Speed", "i.e: Upload speed");
+        case PeerListDelegate::TOT_DOWN: return tr("Downloaded", "i.e: total data downloaded");
+        case PeerListDelegate::TOT_UP: return tr("Uploaded", "i.e: total data uploaded");
+        case PeerListDelegate::RELEVANCE: return tr("Relevance", "i.e: How relevant this peer is to us. How many pieces it has that we don't.");
+        case PeerListDelegate::DOWNLOADING_PIECE: return tr("Files", "i.e. files that are being downloaded right now");
+        default:
+            return QVariant();
+        }
+    }
+
+    if (role == Qt::TextAlignmentRole) {
+        switch (section) {
+        case PeerListDelegate::PORT:
+        case PeerListDelegate::PROGRESS:
+        case PeerListDelegate::DOWN_SPEED:
+        case PeerListDelegate::UP_SPEED:
+        case PeerListDelegate::TOT_DOWN:
+        case PeerListDelegate::TOT_UP:
+        case PeerListDelegate::RELEVANCE:
+            return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+        default:
+            return QAbstractTableModel::headerData(section, orientation, role);
+        }
+    }
+
+    return QVariant();
+}
+
+QVariant PeerListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (index.row() >= m_rows.size()))
+        return QVariant();
+
+    const PeerRow &peer = m_rows[index.row()];
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        switch (index.column()) {
+        case PeerListDelegate::IP: return (peer.hostName.isEmpty() ? peer.ip : peer.hostName);
+        case PeerListDelegate::PORT: return peer.port;
+        case PeerListDelegate::CONNECTION: return peer.connection;
+        case PeerListDelegate::FLAGS: return peer.flags;
+        case PeerListDelegate::CLIENT: return peer.client;
+        case PeerListDelegate::PROGRESS: return peer.progress;
+        case PeerListDelegate::DOWN_SPEED: return peer.downSpeed;
+        case PeerListDelegate::UP_SPEED: return peer.upSpeed;
+        case PeerListDelegate::TOT_DOWN: return peer.totalDownload;
+        case PeerListDelegate::TOT_UP: return peer.totalUpload;
+        case PeerListDelegate::RELEVANCE: return peer.relevance;
+        case PeerListDelegate::DOWNLOADING_PIECE: return peer.downloadingFiles.join(QLatin1Char(';'));
+        case PeerListDelegate::IP_HIDDEN: return peer.ip;
+        default:
+            return QVariant();
+        }
+    case Qt::ToolTipRole:
+        switch (index.column()) {
+        case PeerListDelegate::COUNTRY:
+            return (peer.countryFlag.isNull() ? QVariant() : Net::GeoIPManager::CountryName(peer.country));
+        case PeerListDelegate::IP: return peer.ip;
+        case PeerListDelegate::FLAGS: return peer.flagsDescription;
+        case PeerListDelegate::DOWNLOADING_PIECE: return peer.downloadingFiles.join(QLatin1Char('\n'));
+        default:
+            return QVariant();
+        }
+    case Qt::DecorationRole:
+        if ((index.column() == PeerListDelegate::COUNTRY) && !peer.countryFlag.isNull())
+            return peer.countryFlag;
+        return QVariant();
+    default:
+        return QVariant();
+    }
+}
+
+bool PeerListModel::isCountryResolutionEnabled() const
+{
+    return m_resolveCountries;
+}
+
+void PeerListModel::setCountryResolutionEnabled(const bool enabled)
+{
+    if (m_resolveCountries == enabled) return;
+
+    m_resolveCountries = enabled;
+    if (m_resolveCountries) return; // flags are filled in by the next update
+
+    for (PeerRow &peer : m_rows) {
+        peer.country.clear();
+        peer.countryFlag = QIcon();
+    }
+    if (!m_rows.isEmpty())
+        emit dataChanged(index(0, PeerListDelegate::COUNTRY), index(m_rows.size() - 1, PeerListDelegate::COUNTRY));
+}
+
+QStringList PeerListModel::update(const BitTorrent::TorrentHandle *torrent)
+{
+    QVector<PeerRow> newRows;
+    QVector<bool> seen(m_rows.size(), false);
+
+    const QList<BitTorrent::PeerInfo> peers = torrent->peers();
+    for (const BitTorrent::PeerInfo &peer : peers) {
+        const BitTorrent::PeerAddress addr = peer.address();
+        if (addr.ip.isNull()) continue;
+
+        const QString endpoint = peerEndpoint(addr.ip.toString(), addr.port);
+        const int row = m_rowIndex.value(endpoint, -1);
+        if (row < 0) {
+            // A peer may be reported twice while libtorrent replaces its connection
+            if (std::none_of(newRows.cbegin(), newRows.cend()
+                             , [&endpoint](const PeerRow &newRow) { return newRow.endpoint == endpoint; }))
+                newRows.append(makeRow(torrent, peer, nullptr));
+        }
+        else if (!seen[row]) {
+            seen[row] = true;
+            updateRow(row, makeRow(torrent, peer, &m_rows[row]));
+        }
+    }
+
+    // Delete peers that are gone
+    QVector<int> goneRows;
+    for (int row = 0; row < seen.size(); ++row) {
+        if (!seen[row])
+            goneRows.append(row);
+    }
+    if (!goneRows.isEmpty())
+        removePeerRows(goneRows);
+
+    // Append new peers at once
+    QStringList addedIPs;
+    if (!newRows.isEmpty()) {
+        const int first = m_rows.size();
+        beginInsertRows(QModelIndex(), first, (first + newRows.size() - 1));
+        m_rows.reserve(first + newRows.size());
+        for (PeerRow &newRow : newRows) {
+            m_rowIndex.insert(newRow.endpoint, m_rows.size());
+            addedIPs << newRow.ip;
+            m_rows.append(std::move(newRow));
+        }
+        endInsertRows();
+    }
+
+    return addedIPs;
+}
+
+void PeerListModel::setHostNames(const QHash<QString, QString> &hostNames)
+{
+    if (hostNames.isEmpty()) return;
+
+    // Consecutive rows are reported in a single range
+    int first = -1;
+    for (int row = 0; row <= m_rows.size(); ++row) {
+        bool changed = false;
+        if (row < m_rows.size()) {
+            PeerRow &peer = m_rows[row];
+            const auto it = hostNames.constFind(peer.ip);
+            if ((it != hostNames.cend()) && (it.value() != peer.hostName)) {
+                peer.hostName = it.value();
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            if (first < 0)
+                first = row;
+        }
+        else if (first >= 0) {
+            emit dataChanged(index(first, PeerListDelegate::IP), index(row - 1, PeerListDelegate::IP));
+            first = -1;
+        }
+    }
+}
+
+QStringList PeerListModel::peerIPs() const
+{
+    QStringList ips;
+    ips.reserve(m_rows.size());
+    for (const PeerRow &peer : m_rows)
+        ips << peer.ip;
+    return ips;
+}
+
+void PeerListModel::clear()
+{
+    if (m_rows.isEmpty()) return;
+
+    qDebug("Cleared %d peers", m_rows.size());
+    beginResetModel();
+    m_rows.clear();
+    m_rowIndex.clear();
+    endResetModel();
+}
+
+PeerListModel::PeerRow PeerListModel::makeRow(const BitTorrent::TorrentHandle *torrent, const BitTorrent::PeerInfo &peer, const PeerRow *previous) const
+{
+    const BitTorrent::PeerAddress addr = peer.address();
+
+    PeerRow row;
+    row.ip = addr.ip.toString();
+    row.port = addr.port;
+    row.endpoint = peerEndpoint(row.ip, row.port);
+    if (previous)
+        row.hostName = previous->hostName;
+    if (m_resolveCountries) {
+        row.country = peer.country();
+        // Loading the flag is comparatively expensive, so reuse the previous one
+        if (previous && (previous->country == row.country) && !previous->countryFlag.isNull())
+            row.countryFlag = previous->countryFlag;
+        else
+            row.countryFlag = GuiIconProvider::instance()->getFlagIcon(row.country);
+    }
+    row.connection = peer.connectionType();
+    row.flags = peer.flags();
+    row.flagsDescription = peer.flagsDescription();
+    row.client = peer.client().toHtmlEscaped();
+    row.progress = peer.progress();
+    row.downSpeed = peer.payloadDownSpeed();
+    row.upSpeed = peer.payloadUpSpeed();
+    row.totalDownload = peer.totalDownload();
+    row.totalUpload = peer.totalUpload();
+    row.relevance = peer.relevance();
+    row.downloadingFiles = torrent->info().filesForPiece(peer.downloadingPieceIndex());
+    return row;
+}
+
+void PeerListModel::updateRow(const int row, PeerRow &&newRow)
+{
+    const PeerRow &oldRow = m_rows[row];
+
+    bool changed[PeerListDelegate::COL_COUNT] = {};
+    changed[PeerListDelegate::COUNTRY] = (newRow.country != oldRow.country)
+            || (newRow.countryFlag.isNull() != oldRow.countryFlag.isNull());
+    changed[PeerListDelegate::CONNECTION] = (newRow.connection != oldRow.connection);
+    changed[PeerListDelegate::FLAGS] = (newRow.flags != oldRow.flags)
+            || (newRow.flagsDescription != oldRow.flagsDescription);
+    changed[PeerListDelegate::CLIENT] = (newRow.client != oldRow.client);
+    changed[PeerListDelegate::PROGRESS] = !qFuzzyCompare(newRow.progress + 1, oldRow.progress + 1);
+    changed[PeerListDelegate::DOWN_SPEED] = (newRow.downSpeed != oldRow.downSpeed);
+    changed[PeerListDelegate::UP_SPEED] = (newRow.upSpeed != oldRow.upSpeed);
+    changed[PeerListDelegate::TOT_DOWN] = (newRow.totalDownload != oldRow.totalDownload);
+    changed[PeerListDelegate::TOT_UP] = (newRow.totalUpload != oldRow.totalUpload);
+    changed[PeerListDelegate::RELEVANCE] = !qFuzzyCompare(newRow.relevance + 1, oldRow.relevance + 1);
+    changed[PeerListDelegate::DOWNLOADING_PIECE] = (newRow.downloadingFiles != oldRow.downloadingFiles);
+
+    const bool *firstChanged = std::find(std::begin(changed), std::end(changed), true);
+    if (firstChanged == std::end(changed)) return;
+
+    const int first = static_cast<int>(firstChanged - std::begin(changed));
+    int last = PeerListDelegate::COL_COUNT - 1;
+    while (!changed[last])
+        --last;
+
+    m_rows[row] = std::move(newRow);
+    emit dataChanged(index(row, first), index(row, last));
+}
+
+void PeerListModel::removePeerRows(QVector<int> rows)
+{
+    // Remove contiguous spans starting from the end so that
+    // the remaining row numbers stay valid
+    std::sort(rows.begin(), rows.end());
+    int i = rows.size() - 1;
+    while (i >= 0) {
+        const int last = rows[i];
+        int first = last;
+        while ((i > 0) && (rows[i - 1] == (first - 1))) {
+            --i;
+            --first;
+        }
+        --i;
+
+        beginRemoveRows(QModelIndex(), first, last);
+        m_rows.erase(m_rows.begin() + first, m_rows.begin() + last + 1);
+        endRemoveRows();
+    }
+
+    rebuildIndex();
+}
+
+void PeerListModel::rebuildIndex()
+{
+    m_rowIndex.clear();
+    m_rowIndex.reserve(m_rows.size());
+    for (int row = 0; row < m_rows.size(); ++row)
+        m_rowIndex.insert(m_rows[row].endpoint, row);
+}
@@ -0,0 +1,97 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QIcon>
+#include <QStringList>
+#include <QVector>
+
+namespace BitTorrent
+{
+    class PeerInfo;
+    class TorrentHandle;
+}
+
+class PeerListModel : public QAbstractTableModel
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(PeerListModel)
+
+public:
+    explicit PeerListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool isCountryResolutionEnabled() const;
+    void setCountryResolutionEnabled(bool enabled);
+
+    // Synchronizes the rows with the current peers of the torrent.
+    // Returns the IPs of the peers that were added.
+    QStringList update(const BitTorrent::TorrentHandle *torrent);
+    void setHostNames(const QHash<QString, QString> &hostNames);
+    QStringList peerIPs() const;
+    void clear();
+
+private:
+    struct PeerRow
+    {
+        QString endpoint;
+        QString ip;
+        ushort port;
+        QString hostName;
+        QString country;
+        QIcon countryFlag;
+        QString connection;
+        QString flags;
+        QString flagsDescription;
+        QString client;
+        qreal progress;
+        int downSpeed;
+        int upSpeed;
+        qlonglong totalDownload;
+        qlonglong totalUpload;
+        qreal relevance;
+        QStringList downloadingFiles;
+    };
+
+    PeerRow makeRow(const BitTorrent::TorrentHandle *torrent, const BitTorrent::PeerInfo &peer, const PeerRow *previous) const;
+    void updateRow(int row, PeerRow &&newRow);
+    void removePeerRows(QVector<int> rows);
+    void rebuildIndex();
+
+    QVector<PeerRow> m_rows;
+    QHash<QString, int> m_rowIndex;
+    bool m_resolveCountries;
+};
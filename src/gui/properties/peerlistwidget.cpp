@@ -33,9 +33,6 @@
 #include <QHeaderView>
 #include <QMenu>
 #include <QMessageBox>
-#include <QSet>
-#include <QSortFilterProxyModel>
-#include <QStandardItemModel>
 #include <QTableView>
 #include <QWheelEvent>
 
@@ -43,12 +40,12 @@
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
 #include "base/logger.h"
-#include "base/net/geoipmanager.h"
 #include "base/net/reverseresolution.h"
 #include "base/preferences.h"
 #include "base/unicodestrings.h"
 #include "guiiconprovider.h"
 #include "peerlistdelegate.h"
+#include "peerlistmodel.h"
 #include "peerlistsortmodel.h"
 #include "peersadditiondialog.h"
 #include "propertieswidget.h"
@@ -57,6 +54,7 @@
 PeerListWidget::PeerListWidget(PropertiesWidget *parent)
     : QTreeView(parent)
     , m_properties(parent)
+    , m_resolveHostNames(false)
 {
     // Load settings
     loadSettings();
@@ -68,28 +66,8 @@ PeerListWidget::PeerListWidget(PropertiesWidget *parent)
     setSelectionMode(QAbstractItemView::ExtendedSelection);
     header()->setStretchLastSection(false);
     // List Model
-    m_listModel = new QStandardItemModel(0, PeerListDelegate::COL_COUNT, this);
-    m_listModel->setHeaderData(PeerListDelegate::COUNTRY, Qt::Horizontal, tr("Country")); // Country flag column
-    m_listModel->setHeaderData(PeerListDelegate::IP, Qt::Horizontal, tr("IP"));
-    m_listModel->setHeaderData(PeerListDelegate::PORT, Qt::Horizontal, tr("Port"));
-    m_listModel->setHeaderData(PeerListDelegate::FLAGS, Qt::Horizontal, tr("Flags"));
-    m_listModel->setHeaderData(PeerListDelegate::CONNECTION, Qt::Horizontal, tr("Connection"));
-    m_listModel->setHeaderData(PeerListDelegate::CLIENT, Qt::Horizontal, tr("Client", "i.e.: Client application"));
-    m_listModel->setHeaderData(PeerListDelegate::PROGRESS, Qt::Horizontal, tr("Progress", "i.e: % downloaded"));
-    m_listModel->setHeaderData(PeerListDelegate::DOWN_SPEED, Qt::Horizontal, tr("Down Speed", "i.e: Download speed"));
-    m_listModel->setHeaderData(PeerListDelegate::UP_SPEED, Qt::Horizontal, tr("Up Speed", "i.e: Upload speed"));
-    m_listModel->setHeaderData(PeerListDelegate::TOT_DOWN, Qt::Horizontal, tr("Downloaded", "i.e: total data downloaded"));
-    m_listModel->setHeaderData(PeerListDelegate::TOT_UP, Qt::Horizontal, tr("Uploaded", "i.e: total data uploaded"));
-    m_listModel->setHeaderData(PeerListDelegate::RELEVANCE, Qt::Horizontal, tr("Relevance", "i.e: How relevant this peer is to us. How many pieces it has that we don't."));
-    m_listModel->setHeaderData(PeerListDelegate::DOWNLOADING_PIECE, Qt::Horizontal, tr("Files", "i.e. files that are being downloaded right now"));
-    // Set header text alignment
-    m_listModel->setHeaderData(PeerListDelegate::PORT, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListDelegate::PROGRESS, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListDelegate::DOWN_SPEED, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListDelegate::UP_SPEED, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListDelegate::TOT_DOWN, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListDelegate::TOT_UP, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListDelegate::RELEVANCE, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
+    m_listModel = new PeerListModel(this);
+    m_listModel->setCountryResolutionEnabled(Preferences::instance()->resolvePeerCountries());
     // Proxy model to support sorting without actually altering the underlying model
     m_proxyModel = new PeerListSortModel(this);
     m_proxyModel->setDynamicSortFilter(true);
@@ -98,8 +76,7 @@ PeerListWidget::PeerListWidget(PropertiesWidget *parent)
     setModel(m_proxyModel);
     hideColumn(PeerListDelegate::IP_HIDDEN);
     hideColumn(PeerListDelegate::COL_COUNT);
-    m_resolveCountries = Preferences::instance()->resolvePeerCountries();
-    if (!m_resolveCountries)
+    if (!m_listModel->isCountryResolutionEnabled())
         hideColumn(PeerListDelegate::COUNTRY);
     // Ensure that at least one column is visible at all times
     bool atLeastOne = false;
@@ -149,8 +126,6 @@ PeerListWidget::PeerListWidget(PropertiesWidget *parent)
 PeerListWidget::~PeerListWidget()
 {
     saveSettings();
-    if (m_resolver)
-        delete m_resolver;
 }
 
 void PeerListWidget::displayToggleColumnsMenu(const QPoint &)
@@ -195,22 +170,26 @@ void PeerListWidget::displayToggleColumnsMenu(const QPoint &)
 void PeerListWidget::updatePeerHostNameResolutionState()
 {
     if (Preferences::instance()->resolvePeerHostNames()) {
-        if (!m_resolver) {
-            m_resolver = new Net::ReverseResolution(this);
-            connect(m_resolver.data(), &Net::ReverseResolution::ipResolved, this, &PeerListWidget::handleResolved);
+        if (!m_resolveHostNames) {
+            m_resolveHostNames = true;
+            connect(Net::ReverseResolution::instance(), &Net::ReverseResolution::hostNamesResolved
+                    , this, &PeerListWidget::handleResolved);
             loadPeers(m_properties->getCurrentTorrent(), true);
         }
     }
-    else if (m_resolver) {
-        delete m_resolver;
+    else if (m_resolveHostNames) {
+        m_resolveHostNames = false;
+        disconnect(Net::ReverseResolution::instance(), &Net::ReverseResolution::hostNamesResolved
+                   , this, &PeerListWidget::handleResolved);
     }
 }
 
 void PeerListWidget::updatePeerCountryResolutionState()
 {
-    if (Preferences::instance()->resolvePeerCountries() != m_resolveCountries) {
-        m_resolveCountries = !m_resolveCountries;
-        if (m_resolveCountries) {
+    const bool resolveCountries = Preferences::instance()->resolvePeerCountries();
+    if (resolveCountries != m_listModel->isCountryResolutionEnabled()) {
+        m_listModel->setCountryResolutionEnabled(resolveCountries);
+        if (resolveCountries) {
             loadPeers(m_properties->getCurrentTorrent());
             showColumn(PeerListDelegate::COUNTRY);
             if (columnWidth(PeerListDelegate::COUNTRY) <= 0)
@@ -315,14 +294,7 @@ void PeerListWidget::copySelectedPeers()
 void PeerListWidget::clear()
 {
     qDebug("clearing peer list");
-    m_peerItems.clear();
-    m_peerAddresses.clear();
-    m_missingFlags.clear();
-    int nbrows = m_listModel->rowCount();
-    if (nbrows > 0) {
-        qDebug("Cleared %d peers", nbrows);
-        m_listModel->removeRows(0, nbrows);
-    }
+    m_listModel->clear();
 }
 
 void PeerListWidget::loadSettings()
@@ -339,114 +311,19 @@ void PeerListWidget::loadPeers(BitTorrent::TorrentHandle *const torrent, bool fo
 {
     if (!torrent) return;
 
-    const QList<BitTorrent::PeerInfo> peers = torrent->peers();
-    QSet<QString> oldPeersSet = m_peerItems.keys().toSet();
-
-    for (const BitTorrent::PeerInfo &peer : peers) {
-        BitTorrent::PeerAddress addr = peer.address();
-        if (addr.ip.isNull()) continue;
-
-        QString peerIp = addr.ip.toString();
-        if (m_peerItems.contains(peerIp)) {
-            // Update existing peer
-            updatePeer(peerIp, torrent, peer);
-            oldPeersSet.remove(peerIp);
-            if (forceHostnameResolution && m_resolver)
-                m_resolver->resolve(peerIp);
-        }
-        else {
-            // Add new peer
-            m_peerItems[peerIp] = addPeer(peerIp, torrent, peer);
-            m_peerAddresses[peerIp] = addr;
-            // Resolve peer host name is asked
-            if (m_resolver)
-                m_resolver->resolve(peerIp);
-        }
-    }
-    // Delete peers that are gone
-    QSetIterator<QString> it(oldPeersSet);
-    while (it.hasNext()) {
-        const QString &ip = it.next();
-        m_missingFlags.remove(ip);
-        m_peerAddresses.remove(ip);
-        QStandardItem *item = m_peerItems.take(ip);
-        m_listModel->removeRow(item->row());
+    const QStringList addedIps = m_listModel->update(torrent);
+    // Resolve peer host names if asked
+    if (m_resolveHostNames) {
+        // The host names are requested at once for all the peers
+        const QStringList unresolvedIps = (forceHostnameResolution ? m_listModel->peerIPs() : addedIps);
+        if (!unresolvedIps.isEmpty())
+            handleResolved(Net::ReverseResolution::instance()->resolve(unresolvedIps));
     }
 }
 
-QStandardItem *PeerListWidget::addPeer(const QString &ip, BitTorrent::TorrentHandle *const torrent, const BitTorrent::PeerInfo &peer)
+void PeerListWidget::handleResolved(const QHash<QString, QString> &hostNames)
 {
-    int row = m_listModel->rowCount();
-    // Adding Peer to peer list
-    m_listModel->insertRow(row);
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::IP), ip);
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::IP), ip, Qt::ToolTipRole);
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::PORT), peer.address().port);
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::IP_HIDDEN), ip);
-    if (m_resolveCountries) {
-        const QIcon ico = GuiIconProvider::instance()->getFlagIcon(peer.country());
-        if (!ico.isNull()) {
-            m_listModel->setData(m_listModel->index(row, PeerListDelegate::COUNTRY), ico, Qt::DecorationRole);
-            const QString countryName = Net::GeoIPManager::CountryName(peer.country());
-            m_listModel->setData(m_listModel->index(row, PeerListDelegate::COUNTRY), countryName, Qt::ToolTipRole);
-        }
-        else {
-            m_missingFlags.insert(ip);
-        }
-    }
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::CONNECTION), peer.connectionType());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::FLAGS), peer.flags());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::FLAGS), peer.flagsDescription(), Qt::ToolTipRole);
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::CLIENT), peer.client().toHtmlEscaped());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::PROGRESS), peer.progress());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::DOWN_SPEED), peer.payloadDownSpeed());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::UP_SPEED), peer.payloadUpSpeed());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::TOT_DOWN), peer.totalDownload());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::TOT_UP), peer.totalUpload());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::RELEVANCE), peer.relevance());
-    QStringList downloadingFiles(torrent->info().filesForPiece(peer.downloadingPieceIndex()));
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::DOWNLOADING_PIECE), downloadingFiles.join(QLatin1Char(';')));
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::DOWNLOADING_PIECE), downloadingFiles.join(QLatin1Char('\n')), Qt::ToolTipRole);
-
-    return m_listModel->item(row, PeerListDelegate::IP);
-}
-
-void PeerListWidget::updatePeer(const QString &ip, BitTorrent::TorrentHandle *const torrent, const BitTorrent::PeerInfo &peer)
-{
-    QStandardItem *item = m_peerItems.value(ip);
-    int row = item->row();
-    if (m_resolveCountries) {
-        const QIcon ico = GuiIconProvider::instance()->getFlagIcon(peer.country());
-        if (!ico.isNull()) {
-            m_listModel->setData(m_listModel->index(row, PeerListDelegate::COUNTRY), ico, Qt::DecorationRole);
-            const QString countryName = Net::GeoIPManager::CountryName(peer.country());
-            m_listModel->setData(m_listModel->index(row, PeerListDelegate::COUNTRY), countryName, Qt::ToolTipRole);
-            m_missingFlags.remove(ip);
-        }
-    }
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::CONNECTION), peer.connectionType());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::PORT), peer.address().port);
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::FLAGS), peer.flags());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::FLAGS), peer.flagsDescription(), Qt::ToolTipRole);
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::CLIENT), peer.client().toHtmlEscaped());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::PROGRESS), peer.progress());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::DOWN_SPEED), peer.payloadDownSpeed());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::UP_SPEED), peer.payloadUpSpeed());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::TOT_DOWN), peer.totalDownload());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::TOT_UP), peer.totalUpload());
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::RELEVANCE), peer.relevance());
-    QStringList downloadingFiles(torrent->info().filesForPiece(peer.downloadingPieceIndex()));
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::DOWNLOADING_PIECE), downloadingFiles.join(QLatin1String(";")));
-    m_listModel->setData(m_listModel->index(row, PeerListDelegate::DOWNLOADING_PIECE), downloadingFiles.join(QLatin1String("\n")), Qt::ToolTipRole);
-}
-
-void PeerListWidget::handleResolved(const QString &ip, const QString &hostname)
-{
-    QStandardItem *item = m_peerItems.value(ip, nullptr);
-    if (item) {
-        qDebug("Resolved %s -> %s", qUtf8Printable(ip), qUtf8Printable(hostname));
-        item->setData(hostname, Qt::DisplayRole);
-    }
+    m_listModel->setHostNames(hostNames);
 }
 
 void PeerListWidget::handleSortColumnChanged(int col)
@@ -30,29 +30,17 @@
 #define PEERLISTWIDGET_H
 
 #include <QHash>
-#include <QPointer>
-#include <QSet>
 #include <QShortcut>
 #include <QTreeView>
 
-namespace Net
-{
-    class ReverseResolution;
-}
-
 class PeerListDelegate;
+class PeerListModel;
 class PeerListSortModel;
 class PropertiesWidget;
 
-class QSortFilterProxyModel;
-class QStandardItem;
-class QStandardItemModel;
-
 namespace BitTorrent
 {
     class TorrentHandle;
-    class PeerInfo;
-    struct PeerAddress;
 }
 
 class PeerListWidget : public QTreeView
@@ -64,8 +52,6 @@ public:
     ~PeerListWidget() override;
 
     void loadPeers(BitTorrent::TorrentHandle *const torrent, bool forceHostnameResolution = false);
-    QStandardItem *addPeer(const QString &ip, BitTorrent::TorrentHandle *const torrent, const BitTorrent::PeerInfo &peer);
-    void updatePeer(const QString &ip, BitTorrent::TorrentHandle *const torrent, const BitTorrent::PeerInfo &peer);
     void updatePeerHostNameResolutionState();
     void updatePeerCountryResolutionState();
     void clear();
@@ -78,20 +64,16 @@ private slots:
     void banSelectedPeers();
     void copySelectedPeers();
     void handleSortColumnChanged(int col);
-    void handleResolved(const QString &ip, const QString &hostname);
+    void handleResolved(const QHash<QString, QString> &hostNames);
 
 private:
     void wheelEvent(QWheelEvent *event) override;
 
-    QStandardItemModel *m_listModel;
+    PeerListModel *m_listModel;
     PeerListDelegate *m_listDelegate;
     PeerListSortModel *m_proxyModel;
-    QHash<QString, QStandardItem *> m_peerItems;
-    QHash<QString, BitTorrent::PeerAddress> m_peerAddresses;
-    QSet<QString> m_missingFlags;
-    QPointer<Net::ReverseResolution> m_resolver;
     PropertiesWidget *m_properties;
-    bool m_resolveCountries;
+    bool m_resolveHostNames;
     QShortcut *m_copyHotkey;
 };
 
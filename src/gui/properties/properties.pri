@@ -8,6 +8,7 @@ FORMS += \
 HEADERS += \
     $$PWD/downloadedpiecesbar.h \
     $$PWD/peerlistdelegate.h \
+    $$PWD/peerlistmodel.h \
     $$PWD/peerlistsortmodel.h \
     $$PWD/peerlistwidget.h \
     $$PWD/peersadditiondialog.h \
@@ -23,6 +24,7 @@ HEADERS += \
 
 SOURCES += \
     $$PWD/downloadedpiecesbar.cpp \
+    $$PWD/peerlistmodel.cpp \
     $$PWD/peerlistwidget.cpp \
     $$PWD/peersadditiondialog.cpp \
     $$PWD/pieceavailabilitybar.cpp \
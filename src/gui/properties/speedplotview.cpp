@@ -28,9 +28,13 @@
 
 #include "speedplotview.h"
 
+#include <algorithm>
+
+#include <QDateTime>
 #include <QLocale>
 #include <QPainter>
 #include <QPen>
+#include "base/bittorrent/session.h"
 #include "base/global.h"
 #include "base/unicodestrings.h"
 #include "base/utils/misc.h"
@@ -45,12 +49,8 @@ namespace
         HOUR6_SEC = 6 * 60 * 60
     };
 
-    const int MIN5_BUF_SIZE = 5 * 60;
-    const int MIN30_BUF_SIZE = 5 * 60;
-    const int HOUR6_BUF_SIZE = 5 * 60;
-    const int DIVIDER_30MIN = MIN30_SEC / MIN30_BUF_SIZE;
-    const int DIVIDER_6HOUR = HOUR6_SEC / HOUR6_BUF_SIZE;
-
+    // longer periods are downsampled to this number of points
+    const int MAX_VIEWABLE_POINTS = 5 * 60;
 
     // table of supposed nice steps for grid marks to get nice looking quarters of scale
     const double roundingTable[] = {1.2, 1.6, 2, 2.4, 2.8, 3.2, 4, 6, 8};
@@ -109,51 +109,15 @@ namespace
     }
 }
 
-SpeedPlotView::Averager::Averager(int divider, boost::circular_buffer<PointData> &sink)
-    : m_divider(divider)
-    , m_sink(sink)
-    , m_counter(0)
-    , m_accumulator {}
-{
-}
-
-void SpeedPlotView::Averager::push(const PointData &pointData)
-{
-    // Accumulator overflow will be hit in worst case on longest used averaging span,
-    // defined by divider value. Maximum divider is DIVIDER_6HOUR = 72
-    // Using int32 for accumulator we get overflow when transfer speed reaches 2^31/72 ~~ 28.4 MBytes/s.
-    // With quint64 this speed limit is 2^64/72 ~~ 228 PBytes/s.
-    // This speed is inaccessible to an ordinary user.
-    m_accumulator.x += pointData.x;
-    for (int id = UP; id < NB_GRAPHS; ++id)
-        m_accumulator.y[id] += pointData.y[id];
-    m_counter = (m_counter + 1) % m_divider;
-    if (m_counter != 0)
-        return; // still accumulating
-    // it is time final averaging calculations
-    for (int id = UP; id < NB_GRAPHS; ++id)
-        m_accumulator.y[id] /= m_divider;
-    m_accumulator.x /= m_divider;
-    // now flush out averaged data
-    m_sink.push_back(m_accumulator);
-    m_accumulator = {};
-}
-
-bool SpeedPlotView::Averager::isReady() const
-{
-    return m_counter == 0;
-}
-
 SpeedPlotView::SpeedPlotView(QWidget *parent)
     : QGraphicsView(parent)
-    , m_data5Min(MIN5_BUF_SIZE)
-    , m_data30Min(MIN30_BUF_SIZE)
-    , m_data6Hour(HOUR6_BUF_SIZE)
-    , m_averager30Min(DIVIDER_30MIN, m_data30Min)
-    , m_averager6Hour(DIVIDER_6HOUR, m_data6Hour)
     , m_period(MIN5)
-    , m_viewablePointsCount(MIN5_SEC)
+    , m_periodInSeconds(MIN5_SEC)
+    , m_pointsLoadTime(0)
 {
+    static_assert(static_cast<int>(NB_GRAPHS) == static_cast<int>(BitTorrent::Session::TransferRateChannelsCount)
+                  , "Graphs must match the channels of the transfer rate history");
+
     QPen greenPen;
     greenPen.setWidthF(1.5);
     greenPen.setColor(QColor(134, 196, 63));
@@ -191,71 +155,53 @@ void SpeedPlotView::setGraphEnable(GraphID id, bool enable)
     viewport()->update();
 }
 
-void SpeedPlotView::pushPoint(const SpeedPlotView::PointData &point)
-{
-    m_data5Min.push_back(point);
-    m_averager30Min.push(point);
-    m_averager6Hour.push(point);
-}
-
 void SpeedPlotView::setViewableLastPoints(TimePeriod period)
 {
     m_period = period;
 
     switch (period) {
     case SpeedPlotView::MIN1:
-        m_viewablePointsCount = MIN1_SEC;
+        m_periodInSeconds = MIN1_SEC;
         break;
     case SpeedPlotView::MIN5:
-        m_viewablePointsCount = MIN5_SEC;
+        m_periodInSeconds = MIN5_SEC;
         break;
     case SpeedPlotView::MIN30:
-        m_viewablePointsCount = MIN30_BUF_SIZE;
+        m_periodInSeconds = MIN30_SEC;
         break;
     case SpeedPlotView::HOUR6:
-        m_viewablePointsCount = HOUR6_BUF_SIZE;
+        m_periodInSeconds = HOUR6_SEC;
         break;
     }
 
-    viewport()->update();
+    replot();
 }
 
 void SpeedPlotView::replot()
 {
-    if ((m_period == MIN1)
-        || (m_period == MIN5)
-        || ((m_period == MIN30) && m_averager30Min.isReady())
-        || ((m_period == HOUR6) && m_averager6Hour.isReady()) )
-        viewport()->update();
+    loadPoints();
+    viewport()->update();
 }
 
-boost::circular_buffer<SpeedPlotView::PointData> &SpeedPlotView::getCurrentData()
+void SpeedPlotView::loadPoints()
 {
-    switch (m_period) {
-    case SpeedPlotView::MIN1:
-    case SpeedPlotView::MIN5:
-    default:
-        return m_data5Min;
-    case SpeedPlotView::MIN30:
-        return m_data30Min;
-    case SpeedPlotView::HOUR6:
-        return m_data6Hour;
-    }
+    const int step = std::max((m_periodInSeconds / MAX_VIEWABLE_POINTS), 1);
+    m_pointsLoadTime = QDateTime::currentMSecsSinceEpoch() / 1000;
+    m_points = BitTorrent::Session::instance()->transferRateHistory().query(
+                   (m_pointsLoadTime - m_periodInSeconds), m_pointsLoadTime, step);
 }
 
 quint64 SpeedPlotView::maxYValue()
 {
-    boost::circular_buffer<PointData> &queue = getCurrentData();
-
     quint64 maxYValue = 0;
     for (int id = UP; id < NB_GRAPHS; ++id) {
 
         if (!m_properties[static_cast<GraphID>(id)].enable)
             continue;
 
-        for (int i = static_cast<int>(queue.size()) - 1, j = 0; (i >= 0) && (j <= m_viewablePointsCount); --i, ++j)
-            if (queue[i].y[id] > maxYValue)
-                maxYValue = queue[i].y[id];
+        for (const TimeSeries::Point &point : asConst(m_points))
+            if (point.values[id] > maxYValue)
+                maxYValue = point.values[id];
     }
 
     return maxYValue;
@@ -322,19 +268,18 @@ void SpeedPlotView::paintEvent(QPaintEvent *)
     rect.adjust(3, 0, 0, 0); // Need, else graphs cross left gridline
 
     const double yMultiplier = (niceScale.arg == 0.0) ? 0.0 : (static_cast<double>(rect.height()) / niceScale.sizeInBytes());
-    const double xTickSize = static_cast<double>(rect.width()) / m_viewablePointsCount;
-
-    boost::circular_buffer<PointData> &queue = getCurrentData();
+    const double xTickSize = static_cast<double>(rect.width()) / m_periodInSeconds;
 
     for (int id = UP; id < NB_GRAPHS; ++id) {
         if (!m_properties[static_cast<GraphID>(id)].enable)
             continue;
 
         QVector<QPoint> points;
-        for (int i = static_cast<int>(queue.size()) - 1, j = 0; (i >= 0) && (j <= m_viewablePointsCount); --i, ++j) {
+        points.reserve(m_points.size());
+        for (const TimeSeries::Point &point : asConst(m_points)) {
 
-            int newX = rect.right() - j * xTickSize;
-            int newY = rect.bottom() - queue[i].y[id] * yMultiplier;
+            int newX = rect.right() - (m_pointsLoadTime - point.timestamp) * xTickSize;
+            int newY = rect.bottom() - point.values[id] * yMultiplier;
 
             points.push_back(QPoint(newX, newY));
         }
@@ -29,12 +29,11 @@
 #ifndef SPEEDPLOTVIEW_H
 #define SPEEDPLOTVIEW_H
 
-#ifndef Q_MOC_RUN
-#include <boost/circular_buffer.hpp>
-#endif
-
 #include <QGraphicsView>
 #include <QMap>
+#include <QVector>
+
+#include "base/timeseries.h"
 
 class QPen;
 
@@ -67,39 +66,18 @@ public:
         HOUR6
     };
 
-    struct PointData
-    {
-        qint64 x;
-        quint64 y[NB_GRAPHS];
-    };
-
     explicit SpeedPlotView(QWidget *parent = nullptr);
 
     void setGraphEnable(GraphID id, bool enable);
     void setViewableLastPoints(TimePeriod period);
 
-    void pushPoint(const PointData &point);
-
+    // Reloads the points of the viewable period from the session transfer rate history
     void replot();
 
 protected:
     void paintEvent(QPaintEvent *event) override;
 
 private:
-    class Averager
-    {
-    public:
-        Averager(int divider, boost::circular_buffer<PointData> &sink);
-        void push(const PointData &pointData);
-        bool isReady() const;
-
-    private:
-        const int m_divider;
-        boost::circular_buffer<PointData> &m_sink;
-        int m_counter;
-        PointData m_accumulator;
-    };
-
     struct GraphProperties
     {
         GraphProperties();
@@ -111,18 +89,14 @@ private:
     };
 
     quint64 maxYValue();
-    boost::circular_buffer<PointData> &getCurrentData();
-
-    boost::circular_buffer<PointData> m_data5Min;
-    boost::circular_buffer<PointData> m_data30Min;
-    boost::circular_buffer<PointData> m_data6Hour;
-    Averager m_averager30Min;
-    Averager m_averager6Hour;
+    void loadPoints();
 
     QMap<GraphID, GraphProperties> m_properties;
 
     TimePeriod m_period;
-    int m_viewablePointsCount;
+    int m_periodInSeconds;
+    qint64 m_pointsLoadTime;
+    QVector<TimeSeries::Point> m_points;
 };
 
 #endif // SPEEDPLOTVIEW_H
@@ -33,12 +33,10 @@
 #include <QLabel>
 #include <QMenu>
 #include <QSignalMapper>
-#include <QTimer>
 
 #include <libtorrent/session_status.hpp>
 
 #include "base/bittorrent/session.h"
-#include "base/bittorrent/sessionstatus.h"
 #include "base/preferences.h"
 #include "propertieswidget.h"
 
@@ -117,9 +115,8 @@ SpeedWidget::SpeedWidget(PropertiesWidget *parent)
 
     loadSettings();
 
-    QTimer *localUpdateTimer = new QTimer(this);
-    connect(localUpdateTimer, &QTimer::timeout, this, &SpeedWidget::update);
-    localUpdateTimer->start(1000);
+    // the samples are recorded by the session, there is nothing to do while hidden
+    connect(BitTorrent::Session::instance(), &BitTorrent::Session::statsUpdated, this, &SpeedWidget::update);
 
     m_plot->show();
 }
@@ -133,23 +130,8 @@ SpeedWidget::~SpeedWidget()
 
 void SpeedWidget::update()
 {
-    const BitTorrent::SessionStatus &btStatus = BitTorrent::Session::instance()->status();
-
-    SpeedPlotView::PointData point;
-    point.x = QDateTime::currentMSecsSinceEpoch() / 1000;
-    point.y[SpeedPlotView::UP] = btStatus.uploadRate;
-    point.y[SpeedPlotView::DOWN] = btStatus.downloadRate;
-    point.y[SpeedPlotView::PAYLOAD_UP] = btStatus.payloadUploadRate;
-    point.y[SpeedPlotView::PAYLOAD_DOWN] = btStatus.payloadDownloadRate;
-    point.y[SpeedPlotView::OVERHEAD_UP] = btStatus.ipOverheadUploadRate;
-    point.y[SpeedPlotView::OVERHEAD_DOWN] = btStatus.ipOverheadDownloadRate;
-    point.y[SpeedPlotView::DHT_UP] = btStatus.dhtUploadRate;
-    point.y[SpeedPlotView::DHT_DOWN] = btStatus.dhtDownloadRate;
-    point.y[SpeedPlotView::TRACKER_UP] = btStatus.trackerUploadRate;
-    point.y[SpeedPlotView::TRACKER_DOWN] = btStatus.trackerDownloadRate;
-
-    m_plot->pushPoint(point);
-    m_plot->replot();
+    if (isVisible())
+        m_plot->replot();
 }
 
 void SpeedWidget::onPeriodChange(int period)
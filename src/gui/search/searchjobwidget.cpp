@@ -157,6 +157,7 @@ SearchJobWidget::SearchJobWidget(SearchHandler *searchHandler, QWidget *parent)
     connect(m_ui->resultsBrowser, &QAbstractItemView::doubleClicked, this, &SearchJobWidget::onItemDoubleClicked);
 
     connect(searchHandler, &SearchHandler::newSearchResults, this, &SearchJobWidget::appendSearchResults);
+    connect(searchHandler, &SearchHandler::searchResultsUpdated, this, &SearchJobWidget::updateSearchResults);
     connect(searchHandler, &SearchHandler::searchFinished, this, &SearchJobWidget::searchFinished);
     connect(searchHandler, &SearchHandler::searchFailed, this, &SearchJobWidget::searchFailed);
     connect(this, &QObject::destroyed, searchHandler, &QObject::deleteLater);
@@ -456,23 +457,51 @@ void SearchJobWidget::searchFailed()
 
 void SearchJobWidget::appendSearchResults(const QList<SearchResult> &results)
 {
+    const auto createItem = [](const QVariant &value) -> QStandardItem *
+    {
+        QStandardItem *item = new QStandardItem;
+        item->setData(value, Qt::DisplayRole);
+        return item;
+    };
+
+    // Complete rows are inserted with sorting suspended so the results get sorted once per batch.
+    // Rows follow the indexes of the handler result store.
+    m_proxyModel->setDynamicSortFilter(false);
+
     for (const SearchResult &result : results) {
-        // Add item to search result list
-        int row = m_searchListModel->rowCount();
-        m_searchListModel->insertRow(row);
-
-        m_searchListModel->setData(m_searchListModel->index(row, SearchSortModel::NAME), result.fileName); // Name
-        m_searchListModel->setData(m_searchListModel->index(row, SearchSortModel::DL_LINK), result.fileUrl); // download URL
-        m_searchListModel->setData(m_searchListModel->index(row, SearchSortModel::SIZE), result.fileSize); // Size
-        m_searchListModel->setData(m_searchListModel->index(row, SearchSortModel::SEEDS), result.nbSeeders); // Seeders
-        m_searchListModel->setData(m_searchListModel->index(row, SearchSortModel::LEECHES), result.nbLeechers); // Leechers
-        m_searchListModel->setData(m_searchListModel->index(row, SearchSortModel::ENGINE_URL), result.siteUrl); // Search site URL
-        m_searchListModel->setData(m_searchListModel->index(row, SearchSortModel::DESC_LINK), result.descrLink); // Description Link
+        QList<QStandardItem *> row;
+        row.reserve(SearchSortModel::NB_SEARCH_COLUMNS);
+        for (int i = 0; i < SearchSortModel::NB_SEARCH_COLUMNS; ++i)
+            row << nullptr;
+
+        row[SearchSortModel::NAME] = createItem(result.fileName); // Name
+        row[SearchSortModel::DL_LINK] = createItem(result.fileUrl); // download URL
+        row[SearchSortModel::SIZE] = createItem(result.fileSize); // Size
+        row[SearchSortModel::SEEDS] = createItem(result.nbSeeders); // Seeders
+        row[SearchSortModel::LEECHES] = createItem(result.nbLeechers); // Leechers
+        row[SearchSortModel::ENGINE_URL] = createItem(result.siteUrl); // Search site URL
+        row[SearchSortModel::DESC_LINK] = createItem(result.descrLink); // Description Link
+
+        m_searchListModel->appendRow(row);
     }
 
+    m_proxyModel->setDynamicSortFilter(true);
+
     updateResultsCount();
 }
 
+// Results merged with the ones of other engines
+void SearchJobWidget::updateSearchResults(const QVector<int> &indexes)
+{
+    const SearchResultStore &results = m_searchHandler->results();
+    for (const int row : indexes) {
+        const SearchResult &result = results.at(row);
+        m_searchListModel->setData(m_searchListModel->index(row, SearchSortModel::SEEDS), result.nbSeeders);
+        m_searchListModel->setData(m_searchListModel->index(row, SearchSortModel::LEECHES), result.nbLeechers);
+        m_searchListModel->setData(m_searchListModel->index(row, SearchSortModel::DESC_LINK), result.descrLink);
+    }
+}
+
 CachedSettingValue<SearchJobWidget::NameFilteringMode> &SearchJobWidget::nameFilteringModeSetting()
 {
     static CachedSettingValue<NameFilteringMode> setting("Search/FilteringMode", NameFilteringMode::OnlyNames);
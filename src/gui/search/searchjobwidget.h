@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <QVector>
 #include <QWidget>
 
 #define ENGINE_URL_COLUMN 4
@@ -102,6 +103,7 @@ private:
     void searchFinished(bool cancelled);
     void searchFailed();
     void appendSearchResults(const QList<SearchResult> &results);
+    void updateSearchResults(const QVector<int> &indexes);
     void updateResultsCount();
     void setStatus(Status value);
     void downloadTorrent(const QModelIndex &rowIndex);
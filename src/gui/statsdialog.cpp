@@ -30,6 +30,8 @@
 
 #include <algorithm>
 
+#include <QStringList>
+
 #include "base/bittorrent/cachestatus.h"
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/sessionstatus.h"
@@ -112,4 +114,20 @@ void StatsDialog::update()
 
     // Total connected peers
     m_ui->labelPeers->setText(QString::number(ss.peersCount));
+
+    // Alert processing
+    const BitTorrent::Session *session = BitTorrent::Session::instance();
+    m_ui->labelAlertsQueued->setText(QString("%1 / %2").arg(session->lastAlertsCount()).arg(session->alertsHighWaterMark()));
+    m_ui->labelAlertsBacklog->setText(QString::number(session->alertsBacklog()));
+    const LatencyHistogram &handlingLatency = session->alertsHandlingLatency();
+    m_ui->labelAlertsHandlingTime->setText(tr("%1 ms", "18 milliseconds")
+        .arg(Utils::String::fromDouble((handlingLatency.count() > 0)
+             ? (handlingLatency.sum() / 1000. / handlingLatency.count()) : 0, 2)));
+
+    QStringList slowestAlerts;
+    for (const BitTorrent::AlertTypeStatistics &typeStats : asConst(session->slowestAlertTypes(3))) {
+        slowestAlerts << tr("%1: %2 ms", "state_update_alert: 1.25 ms")
+            .arg(typeStats.name, Utils::String::fromDouble(typeStats.latency.sum() / 1000. / typeStats.latency.count(), 2));
+    }
+    m_ui->labelSlowestAlerts->setText(slowestAlerts.isEmpty() ? QString("-") : slowestAlerts.join('\n'));
 }
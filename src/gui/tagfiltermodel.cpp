@@ -96,10 +96,9 @@ TagFilterModel::TagFilterModel(QObject *parent)
 
     connect(session, &Session::tagAdded, this, &TagFilterModel::tagAdded);
     connect(session, &Session::tagRemoved, this, &TagFilterModel::tagRemoved);
-    connect(session, &Session::torrentTagAdded, this, &TagFilterModel::torrentTagAdded);
-    connect(session, &Session::torrentTagRemoved, this, &TagFilterModel::torrentTagRemoved);
+    connect(session, &Session::torrentsTagsChanged, this, &TagFilterModel::torrentsTagsChanged);
     connect(session, &Session::torrentAdded, this, &TagFilterModel::torrentAdded);
-    connect(session, &Session::torrentAboutToBeRemoved, this, &TagFilterModel::torrentAboutToBeRemoved);
+    connect(session, &Session::torrentsAboutToBeRemoved, this, &TagFilterModel::torrentsAboutToBeRemoved);
     populate();
 }
 
@@ -200,33 +199,23 @@ void TagFilterModel::tagRemoved(const QString &tag)
     endRemoveRows();
 }
 
-void TagFilterModel::torrentTagAdded(BitTorrent::TorrentHandle *const torrent, const QString &tag)
+void TagFilterModel::torrentsTagsChanged(const QVector<BitTorrent::TorrentHandle *> &torrents, const QVector<QSet<QString>> &oldTags)
 {
-    if (torrent->tags().count() == 1)
-        untaggedItem()->decreaseTorrentsCount();
-
-    const int row = findRow(tag);
-    Q_ASSERT(isValidRow(row));
-    TagModelItem &item = m_tagItems[row];
-
-    item.increaseTorrentsCount();
-    const QModelIndex i = index(row, 0, QModelIndex());
-    emit dataChanged(i, i);
-}
-
-void TagFilterModel::torrentTagRemoved(BitTorrent::TorrentHandle *const torrent, const QString &tag)
-{
-    Q_ASSERT(torrent->tags().count() >= 0);
-    if (torrent->tags().count() == 0)
-        untaggedItem()->increaseTorrentsCount();
-
-    const int row = findRow(tag);
-    Q_ASSERT(isValidRow(row));
-    TagModelItem &item = m_tagItems[row];
+    for (int i = 0; i < torrents.size(); ++i) {
+        const QSet<QString> newTags = torrents[i]->tags();
+        if (oldTags[i].isEmpty() && !newTags.isEmpty())
+            untaggedItem()->decreaseTorrentsCount();
+        else if (!oldTags[i].isEmpty() && newTags.isEmpty())
+            untaggedItem()->increaseTorrentsCount();
+
+        for (TagModelItem *item : asConst(findItems(oldTags[i] - newTags)))
+            item->decreaseTorrentsCount();
+        for (TagModelItem *item : asConst(findItems(newTags - oldTags[i])))
+            item->increaseTorrentsCount();
+    }
 
-    item.decreaseTorrentsCount();
-    const QModelIndex i = index(row, 0, QModelIndex());
-    emit dataChanged(i, i);
+    // a single notification for the whole batch
+    emit dataChanged(index(0, 0), index((rowCount() - 1), 0));
 }
 
 void TagFilterModel::torrentAdded(BitTorrent::TorrentHandle *const torrent)
@@ -241,15 +230,17 @@ void TagFilterModel::torrentAdded(BitTorrent::TorrentHandle *const torrent)
         item->increaseTorrentsCount();
 }
 
-void TagFilterModel::torrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent)
+void TagFilterModel::torrentsAboutToBeRemoved(const QVector<BitTorrent::TorrentHandle *> &torrents)
 {
-    allTagsItem()->decreaseTorrentsCount();
+    for (BitTorrent::TorrentHandle *const torrent : torrents) {
+        allTagsItem()->decreaseTorrentsCount();
 
-    if (torrent->tags().isEmpty())
-        untaggedItem()->decreaseTorrentsCount();
+        if (torrent->tags().isEmpty())
+            untaggedItem()->decreaseTorrentsCount();
 
-    for (TagModelItem *item : asConst(findItems(torrent->tags())))
-        item->decreaseTorrentsCount();
+        for (TagModelItem *item : asConst(findItems(torrent->tags())))
+            item->decreaseTorrentsCount();
+    }
 }
 
 QString TagFilterModel::tagDisplayName(const QString &tag)
@@ -263,23 +254,17 @@ QString TagFilterModel::tagDisplayName(const QString &tag)
 
 void TagFilterModel::populate()
 {
-    using Torrent = BitTorrent::TorrentHandle;
-
     auto session = BitTorrent::Session::instance();
-    auto torrents = session->torrents();
+    const BitTorrent::TorrentIndex &torrentIndex = session->torrentIndex();
 
     // All torrents
-    addToModel(getSpecialAllTag(), torrents.count());
+    addToModel(getSpecialAllTag(), torrentIndex.torrentsCount());
 
-    const int untaggedCount = std::count_if(torrents.begin(), torrents.end(),
-                                             [](Torrent *torrent) { return torrent->tags().isEmpty(); });
-    addToModel(getSpecialUntaggedTag(), untaggedCount);
+    // Untagged torrents
+    addToModel(getSpecialUntaggedTag(), torrentIndex.tagTorrentsCount(""));
 
-    for (const QString &tag : asConst(session->tags())) {
-        const int count = std::count_if(torrents.begin(), torrents.end(),
-                                        [tag](Torrent *torrent) { return torrent->hasTag(tag); });
-        addToModel(tag, count);
-    }
+    for (const QString &tag : asConst(session->tags()))
+        addToModel(tag, torrentIndex.tagTorrentsCount(tag));
 }
 
 void TagFilterModel::addToModel(const QString &tag, int count)
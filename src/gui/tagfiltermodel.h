@@ -63,10 +63,9 @@ public:
 private slots:
     void tagAdded(const QString &tag);
     void tagRemoved(const QString &tag);
-    void torrentTagAdded(BitTorrent::TorrentHandle *const torrent, const QString &tag);
-    void torrentTagRemoved(BitTorrent::TorrentHandle *const, const QString &tag);
+    void torrentsTagsChanged(const QVector<BitTorrent::TorrentHandle *> &torrents, const QVector<QSet<QString>> &oldTags);
     void torrentAdded(BitTorrent::TorrentHandle *const torrent);
-    void torrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent);
+    void torrentsAboutToBeRemoved(const QVector<BitTorrent::TorrentHandle *> &torrents);
 
 private:
     static QString tagDisplayName(const QString &tag);
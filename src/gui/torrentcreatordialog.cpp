@@ -169,10 +169,19 @@ void TorrentCreatorDialog::onCreateButtonClicked()
     const QString comment = m_ui->txtComment->toPlainText();
     const QString source = m_ui->lineEditSource->text();
 
+    BitTorrent::TorrentCreatorParams params;
+    params.isPrivate = m_ui->checkPrivate->isChecked();
+    params.isAlignmentOptimized = m_ui->checkOptimizeAlignment->isChecked();
+    params.pieceSize = getPieceSize();
+    params.inputPath = input;
+    params.savePath = destination;
+    params.comment = comment;
+    params.source = source;
+    params.trackers = trackers;
+    params.urlSeeds = urlSeeds;
+
     // run the creator thread
-    m_creatorThread->create({ m_ui->checkPrivate->isChecked()
-        , m_ui->checkOptimizeAlignment->isChecked(), getPieceSize()
-        , input, destination, comment, source, trackers, urlSeeds });
+    m_creatorThread->create(params);
 }
 
 void TorrentCreatorDialog::handleCreationFailure(const QString &msg)
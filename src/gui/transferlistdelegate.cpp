@@ -99,6 +99,12 @@ void TransferListDelegate::paint(QPainter *painter, const QStyleOptionViewItem &
     case TransferListModel::TR_STATUS: {
             const auto state = index.data().value<BitTorrent::TorrentState>();
             QString display = getStatusString(state);
+            const int storageJobPosition = index.data(Qt::UserRole).toInt();
+            if (storageJobPosition >= 0) {
+                display = (state == BitTorrent::TorrentState::Moving)
+                    ? tr("Queued for moving (#%1)").arg(storageJobPosition + 1)
+                    : tr("Queued for checking (#%1)").arg(storageJobPosition + 1);
+            }
             QItemDelegate::drawDisplay(painter, opt, opt.rect, display);
         }
         break;
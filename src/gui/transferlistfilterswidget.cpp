@@ -34,12 +34,14 @@
 #include <QListWidgetItem>
 #include <QMenu>
 #include <QScrollArea>
+#include <QTimer>
 #include <QUrl>
 #include <QVBoxLayout>
 
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
 #include "base/bittorrent/trackerentry.h"
+#include "base/bittorrent/trackerindex.h"
 #include "base/global.h"
 #include "base/logger.h"
 #include "base/net/downloadhandler.h"
@@ -92,8 +94,14 @@ BaseFilterWidget::BaseFilterWidget(QWidget *parent, TransferListWidget *transfer
 
     connect(BitTorrent::Session::instance(), &BitTorrent::Session::torrentAdded
             , this, &BaseFilterWidget::handleNewTorrent);
-    connect(BitTorrent::Session::instance(), &BitTorrent::Session::torrentAboutToBeRemoved
-            , this, &BaseFilterWidget::torrentAboutToBeDeleted);
+    connect(BitTorrent::Session::instance(), &BitTorrent::Session::torrentsAboutToBeRemoved
+            , this, &BaseFilterWidget::handleTorrentsAboutToBeRemoved);
+}
+
+void BaseFilterWidget::handleTorrentsAboutToBeRemoved(const QVector<BitTorrent::TorrentHandle *> &torrents)
+{
+    for (BitTorrent::TorrentHandle *const torrent : torrents)
+        torrentAboutToBeDeleted(torrent);
 }
 
 QSize BaseFilterWidget::sizeHint() const
@@ -195,8 +203,8 @@ void StatusFilterWidget::torrentAboutToBeDeleted(BitTorrent::TorrentHandle *cons
 
 TrackerFiltersList::TrackerFiltersList(QWidget *parent, TransferListWidget *transferList)
     : BaseFilterWidget(parent, transferList)
-    , m_totalTorrents(0)
     , m_downloadTrackerFavicon(true)
+    , m_isFilterUpdatePending(false)
 {
     QListWidgetItem *allTrackers = new QListWidgetItem(this);
     allTrackers->setData(Qt::DisplayRole, QVariant(tr("All (0)", "this is for the tracker filter")));
@@ -210,7 +218,6 @@ TrackerFiltersList::TrackerFiltersList(QWidget *parent, TransferListWidget *tran
     QListWidgetItem *warningTracker = new QListWidgetItem(this);
     warningTracker->setData(Qt::DisplayRole, QVariant(tr("Warning (0)")));
     warningTracker->setData(Qt::DecorationRole, style()->standardIcon(QStyle::SP_MessageBoxWarning));
-    m_trackers.insert("", QStringList());
 
     setCurrentRow(0, QItemSelectionModel::SelectCurrent);
     toggleFilter(Preferences::instance()->getTrackerFilterState());
@@ -222,106 +229,39 @@ TrackerFiltersList::~TrackerFiltersList()
         Utils::Fs::forceRemove(iconPath);
 }
 
-void TrackerFiltersList::addItem(const QString &tracker, const QString &hash)
+void TrackerFiltersList::updateTrackers(const QList<BitTorrent::TrackerEntry> &trackers)
 {
-    QStringList tmp;
-    QListWidgetItem *trackerItem = nullptr;
-    QString host = getHost(tracker);
-    bool exists = m_trackers.contains(host);
-
-    if (exists) {
-        tmp = m_trackers.value(host);
-        if (tmp.contains(hash))
-            return;
-
-        if (host != "") {
-            trackerItem = item(rowFromTracker(host));
-        }
-        else {
-            trackerItem = item(1);
-        }
-    }
-    else {
-        trackerItem = new QListWidgetItem();
-        trackerItem->setData(Qt::DecorationRole, GuiIconProvider::instance()->getIcon("network-server"));
-
-        const QString scheme = getScheme(tracker);
-        downloadFavicon(QString("%1://%2/favicon.ico").arg((scheme.startsWith("http") ? scheme : "http"), host));
-    }
-    if (!trackerItem) return;
-
-    tmp.append(hash);
-    m_trackers.insert(host, tmp);
-    if (host == "") {
-        trackerItem->setText(tr("Trackerless (%1)").arg(tmp.size()));
-        if (currentRow() == 1)
-            applyFilter(1);
-        return;
-    }
-
-    trackerItem->setText(QString("%1 (%2)").arg(host).arg(tmp.size()));
-    if (exists) {
-        if (currentRow() == rowFromTracker(host))
-            applyFilter(currentRow());
-        return;
+    for (const BitTorrent::TrackerEntry &tracker : trackers) {
+        const QString host = BitTorrent::TrackerIndex::hostFromUrl(tracker.url());
+        if (!host.isEmpty())
+            updateHost(host, getScheme(tracker.url()));
     }
+}
 
-    Q_ASSERT(count() >= 4);
-    int insPos = count();
-    for (int i = 4; i < count(); ++i) {
-        if (Utils::String::naturalLessThan<Qt::CaseSensitive>(host, item(i)->text())) {
-            insPos = i;
-            break;
-        }
-    }
-    QListWidget::insertItem(insPos, trackerItem);
-    updateGeometry();
+void TrackerFiltersList::updateTrackerless()
+{
+    const int trackerlessCount = BitTorrent::Session::instance()->trackerIndex().hostTorrentsCount("");
+    item(1)->setText(tr("Trackerless (%1)").arg(trackerlessCount));
+    scheduleFilterUpdate(1);
 }
 
-void TrackerFiltersList::removeItem(const QString &tracker, const QString &hash)
+void TrackerFiltersList::updateTrackerStatuses()
 {
-    QString host = getHost(tracker);
-    QListWidgetItem *trackerItem = nullptr;
-    QStringList tmp = m_trackers.value(host);
-    int row = 0;
+    // Tracker statuses are reported on every announce,
+    // so the filter is updated only when they have changed
+    const BitTorrent::TrackerIndex &trackerIndex = BitTorrent::Session::instance()->trackerIndex();
 
-    if (tmp.empty())
-        return;
-    tmp.removeAll(hash);
-
-    if (!host.isEmpty()) {
-        // Remove from 'Error' and 'Warning' view
-        trackerSuccess(hash, tracker);
-        row = rowFromTracker(host);
-        trackerItem = item(row);
-        if (tmp.empty()) {
-            if (currentRow() == row)
-                setCurrentRow(0, QItemSelectionModel::SelectCurrent);
-            delete trackerItem;
-            m_trackers.remove(host);
-            updateGeometry();
-            return;
-        }
-        if (trackerItem != nullptr)
-            trackerItem->setText(QString("%1 (%2)").arg(host).arg(tmp.size()));
-    }
-    else {
-        row = 1;
-        trackerItem = item(1);
-        trackerItem->setText(tr("Trackerless (%1)").arg(tmp.size()));
+    const QString errorText = tr("Error (%1)").arg(trackerIndex.erroredTorrentsCount());
+    if (item(2)->text() != errorText) {
+        item(2)->setText(errorText);
+        scheduleFilterUpdate(2);
     }
 
-    m_trackers.insert(host, tmp);
-    if (currentRow() == row)
-        applyFilter(row);
-}
-
-void TrackerFiltersList::changeTrackerless(bool trackerless, const QString &hash)
-{
-    if (trackerless)
-        addItem("", hash);
-    else
-        removeItem("", hash);
+    const QString warningText = tr("Warning (%1)").arg(trackerIndex.warnedTorrentsCount());
+    if (item(3)->text() != warningText) {
+        item(3)->setText(warningText);
+        scheduleFilterUpdate(3);
+    }
 }
 
 void TrackerFiltersList::setDownloadTrackerFavicon(bool value)
@@ -330,77 +270,73 @@ void TrackerFiltersList::setDownloadTrackerFavicon(bool value)
     m_downloadTrackerFavicon = value;
 
     if (m_downloadTrackerFavicon) {
-        for (auto i = m_trackers.cbegin(); i != m_trackers.cend(); ++i) {
-            const QString &tracker = i.key();
-            if (!tracker.isEmpty()) {
-                const QString scheme = getScheme(tracker);
-                downloadFavicon(QString("%1://%2/favicon.ico")
-                                .arg((scheme.startsWith("http") ? scheme : "http"), getHost(tracker)));
-             }
-        }
+        for (auto i = m_hostItems.cbegin(); i != m_hostItems.cend(); ++i)
+            downloadFavicon(QString("http://%1/favicon.ico").arg(i.key()));
     }
 }
 
-void TrackerFiltersList::trackerSuccess(const QString &hash, const QString &tracker)
+void TrackerFiltersList::updateHost(const QString &host, const QString &scheme)
 {
-    QStringList errored = m_errors.value(hash);
-    QStringList warned = m_warnings.value(hash);
+    const int torrentsCount = BitTorrent::Session::instance()->trackerIndex().hostTorrentsCount(host);
+    QListWidgetItem *trackerItem = m_hostItems.value(host);
 
-    if (errored.contains(tracker)) {
-        errored.removeAll(tracker);
-        if (errored.empty()) {
-            m_errors.remove(hash);
-            item(2)->setText(tr("Error (%1)").arg(m_errors.size()));
-            if (currentRow() == 2)
-                applyFilter(2);
-        }
-        else {
-            m_errors.insert(hash, errored);
-        }
-    }
+    if (torrentsCount == 0) {
+        if (!trackerItem) return;
 
-    if (warned.contains(tracker)) {
-        warned.removeAll(tracker);
-        if (warned.empty()) {
-            m_warnings.remove(hash);
-            item(3)->setText(tr("Warning (%1)").arg(m_warnings.size()));
-            if (currentRow() == 3)
-                applyFilter(3);
-        }
-        else {
-            m_warnings.insert(hash, warned);
-        }
+        if (currentItem() == trackerItem)
+            setCurrentRow(0, QItemSelectionModel::SelectCurrent);
+        m_hostItems.remove(host);
+        delete trackerItem;
+        updateGeometry();
+        return;
     }
-}
-
-void TrackerFiltersList::trackerError(const QString &hash, const QString &tracker)
-{
-    QStringList trackers = m_errors.value(hash);
 
-    if (trackers.contains(tracker))
+    if (trackerItem) {
+        trackerItem->setText(QString("%1 (%2)").arg(host).arg(torrentsCount));
+        scheduleFilterUpdate(row(trackerItem));
         return;
+    }
 
-    trackers.append(tracker);
-    m_errors.insert(hash, trackers);
-    item(2)->setText(tr("Error (%1)").arg(m_errors.size()));
+    trackerItem = new QListWidgetItem;
+    trackerItem->setData(Qt::DecorationRole, GuiIconProvider::instance()->getIcon("network-server"));
+    trackerItem->setData(Qt::UserRole, host);
+    trackerItem->setText(QString("%1 (%2)").arg(host).arg(torrentsCount));
+
+    // The host items are kept sorted
+    Q_ASSERT(count() >= 4);
+    int first = 4;
+    int last = count();
+    while (first < last) {
+        const int middle = first + ((last - first) / 2);
+        if (Utils::String::naturalLessThan<Qt::CaseSensitive>(host, trackerFromRow(middle)))
+            last = middle;
+        else
+            first = middle + 1;
+    }
+    QListWidget::insertItem(first, trackerItem);
+    m_hostItems.insert(host, trackerItem);
+    updateGeometry();
 
-    if (currentRow() == 2)
-        applyFilter(2);
+    downloadFavicon(QString("%1://%2/favicon.ico").arg((scheme.startsWith("http") ? scheme : "http"), host));
 }
 
-void TrackerFiltersList::trackerWarning(const QString &hash, const QString &tracker)
+void TrackerFiltersList::updateTotalCount()
 {
-    QStringList trackers = m_warnings.value(hash);
-
-    if (trackers.contains(tracker))
-        return;
+    const int torrentsCount = BitTorrent::Session::instance()->torrentIndex().torrentsCount();
+    item(0)->setText(tr("All (%1)", "this is for the tracker filter").arg(torrentsCount));
+}
 
-    trackers.append(tracker);
-    m_warnings.insert(hash, trackers);
-    item(3)->setText(tr("Warning (%1)").arg(m_warnings.size()));
+void TrackerFiltersList::scheduleFilterUpdate(int row)
+{
+    // Many torrents can change at once, the filter is applied once for all of them
+    if ((currentRow() != row) || m_isFilterUpdatePending) return;
 
-    if (currentRow() == 3)
-        applyFilter(3);
+    m_isFilterUpdatePending = true;
+    QTimer::singleShot(0, this, [this]()
+    {
+        m_isFilterUpdatePending = false;
+        applyFilter(currentRow());
+    });
 }
 
 void TrackerFiltersList::downloadFavicon(const QString &url)
@@ -417,16 +353,12 @@ void TrackerFiltersList::downloadFavicon(const QString &url)
 
 void TrackerFiltersList::handleFavicoDownload(const QString &url, const QString &filePath)
 {
-    const QString host = getHost(url);
-
-    if (!m_trackers.contains(host)) {
+    QListWidgetItem *trackerItem = m_hostItems.value(BitTorrent::TrackerIndex::hostFromUrl(url));
+    if (!trackerItem) {
         Utils::Fs::forceRemove(filePath);
         return;
     }
 
-    QListWidgetItem *trackerItem = item(rowFromTracker(host));
-    if (!trackerItem) return;
-
     QIcon icon(filePath);
     //Detect a non-decodable icon
     QList<QSize> sizes = icon.availableSizes();
@@ -479,76 +411,55 @@ void TrackerFiltersList::applyFilter(int row)
 
 void TrackerFiltersList::handleNewTorrent(BitTorrent::TorrentHandle *const torrent)
 {
-    QString hash = torrent->hash();
     const QList<BitTorrent::TrackerEntry> trackers = torrent->trackers();
-    for (const BitTorrent::TrackerEntry &tracker : trackers)
-        addItem(tracker.url(), hash);
-
-    //Check for trackerless torrent
-    if (trackers.size() == 0)
-        addItem("", hash);
+    if (trackers.isEmpty())
+        updateTrackerless();
+    else
+        updateTrackers(trackers);
 
-    item(0)->setText(tr("All (%1)", "this is for the tracker filter").arg(++m_totalTorrents));
+    updateTotalCount();
 }
 
 void TrackerFiltersList::torrentAboutToBeDeleted(BitTorrent::TorrentHandle *const torrent)
 {
-    QString hash = torrent->hash();
+    // The torrent is already removed from the tracker index
     const QList<BitTorrent::TrackerEntry> trackers = torrent->trackers();
-    for (const BitTorrent::TrackerEntry &tracker : trackers)
-        removeItem(tracker.url(), hash);
-
-    //Check for trackerless torrent
-    if (trackers.size() == 0)
-        removeItem("", hash);
+    if (trackers.isEmpty()) {
+        updateTrackerless();
+    }
+    else {
+        updateTrackers(trackers);
+        updateTrackerStatuses();
+    }
 
-    item(0)->setText(tr("All (%1)", "this is for the tracker filter").arg(--m_totalTorrents));
+    updateTotalCount();
 }
 
 QString TrackerFiltersList::trackerFromRow(int row) const
 {
-    Q_ASSERT(row > 1);
-    const QString tracker = item(row)->text();
-    QStringList parts = tracker.split(' ');
-    Q_ASSERT(parts.size() >= 2);
-    parts.removeLast(); // Remove trailing number
-    return parts.join(' ');
+    Q_ASSERT(row > 3);
+    return item(row)->data(Qt::UserRole).toString();
 }
 
-int TrackerFiltersList::rowFromTracker(const QString &tracker) const
+QStringSet TrackerFiltersList::getHashes(int row) const
 {
-    Q_ASSERT(!tracker.isEmpty());
-    for (int i = 4; i<count(); ++i)
-        if (tracker == trackerFromRow(i)) return i;
-    return -1;
-}
+    const BitTorrent::TrackerIndex &trackerIndex = BitTorrent::Session::instance()->trackerIndex();
 
-QString TrackerFiltersList::getHost(const QString &tracker) const
-{
-    QUrl url(tracker);
-    QString longHost = url.host();
-    QString tld = url.topLevelDomain();
-    // We get empty tld when it is invalid or an IPv4/IPv6 address,
-    // so just return the full host
-    if (tld.isEmpty())
-        return longHost;
-    // We want the domain + tld. Subdomains should be disregarded
-    int index = longHost.lastIndexOf('.', -(tld.size() + 1));
-    if (index == -1)
-        return longHost;
-    return longHost.mid(index + 1);
-}
-
-QStringList TrackerFiltersList::getHashes(int row)
-{
+    QSet<BitTorrent::InfoHash> hashes;
     if (row == 1)
-        return m_trackers.value("");
+        hashes = trackerIndex.hostTorrents("");
     else if (row == 2)
-        return m_errors.keys();
+        hashes = trackerIndex.erroredTorrents();
     else if (row == 3)
-        return m_warnings.keys();
+        hashes = trackerIndex.warnedTorrents();
     else
-        return m_trackers.value(trackerFromRow(row));
+        hashes = trackerIndex.hostTorrents(trackerFromRow(row));
+
+    QStringSet result;
+    result.reserve(hashes.size());
+    for (const BitTorrent::InfoHash &hash : asConst(hashes))
+        result.insert(hash);
+    return result;
 }
 
 TransferListFiltersWidget::TransferListFiltersWidget(QWidget *parent, TransferListWidget *transferList)
@@ -639,13 +550,6 @@ TransferListFiltersWidget::TransferListFiltersWidget(QWidget *parent, TransferLi
     connect(trackerLabel, &QCheckBox::toggled, m_trackerFilters, &TrackerFiltersList::toggleFilter);
     connect(trackerLabel, &QCheckBox::toggled, pref, &Preferences::setTrackerFilterState);
 
-    using Func = void (TransferListFiltersWidget::*)(const QString&, const QString&);
-    connect(this, static_cast<Func>(&TransferListFiltersWidget::trackerSuccess)
-            , m_trackerFilters, &TrackerFiltersList::trackerSuccess);
-    connect(this, static_cast<Func>(&TransferListFiltersWidget::trackerError)
-            , m_trackerFilters, &TrackerFiltersList::trackerError);
-    connect(this, static_cast<Func>(&TransferListFiltersWidget::trackerWarning)
-            , m_trackerFilters, &TrackerFiltersList::trackerWarning);
 }
 
 void TransferListFiltersWidget::setDownloadTrackerFavicon(bool value)
@@ -653,36 +557,35 @@ void TransferListFiltersWidget::setDownloadTrackerFavicon(bool value)
     m_trackerFilters->setDownloadTrackerFavicon(value);
 }
 
-void TransferListFiltersWidget::addTrackers(BitTorrent::TorrentHandle *const torrent, const QList<BitTorrent::TrackerEntry> &trackers)
+void TransferListFiltersWidget::addTrackers(BitTorrent::TorrentHandle *const, const QList<BitTorrent::TrackerEntry> &trackers)
 {
-    for (const BitTorrent::TrackerEntry &tracker : trackers)
-        m_trackerFilters->addItem(tracker.url(), torrent->hash());
+    m_trackerFilters->updateTrackers(trackers);
 }
 
-void TransferListFiltersWidget::removeTrackers(BitTorrent::TorrentHandle *const torrent, const QList<BitTorrent::TrackerEntry> &trackers)
+void TransferListFiltersWidget::removeTrackers(BitTorrent::TorrentHandle *const, const QList<BitTorrent::TrackerEntry> &trackers)
 {
-    for (const BitTorrent::TrackerEntry &tracker : trackers)
-        m_trackerFilters->removeItem(tracker.url(), torrent->hash());
+    m_trackerFilters->updateTrackers(trackers);
+    m_trackerFilters->updateTrackerStatuses();
 }
 
-void TransferListFiltersWidget::changeTrackerless(BitTorrent::TorrentHandle *const torrent, bool trackerless)
+void TransferListFiltersWidget::changeTrackerless(BitTorrent::TorrentHandle *const, bool)
 {
-    m_trackerFilters->changeTrackerless(trackerless, torrent->hash());
+    m_trackerFilters->updateTrackerless();
 }
 
-void TransferListFiltersWidget::trackerSuccess(BitTorrent::TorrentHandle *const torrent, const QString &tracker)
+void TransferListFiltersWidget::trackerSuccess(BitTorrent::TorrentHandle *const, const QString &)
 {
-    emit trackerSuccess(torrent->hash(), tracker);
+    m_trackerFilters->updateTrackerStatuses();
 }
 
-void TransferListFiltersWidget::trackerWarning(BitTorrent::TorrentHandle *const torrent, const QString &tracker)
+void TransferListFiltersWidget::trackerWarning(BitTorrent::TorrentHandle *const, const QString &)
 {
-    emit trackerWarning(torrent->hash(), tracker);
+    m_trackerFilters->updateTrackerStatuses();
 }
 
-void TransferListFiltersWidget::trackerError(BitTorrent::TorrentHandle *const torrent, const QString &tracker)
+void TransferListFiltersWidget::trackerError(BitTorrent::TorrentHandle *const, const QString &)
 {
-    emit trackerError(torrent->hash(), tracker);
+    m_trackerFilters->updateTrackerStatuses();
 }
 
 void TransferListFiltersWidget::onCategoryFilterStateChanged(bool enabled)
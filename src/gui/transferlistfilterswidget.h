@@ -31,6 +31,9 @@
 
 #include <QFrame>
 #include <QListWidget>
+#include <QVector>
+
+#include "base/torrentfilter.h"
 
 class QCheckBox;
 class QResizeEvent;
@@ -63,6 +66,9 @@ private slots:
     virtual void applyFilter(int row) = 0;
     virtual void handleNewTorrent(BitTorrent::TorrentHandle *const) = 0;
     virtual void torrentAboutToBeDeleted(BitTorrent::TorrentHandle *const) = 0;
+
+private:
+    void handleTorrentsAboutToBeRemoved(const QVector<BitTorrent::TorrentHandle *> &torrents);
 };
 
 class StatusFilterWidget : public BaseFilterWidget
@@ -93,17 +99,12 @@ public:
     TrackerFiltersList(QWidget *parent, TransferListWidget *transferList);
     ~TrackerFiltersList() override;
 
-    // Redefine addItem() to make sure the list stays sorted
-    void addItem(const QString &tracker, const QString &hash);
-    void removeItem(const QString &tracker, const QString &hash);
-    void changeTrackerless(bool trackerless, const QString &hash);
+    // Updates the items of the tracker hosts from the session tracker index
+    void updateTrackers(const QList<BitTorrent::TrackerEntry> &trackers);
+    void updateTrackerless();
+    void updateTrackerStatuses();
     void setDownloadTrackerFavicon(bool value);
 
-public slots:
-    void trackerSuccess(const QString &hash, const QString &tracker);
-    void trackerError(const QString &hash, const QString &tracker);
-    void trackerWarning(const QString &hash, const QString &tracker);
-
 private slots:
     void handleFavicoDownload(const QString &url, const QString &filePath);
     void handleFavicoFailure(const QString &url, const QString &error);
@@ -115,18 +116,17 @@ private:
     void applyFilter(int row) override;
     void handleNewTorrent(BitTorrent::TorrentHandle *const torrent) override;
     void torrentAboutToBeDeleted(BitTorrent::TorrentHandle *const torrent) override;
+    void updateHost(const QString &host, const QString &scheme);
+    void updateTotalCount();
+    void scheduleFilterUpdate(int row);
     QString trackerFromRow(int row) const;
-    int rowFromTracker(const QString &tracker) const;
-    QString getHost(const QString &tracker) const;
-    QStringList getHashes(int row);
+    QStringSet getHashes(int row) const;
     void downloadFavicon(const QString &url);
 
-    QHash<QString, QStringList> m_trackers;
-    QHash<QString, QStringList> m_errors;
-    QHash<QString, QStringList> m_warnings;
+    QHash<QString, QListWidgetItem *> m_hostItems;
     QStringList m_iconPaths;
-    int m_totalTorrents;
     bool m_downloadTrackerFavicon;
+    bool m_isFilterUpdatePending;
 };
 
 class CategoryFilterWidget;
@@ -148,11 +148,6 @@ public slots:
     void trackerWarning(BitTorrent::TorrentHandle *const torrent, const QString &tracker);
     void trackerError(BitTorrent::TorrentHandle *const torrent, const QString &tracker);
 
-signals:
-    void trackerSuccess(const QString &hash, const QString &tracker);
-    void trackerError(const QString &hash, const QString &tracker);
-    void trackerWarning(const QString &hash, const QString &tracker);
-
 private slots:
     void onCategoryFilterStateChanged(bool enabled);
     void onTagFilterStateChanged(bool enabled);
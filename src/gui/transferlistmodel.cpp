@@ -33,6 +33,7 @@
 #include <QDebug>
 #include <QIcon>
 #include <QPalette>
+#include <QSet>
 
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
@@ -67,14 +68,9 @@ TransferListModel::TransferListModel(QObject *parent)
 
     // Listen for torrent changes
     connect(Session::instance(), &Session::torrentAdded, this, &TransferListModel::addTorrent);
-    connect(Session::instance(), &Session::torrentAboutToBeRemoved, this, &TransferListModel::handleTorrentAboutToBeRemoved);
+    connect(Session::instance(), &Session::torrentsAboutToBeRemoved, this, &TransferListModel::handleTorrentsAboutToBeRemoved);
     connect(Session::instance(), &Session::torrentsUpdated, this, &TransferListModel::handleTorrentsUpdated);
-
-    connect(Session::instance(), &Session::torrentFinished, this, &TransferListModel::handleTorrentStatusUpdated);
-    connect(Session::instance(), &Session::torrentMetadataLoaded, this, &TransferListModel::handleTorrentStatusUpdated);
-    connect(Session::instance(), &Session::torrentResumed, this, &TransferListModel::handleTorrentStatusUpdated);
-    connect(Session::instance(), &Session::torrentPaused, this, &TransferListModel::handleTorrentStatusUpdated);
-    connect(Session::instance(), &Session::torrentFinishedChecking, this, &TransferListModel::handleTorrentStatusUpdated);
+    connect(Session::instance(), &Session::torrentsChanged, this, &TransferListModel::handleTorrentsChanged);
 }
 
 int TransferListModel::rowCount(const QModelIndex &index) const
@@ -185,6 +181,9 @@ QVariant TransferListModel::data(const QModelIndex &index, int role) const
     case TR_PROGRESS:
         return torrent->progress();
     case TR_STATUS:
+        // The secondary value is the position in the queue of the rechecks and moves
+        if (role == Qt::UserRole)
+            return BitTorrent::Session::instance()->storageJobScheduler()->queuePosition(torrent->hash());
         return QVariant::fromValue(torrent->state());
     case TR_SEEDS:
         return (role == Qt::DisplayRole) ? torrent->seedsCount() : torrent->totalSeedsCount();
@@ -295,21 +294,62 @@ BitTorrent::TorrentHandle *TransferListModel::torrentHandle(const QModelIndex &i
     return m_torrents.value(index.row());
 }
 
-void TransferListModel::handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent)
+void TransferListModel::handleTorrentsAboutToBeRemoved(const QVector<BitTorrent::TorrentHandle *> &torrents)
 {
-    const int row = m_torrents.indexOf(torrent);
-    if (row >= 0) {
-        beginRemoveRows(QModelIndex(), row, row);
-        m_torrents.removeAt(row);
+    if (torrents.size() == 1) {
+        const int row = m_torrents.indexOf(torrents.first());
+        if (row >= 0) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_torrents.removeAt(row);
+            endRemoveRows();
+        }
+        return;
+    }
+
+    // Find all the removed rows in a single pass and remove them
+    // by ranges of adjacent rows, starting from the end
+    const QSet<BitTorrent::TorrentHandle *> removedTorrents = torrents.toList().toSet();
+    int row = m_torrents.size() - 1;
+    while (row >= 0) {
+        if (!removedTorrents.contains(m_torrents[row])) {
+            --row;
+            continue;
+        }
+
+        const int lastRow = row;
+        while ((row > 0) && removedTorrents.contains(m_torrents[row - 1]))
+            --row;
+
+        beginRemoveRows(QModelIndex(), row, lastRow);
+        m_torrents.erase((m_torrents.begin() + row), (m_torrents.begin() + lastRow + 1));
         endRemoveRows();
+        --row;
     }
 }
 
-void TransferListModel::handleTorrentStatusUpdated(BitTorrent::TorrentHandle *const torrent)
+void TransferListModel::handleTorrentsChanged(const QVector<BitTorrent::TorrentHandle *> &torrents)
 {
-    const int row = m_torrents.indexOf(torrent);
-    if (row >= 0)
-        emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+    if (torrents.size() == 1) {
+        const int row = m_torrents.indexOf(torrents.first());
+        if (row >= 0)
+            emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+        return;
+    }
+
+    // Find all the affected rows in a single pass
+    const QSet<BitTorrent::TorrentHandle *> changedTorrents = torrents.toList().toSet();
+    int firstRow = -1;
+    int lastRow = -1;
+    for (int row = 0; row < m_torrents.size(); ++row) {
+        if (!changedTorrents.contains(m_torrents[row])) continue;
+
+        if (firstRow < 0)
+            firstRow = row;
+        lastRow = row;
+    }
+
+    if (firstRow >= 0)
+        emit dataChanged(index(firstRow, 0), index(lastRow, columnCount() - 1));
 }
 
 void TransferListModel::handleTorrentsUpdated()
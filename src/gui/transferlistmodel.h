@@ -32,6 +32,7 @@
 
 #include <QAbstractListModel>
 #include <QList>
+#include <QVector>
 
 namespace BitTorrent
 {
@@ -94,8 +95,8 @@ public:
 
 private slots:
     void addTorrent(BitTorrent::TorrentHandle *const torrent);
-    void handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent);
-    void handleTorrentStatusUpdated(BitTorrent::TorrentHandle *const torrent);
+    void handleTorrentsAboutToBeRemoved(const QVector<BitTorrent::TorrentHandle *> &torrents);
+    void handleTorrentsChanged(const QVector<BitTorrent::TorrentHandle *> &torrents);
     void handleTorrentsUpdated();
 
 private:
@@ -71,9 +71,9 @@ void TransferListSortModel::disableTagFilter()
         invalidateFilter();
 }
 
-void TransferListSortModel::setTrackerFilter(const QStringList &hashes)
+void TransferListSortModel::setTrackerFilter(const QStringSet &hashes)
 {
-    if (m_filter.setHashSet(hashes.toSet()))
+    if (m_filter.setHashSet(hashes))
         invalidateFilter();
 }
 
@@ -31,6 +31,7 @@
 #include <QClipboard>
 #include <QDebug>
 #include <QFileDialog>
+#include <QMap>
 #include <QMenu>
 #include <QMessageBox>
 #include <QRegExp>
@@ -402,6 +403,18 @@ QList<BitTorrent::TorrentHandle *> TransferListWidget::getSelectedTorrents() con
     return torrents;
 }
 
+QList<BitTorrent::TorrentHandle *> TransferListWidget::getVisibleTorrents() const
+{
+    QList<BitTorrent::TorrentHandle *> torrents;
+    for (int i = 0; i < m_sortFilterModel->rowCount(); ++i) {
+        BitTorrent::TorrentHandle *const torrent = m_listModel->torrentHandle(mapToSource(m_sortFilterModel->index(i, 0)));
+        if (torrent)
+            torrents << torrent;
+    }
+
+    return torrents;
+}
+
 void TransferListWidget::setSelectedTorrentsLocation()
 {
     const QList<BitTorrent::TorrentHandle *> torrents = getSelectedTorrents();
@@ -427,50 +440,41 @@ void TransferListWidget::setSelectedTorrentsLocation()
 
 void TransferListWidget::pauseAllTorrents()
 {
-    for (BitTorrent::TorrentHandle *const torrent : asConst(BitTorrent::Session::instance()->torrents()))
-        torrent->pause();
+    BitTorrent::Session::instance()->applyToTorrents(extractHashes(BitTorrent::Session::instance()->torrents().values())
+        , [](BitTorrent::TorrentHandle *const torrent) { torrent->pause(); });
 }
 
 void TransferListWidget::resumeAllTorrents()
 {
-    for (BitTorrent::TorrentHandle *const torrent : asConst(BitTorrent::Session::instance()->torrents()))
-        torrent->resume();
+    BitTorrent::Session::instance()->applyToTorrents(extractHashes(BitTorrent::Session::instance()->torrents().values())
+        , [](BitTorrent::TorrentHandle *const torrent) { torrent->resume(); });
 }
 
 void TransferListWidget::startSelectedTorrents()
 {
-    for (BitTorrent::TorrentHandle *const torrent : asConst(getSelectedTorrents()))
-        torrent->resume();
+    applyToSelectedTorrents([](BitTorrent::TorrentHandle *const torrent) { torrent->resume(); });
 }
 
 void TransferListWidget::forceStartSelectedTorrents()
 {
-    for (BitTorrent::TorrentHandle *const torrent : asConst(getSelectedTorrents()))
-        torrent->resume(true);
+    applyToSelectedTorrents([](BitTorrent::TorrentHandle *const torrent) { torrent->resume(true); });
 }
 
 void TransferListWidget::startVisibleTorrents()
 {
-    for (int i = 0; i < m_sortFilterModel->rowCount(); ++i) {
-        BitTorrent::TorrentHandle *const torrent = m_listModel->torrentHandle(mapToSource(m_sortFilterModel->index(i, 0)));
-        if (torrent)
-            torrent->resume();
-    }
+    BitTorrent::Session::instance()->applyToTorrents(extractHashes(getVisibleTorrents())
+        , [](BitTorrent::TorrentHandle *const torrent) { torrent->resume(); });
 }
 
 void TransferListWidget::pauseSelectedTorrents()
 {
-    for (BitTorrent::TorrentHandle *const torrent : asConst(getSelectedTorrents()))
-        torrent->pause();
+    applyToSelectedTorrents([](BitTorrent::TorrentHandle *const torrent) { torrent->pause(); });
 }
 
 void TransferListWidget::pauseVisibleTorrents()
 {
-    for (int i = 0; i < m_sortFilterModel->rowCount(); ++i) {
-        BitTorrent::TorrentHandle *const torrent = m_listModel->torrentHandle(mapToSource(m_sortFilterModel->index(i, 0)));
-        if (torrent)
-            torrent->pause();
-    }
+    BitTorrent::Session::instance()->applyToTorrents(extractHashes(getVisibleTorrents())
+        , [](BitTorrent::TorrentHandle *const torrent) { torrent->pause(); });
 }
 
 void TransferListWidget::softDeleteSelectedTorrents()
@@ -493,25 +497,21 @@ void TransferListWidget::deleteSelectedTorrents(bool deleteLocalFiles)
     if (Preferences::instance()->confirmTorrentDeletion()
         && !DeletionConfirmationDialog::askForDeletionConfirmation(this, deleteLocalFiles, torrents.size(), torrents[0]->name()))
         return;
-    for (BitTorrent::TorrentHandle *const torrent : torrents)
-        BitTorrent::Session::instance()->deleteTorrent(torrent->hash(), deleteLocalFiles);
+    BitTorrent::Session::instance()->deleteTorrents(extractHashes(torrents), deleteLocalFiles);
 }
 
 void TransferListWidget::deleteVisibleTorrents()
 {
     if (m_sortFilterModel->rowCount() <= 0) return;
 
-    QList<BitTorrent::TorrentHandle *> torrents;
-    for (int i = 0; i < m_sortFilterModel->rowCount(); ++i)
-        torrents << m_listModel->torrentHandle(mapToSource(m_sortFilterModel->index(i, 0)));
+    const QList<BitTorrent::TorrentHandle *> torrents = getVisibleTorrents();
 
     bool deleteLocalFiles = false;
     if (Preferences::instance()->confirmTorrentDeletion()
         && !DeletionConfirmationDialog::askForDeletionConfirmation(this, deleteLocalFiles, torrents.size(), torrents[0]->name()))
         return;
 
-    for (BitTorrent::TorrentHandle *const torrent : asConst(torrents))
-        BitTorrent::Session::instance()->deleteTorrent(torrent->hash(), deleteLocalFiles);
+    BitTorrent::Session::instance()->deleteTorrents(extractHashes(torrents), deleteLocalFiles);
 }
 
 void TransferListWidget::increasePrioSelectedTorrents()
@@ -707,6 +707,27 @@ void TransferListWidget::recheckSelectedTorrents()
         torrent->forceRecheck();
 }
 
+void TransferListWidget::cancelSelectedStorageJobs()
+{
+    BitTorrent::Session::instance()->cancelStorageJobs(extractHashes(getSelectedTorrents()));
+}
+
+void TransferListWidget::topStorageJobSelectedTorrents()
+{
+    BitTorrent::Session *const session = BitTorrent::Session::instance();
+
+    // the last queued goes first so that the selected jobs keep their order
+    QMap<int, BitTorrent::InfoHash> queuedTorrents;
+    for (BitTorrent::TorrentHandle *const torrent : asConst(getSelectedTorrents())) {
+        const int position = session->storageJobScheduler()->queuePosition(torrent->hash());
+        if (position >= 0)
+            queuedTorrents.insert(position, torrent->hash());
+    }
+
+    for (auto i = queuedTorrents.cend(); i != queuedTorrents.cbegin();)
+        session->setStorageJobQueuePosition((--i).value(), 0);
+}
+
 void TransferListWidget::reannounceSelectedTorrents()
 {
     for (BitTorrent::TorrentHandle *const torrent : asConst(getSelectedTorrents()))
@@ -828,11 +849,7 @@ QStringList TransferListWidget::askTagsForSelection(const QString &dialogTitle)
 
 void TransferListWidget::applyToSelectedTorrents(const std::function<void (BitTorrent::TorrentHandle *const)> &fn)
 {
-    for (const QModelIndex &index : asConst(selectionModel()->selectedRows())) {
-        BitTorrent::TorrentHandle *const torrent = m_listModel->torrentHandle(mapToSource(index));
-        Q_ASSERT(torrent);
-        fn(torrent);
-    }
+    BitTorrent::Session::instance()->applyToTorrents(extractHashes(getSelectedTorrents()), fn);
 }
 
 void TransferListWidget::renameSelectedTorrent()
@@ -856,8 +873,7 @@ void TransferListWidget::renameSelectedTorrent()
 
 void TransferListWidget::setSelectionCategory(QString category)
 {
-    for (const QModelIndex &index : asConst(selectionModel()->selectedRows()))
-        m_listModel->setData(m_listModel->index(mapToSource(index).row(), TransferListModel::TR_CATEGORY), category, Qt::DisplayRole);
+    applyToSelectedTorrents([&category](BitTorrent::TorrentHandle *const torrent) { torrent->setCategory(category); });
 }
 
 void TransferListWidget::addSelectionTag(const QString &tag)
@@ -913,6 +929,10 @@ void TransferListWidget::displayListMenu(const QPoint&)
     connect(&actionForceRecheck, &QAction::triggered, this, &TransferListWidget::recheckSelectedTorrents);
     QAction actionForceReannounce(GuiIconProvider::instance()->getIcon("document-edit-verify"), tr("Force reannounce"), nullptr);
     connect(&actionForceReannounce, &QAction::triggered, this, &TransferListWidget::reannounceSelectedTorrents);
+    QAction actionCancelStorageJobs(GuiIconProvider::instance()->getIcon("edit-delete"), tr("Cancel queued check or move"), nullptr);
+    connect(&actionCancelStorageJobs, &QAction::triggered, this, &TransferListWidget::cancelSelectedStorageJobs);
+    QAction actionTopStorageJob(GuiIconProvider::instance()->getIcon("go-top"), tr("Check or move first", "i.e. Move to top of the disk jobs queue"), nullptr);
+    connect(&actionTopStorageJob, &QAction::triggered, this, &TransferListWidget::topStorageJobSelectedTorrents);
     QAction actionCopyMagnetLink(GuiIconProvider::instance()->getIcon("kt-magnet"), tr("Copy magnet link"), nullptr);
     connect(&actionCopyMagnetLink, &QAction::triggered, this, &TransferListWidget::copySelectedMagnetURIs);
     QAction actionCopyName(GuiIconProvider::instance()->getIcon("edit-copy"), tr("Copy name"), nullptr);
@@ -946,6 +966,7 @@ void TransferListWidget::displayListMenu(const QPoint&)
     bool allSameCategory = true;
     bool allSameAutoTMM = true;
     bool firstAutoTMM = false;
+    bool oneHasQueuedStorageJob = false;
     QString firstCategory;
     bool first = true;
     QSet<QString> tagsInAny;
@@ -1009,12 +1030,15 @@ void TransferListWidget::displayListMenu(const QPoint&)
             needsPause = true;
         if (torrent->hasMetadata())
             needsPreview = true;
+        if (BitTorrent::Session::instance()->storageJobScheduler()->queuePosition(torrent->hash()) >= 0)
+            oneHasQueuedStorageJob = true;
 
         first = false;
 
         if (oneHasMetadata && oneNotSeed && !allSameSequentialDownloadMode
             && !allSamePrioFirstlast && !allSameSuperSeeding && !allSameCategory
-            && needsStart && needsForce && needsPause && needsPreview && !allSameAutoTMM) {
+            && needsStart && needsForce && needsPause && needsPreview && !allSameAutoTMM
+            && oneHasQueuedStorageJob) {
             break;
         }
     }
@@ -1115,6 +1139,11 @@ void TransferListWidget::displayListMenu(const QPoint&)
         listMenu.addAction(&actionForceReannounce);
         listMenu.addSeparator();
     }
+    if (oneHasQueuedStorageJob) {
+        listMenu.addAction(&actionTopStorageJob);
+        listMenu.addAction(&actionCancelStorageJobs);
+        listMenu.addSeparator();
+    }
     listMenu.addAction(&actionOpenDestinationFolder);
     if (BitTorrent::Session::instance()->isQueueingSystemEnabled() && oneNotSeed) {
         listMenu.addSeparator();
@@ -1194,7 +1223,7 @@ void TransferListWidget::applyTrackerFilterAll()
     m_sortFilterModel->disableTrackerFilter();
 }
 
-void TransferListWidget::applyTrackerFilter(const QStringList &hashes)
+void TransferListWidget::applyTrackerFilter(const QSet<QString> &hashes)
 {
     m_sortFilterModel->setTrackerFilter(hashes);
 }
@@ -30,6 +30,7 @@
 #define TRANSFERLISTWIDGET_H
 
 #include <functional>
+#include <QSet>
 #include <QTreeView>
 
 namespace BitTorrent
@@ -82,6 +83,8 @@ public slots:
     void openSelectedTorrentsFolder() const;
     void recheckSelectedTorrents();
     void reannounceSelectedTorrents();
+    void cancelSelectedStorageJobs();
+    void topStorageJobSelectedTorrents();
     void setDlLimitSelectedTorrents();
     void setUpLimitSelectedTorrents();
     void setMaxRatioSelectedTorrents();
@@ -93,7 +96,7 @@ public slots:
     void applyCategoryFilter(QString category);
     void applyTagFilter(const QString &tag);
     void applyTrackerFilterAll();
-    void applyTrackerFilter(const QStringList &hashes);
+    void applyTrackerFilter(const QSet<QString> &hashes);
     void previewFile(QString filePath);
     void renameSelectedTorrent();
 
@@ -102,6 +105,7 @@ protected:
     QModelIndex mapFromSource(const QModelIndex &index) const;
     bool loadSettings();
     QList<BitTorrent::TorrentHandle *> getSelectedTorrents() const;
+    QList<BitTorrent::TorrentHandle *> getVisibleTorrents() const;
 
 protected slots:
     void torrentDoubleClicked();
@@ -0,0 +1,206 @@
+#VERSION: 1.02
+
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+#    * Redistributions of source code must retain the above copyright notice,
+#      this list of conditions and the following disclaimer.
+#    * Redistributions in binary form must reproduce the above copyright
+#      notice, this list of conditions and the following disclaimer in the
+#      documentation and/or other materials provided with the distribution.
+#    * Neither the name of the author nor the names of its contributors may be
+#      used to endorse or promote products derived from this software without
+#      specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+# Persistent search worker: engines are imported once and searches are
+# served until stdin is closed.
+#
+# Requests (stdin) and messages (stdout) are JSON objects, one per line:
+#   -> {"op": "search", "id": 1, "engines": "all", "category": "all", "query": "ubuntu iso"}
+#   -> {"op": "cancel", "id": 1}
+#   <- {"type": "ready", "engines": ["engine1", "engine2"]}
+#   <- {"type": "result", "id": 1, "result": {"link": ..., "name": ..., "size": ..., ...}}
+#   <- {"type": "finished", "id": 1, "ok": true}
+# No more messages are sent for a search once it is cancelled.
+
+import io
+import json
+import os
+import sys
+import threading
+import urllib.parse
+from concurrent.futures import ThreadPoolExecutor
+
+import nova2
+import novaprinter
+
+# searches spend most of their time waiting for the network
+MAX_THREADS = max(4, 2 * (os.cpu_count() or 1))
+
+RESULT_KEYS = ('link', 'name', 'size', 'seeds', 'leech', 'engine_url', 'desc_link')
+
+output = io.open(sys.stdout.fileno(), 'w', encoding='utf-8', closefd=False)
+output_lock = threading.Lock()
+
+searches = {}
+# url -> searches running that engine, protected by searches_lock
+engine_searches = {}
+searches_lock = threading.Lock()
+current = threading.local()
+
+
+class Search:
+    def __init__(self, search_id, pending_engines):
+        self.id = search_id
+        self.pending_engines = pending_engines
+        self.cancelled = False
+
+
+def send(message):
+    line = json.dumps(message, ensure_ascii=False)
+    with output_lock:
+        output.write(line)
+        output.write('\n')
+        output.flush()
+
+
+def find_engine_search(engine_url):
+    """ Fallback for the threads started by the engines themselves, which don't
+        carry a search: the engine identifies the search as long as a single
+        one is running it """
+    with searches_lock:
+        running = engine_searches.get(engine_url, [])
+        return running[0] if len(running) == 1 else None
+
+
+def on_result(dictionary):
+    search = getattr(current, 'search', None)
+    if search is None:
+        search = find_engine_search(dictionary.get('engine_url'))
+        if search is None:
+            print("Dropped a result of %s: unknown search" % dictionary.get('engine_url'), file=sys.stderr)
+            return
+    if search.cancelled:
+        return
+
+    result = {key: str(dictionary[key]) for key in RESULT_KEYS if key in dictionary}
+    send({'type': 'result', 'id': search.id, 'result': result})
+
+
+def finish_search(search, ok):
+    with searches_lock:
+        if searches.pop(search.id, None) is None:
+            return
+    send({'type': 'finished', 'id': search.id, 'ok': ok})
+
+
+def run_engine(search, engine_class, what, cat):
+    # the pool threads are the ones the worker starts, they carry the search they run
+    current.search = search
+    threading.current_thread().name = "search-%s-%s" % (search.id, engine_class.__name__)
+    engine_url = getattr(engine_class, 'url', None)
+    with searches_lock:
+        engine_searches.setdefault(engine_url, []).append(search)
+    try:
+        if not search.cancelled:
+            engine = engine_class()
+            # avoid exceptions due to invalid category
+            if hasattr(engine, 'supported_categories'):
+                if cat in engine.supported_categories:
+                    engine.search(what, cat)
+            else:
+                engine.search(what)
+    except Exception as e:
+        print("Engine %s failed: %s" % (engine_class.__name__, e), file=sys.stderr)
+    finally:
+        current.search = None
+        threading.current_thread().name = "search-idle"
+        with searches_lock:
+            engine_searches[engine_url].remove(search)
+            if not engine_searches[engine_url]:
+                del engine_searches[engine_url]
+
+    with searches_lock:
+        search.pending_engines -= 1
+        done = (search.pending_engines == 0)
+    if done:
+        finish_search(search, True)
+
+
+def start_search(executor, supported_engines, request):
+    search_id = request.get('id')
+    engines_list = set(e.lower() for e in request.get('engines', '').strip().split(','))
+    if 'all' in engines_list:
+        engines_list = supported_engines
+    else:
+        # discard un-supported engines
+        engines_list = [engine for engine in engines_list
+                        if engine in supported_engines]
+
+    search = Search(search_id, len(engines_list))
+    with searches_lock:
+        searches[search_id] = search
+
+    cat = request.get('category', '').lower()
+    if cat not in nova2.CATEGORIES:
+        finish_search(search, False)
+        return
+
+    if not engines_list:
+        # engine list is empty. Nothing to do here
+        finish_search(search, True)
+        return
+
+    what = urllib.parse.quote(request.get('query', ''))
+    for engine in engines_list:
+        executor.submit(run_engine, search, getattr(nova2, engine), what, cat)
+
+
+def cancel_search(search_id):
+    with searches_lock:
+        search = searches.pop(search_id, None)
+    if search is not None:
+        search.cancelled = True
+
+
+def main():
+    supported_engines = nova2.initialize_engines()
+
+    # stray prints of the engines must not corrupt the protocol
+    sys.stdout = sys.stderr
+    novaprinter.result_sink = on_result
+
+    executor = ThreadPoolExecutor(max_workers=MAX_THREADS)
+    send({'type': 'ready', 'engines': supported_engines})
+
+    for line in io.open(sys.stdin.fileno(), 'r', encoding='utf-8', closefd=False):
+        try:
+            request = json.loads(line)
+        except ValueError:
+            continue
+
+        op = request.get('op')
+        if op == 'search':
+            start_search(executor, supported_engines, request)
+        elif op == 'cancel':
+            cancel_search(request.get('id'))
+
+    # don't wait for the engines still running cancelled searches
+    output.flush()
+    os._exit(0)
+
+
+if __name__ == "__main__":
+    main()
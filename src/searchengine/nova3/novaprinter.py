@@ -1,4 +1,4 @@
-#VERSION: 1.46
+#VERSION: 1.47
 
 # Redistribution and use in source and binary forms, with or without
 # modification, are permitted provided that the following conditions are met:
@@ -24,9 +24,17 @@
 # ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 # POSSIBILITY OF SUCH DAMAGE.
 
+# When set, results are passed to this callable instead of being printed
+# (used by the persistent search worker)
+result_sink = None
+
 
 def prettyPrinter(dictionary):
     dictionary['size'] = anySizeToBytes(dictionary['size'])
+    if result_sink is not None:
+        result_sink(dictionary)
+        return
+
     outtext = "|".join((dictionary["link"], dictionary["name"].replace("|", " "),
                         str(dictionary["size"]), str(dictionary["seeds"]),
                         str(dictionary["leech"]), dictionary["engine_url"]))
@@ -33,6 +33,11 @@
 
 #include "apierror.h"
 
+namespace
+{
+    quint64 lastDeferredResultId = 0;
+}
+
 APIController::APIController(ISessionManager *sessionManager, QObject *parent)
     : QObject {parent}
     , m_sessionManager {sessionManager}
@@ -52,6 +57,17 @@ QVariant APIController::run(const QString &action, const StringMap &params, cons
     return m_result;
 }
 
+QVariant APIController::resume(const StringMap &params, const Continuation &continuation)
+{
+    m_result.clear(); // clear result
+    m_params = params;
+    m_data.clear();
+
+    continuation();
+
+    return m_result;
+}
+
 ISessionManager *APIController::sessionManager() const
 {
     return m_sessionManager;
@@ -80,6 +96,11 @@ void APIController::setResult(const QString &result)
     m_result = result;
 }
 
+void APIController::setResult(const QByteArray &result, const QString &mimeType)
+{
+    m_result = QVariant::fromValue(DataAPIResult {result, mimeType});
+}
+
 void APIController::setResult(const QJsonArray &result)
 {
     m_result = QJsonDocument(result);
@@ -89,3 +110,15 @@ void APIController::setResult(const QJsonObject &result)
 {
     m_result = QJsonDocument(result);
 }
+
+quint64 APIController::deferResult()
+{
+    const quint64 id = ++lastDeferredResultId;
+    m_result = QVariant::fromValue(DeferredAPIResult {id});
+    return id;
+}
+
+void APIController::finishDeferredResult(const quint64 id, const Continuation &continuation)
+{
+    emit deferredResultReady(id, continuation);
+}
@@ -28,6 +28,9 @@
 
 #pragma once
 
+#include <functional>
+
+#include <QByteArray>
 #include <QMap>
 #include <QObject>
 #include <QSet>
@@ -38,6 +41,21 @@ struct ISessionManager;
 using StringMap = QMap<QString, QString>;
 using DataMap = QMap<QString, QByteArray>;
 
+// The result of an action that finishes later, see APIController::deferResult()
+struct DeferredAPIResult
+{
+    quint64 id;
+};
+Q_DECLARE_METATYPE(DeferredAPIResult)
+
+// Raw data along with its MIME type, e.g. a file
+struct DataAPIResult
+{
+    QByteArray data;
+    QString mimeType;
+};
+Q_DECLARE_METATYPE(DataAPIResult)
+
 class APIController : public QObject
 {
     Q_OBJECT
@@ -49,21 +67,35 @@ class APIController : public QObject
 #endif
 
 public:
+    // The rest of a deferred action, it sets the result or throws APIError as the action itself does
+    using Continuation = std::function<void ()>;
+
     explicit APIController(ISessionManager *sessionManager, QObject *parent = nullptr);
 
     QVariant run(const QString &action, const StringMap &params, const DataMap &data = {});
+    // Runs the continuation of a deferred action in the context of its request
+    QVariant resume(const StringMap &params, const Continuation &continuation);
 
     ISessionManager *sessionManager() const;
 
+signals:
+    void deferredResultReady(quint64 id, const APIController::Continuation &continuation);
+
 protected:
     const StringMap &params() const;
     const DataMap &data() const;
     void checkParams(const QSet<QString> &requiredParams) const;
 
     void setResult(const QString &result);
+    void setResult(const QByteArray &result, const QString &mimeType);
     void setResult(const QJsonArray &result);
     void setResult(const QJsonObject &result);
 
+    // Lets the running action return before its result is known. The request is
+    // answered once the returned id is passed to finishDeferredResult().
+    quint64 deferResult();
+    void finishDeferredResult(quint64 id, const Continuation &continuation);
+
 private:
     ISessionManager *m_sessionManager;
     StringMap m_params;
@@ -36,7 +36,8 @@ enum class APIErrorType
     BadData,
     NotFound,
     AccessDenied,
-    Conflict
+    Conflict,
+    ServiceUnavailable
 };
 
 class APIError : public RuntimeError
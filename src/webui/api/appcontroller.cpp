@@ -53,6 +53,7 @@
 #include "base/utils/net.h"
 #include "base/utils/password.h"
 #include "../webapplication.h"
+#include "apierror.h"
 
 void AppController::webapiVersionAction()
 {
@@ -182,6 +183,7 @@ void AppController::preferencesAction()
     data["schedule_to_hour"] = end_time.hour();
     data["schedule_to_min"] = end_time.minute();
     data["scheduler_days"] = pref->getSchedulerDays();
+    data["scheduler_rules"] = session->bandwidthSchedule().toList();
 
     // Bittorrent
     // Privacy
@@ -235,6 +237,7 @@ void AppController::preferencesAction()
     data["web_ui_clickjacking_protection_enabled"] = pref->isWebUiClickjackingProtectionEnabled();
     data["web_ui_csrf_protection_enabled"] = pref->isWebUiCSRFProtectionEnabled();
     data["web_ui_host_header_validation_enabled"] = pref->isWebUIHostHeaderValidationEnabled();
+    data["web_ui_max_sessions"] = pref->getWebUiMaxSessions();
     // Update my dynamic domain name
     data["dyndns_enabled"] = pref->isDynDNSEnabled();
     data["dyndns_service"] = pref->getDynDNSService();
@@ -260,6 +263,15 @@ void AppController::setPreferencesAction()
     const QVariantMap m = QJsonDocument::fromJson(params()["json"].toUtf8()).toVariant().toMap();
     QVariantMap::ConstIterator it;
 
+    // Validated before anything is applied, so an invalid request changes nothing
+    int webUiMaxSessions = 0;
+    if ((it = m.find(QLatin1String("web_ui_max_sessions"))) != m.constEnd()) {
+        bool ok = false;
+        webUiMaxSessions = it.value().toInt(&ok);
+        if (!ok || (webUiMaxSessions < 1))
+            throw APIError(APIErrorType::BadParams, tr("The maximum number of WebUI sessions must be at least 1"));
+    }
+
     // Downloads
     // When adding a torrent
     if ((it = m.find(QLatin1String("create_subfolder_enabled"))) != m.constEnd())
@@ -437,6 +449,8 @@ void AppController::setPreferencesAction()
         pref->setSchedulerEndTime(QTime(m["schedule_to_hour"].toInt(), m["schedule_to_min"].toInt()));
     if (m.contains("scheduler_days"))
         pref->setSchedulerDays(SchedulerDays(m["scheduler_days"].toInt()));
+    if (m.contains("scheduler_rules"))
+        session->setBandwidthSchedule(BitTorrent::BandwidthSchedule::fromList(m["scheduler_rules"].toList()));
 
     // Bittorrent
     // Privacy
@@ -542,6 +556,8 @@ void AppController::setPreferencesAction()
         pref->setWebUiCSRFProtectionEnabled(m["web_ui_csrf_protection_enabled"].toBool());
     if (m.contains("web_ui_host_header_validation_enabled"))
         pref->setWebUIHostHeaderValidationEnabled(m["web_ui_host_header_validation_enabled"].toBool());
+    if (m.contains("web_ui_max_sessions"))
+        pref->setWebUiMaxSessions(webUiMaxSessions);
     // Update my dynamic domain name
     if (m.contains("dyndns_enabled"))
         pref->setDynDNSEnabled(m["dyndns_enabled"].toBool());
@@ -28,6 +28,9 @@
 
 #include "authcontroller.h"
 
+#include <QHostAddress>
+#include <QRunnable>
+
 #include "base/logger.h"
 #include "base/preferences.h"
 #include "base/utils/password.h"
@@ -36,6 +39,55 @@
 
 constexpr int BAN_TIME = 3600000; // 1 hour
 constexpr int MAX_AUTH_FAILED_ATTEMPTS = 5;
+// Neighbouring addresses are often in the hands of the same client
+constexpr int MAX_SUBNET_AUTH_FAILED_ATTEMPTS = 4 * MAX_AUTH_FAILED_ATTEMPTS;
+constexpr int MAX_WIDE_SUBNET_AUTH_FAILED_ATTEMPTS = 2 * MAX_SUBNET_AUTH_FAILED_ATTEMPTS;
+constexpr int MAX_TRACKED_CLIENTS = 4096;
+constexpr int VERIFICATION_THREADS = 2;
+// Beyond it the requests are answered at once, so a flood can't exhaust the server
+constexpr int MAX_PENDING_LOGINS = 32;
+
+namespace
+{
+    class VerificationTask : public QRunnable
+    {
+    public:
+        VerificationTask(QObject *receiver, const quint64 resultId, const QByteArray &secret, const QString &password)
+            : m_receiver(receiver)
+            , m_resultId(resultId)
+            , m_secret(secret)
+            , m_password(password)
+        {
+        }
+
+        void run() override
+        {
+            const bool isPasswordValid = Utils::Password::PBKDF2::verify(m_secret, m_password);
+            QMetaObject::invokeMethod(m_receiver, "handleVerificationFinished", Qt::QueuedConnection
+                , Q_ARG(quint64, m_resultId), Q_ARG(bool, isPasswordValid));
+        }
+
+    private:
+        QObject *const m_receiver;
+        const quint64 m_resultId;
+        const QByteArray m_secret;
+        const QString m_password;
+    };
+}
+
+AuthController::AuthController(ISessionManager *sessionManager, QObject *parent)
+    : APIController(sessionManager, parent)
+    , m_loginLimiter({MAX_AUTH_FAILED_ATTEMPTS, MAX_SUBNET_AUTH_FAILED_ATTEMPTS, MAX_WIDE_SUBNET_AUTH_FAILED_ATTEMPTS
+                      , BAN_TIME, MAX_TRACKED_CLIENTS})
+{
+    m_verificationPool.setMaxThreadCount(VERIFICATION_THREADS);
+}
+
+AuthController::~AuthController()
+{
+    m_verificationPool.clear();
+    m_verificationPool.waitForDone();
+}
 
 void AuthController::loginAction()
 {
@@ -48,12 +100,25 @@ void AuthController::loginAction()
     const QString usernameFromWeb {params()["username"]};
     const QString passwordFromWeb {params()["password"]};
 
-    if (isBanned()) {
+    if (m_pendingLogins.size() >= MAX_PENDING_LOGINS)
+        throw APIError(APIErrorType::ServiceUnavailable, tr("Too many login attempts are in progress, try again later."));
+
+    // Every attempt takes a token, a successful one gives it back
+    switch (m_loginLimiter.tryAcquire(QHostAddress(clientAddr))) {
+    case Net::AddressRateLimiter::AcquireResult::Acquired:
+        break;
+    case Net::AddressRateLimiter::AcquireResult::RateLimited:
         LogMsg(tr("WebAPI login failure. Reason: IP has been banned, IP: %1, username: %2")
                 .arg(clientAddr, usernameFromWeb)
             , Log::WARNING);
         throw APIError(APIErrorType::AccessDenied
                        , tr("Your IP address has been banned after too many failed authentication attempts."));
+    case Net::AddressRateLimiter::AcquireResult::TableFull:
+        // Too many clients failed recently, their limits are kept rather than forgotten
+        LogMsg(tr("WebAPI login failure. Reason: too many clients failed to log in recently, IP: %1, username: %2")
+                .arg(clientAddr, usernameFromWeb)
+            , Log::WARNING);
+        throw APIError(APIErrorType::ServiceUnavailable, tr("Too many login attempts are in progress, try again later."));
     }
 
     const Preferences *pref = Preferences::instance();
@@ -61,22 +126,10 @@ void AuthController::loginAction()
     const QString username {pref->getWebUiUsername()};
     const QByteArray secret {pref->getWebUIPassword()};
     const bool usernameEqual = Utils::Password::slowEquals(usernameFromWeb.toUtf8(), username.toUtf8());
-    const bool passwordEqual = Utils::Password::PBKDF2::verify(secret, passwordFromWeb);
-
-    if (usernameEqual && passwordEqual) {
-        m_clientFailedLogins.remove(clientAddr);
 
-        sessionManager()->sessionStart();
-        setResult(QLatin1String("Ok."));
-        LogMsg(tr("WebAPI login success. IP: %1").arg(clientAddr));
-    }
-    else {
-        increaseFailedAttempts();
-        setResult(QLatin1String("Fails."));
-        LogMsg(tr("WebAPI login failure. Reason: invalid credentials, attempt count: %1, IP: %2, username: %3")
-                .arg(QString::number(failedAttemptsCount()), clientAddr, usernameFromWeb)
-            , Log::WARNING);
-    }
+    const quint64 resultId = deferResult();
+    m_pendingLogins.insert(resultId, {clientAddr, usernameFromWeb, usernameEqual});
+    m_verificationPool.start(new VerificationTask(this, resultId, secret, passwordFromWeb));
 }
 
 void AuthController::logoutAction()
@@ -84,33 +137,28 @@ void AuthController::logoutAction()
     sessionManager()->sessionEnd();
 }
 
-bool AuthController::isBanned() const
-{
-    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
-    const FailedLogin failedLogin = m_clientFailedLogins.value(sessionManager()->clientId());
-
-    bool isBanned = (failedLogin.bannedAt > 0);
-    if (isBanned && ((now - failedLogin.bannedAt) > BAN_TIME)) {
-        m_clientFailedLogins.remove(sessionManager()->clientId());
-        isBanned = false;
-    }
-
-    return isBanned;
-}
-
-int AuthController::failedAttemptsCount() const
+void AuthController::handleVerificationFinished(const quint64 resultId, const bool isPasswordValid)
 {
-    return m_clientFailedLogins.value(sessionManager()->clientId()).failedAttemptsCount;
-}
-
-void AuthController::increaseFailedAttempts()
-{
-    FailedLogin &failedLogin = m_clientFailedLogins[sessionManager()->clientId()];
-    ++failedLogin.failedAttemptsCount;
-
-    if (failedLogin.failedAttemptsCount == MAX_AUTH_FAILED_ATTEMPTS) {
-        // Max number of failed attempts reached
-        // Start ban period
-        failedLogin.bannedAt = QDateTime::currentMSecsSinceEpoch() / 1000;
-    }
+    const PendingLogin login = m_pendingLogins.take(resultId);
+    const bool isValid = login.isUsernameValid && isPasswordValid;
+    if (isValid)
+        m_loginLimiter.release(QHostAddress(login.clientAddr));
+    const int attemptsLeft = m_loginLimiter.availableTokens(QHostAddress(login.clientAddr));
+
+    finishDeferredResult(resultId, [this, login, isValid, attemptsLeft]()
+    {
+        if (isValid) {
+            // Another request of the client could have logged in meanwhile
+            if (!sessionManager()->session())
+                sessionManager()->sessionStart();
+            setResult(QLatin1String("Ok."));
+            LogMsg(tr("WebAPI login success. IP: %1").arg(login.clientAddr));
+        }
+        else {
+            setResult(QLatin1String("Fails."));
+            LogMsg(tr("WebAPI login failure. Reason: invalid credentials, attempts left: %1, IP: %2, username: %3")
+                    .arg(QString::number(attemptsLeft), login.clientAddr, login.username)
+                , Log::WARNING);
+        }
+    });
 }
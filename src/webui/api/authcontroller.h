@@ -30,7 +30,9 @@
 
 #include <QHash>
 #include <QString>
+#include <QThreadPool>
 
+#include "base/net/addressratelimiter.h"
 #include "apicontroller.h"
 
 class AuthController : public APIController
@@ -39,21 +41,25 @@ class AuthController : public APIController
     Q_DISABLE_COPY(AuthController)
 
 public:
-    using APIController::APIController;
+    explicit AuthController(ISessionManager *sessionManager, QObject *parent = nullptr);
+    ~AuthController() override;
 
 private slots:
     void loginAction();
     void logoutAction();
 
 private:
-    bool isBanned() const;
-    int failedAttemptsCount() const;
-    void increaseFailedAttempts();
+    Q_INVOKABLE void handleVerificationFinished(quint64 resultId, bool isPasswordValid);
 
-    struct FailedLogin
+    struct PendingLogin
     {
-        int failedAttemptsCount = 0;
-        qint64 bannedAt = 0;
+        QString clientAddr;
+        QString username;
+        bool isUsernameValid;
     };
-    mutable QHash<QString, FailedLogin> m_clientFailedLogins;
+
+    // Password hashing is slow on purpose, so it is done off the main thread
+    QThreadPool m_verificationPool;
+    QHash<quint64, PendingLogin> m_pendingLogins;
+    Net::AddressRateLimiter m_loginLimiter;
 };
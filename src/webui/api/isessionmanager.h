@@ -28,20 +28,44 @@
 
 #pragma once
 
+#include <memory>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+
 #include <QString>
-#include <QVariant>
+
+// Base of the per-feature data a session keeps between requests (e.g. sync cursors).
+// States are owned by the session and accessed by reference, they are never copied.
+struct ISessionState
+{
+    ISessionState() = default;
+    ISessionState(const ISessionState &) = delete;
+    ISessionState &operator=(const ISessionState &) = delete;
+    virtual ~ISessionState() = default;
+};
 
 struct ISession
 {
     virtual ~ISession() = default;
     virtual QString id() const = 0;
-    virtual QVariant getData(const QString &id) const = 0;
-    virtual void setData(const QString &id, const QVariant &data) = 0;
 
+    // Returns the state of type T, it is created on first access
+    // and destroyed along with the session
     template <class T>
-    T getData(const QString &id) const {
-        return this->getData(id).value<T>();
+    T &state()
+    {
+        static_assert(std::is_base_of<ISessionState, T>::value, "Session state must derive from ISessionState");
+
+        ISessionState *state = findState(typeid(T));
+        if (!state)
+            state = insertState(typeid(T), std::unique_ptr<ISessionState> {new T});
+        return static_cast<T &>(*state);
     }
+
+protected:
+    virtual ISessionState *findState(const std::type_index &type) const = 0;
+    virtual ISessionState *insertState(const std::type_index &type, std::unique_ptr<ISessionState> state) = 0;
 };
 
 struct ISessionManager
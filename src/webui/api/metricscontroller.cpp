@@ -0,0 +1,165 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "metricscontroller.h"
+
+#include <array>
+
+#include "base/bittorrent/session.h"
+#include "base/bittorrent/torrenthandle.h"
+#include "base/global.h"
+#include "base/latencyhistogram.h"
+#include "base/logger.h"
+#include "serialize/serialize_torrent.h"
+#include "webui/websessionstore.h"
+
+namespace
+{
+    const int TORRENT_STATES_COUNT = static_cast<int>(BitTorrent::TorrentState::Error) + 1;
+    // Prometheus text exposition format
+    const char CONTENT_TYPE_METRICS[] = "text/plain; version=0.0.4";
+
+    void appendValue(QByteArray &output, const char *name, const qint64 value)
+    {
+        output.append(name).append(' ').append(QByteArray::number(value)).append('\n');
+    }
+
+    // "labels" is either empty or a comma terminated list, e.g. 'type="x",'
+    void appendHistogramSamples(QByteArray &output, const char *name, const LatencyHistogram &histogram, const QByteArray &labels = {})
+    {
+        const auto &bounds = LatencyHistogram::bucketBounds();
+        for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+            output.append(name).append("_bucket{").append(labels).append("le=\"").append(QByteArray::number(bounds[i] / 1000000., 'g', 6))
+                .append("\"} ").append(QByteArray::number(histogram.cumulativeCount(i))).append('\n');
+        }
+        output.append(name).append("_bucket{").append(labels).append("le=\"+Inf\"} ").append(QByteArray::number(histogram.count())).append('\n');
+
+        const QByteArray braces = labels.isEmpty() ? QByteArray() : ('{' + labels.left(labels.size() - 1) + '}');
+        output.append(name).append("_sum").append(braces).append(' ').append(QByteArray::number(histogram.sum() / 1000000., 'f', 6)).append('\n');
+        output.append(name).append("_count").append(braces).append(' ').append(QByteArray::number(histogram.count())).append('\n');
+    }
+
+    void appendHistogram(QByteArray &output, const char *name, const LatencyHistogram &histogram)
+    {
+        output.append("# TYPE ").append(name).append(" histogram\n");
+        appendHistogramSamples(output, name, histogram);
+    }
+}
+
+MetricsController::MetricsController(const LatencyHistogram &apiRequestsLatency, const WebSessionStore &sessionStore
+                                     , ISessionManager *sessionManager, QObject *parent)
+    : APIController(sessionManager, parent)
+    , m_apiRequestsLatency(apiRequestsLatency)
+    , m_sessionStore(sessionStore)
+{
+}
+
+void MetricsController::initSessionMetrics()
+{
+    const QVector<BitTorrent::SessionMetric> &metrics = BitTorrent::Session::instance()->metrics();
+    m_sessionMetricHeaders.reserve(metrics.size());
+    for (const BitTorrent::SessionMetric &metric : metrics) {
+        QByteArray name = "libtorrent_" + metric.name.toLatin1().replace('.', '_');
+        if (!metric.isGauge)
+            name += "_total";
+
+        m_sessionMetricHeaders.append("# TYPE " + name + (metric.isGauge ? " gauge\n" : " counter\n") + name + ' ');
+    }
+}
+
+// Returns all libtorrent session counters and gauges along with
+// qBittorrent internal metrics in Prometheus text exposition format.
+void MetricsController::mainAction()
+{
+    const BitTorrent::Session *session = BitTorrent::Session::instance();
+    if (m_sessionMetricHeaders.isEmpty())
+        initSessionMetrics();
+
+    QByteArray output;
+    output.reserve(m_lastOutputSize + 1024);
+
+    const QVector<BitTorrent::SessionMetric> &metrics = session->metrics();
+    const QVector<qint64> &values = session->metricValues();
+    for (int i = 0; i < metrics.size(); ++i) {
+        output.append(m_sessionMetricHeaders[i]).append(QByteArray::number(values[metrics[i].valueIndex])).append('\n');
+    }
+
+    output.append("# TYPE qbittorrent_alerts_last_batch_size gauge\n");
+    appendValue(output, "qbittorrent_alerts_last_batch_size", session->lastAlertsCount());
+    output.append("# TYPE qbittorrent_alerts_backlog gauge\n");
+    appendValue(output, "qbittorrent_alerts_backlog", session->alertsBacklog());
+    output.append("# TYPE qbittorrent_alerts_batch_size_peak gauge\n");
+    appendValue(output, "qbittorrent_alerts_batch_size_peak", session->alertsHighWaterMark());
+    appendHistogram(output, "qbittorrent_alerts_handling_seconds", session->alertsHandlingLatency());
+    output.append("# TYPE qbittorrent_torrent_sync_calls_total counter\n");
+    appendValue(output, "qbittorrent_torrent_sync_calls_total", session->syncNativeCallsCount());
+
+    output.append("# TYPE qbittorrent_alert_handler_duration_seconds histogram\n");
+    for (const BitTorrent::AlertTypeStatistics &typeStats : session->alertTypeStatistics()) {
+        if (typeStats.latency.count() > 0) {
+            appendHistogramSamples(output, "qbittorrent_alert_handler_duration_seconds", typeStats.latency
+                , ("type=\"" + typeStats.name.toLatin1() + "\","));
+        }
+    }
+    appendHistogram(output, "qbittorrent_api_request_duration_seconds", m_apiRequestsLatency);
+
+    output.append("# TYPE qbittorrent_webui_sessions gauge\n");
+    appendValue(output, "qbittorrent_webui_sessions", m_sessionStore.count());
+    output.append("# TYPE qbittorrent_webui_sessions_expired_total counter\n");
+    appendValue(output, "qbittorrent_webui_sessions_expired_total", m_sessionStore.expiredCount());
+    output.append("# TYPE qbittorrent_webui_sessions_evicted_total counter\n");
+    appendValue(output, "qbittorrent_webui_sessions_evicted_total", m_sessionStore.evictedCount());
+
+    output.append("# TYPE qbittorrent_log_messages_dropped_total counter\n");
+    appendValue(output, "qbittorrent_log_messages_dropped_total", Logger::instance()->droppedMessagesCount());
+
+    output.append("# TYPE qbittorrent_resume_data_pending gauge\n");
+    appendValue(output, "qbittorrent_resume_data_pending", session->pendingResumeDataCount());
+
+    std::array<int, TORRENT_STATES_COUNT> stateCounts {};
+    int unknownStateCount = 0;
+    for (const BitTorrent::TorrentHandle *torrent : asConst(session->torrents())) {
+        const int state = static_cast<int>(torrent->state());
+        if ((state >= 0) && (state < TORRENT_STATES_COUNT))
+            ++stateCounts[state];
+        else
+            ++unknownStateCount;
+    }
+
+    output.append("# TYPE qbittorrent_torrents gauge\n");
+    for (int i = 0; i < TORRENT_STATES_COUNT; ++i) {
+        output.append("qbittorrent_torrents{state=\"")
+            .append(torrentStateToString(static_cast<BitTorrent::TorrentState>(i)).toLatin1())
+            .append("\"} ").append(QByteArray::number(stateCounts[i])).append('\n');
+    }
+    output.append("qbittorrent_torrents{state=\"unknown\"} ").append(QByteArray::number(unknownStateCount)).append('\n');
+
+    m_lastOutputSize = output.size();
+    setResult(output, QLatin1String(CONTENT_TYPE_METRICS));
+}
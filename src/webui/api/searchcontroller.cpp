@@ -28,6 +28,8 @@
 
 #include "searchcontroller.h"
 
+#include <QMap>
+#include <QSet>
 #include <QSharedPointer>
 
 #include "base/global.h"
@@ -41,19 +43,15 @@
 class SearchPluginManager;
 
 using SearchHandlerPtr = QSharedPointer<SearchHandler>;
-using SearchHandlerDict = QMap<int, SearchHandlerPtr>;
 
 namespace
 {
-    const QLatin1String ACTIVE_SEARCHES("activeSearches");
-    const QLatin1String SEARCH_HANDLERS("searchHandlers");
-
-    void removeActiveSearch(ISession *session, const int id)
+    // Searches of a WebUI session, they are released together with the session
+    struct SearchState : ISessionState
     {
-        auto activeSearches = session->getData<QSet<int>>(ACTIVE_SEARCHES);
-        if (activeSearches.remove(id))
-            session->setData(ACTIVE_SEARCHES, QVariant::fromValue(activeSearches));
-    }
+        QMap<int, SearchHandlerPtr> searchHandlers;
+        QSet<int> activeSearches;
+    };
 }
 
 void SearchController::startAction()
@@ -81,22 +79,20 @@ void SearchController::startAction()
         pluginsToUse << plugins;
     }
 
-    ISession *const session = sessionManager()->session();
-    auto activeSearches = session->getData<QSet<int>>(ACTIVE_SEARCHES);
-    if (activeSearches.size() >= MAX_CONCURRENT_SEARCHES)
+    SearchState &searchState = sessionManager()->session()->state<SearchState>();
+    if (searchState.activeSearches.size() >= MAX_CONCURRENT_SEARCHES)
         throw APIError(APIErrorType::Conflict, QString("Unable to create more than %1 concurrent searches.").arg(MAX_CONCURRENT_SEARCHES));
 
     const auto id = generateSearchId();
     const SearchHandlerPtr searchHandler {SearchPluginManager::instance()->startSearch(pattern, category, pluginsToUse)};
-    QObject::connect(searchHandler.data(), &SearchHandler::searchFinished, this, [session, id, this]() { searchFinished(session, id); });
-    QObject::connect(searchHandler.data(), &SearchHandler::searchFailed, this, [session, id, this]() { searchFailed(session, id); });
-
-    auto searchHandlers = session->getData<SearchHandlerDict>(SEARCH_HANDLERS);
-    searchHandlers.insert(id, searchHandler);
-    session->setData(SEARCH_HANDLERS, QVariant::fromValue(searchHandlers));
+    // The handler is owned by the session state, so the connections
+    // can't outlive the state they refer to
+    SearchState *const searchStatePtr = &searchState;
+    QObject::connect(searchHandler.data(), &SearchHandler::searchFinished, this, [searchStatePtr, id]() { searchStatePtr->activeSearches.remove(id); });
+    QObject::connect(searchHandler.data(), &SearchHandler::searchFailed, this, [searchStatePtr, id]() { searchStatePtr->activeSearches.remove(id); });
 
-    activeSearches.insert(id);
-    session->setData(ACTIVE_SEARCHES, QVariant::fromValue(activeSearches));
+    searchState.searchHandlers.insert(id, searchHandler);
+    searchState.activeSearches.insert(id);
 
     const QJsonObject result = {{"id", id}};
     setResult(result);
@@ -107,17 +103,15 @@ void SearchController::stopAction()
     checkParams({"id"});
 
     const int id = params()["id"].toInt();
-    ISession *const session = sessionManager()->session();
+    SearchState &searchState = sessionManager()->session()->state<SearchState>();
 
-    auto searchHandlers = session->getData<SearchHandlerDict>(SEARCH_HANDLERS);
-    if (!searchHandlers.contains(id))
+    const SearchHandlerPtr searchHandler = searchState.searchHandlers.value(id);
+    if (!searchHandler)
         throw APIError(APIErrorType::NotFound);
 
-    const SearchHandlerPtr searchHandler = searchHandlers[id];
-
     if (searchHandler->isActive()) {
         searchHandler->cancelSearch();
-        removeActiveSearch(session, id);
+        searchState.activeSearches.remove(id);
     }
 }
 
@@ -125,7 +119,7 @@ void SearchController::statusAction()
 {
     const int id = params()["id"].toInt();
 
-    const auto searchHandlers = sessionManager()->session()->getData<SearchHandlerDict>(SEARCH_HANDLERS);
+    const auto &searchHandlers = sessionManager()->session()->state<SearchState>().searchHandlers;
     if ((id != 0) && !searchHandlers.contains(id))
         throw APIError(APIErrorType::NotFound);
 
@@ -144,6 +138,12 @@ void SearchController::statusAction()
     setResult(statusArray);
 }
 
+// Optional parameters:
+//   - "filter": words which must all be contained in the file name
+//   - "minSeeds", "maxSeeds", "minSize", "maxSize": ranges of accepted values
+//   - "sort": "fileName", "fileSize" or "nbSeeders" (order of arrival by default)
+//   - "reverse": descending sort order
+//   - "offset", "limit": page of the filtered results, a negative offset counts from the end
 void SearchController::resultsAction()
 {
     checkParams({"id"});
@@ -152,13 +152,36 @@ void SearchController::resultsAction()
     int limit = params()["limit"].toInt();
     int offset = params()["offset"].toInt();
 
-    const auto searchHandlers = sessionManager()->session()->getData<SearchHandlerDict>(SEARCH_HANDLERS);
-    if (!searchHandlers.contains(id))
+    const SearchHandlerPtr searchHandler = sessionManager()->session()->state<SearchState>().searchHandlers.value(id);
+    if (!searchHandler)
         throw APIError(APIErrorType::NotFound);
 
-    const SearchHandlerPtr searchHandler = searchHandlers[id];
-    const QList<SearchResult> searchResults = searchHandler->results();
-    const int size = searchResults.size();
+    static const QHash<QString, SearchResultStore::SortField> sortFields {
+        {"", SearchResultStore::SortField::None},
+        {"fileName", SearchResultStore::SortField::Name},
+        {"fileSize", SearchResultStore::SortField::Size},
+        {"nbSeeders", SearchResultStore::SortField::Seeds}
+    };
+    const auto sortField = sortFields.constFind(params()["sort"]);
+    if (sortField == sortFields.cend())
+        throw APIError(APIErrorType::BadParams, tr("Unsupported sort field"));
+    const bool reverse = Utils::String::parseBool(params()["reverse"], false);
+
+    SearchResultFilter filter;
+    filter.name = params()["filter"];
+    if (params().contains("minSeeds"))
+        filter.minSeeds = params()["minSeeds"].toLongLong();
+    if (params().contains("maxSeeds"))
+        filter.maxSeeds = params()["maxSeeds"].toLongLong();
+    if (params().contains("minSize"))
+        filter.minSize = params()["minSize"].toLongLong();
+    if (params().contains("maxSize"))
+        filter.maxSize = params()["maxSize"].toLongLong();
+
+    const SearchResultStore &searchResults = searchHandler->results();
+    const QVector<int> indexes = searchResults.query(filter, sortField.value()
+                                                     , (reverse ? Qt::DescendingOrder : Qt::AscendingOrder));
+    const int size = indexes.size();
 
     if (offset > size)
         throw APIError(APIErrorType::Conflict, tr("Offset is out of range"));
@@ -171,10 +194,7 @@ void SearchController::resultsAction()
     if (limit <= 0)
         limit = -1;
 
-    if ((limit > 0) || (offset > 0))
-        setResult(getResults(searchResults.mid(offset, limit), searchHandler->isActive(), size));
-    else
-        setResult(getResults(searchResults, searchHandler->isActive(), size));
+    setResult(getResults(searchResults, indexes.mid(offset, limit), searchHandler->isActive(), size));
 }
 
 void SearchController::deleteAction()
@@ -182,18 +202,14 @@ void SearchController::deleteAction()
     checkParams({"id"});
 
     const int id = params()["id"].toInt();
-    ISession *const session = sessionManager()->session();
+    SearchState &searchState = sessionManager()->session()->state<SearchState>();
 
-    auto searchHandlers = session->getData<SearchHandlerDict>(SEARCH_HANDLERS);
-    if (!searchHandlers.contains(id))
+    const SearchHandlerPtr searchHandler = searchState.searchHandlers.take(id);
+    if (!searchHandler)
         throw APIError(APIErrorType::NotFound);
 
-    const SearchHandlerPtr searchHandler = searchHandlers[id];
     searchHandler->cancelSearch();
-    searchHandlers.remove(id);
-    session->setData(SEARCH_HANDLERS, QVariant::fromValue(searchHandlers));
-
-    removeActiveSearch(session, id);
+    searchState.activeSearches.remove(id);
 }
 
 void SearchController::categoriesAction()
@@ -274,19 +290,9 @@ void SearchController::checkForUpdatesFailed(const QString &reason)
     LogMsg(tr("Failed to check for plugin updates: %1").arg(reason), Log::INFO);
 }
 
-void SearchController::searchFinished(ISession *session, const int id)
-{
-    removeActiveSearch(session, id);
-}
-
-void SearchController::searchFailed(ISession *session, const int id)
-{
-    removeActiveSearch(session, id);
-}
-
 int SearchController::generateSearchId() const
 {
-    const auto searchHandlers = sessionManager()->session()->getData<SearchHandlerDict>(SEARCH_HANDLERS);
+    const auto &searchHandlers = sessionManager()->session()->state<SearchState>().searchHandlers;
 
     while (true)
     {
@@ -299,7 +305,8 @@ int SearchController::generateSearchId() const
 /**
  * Returns the search results in JSON format.
  *
- * The return value is an object with a status and an array of dictionaries.
+ * The return value is an object with a status, the total number of results,
+ * the number of results accepted by the filter and an array of dictionaries.
  * The dictionary keys are:
  *   - "fileName"
  *   - "fileUrl"
@@ -309,10 +316,12 @@ int SearchController::generateSearchId() const
  *   - "siteUrl"
  *   - "descrLink"
  */
-QJsonObject SearchController::getResults(const QList<SearchResult> &searchResults, const bool isSearchActive, const int totalResults) const
+QJsonObject SearchController::getResults(const SearchResultStore &searchResults, const QVector<int> &indexes
+                                         , const bool isSearchActive, const int filteredResults) const
 {
     QJsonArray searchResultsArray;
-    for (const SearchResult &searchResult : searchResults) {
+    for (const int index : indexes) {
+        const SearchResult &searchResult = searchResults.at(index);
         searchResultsArray << QJsonObject {
             {"fileName", searchResult.fileName},
             {"fileUrl", searchResult.fileUrl},
@@ -327,7 +336,8 @@ QJsonObject SearchController::getResults(const QList<SearchResult> &searchResult
     const QJsonObject result = {
         {"status", isSearchActive ? "Running" : "Stopped"},
         {"results", searchResultsArray},
-        {"total", totalResults}
+        {"total", searchResults.size()},
+        {"filtered", filteredResults}
     };
 
     return result;
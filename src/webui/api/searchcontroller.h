@@ -33,12 +33,13 @@
 #include <QJsonObject>
 #include <QList>
 #include <QString>
+#include <QVector>
 
 #include "base/search/searchpluginmanager.h"
 #include "apicontroller.h"
 #include "isessionmanager.h"
 
-struct SearchResult;
+class SearchResultStore;
 
 class SearchController : public APIController
 {
@@ -66,9 +67,8 @@ private:
 
     void checkForUpdatesFinished(const QHash<QString, PluginVersion> &updateInfo);
     void checkForUpdatesFailed(const QString &reason);
-    void searchFinished(ISession *session, const int id);
-    void searchFailed(ISession *session, const int id);
     int generateSearchId() const;
-    QJsonObject getResults(const QList<SearchResult> &searchResults, bool isSearchActive, int totalResults) const;
+    QJsonObject getResults(const SearchResultStore &searchResults, const QVector<int> &indexes
+                           , bool isSearchActive, int filteredResults) const;
     QJsonArray getPluginsInfo(const QStringList &plugins) const;
 };
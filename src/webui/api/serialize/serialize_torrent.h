@@ -28,11 +28,13 @@
 
 #pragma once
 
+#include <QString>
 #include <QVariantMap>
 
 namespace BitTorrent
 {
     class TorrentHandle;
+    enum class TorrentState;
 }
 
 // Torrent keys
@@ -79,4 +81,5 @@ const char KEY_TORRENT_TOTAL_SIZE[] = "total_size";
 const char KEY_TORRENT_AUTO_TORRENT_MANAGEMENT[] = "auto_tmm";
 const char KEY_TORRENT_TIME_ACTIVE[] = "time_active";
 
+QString torrentStateToString(BitTorrent::TorrentState state);
 QVariantMap serialize(const BitTorrent::TorrentHandle &torrent);
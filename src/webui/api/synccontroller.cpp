@@ -31,19 +31,19 @@
 #include <algorithm>
 
 #include <QJsonObject>
-#include <QThread>
-#include <QTimer>
+#include <QStringList>
 
 #include "base/bittorrent/peerinfo.h"
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
+#include "base/diskspacemonitor.h"
 #include "base/global.h"
 #include "base/net/geoipmanager.h"
+#include "base/net/reverseresolution.h"
 #include "base/preferences.h"
 #include "base/utils/fs.h"
 #include "base/utils/string.h"
 #include "apierror.h"
-#include "freediskspacechecker.h"
 #include "isessionmanager.h"
 #include "serialize/serialize_torrent.h"
 
@@ -57,6 +57,7 @@ const char KEY_SYNC_TORRENT_PEERS_SHOW_FLAGS[] = "show_flags";
 
 // Peer keys
 const char KEY_PEER_IP[] = "ip";
+const char KEY_PEER_HOST_NAME[] = "host_name";
 const char KEY_PEER_PORT[] = "port";
 const char KEY_PEER_COUNTRY_CODE[] = "country_code";
 const char KEY_PEER_COUNTRY[] = "country";
@@ -95,16 +96,28 @@ const char KEY_TRANSFER_WRITE_CACHE_OVERLOAD[] = "write_cache_overload";
 const char KEY_TRANSFER_READ_CACHE_OVERLOAD[] = "read_cache_overload";
 const char KEY_TRANSFER_QUEUED_IO_JOBS[] = "queued_io_jobs";
 const char KEY_TRANSFER_AVERAGE_TIME_QUEUE[] = "average_time_queue";
+const char KEY_TRANSFER_ALERTS_QUEUED[] = "alerts_queued";
+const char KEY_TRANSFER_ALERTS_QUEUED_PEAK[] = "alerts_queued_peak";
+const char KEY_TRANSFER_ALERTS_BACKLOG[] = "alerts_backlog";
+const char KEY_TRANSFER_SLOWEST_ALERT_HANDLERS[] = "slowest_alert_handlers";
 const char KEY_TRANSFER_TOTAL_QUEUED_SIZE[] = "total_queued_size";
 
 const char KEY_FULL_UPDATE[] = "full_update";
 const char KEY_RESPONSE_ID[] = "rid";
 const char KEY_SUFFIX_REMOVED[] = "_removed";
 
-const int FREEDISKSPACE_CHECK_TIMEOUT = 30000;
-
 namespace
 {
+    // Per-session state of the sync API: the last sent and the last
+    // client-acknowledged responses, used to build incremental updates
+    struct SyncState : ISessionState
+    {
+        QVariantMap mainDataLastResponse;
+        QVariantMap mainDataLastAcceptedResponse;
+        QVariantMap torrentPeersLastResponse;
+        QVariantMap torrentPeersLastAcceptedResponse;
+    };
+
     void processMap(const QVariantMap &prevData, const QVariantMap &data, QVariantMap &syncData);
     void processHash(QVariantHash prevData, const QVariantHash &data, QVariantMap &syncData, QVariantList &removedItems);
     void processList(QVariantList prevData, const QVariantList &data, QVariantList &syncData, QVariantList &removedItems);
@@ -148,6 +161,17 @@ namespace
         map[KEY_TRANSFER_AVERAGE_TIME_QUEUE] = cacheStatus.averageJobTime;
         map[KEY_TRANSFER_TOTAL_QUEUED_SIZE] = cacheStatus.queuedBytes;
 
+        const BitTorrent::Session *session = BitTorrent::Session::instance();
+        map[KEY_TRANSFER_ALERTS_QUEUED] = session->lastAlertsCount();
+        map[KEY_TRANSFER_ALERTS_QUEUED_PEAK] = session->alertsHighWaterMark();
+        map[KEY_TRANSFER_ALERTS_BACKLOG] = session->alertsBacklog();
+        QStringList slowestAlertHandlers;
+        for (const BitTorrent::AlertTypeStatistics &typeStats : asConst(session->slowestAlertTypes(3))) {
+            slowestAlertHandlers << QString::fromLatin1("%1: %2 ms").arg(typeStats.name
+                , Utils::String::fromDouble(typeStats.latency.sum() / 1000. / typeStats.latency.count(), 2));
+        }
+        map[KEY_TRANSFER_SLOWEST_ALERT_HANDLERS] = slowestAlertHandlers.join(QLatin1String(", "));
+
         map[KEY_TRANSFER_DHT_NODES] = sessionStatus.dhtNodes;
         if (!BitTorrent::Session::instance()->isListening())
             map[KEY_TRANSFER_CONNECTION_STATUS] = "disconnected";
@@ -327,22 +351,13 @@ namespace
 SyncController::SyncController(ISessionManager *sessionManager, QObject *parent)
     : APIController(sessionManager, parent)
 {
-    m_freeDiskSpaceThread = new QThread(this);
-    m_freeDiskSpaceChecker = new FreeDiskSpaceChecker();
-    m_freeDiskSpaceChecker->moveToThread(m_freeDiskSpaceThread);
-
-    connect(m_freeDiskSpaceThread, &QThread::finished, m_freeDiskSpaceChecker, &QObject::deleteLater);
-    connect(m_freeDiskSpaceChecker, &FreeDiskSpaceChecker::checked, this, &SyncController::freeDiskSpaceSizeUpdated);
-
-    m_freeDiskSpaceThread->start();
-    QTimer::singleShot(0, m_freeDiskSpaceChecker, &FreeDiskSpaceChecker::check);
-    m_freeDiskSpaceElapsedTimer.start();
+    m_freeDiskSpacePath = BitTorrent::Session::instance()->defaultSavePath();
+    DiskSpaceMonitor::instance()->watchPath(m_freeDiskSpacePath);
 }
 
 SyncController::~SyncController()
 {
-    m_freeDiskSpaceThread->quit();
-    m_freeDiskSpaceThread->wait();
+    DiskSpaceMonitor::instance()->unwatchPath(m_freeDiskSpacePath);
 }
 
 // The function returns the changed data from the server to synchronize with the web client.
@@ -407,8 +422,8 @@ SyncController::~SyncController()
 //   - rid (int): last response id
 void SyncController::maindataAction()
 {
-    auto lastResponse = sessionManager()->session()->getData(QLatin1String("syncMainDataLastResponse")).toMap();
-    auto lastAcceptedResponse = sessionManager()->session()->getData(QLatin1String("syncMainDataLastAcceptedResponse")).toMap();
+    SyncState &syncState = sessionManager()->session()->state<SyncState>();
+    const QVariantHash lastTorrents = syncState.mainDataLastResponse.value("torrents").toHash();
 
     QVariantMap data;
     QVariantHash torrents;
@@ -421,9 +436,9 @@ void SyncController::maindataAction()
 
         // Calculated last activity time can differ from actual value by up to 10 seconds (this is a libtorrent issue).
         // So we don't need unnecessary updates of last activity time in response.
-        if (lastResponse.contains("torrents") && lastResponse["torrents"].toHash().contains(torrent->hash()) &&
-                lastResponse["torrents"].toHash()[torrent->hash()].toMap().contains(KEY_TORRENT_LAST_ACTIVITY_TIME)) {
-            uint lastValue = lastResponse["torrents"].toHash()[torrent->hash()].toMap()[KEY_TORRENT_LAST_ACTIVITY_TIME].toUInt();
+        const QVariantMap lastTorrent = lastTorrents.value(torrent->hash()).toMap();
+        if (lastTorrent.contains(KEY_TORRENT_LAST_ACTIVITY_TIME)) {
+            uint lastValue = lastTorrent[KEY_TORRENT_LAST_ACTIVITY_TIME].toUInt();
             if (qAbs(static_cast<int>(lastValue - map[KEY_TORRENT_LAST_ACTIVITY_TIME].toUInt())) < 15)
                 map[KEY_TORRENT_LAST_ACTIVITY_TIME] = lastValue;
         }
@@ -433,13 +448,17 @@ void SyncController::maindataAction()
 
     data["torrents"] = torrents;
 
+    const BitTorrent::TorrentIndex &torrentIndex = session->torrentIndex();
+    const bool isSubcategoriesEnabled = session->isSubcategoriesEnabled();
+
     QVariantHash categories;
     const auto categoriesList = session->categories();
     for (auto it = categoriesList.cbegin(); it != categoriesList.cend(); ++it) {
         const auto key = it.key();
         categories[key] = QVariantMap {
             {"name", key},
-            {"savePath", it.value()}
+            {"savePath", it.value()},
+            {"torrentsCount", torrentIndex.categoryTorrentsCount(key, isSubcategoriesEnabled)}
         };
     }
 
@@ -453,10 +472,8 @@ void SyncController::maindataAction()
     data["server_state"] = serverState;
 
     const int acceptedResponseId {params()["rid"].toInt()};
-    setResult(QJsonObject::fromVariantMap(generateSyncData(acceptedResponseId, data, lastAcceptedResponse, lastResponse)));
-
-    sessionManager()->session()->setData(QLatin1String("syncMainDataLastResponse"), lastResponse);
-    sessionManager()->session()->setData(QLatin1String("syncMainDataLastAcceptedResponse"), lastAcceptedResponse);
+    setResult(QJsonObject::fromVariantMap(generateSyncData(acceptedResponseId, data
+        , syncState.mainDataLastAcceptedResponse, syncState.mainDataLastResponse)));
 }
 
 // GET param:
@@ -464,9 +481,6 @@ void SyncController::maindataAction()
 //   - rid (int): last response id
 void SyncController::torrentPeersAction()
 {
-    auto lastResponse = sessionManager()->session()->getData(QLatin1String("syncTorrentPeersLastResponse")).toMap();
-    auto lastAcceptedResponse = sessionManager()->session()->getData(QLatin1String("syncTorrentPeersLastAcceptedResponse")).toMap();
-
     const QString hash {params()["hash"]};
     BitTorrent::TorrentHandle *const torrent = BitTorrent::Session::instance()->findTorrent(hash);
     if (!torrent)
@@ -483,6 +497,18 @@ void SyncController::torrentPeersAction()
 
     data[KEY_SYNC_TORRENT_PEERS_SHOW_FLAGS] = resolvePeerCountries;
 
+    // The host names which aren't known yet are sent with the next responses
+    QHash<QString, QString> hostNames;
+    if (Preferences::instance()->resolvePeerHostNames()) {
+        QStringList peerIps;
+        peerIps.reserve(peersList.size());
+        for (const BitTorrent::PeerInfo &pi : peersList) {
+            if (!pi.address().ip.isNull())
+                peerIps << pi.address().ip.toString();
+        }
+        hostNames = Net::ReverseResolution::instance()->resolve(peerIps);
+    }
+
     for (const BitTorrent::PeerInfo &pi : peersList) {
         if (pi.address().ip.isNull()) continue;
         QVariantMap peer;
@@ -492,7 +518,11 @@ void SyncController::torrentPeersAction()
             peer[KEY_PEER_COUNTRY] = Net::GeoIPManager::CountryName(pi.country());
         }
 #endif
-        peer[KEY_PEER_IP] = pi.address().ip.toString();
+        const QString peerIp = pi.address().ip.toString();
+        peer[KEY_PEER_IP] = peerIp;
+        const QString hostName = hostNames.value(peerIp);
+        if (!hostName.isEmpty())
+            peer[KEY_PEER_HOST_NAME] = hostName;
         peer[KEY_PEER_PORT] = pi.address().port;
         peer[KEY_PEER_CLIENT] = pi.client();
         peer[KEY_PEER_PROGRESS] = pi.progress();
@@ -506,29 +536,27 @@ void SyncController::torrentPeersAction()
         peer[KEY_PEER_RELEVANCE] = pi.relevance();
         peer[KEY_PEER_FILES] = torrent->info().filesForPiece(pi.downloadingPieceIndex()).join(QLatin1String("\n"));
 
-        peers[pi.address().ip.toString() + ':' + QString::number(pi.address().port)] = peer;
+        peers[peerIp + ':' + QString::number(pi.address().port)] = peer;
     }
 
     data["peers"] = peers;
 
     const int acceptedResponseId {params()["rid"].toInt()};
-    setResult(QJsonObject::fromVariantMap(generateSyncData(acceptedResponseId, data, lastAcceptedResponse, lastResponse)));
-
-    sessionManager()->session()->setData(QLatin1String("syncTorrentPeersLastResponse"), lastResponse);
-    sessionManager()->session()->setData(QLatin1String("syncTorrentPeersLastAcceptedResponse"), lastAcceptedResponse);
+    SyncState &syncState = sessionManager()->session()->state<SyncState>();
+    setResult(QJsonObject::fromVariantMap(generateSyncData(acceptedResponseId, data
+        , syncState.torrentPeersLastAcceptedResponse, syncState.torrentPeersLastResponse)));
 }
 
 qint64 SyncController::getFreeDiskSpace()
 {
-    if (m_freeDiskSpaceElapsedTimer.hasExpired(FREEDISKSPACE_CHECK_TIMEOUT)) {
-        QTimer::singleShot(0, m_freeDiskSpaceChecker, &FreeDiskSpaceChecker::check);
-        m_freeDiskSpaceElapsedTimer.restart();
+    DiskSpaceMonitor *const monitor = DiskSpaceMonitor::instance();
+    const QString savePath = BitTorrent::Session::instance()->defaultSavePath();
+    if (savePath != m_freeDiskSpacePath) {
+        monitor->unwatchPath(m_freeDiskSpacePath);
+        m_freeDiskSpacePath = savePath;
+        monitor->watchPath(m_freeDiskSpacePath);
     }
 
-    return m_freeDiskSpace;
-}
-
-void SyncController::freeDiskSpaceSizeUpdated(qint64 freeSpaceSize)
-{
-    m_freeDiskSpace = freeSpaceSize;
+    // It's unknown until the first refresh of a newly watched path
+    return qMax<qint64>(0, monitor->freeSpace(m_freeDiskSpacePath));
 }
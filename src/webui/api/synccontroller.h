@@ -28,16 +28,10 @@
 
 #pragma once
 
-#include <QElapsedTimer>
-
 #include "apicontroller.h"
 
 struct ISessionManager;
 
-class QThread;
-
-class FreeDiskSpaceChecker;
-
 class SyncController : public APIController
 {
     Q_OBJECT
@@ -52,13 +46,9 @@ public:
 private slots:
     void maindataAction();
     void torrentPeersAction();
-    void freeDiskSpaceSizeUpdated(qint64 freeSpaceSize);
 
 private:
     qint64 getFreeDiskSpace();
 
-    qint64 m_freeDiskSpace = 0;
-    FreeDiskSpaceChecker *m_freeDiskSpaceChecker = nullptr;
-    QThread *m_freeDiskSpaceThread = nullptr;
-    QElapsedTimer m_freeDiskSpaceElapsedTimer;
+    QString m_freeDiskSpacePath;
 };
@@ -0,0 +1,233 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "torrentcreatorcontroller.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "base/bittorrent/torrentcreationmanager.h"
+#include "base/global.h"
+#include "base/http/types.h"
+#include "base/utils/fs.h"
+#include "base/utils/string.h"
+#include "apierror.h"
+
+const char KEY_TASK_ID[] = "taskID";
+const char KEY_TASK_SOURCE_PATH[] = "sourcePath";
+const char KEY_TASK_TORRENT_FILE_PATH[] = "torrentFilePath";
+const char KEY_TASK_STATUS[] = "status";
+const char KEY_TASK_PROGRESS[] = "progress";
+const char KEY_TASK_ERROR_MESSAGE[] = "errorMessage";
+const char KEY_TASK_TOTAL_SIZE[] = "totalSize";
+const char KEY_TASK_THROUGHPUT[] = "throughput";
+const char KEY_TASK_TIME_ADDED[] = "timeAdded";
+const char KEY_TASK_TIME_STARTED[] = "timeStarted";
+const char KEY_TASK_TIME_FINISHED[] = "timeFinished";
+
+namespace
+{
+    using Utils::String::parseBool;
+
+    // Same range as the torrent creator dialog
+    const int MIN_PIECE_SIZE = 16 * 1024;
+    const int MAX_PIECE_SIZE = 32 * 1024 * 1024;
+
+    // 0 stands for automatic
+    bool isValidPieceSize(const int pieceSize)
+    {
+        if (pieceSize == 0)
+            return true;
+        const bool isPowerOfTwo = ((pieceSize & (pieceSize - 1)) == 0);
+        return isPowerOfTwo && (pieceSize >= MIN_PIECE_SIZE) && (pieceSize <= MAX_PIECE_SIZE);
+    }
+
+    QString statusString(const BitTorrent::TorrentCreationStatus status)
+    {
+        switch (status) {
+        case BitTorrent::TorrentCreationStatus::Queued:
+            return QLatin1String("Queued");
+        case BitTorrent::TorrentCreationStatus::Running:
+            return QLatin1String("Running");
+        case BitTorrent::TorrentCreationStatus::Finished:
+            return QLatin1String("Finished");
+        case BitTorrent::TorrentCreationStatus::Failed:
+            return QLatin1String("Failed");
+        case BitTorrent::TorrentCreationStatus::Cancelled:
+            return QLatin1String("Cancelled");
+        }
+        return {};
+    }
+
+    qlonglong toSecsSinceEpoch(const QDateTime &dateTime)
+    {
+        return dateTime.isValid() ? (dateTime.toMSecsSinceEpoch() / 1000) : -1;
+    }
+
+    QJsonObject serializeJob(const BitTorrent::TorrentCreationJob &job)
+    {
+        return {
+            {KEY_TASK_ID, job.id},
+            {KEY_TASK_SOURCE_PATH, Utils::Fs::toNativePath(job.params.inputPath)},
+            {KEY_TASK_TORRENT_FILE_PATH, Utils::Fs::toNativePath(job.params.savePath)},
+            {KEY_TASK_STATUS, statusString(job.status)},
+            {KEY_TASK_PROGRESS, job.progress},
+            {KEY_TASK_ERROR_MESSAGE, job.errorMessage},
+            {KEY_TASK_TOTAL_SIZE, job.totalSize},
+            {KEY_TASK_THROUGHPUT, job.throughput()},
+            {KEY_TASK_TIME_ADDED, toSecsSinceEpoch(job.timeAdded)},
+            {KEY_TASK_TIME_STARTED, toSecsSinceEpoch(job.timeStarted)},
+            {KEY_TASK_TIME_FINISHED, toSecsSinceEpoch(job.timeFinished)}
+        };
+    }
+
+    // empty entries are kept since they separate tracker tiers
+    QStringList splitList(const QString &list)
+    {
+        return list.isEmpty() ? QStringList() : list.split('|');
+    }
+}
+
+// Queues a new torrent creation task.
+// POST params:
+//   - sourcePath (string): file or folder to create the torrent from
+//   - torrentFilePath (string): where to save the torrent file (default: temporary file)
+//   - pieceSize (int): piece size in bytes, a power of two from 16 KiB to 32 MiB or 0 for automatic (default 0)
+//   - hashingThreads (int): threads hashing the pieces, 0 for one per CPU core (default 0)
+//   - private (bool): default false
+//   - optimizeAlignment (bool): default true
+//   - trackers (string): '|' separated list, an empty entry starts a new tier
+//   - urlSeeds (string): '|' separated list
+//   - comment (string)
+//   - source (string)
+//   - startSeeding (bool): add the created torrent to the session (default false)
+//   - ignoreShareLimits (bool): default false
+void TorrentCreatorController::addTaskAction()
+{
+    checkParams({KEY_TASK_SOURCE_PATH});
+
+    const QString sourcePath = Utils::Fs::fromNativePath(params()[KEY_TASK_SOURCE_PATH].trimmed());
+    if (sourcePath.isEmpty() || !QFileInfo::exists(sourcePath))
+        throw APIError(APIErrorType::BadParams, tr("Source path doesn't exist"));
+
+    // an empty path lets the manager create a temporary file
+    const QString torrentFilePath = Utils::Fs::fromNativePath(params()[KEY_TASK_TORRENT_FILE_PATH].trimmed());
+
+    bool ok = true;
+    const int pieceSize = params()["pieceSize"].isEmpty() ? 0 : params()["pieceSize"].toInt(&ok);
+    if (!ok || !isValidPieceSize(pieceSize))
+        throw APIError(APIErrorType::BadParams, tr("Invalid piece size"));
+
+    const int hashingThreadCount = params()["hashingThreads"].isEmpty() ? 0 : params()["hashingThreads"].toInt(&ok);
+    if (!ok || (hashingThreadCount < 0))
+        throw APIError(APIErrorType::BadParams, tr("Invalid hashing thread count"));
+
+    BitTorrent::TorrentCreatorParams creatorParams;
+    creatorParams.isPrivate = parseBool(params()["private"], false);
+    creatorParams.isAlignmentOptimized = parseBool(params()["optimizeAlignment"], true);
+    creatorParams.pieceSize = pieceSize;
+    creatorParams.inputPath = sourcePath;
+    creatorParams.savePath = torrentFilePath;
+    creatorParams.comment = params()["comment"];
+    creatorParams.source = params()["source"];
+    creatorParams.trackers = splitList(params()["trackers"]);
+    creatorParams.urlSeeds = splitList(params()["urlSeeds"]);
+    creatorParams.hashingThreadCount = hashingThreadCount;
+
+    const QString id = BitTorrent::TorrentCreationManager::instance()->addJob(creatorParams
+        , parseBool(params()["startSeeding"], false), parseBool(params()["ignoreShareLimits"], false));
+
+    setResult(QJsonObject {{KEY_TASK_ID, id}});
+}
+
+// Returns the state of the creation tasks in JSON format.
+// The return value is an array of dictionaries, see serializeJob() for the keys.
+// "throughput" (bytes/s) and "totalSize" are only known for finished tasks.
+// GET params:
+//   - taskID (string): only return this task (default: all tasks)
+void TorrentCreatorController::statusAction()
+{
+    BitTorrent::TorrentCreationManager *const manager = BitTorrent::TorrentCreationManager::instance();
+    const QString id = params()[KEY_TASK_ID];
+
+    QJsonArray statusArray;
+    if (!id.isEmpty()) {
+        if (!manager->hasJob(id))
+            throw APIError(APIErrorType::NotFound);
+        statusArray << serializeJob(manager->job(id));
+    }
+    else {
+        for (const BitTorrent::TorrentCreationJob &job : asConst(manager->jobs()))
+            statusArray << serializeJob(job);
+    }
+
+    setResult(statusArray);
+}
+
+void TorrentCreatorController::torrentFileAction()
+{
+    checkParams({KEY_TASK_ID});
+
+    BitTorrent::TorrentCreationManager *const manager = BitTorrent::TorrentCreationManager::instance();
+    const QString id = params()[KEY_TASK_ID];
+    if (!manager->hasJob(id))
+        throw APIError(APIErrorType::NotFound);
+
+    const BitTorrent::TorrentCreationJob job = manager->job(id);
+    if (job.status != BitTorrent::TorrentCreationStatus::Finished)
+        throw APIError(APIErrorType::Conflict, tr("Torrent creation is not finished"));
+
+    QFile torrentFile(job.params.savePath);
+    if (!torrentFile.open(QIODevice::ReadOnly))
+        throw APIError(APIErrorType::Conflict, tr("Unable to read the created torrent file"));
+
+    setResult(torrentFile.readAll(), QLatin1String(Http::CONTENT_TYPE_BITTORRENT));
+}
+
+void TorrentCreatorController::cancelTaskAction()
+{
+    checkParams({KEY_TASK_ID});
+
+    const QString id = params()[KEY_TASK_ID];
+    BitTorrent::TorrentCreationManager *const manager = BitTorrent::TorrentCreationManager::instance();
+    if (!manager->hasJob(id))
+        throw APIError(APIErrorType::NotFound);
+    if (!manager->cancelJob(id))
+        throw APIError(APIErrorType::Conflict, tr("Torrent creation task is not active"));
+}
+
+void TorrentCreatorController::deleteTaskAction()
+{
+    checkParams({KEY_TASK_ID});
+
+    if (!BitTorrent::TorrentCreationManager::instance()->deleteJob(params()[KEY_TASK_ID]))
+        throw APIError(APIErrorType::NotFound);
+}
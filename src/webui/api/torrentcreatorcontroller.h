@@ -1,6 +1,6 @@
 /*
  * Bittorrent Client using Qt and libtorrent.
- * Copyright (C) 2018  Thomas Piccirello <thomas.piccirello@gmail.com>
+ * Copyright (C) 2019  qBittorrent project
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License
@@ -26,21 +26,23 @@
  * exception statement from your version.
  */
 
+
 #pragma once
 
-#include <QObject>
+#include "apicontroller.h"
 
-class FreeDiskSpaceChecker : public QObject
+class TorrentCreatorController : public APIController
 {
     Q_OBJECT
-    Q_DISABLE_COPY(FreeDiskSpaceChecker)
+    Q_DISABLE_COPY(TorrentCreatorController)
 
 public:
-    FreeDiskSpaceChecker() = default;
-
-public slots:
-    void check();
+    using APIController::APIController;
 
-signals:
-    void checked(qint64 freeSpaceSize);
+private slots:
+    void addTaskAction();
+    void statusAction();
+    void torrentFileAction();
+    void cancelTaskAction();
+    void deleteTaskAction();
 };
@@ -28,6 +28,7 @@
 
 #include "torrentscontroller.h"
 
+#include <algorithm>
 #include <functional>
 
 #include <QBitArray>
@@ -42,9 +43,11 @@
 #include "base/bittorrent/filepriority.h"
 #include "base/bittorrent/peerinfo.h"
 #include "base/bittorrent/session.h"
+#include "base/bittorrent/storagejobscheduler.h"
 #include "base/bittorrent/torrenthandle.h"
 #include "base/bittorrent/torrentinfo.h"
 #include "base/bittorrent/trackerentry.h"
+#include "base/bittorrent/trackerindex.h"
 #include "base/global.h"
 #include "base/logger.h"
 #include "base/net/downloadmanager.h"
@@ -64,6 +67,22 @@ const char KEY_TRACKER_SEEDS_COUNT[] = "num_seeds";
 const char KEY_TRACKER_LEECHES_COUNT[] = "num_leeches";
 const char KEY_TRACKER_DOWNLOADED_COUNT[] = "num_downloaded";
 
+// Tracker host keys
+const char KEY_TRACKER_HOST_HOST[] = "host";
+const char KEY_TRACKER_HOST_TORRENTS_COUNT[] = "num_torrents";
+const char KEY_TRACKER_HOST_ERRORED_COUNT[] = "num_errored";
+const char KEY_TRACKER_HOST_WARNED_COUNT[] = "num_warned";
+const char KEY_TRACKER_HOSTS[] = "hosts";
+const char KEY_TRACKER_HOSTS_TRACKERLESS_COUNT[] = "num_trackerless";
+
+// Storage job keys
+const char KEY_STORAGE_JOB_HASH[] = "hash";
+const char KEY_STORAGE_JOB_TYPE[] = "type";
+const char KEY_STORAGE_JOB_STATE[] = "state";
+const char KEY_STORAGE_JOB_QUEUE_POSITION[] = "queue_position";
+const char KEY_STORAGE_JOB_PROGRESS[] = "progress";
+const char KEY_STORAGE_JOB_PATHS[] = "paths";
+
 // Web seed keys
 const char KEY_WEBSEED_URL[] = "url";
 
@@ -116,19 +135,23 @@ namespace
     using Utils::String::parseBool;
     using Utils::String::parseTriStateBool;
 
+    // Replaces the "all" keyword with the hashes of all the torrents
+    QStringList expandHashes(const QStringList &hashes)
+    {
+        if ((hashes.size() != 1) || (hashes[0] != QLatin1String("all")))
+            return hashes;
+
+        const BitTorrent::Session *const session = BitTorrent::Session::instance();
+        QStringList allHashes;
+        allHashes.reserve(session->torrents().size());
+        for (const BitTorrent::TorrentHandle *torrent : asConst(session->torrents()))
+            allHashes << torrent->hash();
+        return allHashes;
+    }
+
     void applyToTorrents(const QStringList &hashes, const std::function<void (BitTorrent::TorrentHandle *torrent)> &func)
     {
-        if ((hashes.size() == 1) && (hashes[0] == QLatin1String("all"))) {
-            for (BitTorrent::TorrentHandle *const torrent : asConst(BitTorrent::Session::instance()->torrents()))
-                func(torrent);
-        }
-        else {
-            for (const QString &hash : hashes) {
-                BitTorrent::TorrentHandle *const torrent = BitTorrent::Session::instance()->findTorrent(hash);
-                if (torrent)
-                    func(torrent);
-            }
-        }
+        BitTorrent::Session::instance()->applyToTorrents(expandHashes(hashes), func);
     }
 
     QVariantList getStickyTrackers(const BitTorrent::TorrentHandle *const torrent)
@@ -237,12 +260,13 @@ void TorrentsController::infoAction()
     int offset {params()["offset"].toInt()};
     const QStringSet hashSet {params()["hashes"].split('|', QString::SkipEmptyParts).toSet()};
 
+    const TorrentFilter torrentFilter(filter, (hashSet.isEmpty() ? TorrentFilter::AnyHash : hashSet), category);
+    const QVector<BitTorrent::TorrentHandle *> torrents = BitTorrent::Session::instance()->torrents(torrentFilter);
+
     QVariantList torrentList;
-    TorrentFilter torrentFilter(filter, (hashSet.isEmpty() ? TorrentFilter::AnyHash : hashSet), category);
-    for (BitTorrent::TorrentHandle *const torrent : asConst(BitTorrent::Session::instance()->torrents())) {
-        if (torrentFilter.match(torrent))
-            torrentList.append(serialize(*torrent));
-    }
+    torrentList.reserve(torrents.size());
+    for (BitTorrent::TorrentHandle *const torrent : torrents)
+        torrentList.append(serialize(*torrent));
 
     std::sort(torrentList.begin(), torrentList.end()
               , [sortedColumn, reverse](const QVariant &torrent1, const QVariant &torrent2)
@@ -402,6 +426,42 @@ void TorrentsController::trackersAction()
     setResult(QJsonArray::fromVariantList(trackerList));
 }
 
+// Returns the tracker hosts of all the torrents in JSON format.
+// The return value is a JSON-formatted dictionary.
+// The dictionary keys are:
+//   - "hosts": List of dictionaries with the keys:
+//       - "host": Tracker host
+//       - "num_torrents": Number of torrents using a tracker of the host
+//       - "num_errored": Number of these torrents having an errored tracker of the host
+//       - "num_warned": Number of these torrents having a warned tracker of the host
+//   - "num_trackerless": Number of torrents without any tracker
+//   - "num_errored": Number of torrents having an errored tracker
+//   - "num_warned": Number of torrents having a warned tracker
+void TorrentsController::trackerHostsAction()
+{
+    const BitTorrent::TrackerIndex &trackerIndex = BitTorrent::Session::instance()->trackerIndex();
+
+    QStringList hosts = trackerIndex.hosts();
+    std::sort(hosts.begin(), hosts.end(), Utils::String::naturalLessThan<Qt::CaseSensitive>);
+
+    QJsonArray hostList;
+    for (const QString &host : asConst(hosts)) {
+        hostList << QJsonObject {
+            {KEY_TRACKER_HOST_HOST, host},
+            {KEY_TRACKER_HOST_TORRENTS_COUNT, trackerIndex.hostTorrentsCount(host)},
+            {KEY_TRACKER_HOST_ERRORED_COUNT, trackerIndex.hostErroredTorrentsCount(host)},
+            {KEY_TRACKER_HOST_WARNED_COUNT, trackerIndex.hostWarnedTorrentsCount(host)}
+        };
+    }
+
+    setResult(QJsonObject {
+        {KEY_TRACKER_HOSTS, hostList},
+        {KEY_TRACKER_HOSTS_TRACKERLESS_COUNT, trackerIndex.hostTorrentsCount("")},
+        {KEY_TRACKER_HOST_ERRORED_COUNT, trackerIndex.erroredTorrentsCount()},
+        {KEY_TRACKER_HOST_WARNED_COUNT, trackerIndex.warnedTorrentsCount()}
+    });
+}
+
 // Returns the web seeds for a torrent in JSON format.
 // The return value is a JSON-formatted list of dictionaries.
 // The dictionary keys are:
@@ -847,10 +907,7 @@ void TorrentsController::deleteAction()
 
     const QStringList hashes {params()["hashes"].split('|')};
     const bool deleteFiles {parseBool(params()["deleteFiles"], false)};
-    applyToTorrents(hashes, [deleteFiles](BitTorrent::TorrentHandle *const torrent)
-    {
-        BitTorrent::Session::instance()->deleteTorrent(torrent->hash(), deleteFiles);
-    });
+    BitTorrent::Session::instance()->deleteTorrents(expandHashes(hashes), deleteFiles);
 }
 
 void TorrentsController::increasePrioAction()
@@ -962,6 +1019,66 @@ void TorrentsController::recheckAction()
     applyToTorrents(hashes, [](BitTorrent::TorrentHandle *const torrent) { torrent->forceRecheck(); });
 }
 
+// Returns the queued and running rechecks and storage moves in JSON format.
+// The return value is a JSON-formatted list of dictionaries.
+// The dictionary keys are:
+//   - "hash": Torrent hash
+//   - "type": "recheck" or "move"
+//   - "state": "queued" or "running"
+//   - "queue_position": Position in the queue, -1 for the running jobs
+//   - "progress": Torrent progress for the rechecks, -1 for the moves
+//   - "paths": Locations of the data the job reads or writes
+void TorrentsController::storageJobsAction()
+{
+    const BitTorrent::Session *const session = BitTorrent::Session::instance();
+    const BitTorrent::StorageJobScheduler *const scheduler = session->storageJobScheduler();
+
+    QJsonArray jobList;
+    const auto addJobs = [session, &jobList](const QList<BitTorrent::StorageJob> &jobs, const bool isRunning)
+    {
+        int position = 0;
+        for (const BitTorrent::StorageJob &job : jobs) {
+            const BitTorrent::TorrentHandle *const torrent = session->findTorrent(job.torrentHash);
+            const bool isRecheck = (job.type == BitTorrent::StorageJob::Recheck);
+            jobList << QJsonObject {
+                {KEY_STORAGE_JOB_HASH, QString(job.torrentHash)},
+                {KEY_STORAGE_JOB_TYPE, (isRecheck ? "recheck" : "move")},
+                {KEY_STORAGE_JOB_STATE, (isRunning ? "running" : "queued")},
+                {KEY_STORAGE_JOB_QUEUE_POSITION, (isRunning ? -1 : position++)},
+                {KEY_STORAGE_JOB_PROGRESS, ((isRecheck && torrent) ? torrent->progress() : -1)},
+                {KEY_STORAGE_JOB_PATHS, QJsonArray::fromStringList(job.paths)}
+            };
+        }
+    };
+
+    addJobs(scheduler->runningJobs(), true);
+    addJobs(scheduler->queuedJobs(), false);
+
+    setResult(jobList);
+}
+
+void TorrentsController::cancelStorageJobsAction()
+{
+    checkParams({"hashes"});
+
+    const QStringList hashes {params()["hashes"].split('|')};
+    BitTorrent::Session::instance()->cancelStorageJobs(hashes);
+}
+
+void TorrentsController::setStorageJobPositionAction()
+{
+    checkParams({"hash", "position"});
+
+    const QString hash {params()["hash"]};
+    bool ok = false;
+    const int position = params()["position"].toInt(&ok);
+    if (!ok || (position < 0))
+        throw APIError(APIErrorType::BadParams, tr("Invalid queue position"));
+
+    if (!BitTorrent::Session::instance()->setStorageJobQueuePosition(hash, position))
+        throw APIError(APIErrorType::NotFound);
+}
+
 void TorrentsController::reannounceAction()
 {
     checkParams({"hashes"});
@@ -42,6 +42,7 @@ private slots:
     void infoAction();
     void propertiesAction();
     void trackersAction();
+    void trackerHostsAction();
     void webseedsAction();
     void filesAction();
     void pieceHashesAction();
@@ -49,6 +50,9 @@ private slots:
     void resumeAction();
     void pauseAction();
     void recheckAction();
+    void storageJobsAction();
+    void cancelStorageJobsAction();
+    void setStorageJobPositionAction();
     void reannounceAction();
     void renameAction();
     void setCategoryAction();
@@ -28,9 +28,17 @@
 
 #include "transfercontroller.h"
 
+#include <algorithm>
+
+#include <QDateTime>
+#include <QJsonArray>
 #include <QJsonObject>
 
+#include "base/bittorrent/infohash.h"
 #include "base/bittorrent/session.h"
+#include "base/global.h"
+#include "base/timeseries.h"
+#include "apierror.h"
 
 const char KEY_TRANSFER_DLSPEED[] = "dl_info_speed";
 const char KEY_TRANSFER_DLDATA[] = "dl_info_data";
@@ -41,6 +49,16 @@ const char KEY_TRANSFER_UPRATELIMIT[] = "up_rate_limit";
 const char KEY_TRANSFER_DHT_NODES[] = "dht_nodes";
 const char KEY_TRANSFER_CONNECTION_STATUS[] = "connection_status";
 
+const char KEY_HISTORY_STEP[] = "step";
+const char KEY_HISTORY_CHANNELS[] = "channels";
+const char KEY_HISTORY_POINTS[] = "points";
+
+namespace
+{
+    const int HISTORY_MAX_POINTS = 1000;
+    const qint64 HISTORY_MAX_RANGE = 31 * 24 * 3600; // secs
+}
+
 // Returns the global transfer information in JSON format.
 // The return value is a JSON-formatted dictionary.
 // The dictionary keys are:
@@ -73,6 +91,61 @@ void TransferController::infoAction()
     setResult(dict);
 }
 
+// Returns the transfer rate history in JSON format.
+// Optional parameters:
+//   - "range": history length in seconds (defaults to 300)
+//   - "step": seconds averaged into each point (chosen automatically when omitted)
+//   - "hash": torrent to get the payload rates of instead of the global rates
+// The return value is a JSON-formatted dictionary.
+// The dictionary keys are:
+//   - "step": seconds averaged into each point
+//   - "channels": names of the rates contained in each point
+//   - "points": array of [timestamp, rate...] arrays, rates are in bytes per second
+//               and steps without any transfer are omitted
+void TransferController::historyAction()
+{
+    const qint64 range = params().contains("range") ? params()["range"].toLongLong() : 300;
+    if ((range <= 0) || (range > HISTORY_MAX_RANGE))
+        throw APIError(APIErrorType::BadParams, tr("Invalid history range"));
+
+    int step = params()["step"].toInt();
+    if (step < 0)
+        throw APIError(APIErrorType::BadParams, tr("Invalid history step"));
+    step = std::max(step, static_cast<int>((range + HISTORY_MAX_POINTS - 1) / HISTORY_MAX_POINTS));
+
+    const BitTorrent::Session *const session = BitTorrent::Session::instance();
+
+    const TimeSeries *history = &session->transferRateHistory();
+    QJsonArray channels {"up", "down", "payload_up", "payload_down", "overhead_up", "overhead_down"
+                         , "dht_up", "dht_down", "tracker_up", "tracker_down"};
+
+    const QString hash {params()["hash"]};
+    if (!hash.isEmpty()) {
+        if (!session->findTorrent(hash))
+            throw APIError(APIErrorType::NotFound);
+
+        history = session->torrentTransferRateHistory(hash);
+        channels = QJsonArray {"payload_up", "payload_down"};
+    }
+
+    QJsonArray points;
+    if (history) {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+        for (const TimeSeries::Point &point : asConst(history->query((now - range), now, step))) {
+            QJsonArray values {point.timestamp};
+            for (const quint64 value : point.values)
+                values.append(static_cast<qint64>(value));
+            points.append(values);
+        }
+    }
+
+    setResult(QJsonObject {
+        {KEY_HISTORY_STEP, step},
+        {KEY_HISTORY_CHANNELS, channels},
+        {KEY_HISTORY_POINTS, points}
+    });
+}
+
 void TransferController::uploadLimitAction()
 {
     setResult(QString::number(BitTorrent::Session::instance()->uploadSpeedLimit()));
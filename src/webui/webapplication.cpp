@@ -32,10 +32,12 @@
 #include <functional>
 #include <queue>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QJsonDocument>
@@ -58,9 +60,11 @@
 #include "api/appcontroller.h"
 #include "api/authcontroller.h"
 #include "api/logcontroller.h"
+#include "api/metricscontroller.h"
 #include "api/rsscontroller.h"
 #include "api/searchcontroller.h"
 #include "api/synccontroller.h"
+#include "api/torrentcreatorcontroller.h"
 #include "api/torrentscontroller.h"
 #include "api/transfercontroller.h"
 
@@ -113,6 +117,27 @@ namespace
 
         return QLatin1String("no-store");
     }
+
+    void throwHTTPError(const APIError &error)
+    {
+        switch (error.type()) {
+        case APIErrorType::AccessDenied:
+            throw ForbiddenHTTPError(error.message());
+        case APIErrorType::BadData:
+            throw UnsupportedMediaTypeHTTPError(error.message());
+        case APIErrorType::BadParams:
+            throw BadRequestHTTPError(error.message());
+        case APIErrorType::Conflict:
+            throw ConflictHTTPError(error.message());
+        case APIErrorType::NotFound:
+            throw NotFoundHTTPError(error.message());
+        case APIErrorType::ServiceUnavailable:
+            throw ServiceUnavailableHTTPError(error.message());
+        default:
+            Q_ASSERT(false);
+            throw InternalServerErrorHTTPError(error.message());
+        }
+    }
 }
 
 WebApplication::WebApplication(QObject *parent)
@@ -121,9 +146,11 @@ WebApplication::WebApplication(QObject *parent)
     registerAPIController(QLatin1String("app"), new AppController(this, this));
     registerAPIController(QLatin1String("auth"), new AuthController(this, this));
     registerAPIController(QLatin1String("log"), new LogController(this, this));
+    registerAPIController(QLatin1String("metrics"), new MetricsController(m_apiRequestsLatency, m_sessionStore, this, this));
     registerAPIController(QLatin1String("rss"), new RSSController(this, this));
     registerAPIController(QLatin1String("search"), new SearchController(this, this));
     registerAPIController(QLatin1String("sync"), new SyncController(this, this));
+    registerAPIController(QLatin1String("torrentcreator"), new TorrentCreatorController(this, this));
     registerAPIController(QLatin1String("torrents"), new TorrentsController(this, this));
     registerAPIController(QLatin1String("transfer"), new TransferController(this, this));
 
@@ -133,11 +160,7 @@ WebApplication::WebApplication(QObject *parent)
     connect(Preferences::instance(), &Preferences::changed, this, &WebApplication::configure);
 }
 
-WebApplication::~WebApplication()
-{
-    // cleanup sessions data
-    qDeleteAll(m_sessions);
-}
+WebApplication::~WebApplication() = default;
 
 void WebApplication::sendWebUIFile()
 {
@@ -254,7 +277,10 @@ void WebApplication::doProcessRequest()
         return;
     }
 
-    const QString action = match.captured(QLatin1String("action"));
+    // "/api/v2/<scope>" is a shortcut for "/api/v2/<scope>/main"
+    QString action = match.captured(QLatin1String("action"));
+    if (action.isEmpty())
+        action = QLatin1String("main");
     const QString scope = match.captured(QLatin1String("scope"));
 
     APIController *controller = m_apiControllers.value(scope);
@@ -269,35 +295,40 @@ void WebApplication::doProcessRequest()
         data[torrent.filename] = torrent.data;
 
     try {
-        const QVariant result = controller->run(action, m_params, data);
-        switch (result.userType()) {
-        case QMetaType::QString:
-            print(result.toString(), Http::CONTENT_TYPE_TXT);
-            break;
-        case QMetaType::QJsonDocument:
-            print(result.toJsonDocument().toJson(QJsonDocument::Compact), Http::CONTENT_TYPE_JSON);
-            break;
-        default:
-            print(result.toString(), Http::CONTENT_TYPE_TXT);
-            break;
-        }
+        m_requestTimer.start();
+        processAPIResult(controller->run(action, m_params, data));
     }
     catch (const APIError &error) {
         // re-throw as HTTPError
-        switch (error.type()) {
-        case APIErrorType::AccessDenied:
-            throw ForbiddenHTTPError(error.message());
-        case APIErrorType::BadData:
-            throw UnsupportedMediaTypeHTTPError(error.message());
-        case APIErrorType::BadParams:
-            throw BadRequestHTTPError(error.message());
-        case APIErrorType::Conflict:
-            throw ConflictHTTPError(error.message());
-        case APIErrorType::NotFound:
-            throw NotFoundHTTPError(error.message());
-        default:
-            Q_ASSERT(false);
-        }
+        throwHTTPError(error);
+    }
+}
+
+void WebApplication::processAPIResult(const QVariant &result)
+{
+    if (result.userType() == qMetaTypeId<DeferredAPIResult>()) {
+        m_deferredResultId = result.value<DeferredAPIResult>().id;
+        return;
+    }
+
+    m_apiRequestsLatency.record(m_requestTimer.nsecsElapsed() / 1000);
+
+    if (result.userType() == qMetaTypeId<DataAPIResult>()) {
+        const DataAPIResult dataResult = result.value<DataAPIResult>();
+        print(dataResult.data, dataResult.mimeType);
+        return;
+    }
+
+    switch (result.userType()) {
+    case QMetaType::QString:
+        print(result.toString(), Http::CONTENT_TYPE_TXT);
+        break;
+    case QMetaType::QJsonDocument:
+        print(result.toJsonDocument().toJson(QJsonDocument::Compact), Http::CONTENT_TYPE_JSON);
+        break;
+    default:
+        print(result.toString(), Http::CONTENT_TYPE_TXT);
+        break;
     }
 }
 
@@ -345,6 +376,8 @@ void WebApplication::configure()
     m_isHostHeaderValidationEnabled = pref->isWebUIHostHeaderValidationEnabled();
     m_isHttpsEnabled = pref->isWebUiHttpsEnabled();
 
+    m_sessionStore.setMaxCount(pref->getWebUiMaxSessions());
+
     m_contentSecurityPolicy =
         (m_isAltUIUsed
             ? QLatin1String("")
@@ -359,6 +392,11 @@ void WebApplication::registerAPIController(const QString &scope, APIController *
     Q_ASSERT(!m_apiControllers.value(scope));
 
     m_apiControllers[scope] = controller;
+    connect(controller, &APIController::deferredResultReady, this
+            , [this, controller](const quint64 id, const APIController::Continuation &continuation)
+    {
+        resumeRequest(controller, id, continuation);
+    });
 }
 
 void WebApplication::declarePublicAPI(const QString &apiPath)
@@ -410,7 +448,7 @@ void WebApplication::sendFile(const QString &path)
     header(Http::HEADER_CACHE_CONTROL, getCachingInterval(mimeType.name()));
 }
 
-Http::Response WebApplication::processRequest(const Http::Request &request, const Http::Environment &env)
+void WebApplication::processRequest(const Http::Request &request, const Http::Environment &env, const ResponseCallback &callback)
 {
     m_currentSession = nullptr;
     m_request = request;
@@ -454,6 +492,17 @@ Http::Response WebApplication::processRequest(const Http::Request &request, cons
             print(error.message(), Http::CONTENT_TYPE_TXT);
     }
 
+    completeRequest(callback);
+}
+
+void WebApplication::completeRequest(const ResponseCallback &callback)
+{
+    if (m_deferredResultId > 0) {
+        m_deferredRequests.insert(m_deferredResultId, {m_request, m_env, m_params, callback, m_requestTimer});
+        m_deferredResultId = 0;
+        return;
+    }
+
     header(QLatin1String(Http::HEADER_X_XSS_PROTECTION), QLatin1String("1; mode=block"));
     header(QLatin1String(Http::HEADER_X_CONTENT_TYPE_OPTIONS), QLatin1String("nosniff"));
 
@@ -466,7 +515,41 @@ Http::Response WebApplication::processRequest(const Http::Request &request, cons
     if (!m_contentSecurityPolicy.isEmpty())
         header(QLatin1String(Http::HEADER_CONTENT_SECURITY_POLICY), m_contentSecurityPolicy);
 
-    return response();
+    callback(response());
+}
+
+void WebApplication::resumeRequest(APIController *controller, const quint64 id, const std::function<void ()> &continuation)
+{
+    const auto it = m_deferredRequests.find(id);
+    if (it == m_deferredRequests.end()) return;
+
+    const DeferredRequest deferred = it.value();
+    m_deferredRequests.erase(it);
+
+    // Restore the context of the request, the session may have changed meanwhile
+    m_currentSession = nullptr;
+    m_request = deferred.request;
+    m_env = deferred.env;
+    m_params = deferred.params;
+    m_requestTimer = deferred.timer;
+    clear();
+
+    try {
+        sessionInitialize();
+        try {
+            processAPIResult(controller->resume(m_params, continuation));
+        }
+        catch (const APIError &error) {
+            throwHTTPError(error);
+        }
+    }
+    catch (const HTTPError &error) {
+        status(error.statusCode(), error.statusText());
+        if (!error.message().isEmpty())
+            print(error.message(), Http::CONTENT_TYPE_TXT);
+    }
+
+    completeRequest(deferred.callback);
 }
 
 QString WebApplication::clientId() const
@@ -483,21 +566,10 @@ void WebApplication::sessionInitialize()
     // TODO: Additional session check
 
     if (!sessionId.isEmpty()) {
-        m_currentSession = m_sessions.value(sessionId);
-        if (m_currentSession) {
-            const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
-            if ((now - m_currentSession->m_timestamp) > INACTIVE_TIME) {
-                // session is outdated - removing it
-                delete m_sessions.take(sessionId);
-                m_currentSession = nullptr;
-            }
-            else {
-                m_currentSession->updateTimestamp();
-            }
-        }
-        else {
+        // an outdated session is removed by the lookup
+        m_currentSession = m_sessionStore.find(sessionId);
+        if (!m_currentSession)
             qDebug() << Q_FUNC_INFO << "session does not exist!";
-        }
     }
 
     if (!m_currentSession && !isAuthNeeded())
@@ -517,7 +589,7 @@ QString WebApplication::generateSid() const
 
         sid = QByteArray::fromRawData(reinterpret_cast<const char *>(tmp), sizeof(quint32) * size).toBase64();
     }
-    while (m_sessions.contains(sid));
+    while (m_sessionStore.contains(sid));
 
     return sid;
 }
@@ -540,16 +612,8 @@ void WebApplication::sessionStart()
 {
     Q_ASSERT(!m_currentSession);
 
-    // remove outdated sessions
-    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
-    const QMap<QString, WebSession *> sessionsCopy {m_sessions};
-    for (const auto session : sessionsCopy) {
-        if ((now - session->timestamp()) > INACTIVE_TIME)
-            delete m_sessions.take(session->id());
-    }
-
     m_currentSession = new WebSession(generateSid());
-    m_sessions[m_currentSession->id()] = m_currentSession;
+    m_sessionStore.insert(m_currentSession);
 
     QNetworkCookie cookie(C_SID, m_currentSession->id().toUtf8());
     cookie.setHttpOnly(true);
@@ -568,7 +632,7 @@ void WebApplication::sessionEnd()
     cookie.setPath(QLatin1String("/"));
     cookie.setExpirationDate(QDateTime::currentDateTime().addDays(-1));
 
-    delete m_sessions.take(m_currentSession->id());
+    m_sessionStore.remove(m_currentSession->id());
     m_currentSession = nullptr;
 
     header(Http::HEADER_SET_COOKIE, cookie.toRawForm());
@@ -669,7 +733,6 @@ bool WebApplication::validateHostHeader(const QStringList &domains) const
 WebSession::WebSession(const QString &sid)
     : m_sid {sid}
 {
-    updateTimestamp();
 }
 
 QString WebSession::id() const
@@ -677,22 +740,15 @@ QString WebSession::id() const
     return m_sid;
 }
 
-qint64 WebSession::timestamp() const
-{
-    return m_timestamp;
-}
-
-QVariant WebSession::getData(const QString &id) const
-{
-    return m_data.value(id);
-}
-
-void WebSession::setData(const QString &id, const QVariant &data)
+ISessionState *WebSession::findState(const std::type_index &type) const
 {
-    m_data[id] = data;
+    const auto iter = m_states.find(type);
+    return (iter != m_states.end()) ? iter->second.get() : nullptr;
 }
 
-void WebSession::updateTimestamp()
+ISessionState *WebSession::insertState(const std::type_index &type, std::unique_ptr<ISessionState> state)
 {
-    m_timestamp = QDateTime::currentMSecsSinceEpoch() / 1000;
+    ISessionState *const result = state.get();
+    m_states[type] = std::move(state);
+    return result;
 }
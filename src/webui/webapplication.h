@@ -28,7 +28,13 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QMap>
 #include <QObject>
@@ -40,10 +46,12 @@
 #include "base/http/irequesthandler.h"
 #include "base/http/responsebuilder.h"
 #include "base/http/types.h"
+#include "base/latencyhistogram.h"
 #include "base/utils/net.h"
 #include "base/utils/version.h"
+#include "websessionstore.h"
 
-constexpr Utils::Version<int, 3, 2> API_VERSION {2, 2, 0};
+constexpr Utils::Version<int, 3, 2> API_VERSION {2, 8, 3};
 
 class APIController;
 class WebApplication;
@@ -59,17 +67,14 @@ public:
     explicit WebSession(const QString &sid);
 
     QString id() const override;
-    qint64 timestamp() const;
 
-    QVariant getData(const QString &id) const override;
-    void setData(const QString &id, const QVariant &data) override;
+protected:
+    ISessionState *findState(const std::type_index &type) const override;
+    ISessionState *insertState(const std::type_index &type, std::unique_ptr<ISessionState> state) override;
 
 private:
-    void updateTimestamp();
-
     const QString m_sid;
-    qint64 m_timestamp;
-    QVariantHash m_data;
+    std::unordered_map<std::type_index, std::unique_ptr<ISessionState>> m_states;
 };
 
 class WebApplication
@@ -88,7 +93,7 @@ public:
     explicit WebApplication(QObject *parent = nullptr);
     ~WebApplication() override;
 
-    Http::Response processRequest(const Http::Request &request, const Http::Environment &env) override;
+    void processRequest(const Http::Request &request, const Http::Environment &env, const ResponseCallback &callback) override;
 
     QString clientId() const override;
     WebSession *session() override;
@@ -99,7 +104,19 @@ public:
     const Http::Environment &env() const;
 
 private:
+    struct DeferredRequest
+    {
+        Http::Request request;
+        Http::Environment env;
+        QMap<QString, QString> params;
+        ResponseCallback callback;
+        QElapsedTimer timer;
+    };
+
     void doProcessRequest();
+    void processAPIResult(const QVariant &result);
+    void completeRequest(const ResponseCallback &callback);
+    void resumeRequest(APIController *controller, quint64 id, const std::function<void ()> &continuation);
     void configure();
 
     void registerAPIController(const QString &scope, APIController *controller);
@@ -120,17 +137,22 @@ private:
     bool validateHostHeader(const QStringList &domains) const;
 
     // Persistent data
-    QMap<QString, WebSession *> m_sessions;
+    WebSessionStore m_sessionStore;
 
     // Current data
     WebSession *m_currentSession = nullptr;
     Http::Request m_request;
     Http::Environment m_env;
     QMap<QString, QString> m_params;
+    QElapsedTimer m_requestTimer;
+    // Set when the action of the current request has deferred its result
+    quint64 m_deferredResultId = 0;
+    QHash<quint64, DeferredRequest> m_deferredRequests;
 
-    const QRegularExpression m_apiPathPattern {(QLatin1String("^/api/v2/(?<scope>[A-Za-z_][A-Za-z_0-9]*)/(?<action>[A-Za-z_][A-Za-z_0-9]*)$"))};
+    const QRegularExpression m_apiPathPattern {(QLatin1String("^/api/v2/(?<scope>[A-Za-z_][A-Za-z_0-9]*)(?:/(?<action>[A-Za-z_][A-Za-z_0-9]*))?$"))};
 
     QHash<QString, APIController *> m_apiControllers;
+    LatencyHistogram m_apiRequestsLatency;
     QSet<QString> m_publicAPIs;
     bool m_isAltUIUsed = false;
     QString m_rootFolder;
@@ -0,0 +1,186 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#include "websessionstore.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "webapplication.h"
+
+namespace
+{
+    const qint64 DEFAULT_INACTIVE_TIME = INACTIVE_TIME * 1000;
+    const int DEFAULT_MAX_COUNT = 256;
+}
+
+WebSessionStore::WebSessionStore(const Clock &clock, QObject *parent)
+    : QObject(parent)
+    , m_clock(clock)
+    , m_inactiveTime(DEFAULT_INACTIVE_TIME)
+    , m_maxCount(DEFAULT_MAX_COUNT)
+{
+    if (!m_clock) {
+        m_elapsedTimer.start();
+        m_clock = [this]() { return m_elapsedTimer.elapsed(); };
+    }
+
+    m_expirationTimer.setSingleShot(true);
+    connect(&m_expirationTimer, &QTimer::timeout, this, &WebSessionStore::removeExpired);
+}
+
+WebSessionStore::~WebSessionStore()
+{
+    for (const Entry &entry : m_entries)
+        delete entry.session;
+}
+
+WebSession *WebSessionStore::find(const QString &sid)
+{
+    const auto indexIter = m_index.constFind(sid);
+    if (indexIter == m_index.cend())
+        return nullptr;
+
+    const EntryList::iterator it = indexIter.value();
+    const qint64 now = m_clock();
+    if ((now - it->lastUsed) > m_inactiveTime) {
+        erase(it);
+        ++m_expiredCount;
+        return nullptr;
+    }
+
+    it->lastUsed = now;
+    m_entries.splice(m_entries.end(), m_entries, it);
+    return it->session;
+}
+
+bool WebSessionStore::contains(const QString &sid) const
+{
+    return m_index.contains(sid);
+}
+
+void WebSessionStore::insert(WebSession *session)
+{
+    Q_ASSERT(!m_index.contains(session->id()));
+
+    m_entries.push_back({session, m_clock()});
+    m_index.insert(session->id(), std::prev(m_entries.end()));
+    evictExcess();
+
+    if (!m_expirationTimer.isActive())
+        scheduleExpiration();
+}
+
+void WebSessionStore::remove(const QString &sid)
+{
+    const auto indexIter = m_index.constFind(sid);
+    if (indexIter != m_index.cend())
+        erase(indexIter.value());
+}
+
+int WebSessionStore::count() const
+{
+    return m_index.size();
+}
+
+qint64 WebSessionStore::expiredCount() const
+{
+    return m_expiredCount;
+}
+
+qint64 WebSessionStore::evictedCount() const
+{
+    return m_evictedCount;
+}
+
+qint64 WebSessionStore::inactiveTime() const
+{
+    return m_inactiveTime;
+}
+
+void WebSessionStore::setInactiveTime(const qint64 msecs)
+{
+    if (msecs == m_inactiveTime) return;
+
+    m_inactiveTime = msecs;
+    removeExpired();
+}
+
+int WebSessionStore::maxCount() const
+{
+    return m_maxCount;
+}
+
+void WebSessionStore::setMaxCount(const int count)
+{
+    // The callers validate the value, a store without room for any session couldn't log anyone in
+    Q_ASSERT(count > 0);
+    if (count <= 0) return;
+
+    m_maxCount = count;
+    evictExcess();
+}
+
+void WebSessionStore::removeExpired()
+{
+    const qint64 now = m_clock();
+    while (!m_entries.empty() && ((now - m_entries.front().lastUsed) > m_inactiveTime)) {
+        erase(m_entries.begin());
+        ++m_expiredCount;
+    }
+
+    scheduleExpiration();
+}
+
+void WebSessionStore::scheduleExpiration()
+{
+    if (m_entries.empty()) {
+        m_expirationTimer.stop();
+        return;
+    }
+
+    // The session expires once its inactive time is exceeded
+    const qint64 expiresIn = m_entries.front().lastUsed + m_inactiveTime + 1 - m_clock();
+    m_expirationTimer.start(static_cast<int>(std::max<qint64>(0, expiresIn)));
+}
+
+void WebSessionStore::evictExcess()
+{
+    while (m_index.size() > m_maxCount) {
+        erase(m_entries.begin());
+        ++m_evictedCount;
+    }
+}
+
+void WebSessionStore::erase(const EntryList::iterator it)
+{
+    m_index.remove(it->session->id());
+    delete it->session;
+    m_entries.erase(it);
+}
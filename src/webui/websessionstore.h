@@ -0,0 +1,100 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2019  qBittorrent project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+
+#pragma once
+
+#include <functional>
+#include <list>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+class WebSession;
+
+// Owns the WebUI sessions. They are indexed by id and kept in the order of their last use,
+// which is also the order they expire in since all of them have the same inactive time.
+// So the least recently used session is both the next one to expire and the one evicted
+// when the count limit is reached, and a single timer is enough to expire them.
+class WebSessionStore : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(WebSessionStore)
+
+public:
+    // Monotonic time in milliseconds
+    using Clock = std::function<qint64 ()>;
+
+    explicit WebSessionStore(const Clock &clock = {}, QObject *parent = nullptr);
+    ~WebSessionStore() override;
+
+    // Marks the session as used, nullptr if it doesn't exist or has expired
+    WebSession *find(const QString &sid);
+    bool contains(const QString &sid) const;
+    // Takes the ownership of the session
+    void insert(WebSession *session);
+    void remove(const QString &sid);
+
+    int count() const;
+    qint64 expiredCount() const;
+    qint64 evictedCount() const;
+
+    qint64 inactiveTime() const;
+    void setInactiveTime(qint64 msecs);
+    int maxCount() const;
+    void setMaxCount(int count);
+
+private:
+    struct Entry
+    {
+        WebSession *session;
+        qint64 lastUsed;
+    };
+    using EntryList = std::list<Entry>;
+
+    void removeExpired();
+    void scheduleExpiration();
+    void evictExcess();
+    void erase(EntryList::iterator it);
+
+    Clock m_clock;
+    QElapsedTimer m_elapsedTimer;
+    // It may fire before the next session expires, e.g. if it was used meanwhile,
+    // in which case it is just started again
+    QTimer m_expirationTimer;
+    qint64 m_inactiveTime;
+    int m_maxCount;
+    // Least recently used first
+    EntryList m_entries;
+    QHash<QString, EntryList::iterator> m_index;
+    qint64 m_expiredCount = 0;
+    qint64 m_evictedCount = 0;
+};
@@ -3,16 +3,18 @@ HEADERS += \
     $$PWD/api/apierror.h \
     $$PWD/api/appcontroller.h \
     $$PWD/api/authcontroller.h \
-    $$PWD/api/freediskspacechecker.h \
     $$PWD/api/isessionmanager.h \
     $$PWD/api/logcontroller.h \
+    $$PWD/api/metricscontroller.h \
     $$PWD/api/rsscontroller.h \
     $$PWD/api/searchcontroller.h \
     $$PWD/api/synccontroller.h \
+    $$PWD/api/torrentcreatorcontroller.h \
     $$PWD/api/torrentscontroller.h \
     $$PWD/api/transfercontroller.h \
     $$PWD/api/serialize/serialize_torrent.h \
     $$PWD/webapplication.h \
+    $$PWD/websessionstore.h \
     $$PWD/webui.h
 
 SOURCES += \
@@ -20,15 +22,17 @@ SOURCES += \
     $$PWD/api/apierror.cpp \
     $$PWD/api/appcontroller.cpp \
     $$PWD/api/authcontroller.cpp \
-    $$PWD/api/freediskspacechecker.cpp \
     $$PWD/api/logcontroller.cpp \
+    $$PWD/api/metricscontroller.cpp \
     $$PWD/api/rsscontroller.cpp \
     $$PWD/api/searchcontroller.cpp \
     $$PWD/api/synccontroller.cpp \
+    $$PWD/api/torrentcreatorcontroller.cpp \
     $$PWD/api/torrentscontroller.cpp \
     $$PWD/api/transfercontroller.cpp \
     $$PWD/api/serialize/serialize_torrent.cpp \
     $$PWD/webapplication.cpp \
+    $$PWD/websessionstore.cpp \
     $$PWD/webui.cpp
 
 TS_SOURCES += $$files($$PWD/www/translations/webui_*.ts)
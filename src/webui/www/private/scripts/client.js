@@ -476,6 +476,9 @@ window.addEvent('load', function() {
             $('QueuedIOJobs').set('html', serverState.queued_io_jobs);
             $('AverageTimeInQueue').set('html', serverState.average_time_queue + " ms");
             $('TotalQueuedSize').set('html', friendlyUnit(serverState.total_queued_size, false));
+            $('AlertsQueued').set('html', serverState.alerts_queued + " / " + serverState.alerts_queued_peak);
+            $('AlertsBacklog').set('html', serverState.alerts_backlog);
+            $('SlowestAlertHandlers').set('text', serverState.slowest_alert_handlers || "-");
         }
 
         if (serverState.connection_status == "connected")
@@ -1303,6 +1303,7 @@ var TorrentPeersTable = new Class({
         this.newColumn('files', '', 'QBT_TR(Files)QBT_TR[CONTEXT=PeerListWidget]', 100, true);
 
         this.columns['country'].dataProperties.push('country_code');
+        this.columns['ip'].dataProperties.push('host_name');
         this.columns['flags'].dataProperties.push('flags_desc');
         this.initColumnsFunctions();
     },
@@ -1341,6 +1342,13 @@ var TorrentPeersTable = new Class({
 
         // ip
 
+        this.columns['ip'].updateTd = function(td, row) {
+            var ip = this.getRowValue(row, 0);
+            var hostName = this.getRowValue(row, 1);
+            td.set('html', escapeHtml(hostName ? hostName : ip));
+            td.set('title', ip);
+        };
+
         this.columns['ip'].compareRows = function(row1, row2) {
             var ip1 = this.getRowValue(row1);
             var ip2 = this.getRowValue(row2);